@@ -0,0 +1,320 @@
+#include "Arpeggiator.h"
+
+namespace
+{
+    constexpr double stepsPerBeat[Arpeggiator::numDivisions] = { 1.0, 2.0, 3.0, 4.0, 6.0, 8.0 };
+    constexpr const char* divisionNames[Arpeggiator::numDivisions] = { "1/4", "1/8", "1/8T", "1/16", "1/16T", "1/32" };
+    constexpr const char* modeNames[Arpeggiator::numModes] = { "Off", "Up", "Down", "Up/down", "As played", "Random", "Step sequencer" };
+    constexpr int maxOctaves = 4;
+    constexpr int midiChannel = 1;
+
+    // Semitones per step, with -1 for a rest; a pattern repeats to fill 32 steps
+    struct PresetPattern
+    {
+        const char* name;
+        int length;
+        int semitones[16];
+    };
+
+    constexpr PresetPattern presetPatterns[] = {
+        { "Root pulse",   16, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+        { "Octave pump",  16, { 0, 12, 0, 12, 0, 12, 0, 12, 0, 12, 0, 12, 0, 12, 0, 12 } },
+        { "Minor walk",   16, { 0, 3, 7, 10, 12, 10, 7, 3, 0, 3, 7, 12, 15, 12, 7, 3 } },
+        { "Offbeat stab", 16, { -1, 0, -1, 0, -1, 0, -1, 7, -1, 0, -1, 0, -1, 12, -1, 7 } },
+        { "Fifths climb", 16, { 0, 7, 12, 19, 0, 7, 12, 19, 5, 12, 17, 24, 7, 14, 19, 26 } }
+    };
+
+    int clampToMidiRange(int note) noexcept
+    {
+        while (note > 127)
+            note -= 12;
+        while (note < 0)
+            note += 12;
+        return note;
+    }
+}
+
+//==============================================================================
+void Arpeggiator::prepare(double newSampleRate)
+{
+    // A running pattern keeps its place in time at the new rate
+    if (running && sampleRate > 0.0)
+    {
+        const double ratio = newSampleRate / sampleRate;
+        nextStepTime = (double)blockStart + (nextStepTime - (double)blockStart) * ratio;
+        if (gateOffTime >= 0)
+            gateOffTime = blockStart + (juce::int64)std::ceil((double)(gateOffTime - blockStart) * ratio);
+    }
+    sampleRate = newSampleRate;
+}
+
+void Arpeggiator::reset()
+{
+    blockStart = 0;
+    wasActive = false;
+    running = false;
+    stepIndex = 0;
+    nextStepTime = 0.0;
+    gateOffTime = -1;
+    soundingNote = -1;
+    numHeld = 0;
+}
+
+//==============================================================================
+void Arpeggiator::process(const juce::MidiBuffer& input, juce::MidiBuffer& output, int numSamples, const Settings& settings)
+{
+    output.clear();
+    const bool active = settings.mode > off && settings.mode < numModes;
+
+    if (active != wasActive)
+    {
+        // Notes that went straight through while off would otherwise hang
+        // under the pattern, and a pattern note would hang once it stops
+        if (active)
+            for (int i = 0; i < numHeld; ++i)
+                output.addEvent(juce::MidiMessage::noteOff(midiChannel, pressOrder[(size_t)i]), 0);
+        else
+            releaseSoundingNote(0, output);
+
+        running = false;
+        wasActive = active;
+    }
+
+    // Notes held from before the mode was switched on start straight away
+    if (active && !running && numHeld > 0)
+    {
+        running = true;
+        stepIndex = 0;
+        nextStepTime = (double)blockStart;
+    }
+
+    for (const auto metadata : input)
+    {
+        const int position = juce::jlimit(0, numSamples, metadata.samplePosition);
+        if (active)
+            advanceTo(position, output, settings);
+        handleMessage(metadata.getMessage(), position, output, active);
+    }
+
+    if (active)
+        advanceTo(numSamples, output, settings);
+
+    blockStart += numSamples;
+}
+
+void Arpeggiator::handleMessage(const juce::MidiMessage& message, int position, juce::MidiBuffer& output, bool active)
+{
+    if (message.isNoteOn())
+    {
+        const bool wasEmpty = numHeld == 0;
+        addHeld(message.getNoteNumber(), message.getVelocity());
+
+        // The first note down starts the pattern on its own sample
+        if (active && wasEmpty)
+        {
+            running = true;
+            stepIndex = 0;
+            nextStepTime = (double)(blockStart + position);
+        }
+    }
+    else if (message.isNoteOff())
+    {
+        removeHeld(message.getNoteNumber());
+        if (active && numHeld == 0)
+        {
+            releaseSoundingNote(position, output);
+            running = false;
+        }
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        numHeld = 0;
+        running = false;
+        releaseSoundingNote(position, output);
+    }
+
+    if (!active || !(message.isNoteOn() || message.isNoteOff()))
+        output.addEvent(message, position);
+}
+
+void Arpeggiator::advanceTo(int limit, juce::MidiBuffer& output, const Settings& settings)
+{
+    const auto end = blockStart + limit;
+    for (;;)
+    {
+        const auto stepTime = running ? (juce::int64)std::ceil(nextStepTime) : end;
+        const auto offTime = gateOffTime >= 0 ? gateOffTime : end;
+        const auto next = juce::jmin(stepTime, offTime);
+        if (next >= end)
+            return;
+
+        // A gate that ends on a step boundary lifts before the next note goes down
+        const int position = (int)juce::jmax((juce::int64)0, next - blockStart);
+        if (offTime <= stepTime)
+            releaseSoundingNote(position, output);
+        else
+            startStep(position, output, settings);
+    }
+}
+
+void Arpeggiator::startStep(int position, juce::MidiBuffer& output, const Settings& settings)
+{
+    int velocity = 0;
+    const int note = pickNote(settings, velocity);
+    const double length = getStepLength(settings, stepIndex);
+    const bool tie = settings.gate >= 1.0f;
+
+    if (note < 0)
+    {
+        releaseSoundingNote(position, output);
+    }
+    else
+    {
+        // Tied steps press the new note before lifting the old one, so the
+        // voice moves on without retriggering
+        const int previous = soundingNote;
+        if (previous >= 0 && (!tie || previous == note))
+            releaseSoundingNote(position, output);
+        output.addEvent(juce::MidiMessage::noteOn(midiChannel, note, (juce::uint8)juce::jlimit(1, 127, velocity)), position);
+        if (tie && previous >= 0 && previous != note)
+            output.addEvent(juce::MidiMessage::noteOff(midiChannel, previous), position);
+
+        soundingNote = note;
+        gateOffTime = tie ? -1
+                          : (juce::int64)std::ceil(nextStepTime + juce::jmax(1.0, (double)juce::jmax(0.0f, settings.gate) * length));
+    }
+
+    nextStepTime += length;
+    ++stepIndex;
+}
+
+void Arpeggiator::releaseSoundingNote(int position, juce::MidiBuffer& output)
+{
+    if (soundingNote >= 0)
+        output.addEvent(juce::MidiMessage::noteOff(midiChannel, soundingNote), position);
+    soundingNote = -1;
+    gateOffTime = -1;
+}
+
+int Arpeggiator::pickNote(const Settings& settings, int& velocity) noexcept
+{
+    if (numHeld == 0)
+        return -1;
+
+    const int octaves = juce::jlimit(1, maxOctaves, settings.octaves);
+    if (settings.mode == sequencer)
+    {
+        const int length = juce::jlimit(1, maxSteps, settings.steps);
+        const auto& step = settings.pattern[(size_t)(stepIndex % length)];
+        if (step.velocity == 0)
+            return -1;
+
+        velocity = step.velocity;
+        const int octave = (int)((stepIndex / length) % octaves);
+        return clampToMidiRange(pressOrder[(size_t)(numHeld - 1)] + step.semitones + 12 * octave);
+    }
+
+    const int total = numHeld * octaves;
+    int index = 0;
+    switch (settings.mode)
+    {
+        case down:      index = total - 1 - (int)(stepIndex % total); break;
+        case upDown:
+        {
+            const int period = juce::jmax(1, 2 * total - 2);
+            const int p = (int)(stepIndex % period);
+            index = p < total ? p : period - p;
+            break;
+        }
+        case randomOrder: index = random.nextInt(total); break;
+        case up:
+        case asPlayed:
+        default:        index = (int)(stepIndex % total); break;
+    }
+
+    const int source = index % numHeld;
+    const int base = settings.mode == asPlayed ? pressOrder[(size_t)source] : pitchOrder[(size_t)source];
+    velocity = velocities[(size_t)base];
+    return clampToMidiRange(base + 12 * (index / numHeld));
+}
+
+double Arpeggiator::getStepLength(const Settings& settings, juce::int64 step) const noexcept
+{
+    const double bpm = juce::jlimit(20.0, 400.0, (double)settings.tempoBpm);
+    const double straight = sampleRate * 60.0 / bpm / stepsPerBeat[juce::jlimit(0, numDivisions - 1, settings.division)];
+
+    // Swing borrows time from every second step and gives it to the one before
+    const double swingOffset = 0.5 * straight * juce::jlimit(0.0, 1.0, (double)settings.swing);
+    return (step % 2) == 0 ? straight + swingOffset : straight - swingOffset;
+}
+
+//==============================================================================
+void Arpeggiator::addHeld(int note, int velocity) noexcept
+{
+    note = juce::jlimit(0, 127, note);
+    velocities[(size_t)note] = (juce::uint8)juce::jlimit(1, 127, velocity);
+    for (int i = 0; i < numHeld; ++i)
+        if (pressOrder[(size_t)i] == note)
+            return;
+
+    pressOrder[(size_t)numHeld] = (juce::uint8)note;
+
+    int insertAt = numHeld;
+    while (insertAt > 0 && pitchOrder[(size_t)(insertAt - 1)] > note)
+    {
+        pitchOrder[(size_t)insertAt] = pitchOrder[(size_t)(insertAt - 1)];
+        --insertAt;
+    }
+    pitchOrder[(size_t)insertAt] = (juce::uint8)note;
+    ++numHeld;
+}
+
+void Arpeggiator::removeHeld(int note) noexcept
+{
+    const auto removeFrom = [this, note](std::array<juce::uint8, 128>& list)
+    {
+        int out = 0;
+        for (int i = 0; i < numHeld; ++i)
+            if (list[(size_t)i] != note)
+                list[(size_t)out++] = list[(size_t)i];
+        return out;
+    };
+
+    removeFrom(pitchOrder);
+    numHeld = removeFrom(pressOrder);
+}
+
+//==============================================================================
+juce::String Arpeggiator::getModeName(int mode)
+{
+    return juce::isPositiveAndBelow(mode, (int)numModes) ? modeNames[mode] : "";
+}
+
+juce::String Arpeggiator::getDivisionName(int division)
+{
+    return juce::isPositiveAndBelow(division, numDivisions) ? divisionNames[division] : "";
+}
+
+int Arpeggiator::getNumPresetPatterns() noexcept
+{
+    return (int)std::size(presetPatterns);
+}
+
+juce::String Arpeggiator::getPresetPatternName(int index)
+{
+    return juce::isPositiveAndBelow(index, getNumPresetPatterns()) ? presetPatterns[index].name : "";
+}
+
+void Arpeggiator::applyPresetPattern(int index, Settings& settings) noexcept
+{
+    if (!juce::isPositiveAndBelow(index, getNumPresetPatterns()))
+        return;
+
+    const auto& preset = presetPatterns[index];
+    for (int i = 0; i < maxSteps; ++i)
+    {
+        const int semitones = preset.semitones[i % preset.length];
+        settings.pattern[(size_t)i].semitones = (juce::int8)juce::jmax(0, semitones);
+        settings.pattern[(size_t)i].velocity = (juce::uint8)(semitones < 0 ? 0 : (i % 4) == 0 ? 120 : 96);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+// Arpeggiator and step sequencer, run by SynthEngine::render() on the audio
+// thread. Held notes arrive as MIDI (devices and the on-screen keyboard alike)
+// and the notes they drive come out at exact sample positions. Steps are
+// counted in samples from the first note down, never from block boundaries,
+// so a pattern lands on the same samples at every block size.
+//
+// Held notes live in fixed arrays, so nothing allocates while playing.
+class Arpeggiator
+{
+public:
+    enum Mode { off, up, down, upDown, asPlayed, randomOrder, sequencer, numModes };
+    static constexpr int maxSteps = 32;
+    static constexpr int numDivisions = 6;
+
+    struct Step
+    {
+        juce::int8 semitones = 0;       // above the most recently pressed note
+        juce::uint8 velocity = 100;     // 0 rests
+    };
+
+    // Part of SynthParameters, so kept trivially copyable
+    struct Settings
+    {
+        int     mode = off;
+        float   tempoBpm = 120.0f;
+        int     division = 3;           // see getDivisionName()
+        float   gate = 0.5f;            // fraction of a step; 1 ties into the next note
+        float   swing = 0.0f;           // 0 straight, 1 pushes every second step to 3:1
+        int     octaves = 1;            // 1..4
+        int     steps = 16;             // sequencer pattern length
+        std::array<Step, maxSteps> pattern {};
+    };
+
+    // Not the audio thread. A new rate keeps the pattern running.
+    void prepare(double sampleRate);
+    void reset();
+
+    // Audio thread. With a mode set, note events in input are consumed and the
+    // pattern they drive is written to output instead; other messages pass
+    // straight through. output must have room reserved.
+    void process(const juce::MidiBuffer& input, juce::MidiBuffer& output, int numSamples, const Settings& settings);
+
+    void setRandomSeed(juce::int64 seed)    { random.setSeed(seed); }
+
+    static juce::String getModeName(int mode);
+    static juce::String getDivisionName(int division);
+
+    static int getNumPresetPatterns() noexcept;
+    static juce::String getPresetPatternName(int index);
+    static void applyPresetPattern(int index, Settings& settings) noexcept;
+
+private:
+    void handleMessage(const juce::MidiMessage& message, int position, juce::MidiBuffer& output, bool active);
+    void advanceTo(int limit, juce::MidiBuffer& output, const Settings& settings);
+    void startStep(int position, juce::MidiBuffer& output, const Settings& settings);
+    void releaseSoundingNote(int position, juce::MidiBuffer& output);
+    int pickNote(const Settings& settings, int& velocity) noexcept;
+    double getStepLength(const Settings& settings, juce::int64 step) const noexcept;
+    void addHeld(int note, int velocity) noexcept;
+    void removeHeld(int note) noexcept;
+
+    double sampleRate = 44100.0;
+    juce::int64 blockStart = 0;         // samples since prepare, at the start of the block
+    bool wasActive = false;
+
+    // Pattern clock, in absolute samples
+    bool running = false;
+    juce::int64 stepIndex = 0;
+    double nextStepTime = 0.0;
+    juce::int64 gateOffTime = -1;
+    int soundingNote = -1;
+
+    // Held notes in the order they went down, and in pitch order
+    std::array<juce::uint8, 128> pressOrder {};
+    std::array<juce::uint8, 128> pitchOrder {};
+    std::array<juce::uint8, 128> velocities {};
+    int numHeld = 0;
+
+    juce::Random random;
+};
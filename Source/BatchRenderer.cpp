@@ -0,0 +1,405 @@
+#include "BatchRenderer.h"
+
+namespace
+{
+    constexpr int renderBlockSize = 512;
+    constexpr int analysisFftOrder = 11;
+    constexpr double progressIntervalMs = 1000.0;
+
+    struct FloatField { const char* name; float SynthParameters::* member; };
+    struct IntField   { const char* name; int SynthParameters::* member; };
+    struct BoolField  { const char* name; bool SynthParameters::* member; };
+
+    const FloatField floatFields[] =
+    {
+        { "waveMorph", &SynthParameters::waveMorph },
+        { "outputGain", &SynthParameters::outputGain },
+        { "attackMs", &SynthParameters::attackMs },
+        { "decayMs", &SynthParameters::decayMs },
+        { "sustainLevel", &SynthParameters::sustainLevel },
+        { "releaseMs", &SynthParameters::releaseMs },
+        { "cutoffHz", &SynthParameters::cutoffHz },
+        { "resonanceQ", &SynthParameters::resonanceQ },
+        { "lfoCutModAmt", &SynthParameters::lfoCutModAmt },
+        { "envFilterAmount", &SynthParameters::envFilterAmount },
+        { "lfoRateHz", &SynthParameters::lfoRateHz },
+        { "lfoDepth", &SynthParameters::lfoDepth },
+        { "stereoWidth", &SynthParameters::stereoWidth },
+        { "driveAmount", &SynthParameters::driveAmount },
+        { "crushAmount", &SynthParameters::crushAmount },
+        { "subMixAmount", &SynthParameters::subMixAmount },
+        { "chaosAmount", &SynthParameters::chaosAmount },
+        { "delayAmount", &SynthParameters::delayAmount },
+        { "autoPanAmount", &SynthParameters::autoPanAmount },
+        { "chorusMix", &SynthParameters::chorusMix },
+        { "glitchProbability", &SynthParameters::glitchProbability },
+        { "reverbMix", &SynthParameters::reverbMix },
+        { "sampleMix", &SynthParameters::sampleMix },
+        { "roomMix", &SynthParameters::roomMix },
+        { "roomSize", &SynthParameters::roomSize },
+        { "roomDecay", &SynthParameters::roomDecay },
+        { "roomDamping", &SynthParameters::roomDamping },
+        { "grainMix", &SynthParameters::grainMix },
+        { "grainSizeMs", &SynthParameters::grainSizeMs },
+        { "grainDensity", &SynthParameters::grainDensity },
+        { "grainPitch", &SynthParameters::grainPitch },
+        { "grainSpray", &SynthParameters::grainSpray },
+        { "grainReverse", &SynthParameters::grainReverse },
+        { "spectralMix", &SynthParameters::spectralMix },
+        { "spectralBlur", &SynthParameters::spectralBlur },
+        { "spectralGateDb", &SynthParameters::spectralGateDb },
+        { "fmFeedback", &SynthParameters::fmFeedback },
+        { "unisonDetuneCents", &SynthParameters::unisonDetuneCents },
+        { "unisonStereoSpread", &SynthParameters::unisonStereoSpread },
+        { "unisonPhaseRandom", &SynthParameters::unisonPhaseRandom }
+    };
+
+    const IntField intFields[] =
+    {
+        { "fmAlgorithm", &SynthParameters::fmAlgorithm },
+        { "unisonVoices", &SynthParameters::unisonVoices },
+        { "spectralFftOrder", &SynthParameters::spectralFftOrder },
+        { "spectralOverlap", &SynthParameters::spectralOverlap }
+    };
+
+    const BoolField boolFields[] =
+    {
+        { "roomFreeze", &SynthParameters::roomFreeze },
+        { "fmEnabled", &SynthParameters::fmEnabled },
+        { "spectralFreeze", &SynthParameters::spectralFreeze }
+    };
+
+    bool parseOperators(const juce::var& value, FmOscillator::Operators& operators)
+    {
+        const auto* list = value.getArray();
+        if (list == nullptr || list->size() > FmOscillator::numOperators)
+            return false;
+
+        for (int op = 0; op < list->size(); ++op)
+        {
+            const auto& v = list->getReference(op);
+            auto& p = operators[(size_t)op];
+            p.ratio = (float)v.getProperty("ratio", p.ratio);
+            p.level = (float)v.getProperty("level", p.level);
+            p.attackMs = (float)v.getProperty("attackMs", p.attackMs);
+            p.decayMs = (float)v.getProperty("decayMs", p.decayMs);
+            p.sustain = (float)v.getProperty("sustain", p.sustain);
+            p.releaseMs = (float)v.getProperty("releaseMs", p.releaseMs);
+        }
+        return true;
+    }
+
+    // Unknown keys are reported rather than ignored so a typo can't quietly
+    // export a whole library with the wrong sound
+    juce::String parsePatch(const juce::var& value, int index, BatchRenderer::Patch& patch)
+    {
+        const auto* object = value.getDynamicObject();
+        if (object == nullptr)
+            return "patch " + juce::String(index) + " is not an object";
+
+        patch.name = "patch" + juce::String(index + 1);
+
+        for (const auto& property : object->getProperties())
+        {
+            const auto key = property.name.toString();
+            bool known = false;
+
+            if (key == "name")
+            {
+                patch.name = property.value.toString();
+                known = true;
+            }
+            else if (key == "fmOperators")
+            {
+                if (!parseOperators(property.value, patch.params.fmOperators))
+                    return "patch " + patch.name + ": fmOperators must be a list of up to six objects";
+                known = true;
+            }
+
+            for (const auto& f : floatFields)
+                if (key == f.name) { patch.params.*f.member = (float)property.value; known = true; }
+            for (const auto& f : intFields)
+                if (key == f.name) { patch.params.*f.member = (int)property.value; known = true; }
+            for (const auto& f : boolFields)
+                if (key == f.name) { patch.params.*f.member = (bool)property.value; known = true; }
+
+            if (!known)
+                return "patch " + patch.name + ": unknown parameter '" + key + "'";
+        }
+
+        patch.name = juce::File::createLegalFileName(patch.name);
+        return {};
+    }
+}
+
+//==============================================================================
+int BatchRenderer::Job::getNumRenders() const
+{
+    const int numNotes = highNote >= lowNote ? (highNote - lowNote) / juce::jmax(1, noteStep) + 1 : 0;
+    return patches.size() * numNotes * velocities.size();
+}
+
+juce::String BatchRenderer::parseJob(const juce::File& jobFile, Job& job)
+{
+    if (!jobFile.existsAsFile())
+        return jobFile.getFullPathName() + " not found";
+
+    juce::var root;
+    const auto parsed = juce::JSON::parse(jobFile.loadFileAsString(), root);
+    if (parsed.failed())
+        return jobFile.getFileName() + ": " + parsed.getErrorMessage();
+    if (!root.isObject())
+        return jobFile.getFileName() + ": expected a JSON object";
+
+    const auto output = root.getProperty("output", "").toString();
+    job.outputDirectory = output.isEmpty() ? jobFile.getParentDirectory().getChildFile(jobFile.getFileNameWithoutExtension())
+                                           : jobFile.getParentDirectory().getChildFile(output);
+
+    job.sampleRate = juce::jlimit(8000.0, 384000.0, (double)root.getProperty("sampleRate", job.sampleRate));
+    job.bitsPerSample = (int)root.getProperty("bitsPerSample", job.bitsPerSample);
+    if (job.bitsPerSample != 16 && job.bitsPerSample != 24 && job.bitsPerSample != 32)
+        return "bitsPerSample must be 16, 24 or 32";
+
+    job.lowNote = juce::jlimit(0, 127, (int)root.getProperty("lowNote", job.lowNote));
+    job.highNote = juce::jlimit(0, 127, (int)root.getProperty("highNote", job.highNote));
+    job.noteStep = juce::jmax(1, (int)root.getProperty("noteStep", job.noteStep));
+    job.holdSeconds = juce::jmax(0.0, (double)root.getProperty("holdSeconds", job.holdSeconds));
+    job.tailSeconds = juce::jmax(0.0, (double)root.getProperty("tailSeconds", job.tailSeconds));
+    job.writeAnalysis = (bool)root.getProperty("analysis", job.writeAnalysis);
+
+    const auto velocityList = root.getProperty("velocities", {});
+    if (const auto* velocities = velocityList.getArray())
+    {
+        job.velocities.clear();
+        for (const auto& v : *velocities)
+            job.velocities.addIfNotAlreadyThere(juce::jlimit(1, 127, (int)v));
+    }
+
+    job.patches.clear();
+    const auto patchList = root.getProperty("patches", {});
+    if (const auto* patches = patchList.getArray())
+    {
+        for (int i = 0; i < patches->size(); ++i)
+        {
+            Patch patch;
+            const auto error = parsePatch(patches->getReference(i), i, patch);
+            if (error.isNotEmpty())
+                return error;
+            job.patches.add(patch);
+        }
+    }
+    else
+    {
+        job.patches.add({ "default", {} });
+    }
+
+    if (job.getNumRenders() == 0)
+        return "the job has nothing to render";
+    if (job.holdSeconds + job.tailSeconds <= 0.0)
+        return "holdSeconds + tailSeconds must be above zero";
+
+    return {};
+}
+
+//==============================================================================
+bool BatchRenderer::run(const Job& job, int numThreads)
+{
+    if (!job.outputDirectory.createDirectory())
+    {
+        juce::Logger::writeToLog("Batch: can't create " + job.outputDirectory.getFullPathName());
+        return false;
+    }
+
+    const int numRenders = job.getNumRenders();
+    numThreads = juce::jlimit(1, numRenders, numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus());
+
+    std::vector<Analysis> results((size_t)numRenders);
+    std::atomic<int> nextRender { 0 };
+    std::atomic<int> finishedRenders { 0 };
+
+    juce::Logger::writeToLog("Batch: " + juce::String(numRenders) + " renders on "
+                             + juce::String(numThreads) + " threads into " + job.outputDirectory.getFullPathName());
+
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        juce::ThreadPool pool(numThreads);
+        for (int t = 0; t < numThreads; ++t)
+            pool.addJob([&] { renderWorker(job, nextRender, finishedRenders, results); });
+
+        double lastReportMs = startMs;
+        while (pool.getNumJobs() > 0)
+        {
+            juce::Thread::sleep(50);
+
+            const double nowMs = juce::Time::getMillisecondCounterHiRes();
+            if (nowMs - lastReportMs >= progressIntervalMs)
+            {
+                lastReportMs = nowMs;
+                juce::Logger::writeToLog("Batch: " + juce::String(finishedRenders.load()) + " / " + juce::String(numRenders));
+            }
+        }
+    }
+
+    const double elapsedSeconds = juce::jmax(1.0e-3, (juce::Time::getMillisecondCounterHiRes() - startMs) * 0.001);
+    const auto failures = std::count_if(results.begin(), results.end(), [](const Analysis& a) { return !a.ok; });
+    const double audioSeconds = numRenders * (job.holdSeconds + job.tailSeconds);
+
+    juce::Logger::writeToLog("Batch: " + juce::String(numRenders - (int)failures) + " files in "
+                             + juce::String(elapsedSeconds, 2) + " s, "
+                             + juce::String(numRenders / elapsedSeconds, 1) + " renders/sec ("
+                             + juce::String(audioSeconds / elapsedSeconds, 1) + "x realtime)");
+
+    bool ok = failures == 0;
+    if (job.writeAnalysis)
+        ok = writeIndex(job, results) && ok;
+
+    return ok;
+}
+
+void BatchRenderer::renderWorker(const Job& job, std::atomic<int>& nextRender,
+                                 std::atomic<int>& finishedRenders, std::vector<Analysis>& results)
+{
+    // One engine per worker, re-prepared for every note so renders don't
+    // depend on which thread picked them up or what it played before
+    SynthEngine engine;
+
+    const int holdSamples = (int)std::round(job.holdSeconds * job.sampleRate);
+    const int totalSamples = juce::jmax(1, (int)std::round((job.holdSeconds + job.tailSeconds) * job.sampleRate));
+    juce::AudioBuffer<float> buffer(2, totalSamples);
+
+    const int numNotes = (job.highNote - job.lowNote) / job.noteStep + 1;
+    const int numVelocities = job.velocities.size();
+    const int numRenders = job.getNumRenders();
+    juce::WavAudioFormat wav;
+
+    for (int index = nextRender++; index < numRenders; index = nextRender++)
+    {
+        const auto& patch = job.patches.getReference(index / (numNotes * numVelocities));
+        const int note = job.lowNote + ((index / numVelocities) % numNotes) * job.noteStep;
+        const int velocity = job.velocities[index % numVelocities];
+
+        auto& result = results[(size_t)index];
+        result.patchName = patch.name;
+        result.note = note;
+        result.velocity = velocity;
+        result.fileName = patch.name + "_" + juce::String(note).paddedLeft('0', 3) + "_"
+                        + juce::MidiMessage::getMidiNoteName(note, true, true, 3)
+                        + "_v" + juce::String(velocity).paddedLeft('0', 3) + ".wav";
+
+        engine.params = patch.params;
+        engine.prepare(job.sampleRate, renderBlockSize);
+        engine.reset();
+        engine.setRandomSeed(index);
+        engine.allNotesOff();
+        engine.noteOn(note, (float)velocity / 127.0f);
+        engine.setTargetFrequency(engine.getNoteFrequency(note), true);
+
+        buffer.clear();
+        for (int pos = 0; pos < totalSamples;)
+        {
+            if (pos == holdSamples)
+                engine.noteOff(note);
+
+            int n = juce::jmin(renderBlockSize, totalSamples - pos);
+            if (pos < holdSamples)
+                n = juce::jmin(n, holdSamples - pos);
+
+            engine.render(buffer.getWritePointer(0, pos), buffer.getWritePointer(1, pos), n);
+            pos += n;
+        }
+
+        const auto file = job.outputDirectory.getChildFile(result.fileName);
+        file.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        if (stream != nullptr)
+            writer.reset(wav.createWriterFor(stream.get(), job.sampleRate, 2, job.bitsPerSample, {}, 0));
+
+        if (writer != nullptr)
+        {
+            stream.release(); // now owned by the writer
+            result.ok = writer->writeFromAudioSampleBuffer(buffer, 0, totalSamples);
+        }
+        else
+        {
+            juce::Logger::writeToLog("Batch: can't write " + file.getFullPathName());
+        }
+
+        if (result.ok && job.writeAnalysis)
+            analyse(buffer, job.sampleRate, result);
+
+        ++finishedRenders;
+    }
+}
+
+//==============================================================================
+void BatchRenderer::analyse(const juce::AudioBuffer<float>& audio, double sampleRate, Analysis& result)
+{
+    const int numSamples = audio.getNumSamples();
+    const int numChannels = audio.getNumChannels();
+
+    result.peak = audio.getMagnitude(0, numSamples);
+
+    double sumSquares = 0.0;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float channelRms = audio.getRMSLevel(ch, 0, numSamples);
+        sumSquares += (double)channelRms * channelRms;
+    }
+    result.rms = (float)std::sqrt(sumSquares / juce::jmax(1, numChannels));
+
+    // Centroid of the average magnitude spectrum of the mono sum
+    constexpr int fftSize = 1 << analysisFftOrder;
+    juce::dsp::FFT fft(analysisFftOrder);
+    juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> frame((size_t)fftSize * 2);
+    std::vector<double> spectrum((size_t)fftSize / 2 + 1, 0.0);
+
+    for (int start = 0; start < numSamples; start += fftSize)
+    {
+        std::fill(frame.begin(), frame.end(), 0.0f);
+        const int n = juce::jmin(fftSize, numSamples - start);
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::add(frame.data(), audio.getReadPointer(ch, start), n);
+
+        window.multiplyWithWindowingTable(frame.data(), (size_t)fftSize);
+        fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+
+        for (size_t bin = 0; bin < spectrum.size(); ++bin)
+            spectrum[bin] += frame[bin];
+    }
+
+    double weighted = 0.0, total = 0.0;
+    for (size_t bin = 1; bin < spectrum.size(); ++bin)
+    {
+        weighted += spectrum[bin] * (double)bin * sampleRate / fftSize;
+        total += spectrum[bin];
+    }
+    result.centroidHz = total > 0.0 ? (float)(weighted / total) : 0.0f;
+}
+
+bool BatchRenderer::writeIndex(const Job& job, const std::vector<Analysis>& results)
+{
+    juce::String csv = "file,patch,note,velocity,peak_dbfs,rms_dbfs,centroid_hz\n";
+
+    for (const auto& a : results)
+    {
+        if (!a.ok)
+            continue;
+
+        csv << a.fileName << ',' << a.patchName << ',' << a.note << ',' << a.velocity << ','
+            << juce::String(juce::Decibels::gainToDecibels(a.peak), 2) << ','
+            << juce::String(juce::Decibels::gainToDecibels(a.rms), 2) << ','
+            << juce::String(a.centroidHz, 1) << '\n';
+    }
+
+    const auto indexFile = job.outputDirectory.getChildFile("index.csv");
+    if (!indexFile.replaceWithText(csv))
+    {
+        juce::Logger::writeToLog("Batch: can't write " + indexFile.getFullPathName());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SynthEngine.h"
+
+// Offline export of sampled-instrument sources: every patch x note x velocity
+// layer of a job is rendered to its own WAV file. Each worker thread owns one
+// SynthEngine and pulls renders from a shared counter, so nothing is shared
+// between engines and all cores stay busy.
+//
+// Jobs are JSON files, for example:
+//   {
+//     "output": "/path/to/export",
+//     "sampleRate": 48000, "bitsPerSample": 24,
+//     "lowNote": 36, "highNote": 96, "noteStep": 3,
+//     "velocities": [ 32, 80, 127 ],
+//     "holdSeconds": 2.0, "tailSeconds": 1.5,
+//     "analysis": true,
+//     "patches": [ { "name": "pad", "waveMorph": 0.4, "cutoffHz": 1800 } ]
+//   }
+// Patch keys are SynthParameters member names; anything missing keeps its default.
+class BatchRenderer
+{
+public:
+    struct Patch
+    {
+        juce::String name;
+        SynthParameters params;
+    };
+
+    struct Job
+    {
+        juce::File outputDirectory;
+        double sampleRate = 48000.0;
+        int bitsPerSample = 24;
+        int lowNote = 48;
+        int highNote = 72;
+        int noteStep = 1;
+        juce::Array<int> velocities { 127 };
+        double holdSeconds = 2.0;
+        double tailSeconds = 1.0;
+        bool writeAnalysis = false;
+        juce::Array<Patch> patches;
+
+        int getNumRenders() const;
+    };
+
+    // Returns an error message, or an empty string on success
+    static juce::String parseJob(const juce::File& jobFile, Job& job);
+
+    // Renders the whole job on numThreads workers (0 uses every core) and
+    // blocks until done. Progress and throughput go to the logger.
+    static bool run(const Job& job, int numThreads = 0);
+
+private:
+    struct Analysis
+    {
+        juce::String fileName;
+        juce::String patchName;
+        int note = 0;
+        int velocity = 0;
+        float peak = 0.0f;
+        float rms = 0.0f;
+        float centroidHz = 0.0f;
+        bool ok = false;
+    };
+
+    static void renderWorker(const Job& job, std::atomic<int>& nextRender,
+                             std::atomic<int>& finishedRenders, std::vector<Analysis>& results);
+    static void analyse(const juce::AudioBuffer<float>& audio, double sampleRate, Analysis& result);
+    static bool writeIndex(const Job& job, const std::vector<Analysis>& results);
+};
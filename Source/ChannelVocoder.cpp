@@ -0,0 +1,247 @@
+#include "ChannelVocoder.h"
+
+namespace
+{
+    constexpr double lowestBandHz = 80.0;
+    constexpr double highestBandHz = 10000.0;
+    // Top band centre as a fraction of the rate, for low device rates
+    constexpr double highestBandFraction = 0.4;
+    // Two cascaded identical sections narrow the -3 dB bandwidth by sqrt(2^(1/2) - 1)
+    constexpr double cascadeNarrowing = 0.6436;
+
+    constexpr double attackSeconds = 0.002;
+    constexpr double releaseSeconds = 0.02;
+    constexpr double mixRampSeconds = 0.05;
+
+    // Loopback probe
+    constexpr float probeClickLevel = 0.5f;
+    constexpr int probeClickSamples = 4;
+    constexpr float probeDetectLevel = 0.05f;
+    constexpr double probeTimeoutSeconds = 1.0;
+}
+
+//==============================================================================
+void ChannelVocoder::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    attackCoefficient = (float)(1.0 - std::exp(-1.0 / (attackSeconds * sampleRate)));
+    releaseMultiplier = (float)std::exp(-1.0 / (releaseSeconds * sampleRate));
+    mixSmoothed.reset(sampleRate, mixRampSeconds);
+    mixSmoothed.setCurrentAndTargetValue(0.0f);
+    engaged = false;
+
+    numBands = 0;
+    applyParameters();
+    probeWaiting.store(false, std::memory_order_relaxed);
+}
+
+void ChannelVocoder::reset() noexcept
+{
+    analysis = {};
+    carrierL = {};
+    carrierR = {};
+    peaks.fill(0.0f);
+    envelopes.fill(0.0f);
+}
+
+void ChannelVocoder::setParameters(int bands, float mix, float inputGainDb) noexcept
+{
+    bands = bands >= 32 ? 32 : (bands >= 24 ? 24 : 16);
+    requestedBands.store(bands, std::memory_order_relaxed);
+    requestedMix.store(juce::jlimit(0.0f, 1.0f, mix), std::memory_order_relaxed);
+    requestedInputGainDb.store(juce::jlimit(0.0f, 36.0f, inputGainDb), std::memory_order_relaxed);
+}
+
+void ChannelVocoder::applyParameters() noexcept
+{
+    mixSmoothed.setTargetValue(requestedMix.load(std::memory_order_relaxed));
+    inputGain = juce::Decibels::decibelsToGain(requestedInputGainDb.load(std::memory_order_relaxed));
+
+    const int bands = requestedBands.load(std::memory_order_relaxed);
+    if (bands == numBands)
+        return;
+
+    numBands = bands;
+    numRegisters = numBands / (int)Lanes::SIZE;
+    // Band outputs add roughly in power
+    makeupGain = std::sqrt((float)numBands);
+
+    // Centres share one ratio; each band's Q makes neighbours cross near -3 dB
+    const double top = juce::jmin(highestBandHz, sampleRate * highestBandFraction);
+    const double ratio = std::pow(top / lowestBandHz, 1.0 / (numBands - 1));
+    const double bandQ = std::sqrt(ratio) / (ratio - 1.0);
+    const double stageQ = bandQ * cascadeNarrowing;
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        // Lanes past the band count stay silent so whole registers always run
+        if (band >= numBands)
+        {
+            b0[(size_t)band] = a1[(size_t)band] = a2[(size_t)band] = 0.0f;
+            continue;
+        }
+
+        const double w0 = juce::MathConstants<double>::twoPi * lowestBandHz * std::pow(ratio, band) / sampleRate;
+        const double alpha = std::sin(w0) / (2.0 * stageQ);
+        const double a0 = 1.0 + alpha;
+        b0[(size_t)band] = (float)(alpha / a0);
+        a1[(size_t)band] = (float)(-2.0 * std::cos(w0) / a0);
+        a2[(size_t)band] = (float)((1.0 - alpha) / a0);
+    }
+
+    reset();
+}
+
+//==============================================================================
+void ChannelVocoder::process(const float* modulator, float* left, float* right, int numSamples) noexcept
+{
+    // Band states ring down towards denormals whenever the input goes quiet
+    const juce::ScopedNoDenormals noDenormals;
+    applyParameters();
+
+    if (mixSmoothed.getTargetValue() > 0.0f || mixSmoothed.isSmoothing())
+    {
+        if (!engaged)
+        {
+            reset();
+            engaged = true;
+        }
+
+        for (int offset = 0; offset < numSamples; offset += chunkSize)
+        {
+            const int count = juce::jmin(chunkSize, numSamples - offset);
+            processChunk(modulator + offset, left + offset, right != nullptr ? right + offset : nullptr, count);
+        }
+    }
+    else
+    {
+        engaged = false;
+    }
+
+    updateProbe(modulator, left, right, numSamples);
+}
+
+void ChannelVocoder::processChunk(const float* modulator, float* left, float* right, int numSamples) noexcept
+{
+    const Lanes zero(0.0f);
+    const Lanes attack(attackCoefficient), release(releaseMultiplier);
+    const bool stereo = right != nullptr;
+
+    for (int reg = 0; reg < numRegisters; ++reg)
+    {
+        const size_t k = (size_t)reg * Lanes::SIZE;
+        const auto gain = Lanes::fromRawArray(b0.data() + k);
+        const auto feedback1 = Lanes::fromRawArray(a1.data() + k);
+        const auto feedback2 = Lanes::fromRawArray(a2.data() + k);
+
+        Lanes mz1[numStages], mz2[numStages], lz1[numStages], lz2[numStages], rz1[numStages], rz2[numStages];
+        for (int s = 0; s < numStages; ++s)
+        {
+            mz1[s] = Lanes::fromRawArray(analysis.z1[s].data() + k);
+            mz2[s] = Lanes::fromRawArray(analysis.z2[s].data() + k);
+            lz1[s] = Lanes::fromRawArray(carrierL.z1[s].data() + k);
+            lz2[s] = Lanes::fromRawArray(carrierL.z2[s].data() + k);
+            rz1[s] = Lanes::fromRawArray(carrierR.z1[s].data() + k);
+            rz2[s] = Lanes::fromRawArray(carrierR.z2[s].data() + k);
+        }
+        auto peak = Lanes::fromRawArray(peaks.data() + k);
+        auto envelope = Lanes::fromRawArray(envelopes.data() + k);
+
+        // y = b0 x + z1,  z1' = z2 - a1 y,  z2' = -(b0 x + a2 y)
+        const auto bandPass = [&](Lanes x, Lanes* z1, Lanes* z2)
+        {
+            for (int s = 0; s < numStages; ++s)
+            {
+                const auto forward = gain * x;
+                const auto y = forward + z1[s];
+                z1[s] = z2[s] - feedback1 * y;
+                z2[s] = zero - (forward + feedback2 * y);
+                x = y;
+            }
+            return x;
+        };
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto band = bandPass(Lanes(modulator[i] * inputGain), mz1, mz2);
+            peak = Lanes::max(Lanes::max(band, zero - band), peak * release);
+            envelope = envelope + (peak - envelope) * attack;
+
+            auto* sumL = sumsL.data() + (size_t)i * Lanes::SIZE;
+            auto voicedL = bandPass(Lanes(left[i]), lz1, lz2) * envelope;
+            if (reg > 0)
+                voicedL = voicedL + Lanes::fromRawArray(sumL);
+            voicedL.copyToRawArray(sumL);
+
+            if (stereo)
+            {
+                auto* sumR = sumsR.data() + (size_t)i * Lanes::SIZE;
+                auto voicedR = bandPass(Lanes(right[i]), rz1, rz2) * envelope;
+                if (reg > 0)
+                    voicedR = voicedR + Lanes::fromRawArray(sumR);
+                voicedR.copyToRawArray(sumR);
+            }
+        }
+
+        for (int s = 0; s < numStages; ++s)
+        {
+            mz1[s].copyToRawArray(analysis.z1[s].data() + k);
+            mz2[s].copyToRawArray(analysis.z2[s].data() + k);
+            lz1[s].copyToRawArray(carrierL.z1[s].data() + k);
+            lz2[s].copyToRawArray(carrierL.z2[s].data() + k);
+            rz1[s].copyToRawArray(carrierR.z1[s].data() + k);
+            rz2[s].copyToRawArray(carrierR.z2[s].data() + k);
+        }
+        peak.copyToRawArray(peaks.data() + k);
+        envelope.copyToRawArray(envelopes.data() + k);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float mix = mixSmoothed.getNextValue();
+        const auto* sumL = sumsL.data() + (size_t)i * Lanes::SIZE;
+        left[i] += mix * (Lanes::fromRawArray(sumL).sum() * makeupGain - left[i]);
+        if (stereo)
+        {
+            const auto* sumR = sumsR.data() + (size_t)i * Lanes::SIZE;
+            right[i] += mix * (Lanes::fromRawArray(sumR).sum() * makeupGain - right[i]);
+        }
+    }
+}
+
+void ChannelVocoder::updateProbe(const float* modulator, float* left, float* right, int numSamples) noexcept
+{
+    if (probeWaiting.load(std::memory_order_relaxed))
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (std::abs(modulator[i]) > probeDetectLevel)
+            {
+                roundTripMs.store((float)(1000.0 * (double)(probeElapsed + i) / sampleRate), std::memory_order_relaxed);
+                probeWaiting.store(false, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        probeElapsed += numSamples;
+        if (probeElapsed > (juce::int64)(probeTimeoutSeconds * sampleRate))
+        {
+            roundTripMs.store(-1.0f, std::memory_order_relaxed);
+            probeWaiting.store(false, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // The click leads this block's output; its echo can turn up from the next block on
+    if (roundTripRequested.exchange(false, std::memory_order_relaxed))
+    {
+        for (int i = 0; i < juce::jmin(probeClickSamples, numSamples); ++i)
+        {
+            left[i] = probeClickLevel;
+            if (right != nullptr)
+                right[i] = probeClickLevel;
+        }
+        probeElapsed = numSamples;
+        probeWaiting.store(true, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+// Channel vocoder with the live input as modulator and the synth as carrier.
+// Both go through the same bank of 4th-order band-passes (two cascaded
+// biquads per band), log-spaced from 80 Hz; each analysis band drives a
+// peak-hold envelope follower that sets the level of its synthesis band.
+//
+// Bands are packed across SIMD lanes, and each register of bands runs through
+// a whole chunk with its filter state held in registers, so the cost grows
+// with the number of registers rather than bands.
+class ChannelVocoder
+{
+public:
+    static constexpr int minBands = 16;
+    static constexpr int maxBands = 32;
+
+    void prepare(double sampleRate);
+    void reset() noexcept;
+
+    // Any thread; applied at the start of the next block. Band counts round
+    // to 16, 24 or 32. inputGainDb lifts a quiet modulator before analysis.
+    void setParameters(int numBands, float mix, float inputGainDb) noexcept;
+    int getNumBands() const noexcept            { return requestedBands.load(std::memory_order_relaxed); }
+    float getMix() const noexcept               { return requestedMix.load(std::memory_order_relaxed); }
+    float getInputGainDb() const noexcept       { return requestedInputGainDb.load(std::memory_order_relaxed); }
+
+    // Audio thread. modulator is the mono live input for the block; left and
+    // right carry the synth in and the vocoded mix out. right may be null.
+    void process(const float* modulator, float* left, float* right, int numSamples) noexcept;
+
+    // Input-to-output latency over a loopback: the next block sends a click
+    // and times how long it takes to come back on the input. Any thread.
+    void measureRoundTrip() noexcept            { roundTripRequested.store(true, std::memory_order_relaxed); }
+    bool isMeasuringRoundTrip() const noexcept  { return probeWaiting.load(std::memory_order_relaxed); }
+    // Zero before any measurement; negative if the click never came back
+    float getRoundTripMs() const noexcept       { return roundTripMs.load(std::memory_order_relaxed); }
+
+private:
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static_assert(maxBands % Lanes::SIZE == 0 && minBands % Lanes::SIZE == 0, "bands must fill whole registers");
+
+    static constexpr int numStages = 2;
+    static constexpr int chunkSize = 64;
+
+    // Transposed direct form II state for one signal through every band
+    struct BandStates
+    {
+        alignas(32) std::array<float, maxBands> z1[numStages] {};
+        alignas(32) std::array<float, maxBands> z2[numStages] {};
+    };
+
+    void applyParameters() noexcept;
+    void processChunk(const float* modulator, float* left, float* right, int numSamples) noexcept;
+    void updateProbe(const float* modulator, float* left, float* right, int numSamples) noexcept;
+
+    std::atomic<int> requestedBands { 24 };
+    std::atomic<float> requestedMix { 0.0f };
+    std::atomic<float> requestedInputGainDb { 12.0f };
+
+    double sampleRate = 44100.0;
+    int numBands = 0;
+    int numRegisters = 0;
+    float makeupGain = 1.0f;
+    float inputGain = 1.0f;
+    float attackCoefficient = 1.0f;
+    float releaseMultiplier = 0.0f;
+    juce::SmoothedValue<float> mixSmoothed;
+    bool engaged = false;
+
+    // Band-pass coefficients, normalised: b1 = 0 and b2 = -b0
+    alignas(32) std::array<float, maxBands> b0 {};
+    alignas(32) std::array<float, maxBands> a1 {};
+    alignas(32) std::array<float, maxBands> a2 {};
+
+    BandStates analysis, carrierL, carrierR;
+    alignas(32) std::array<float, maxBands> peaks {};
+    alignas(32) std::array<float, maxBands> envelopes {};
+    alignas(32) std::array<float, chunkSize * Lanes::SIZE> sumsL {};
+    alignas(32) std::array<float, chunkSize * Lanes::SIZE> sumsR {};
+
+    // Loopback probe
+    std::atomic<bool> roundTripRequested { false };
+    std::atomic<bool> probeWaiting { false };
+    std::atomic<float> roundTripMs { 0.0f };
+    juce::int64 probeElapsed = 0;
+
+    friend class ChannelVocoderTests;
+};
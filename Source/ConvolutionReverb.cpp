@@ -0,0 +1,445 @@
+#include "ConvolutionReverb.h"
+
+namespace
+{
+    constexpr double maxImpulseSeconds = 20.0;
+    constexpr float trimThreshold = 1.0e-6f;
+    constexpr double mixRampSeconds = 0.05;
+}
+
+//==============================================================================
+ConvolutionReverb::ConvolutionReverb()
+    : juce::Thread("Convolution tail")
+{
+    // The worker's own buffers, so neither starting it nor resetting allocates
+    fftBuffer.assign((size_t)fftSize * 2, 0.0f);
+    accumulator.assign((size_t)numBins, {});
+    previousInput.assign(2, std::vector<float>((size_t)tailPartitionSize, 0.0f));
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    loaderPool.removeAllJobs(true, 5000);
+    stopThread(2000);
+    delete pendingKernel.exchange(nullptr);
+}
+
+void ConvolutionReverb::prepare(double sampleRate, int maximumBlockSize)
+{
+    const bool rateChanged = sampleRate != currentSampleRate;
+    currentSampleRate = sampleRate;
+
+    // The head is only prepared again for a longer block. Its impulse
+    // response is resampled here, so a new rate just reloads the file.
+    if (headSampleRate == 0.0 || maximumBlockSize > maxBlockSize)
+    {
+        maxBlockSize = juce::jmax(1, maximumBlockSize, maxBlockSize);
+        headSampleRate = sampleRate;
+
+        juce::dsp::ProcessSpec spec;
+        spec.sampleRate = sampleRate;
+        spec.maximumBlockSize = (juce::uint32)maxBlockSize;
+        spec.numChannels = 2;
+        head.prepare(spec);
+        wetBuffer.setSize(2, maxBlockSize);
+    }
+
+    mixSmoothed.reset(sampleRate, mixRampSeconds);
+    reset();
+
+    if (!isThreadRunning())
+        startThread(juce::Thread::Priority::high);
+
+    if (rateChanged)
+    {
+        juce::File file;
+        {
+            const juce::ScopedLock sl(fileLock);
+            file = currentIrFile;
+        }
+
+        if (file.existsAsFile())
+            loadImpulseResponse(file);
+    }
+}
+
+void ConvolutionReverb::reset()
+{
+    head.reset();
+    mixSmoothed.setCurrentAndTargetValue(0.0f);
+    engaged = false;
+    staleTailSamples = 0;
+    tailDeficit = 0;
+
+    {
+        const juce::ScopedLock sl(workerLock);
+        inputFifo.reset();
+        outputFifo.reset();
+        inputRing.clear();
+        outputRing.clear();
+
+        // Pre-roll the tail path by the head length so the worker's output lines up
+        // with impulse response sample headLength
+        int start1, size1, start2, size2;
+        outputFifo.prepareToWrite(headLength, start1, size1, start2, size2);
+        outputFifo.finishedWrite(size1 + size2);
+    }
+
+    clearTailHistory.store(true);
+    notify();
+}
+
+juce::String ConvolutionReverb::getImpulseResponseName() const
+{
+    const juce::ScopedLock sl(fileLock);
+    return currentIrFile.getFileNameWithoutExtension();
+}
+
+//==============================================================================
+void ConvolutionReverb::loadImpulseResponse(const juce::File& wavFile)
+{
+    {
+        const juce::ScopedLock sl(fileLock);
+        currentIrFile = wavFile;
+    }
+
+    const double sampleRate = currentSampleRate;
+    const double headRate = headSampleRate > 0.0 ? headSampleRate : sampleRate;
+    loaderPool.addJob([this, wavFile, sampleRate, headRate] { loadOnBackgroundThread(wavFile, sampleRate, headRate); });
+}
+
+void ConvolutionReverb::loadOnBackgroundThread(const juce::File& wavFile, double sampleRate, double headRate)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(wavFile));
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        return;
+
+    const int fileLength = (int)juce::jmin(reader->lengthInSamples, (juce::int64)(reader->sampleRate * maxImpulseSeconds));
+    juce::AudioBuffer<float> ir(2, fileLength);
+    reader->read(&ir, 0, fileLength, 0, true, true);
+
+    if (reader->sampleRate != sampleRate)
+    {
+        const double ratio = reader->sampleRate / sampleRate;
+        const int resampledLength = juce::jmax(1, (int)((double)(fileLength - 4) / ratio));
+        juce::AudioBuffer<float> resampled(2, resampledLength);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, ir.getReadPointer(ch), resampled.getWritePointer(ch), resampledLength);
+        }
+
+        ir = std::move(resampled);
+    }
+
+    // Drop trailing silence so it doesn't cost tail partitions
+    int length = ir.getNumSamples();
+    while (length > 1 && std::abs(ir.getSample(0, length - 1)) < trimThreshold
+                      && std::abs(ir.getSample(1, length - 1)) < trimThreshold)
+        --length;
+
+    // Unit energy on the louder channel keeps wet level comparable across IRs
+    double maxEnergy = 0.0;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        double energy = 0.0;
+        const auto* d = ir.getReadPointer(ch);
+        for (int i = 0; i < length; ++i)
+            energy += (double)d[i] * (double)d[i];
+        maxEnergy = juce::jmax(maxEnergy, energy);
+    }
+
+    if (maxEnergy <= 0.0)
+        return;
+
+    ir.setSize(2, length, true);
+    ir.applyGain((float)(1.0 / std::sqrt(maxEnergy)));
+
+    juce::AudioBuffer<float> headIr(2, juce::jmin(headLength, length));
+    for (int ch = 0; ch < 2; ++ch)
+        headIr.copyFrom(ch, 0, ir, ch, 0, headIr.getNumSamples());
+
+    // Already at the engine rate; given as the head's prepared rate so it isn't resampled again
+    head.loadImpulseResponse(std::move(headIr), headRate,
+        juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::no);
+
+    // Any kernel the worker hasn't picked up yet is simply replaced
+    delete pendingKernel.exchange(buildTailKernel(ir).release(), std::memory_order_acq_rel);
+
+    irLengthSamples.store(length, std::memory_order_relaxed);
+    irLoaded.store(true, std::memory_order_release);
+    notify();
+}
+
+std::unique_ptr<ConvolutionReverb::TailKernel> ConvolutionReverb::buildTailKernel(const juce::AudioBuffer<float>& ir) const
+{
+    auto kernel = std::make_unique<TailKernel>();
+    kernel->numChannels = ir.getNumChannels();
+
+    const int tailLength = ir.getNumSamples() - headLength;
+    if (tailLength <= 0)
+        return kernel;
+
+    kernel->numPartitions = (tailLength + tailPartitionSize - 1) / tailPartitionSize;
+
+    juce::dsp::FFT loaderFft(fftOrder);
+    std::vector<float> buffer((size_t)fftSize * 2);
+
+    for (int ch = 0; ch < kernel->numChannels; ++ch)
+    {
+        auto& spectra = kernel->spectra.emplace_back((size_t)(kernel->numPartitions * numBins));
+
+        for (int p = 0; p < kernel->numPartitions; ++p)
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            const int start = headLength + p * tailPartitionSize;
+            const int count = juce::jmin(tailPartitionSize, ir.getNumSamples() - start);
+            std::copy(ir.getReadPointer(ch, start), ir.getReadPointer(ch, start) + count, buffer.begin());
+
+            loaderFft.performRealOnlyForwardTransform(buffer.data(), true);
+            const auto* bins = reinterpret_cast<const std::complex<float>*>(buffer.data());
+            std::copy(bins, bins + numBins, spectra.begin() + p * numBins);
+        }
+    }
+
+    return kernel;
+}
+
+//==============================================================================
+void ConvolutionReverb::run()
+{
+    threadResult = Realtime::configureWorkerThread();
+    threadConfigured.store(true, std::memory_order_release);
+
+    // Woken by a queued partition, a new kernel or reset(); otherwise asleep
+    while (!threadShouldExit())
+    {
+        {
+            const juce::ScopedLock sl(workerLock);
+            adoptPendingKernel();
+
+            if (clearTailHistory.exchange(false))
+            {
+                for (auto& line : frequencyDelayLine)
+                    std::fill(line.begin(), line.end(), std::complex<float>());
+                for (auto& prev : previousInput)
+                    std::fill(prev.begin(), prev.end(), 0.0f);
+                delayLineSlot = 0;
+            }
+
+            while (inputFifo.getNumReady() >= tailPartitionSize
+                   && outputFifo.getFreeSpace() >= tailPartitionSize
+                   && !threadShouldExit())
+                processTailPartition();
+        }
+
+        wait(-1);
+    }
+}
+
+void ConvolutionReverb::adoptPendingKernel()
+{
+    if (auto* kernel = pendingKernel.exchange(nullptr, std::memory_order_acq_rel))
+    {
+        activeKernel.reset(kernel);
+
+        const int partitions = juce::jmax(1, activeKernel->numPartitions);
+        frequencyDelayLine.assign(2, std::vector<std::complex<float>>((size_t)(partitions * numBins)));
+        for (auto& prev : previousInput)
+            std::fill(prev.begin(), prev.end(), 0.0f);
+        delayLineSlot = 0;
+    }
+}
+
+void ConvolutionReverb::processTailPartition()
+{
+    float current[2][tailPartitionSize];
+
+    int start1, size1, start2, size2;
+    inputFifo.prepareToRead(tailPartitionSize, start1, size1, start2, size2);
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        std::copy(inputRing.getReadPointer(ch, start1), inputRing.getReadPointer(ch, start1) + size1, current[ch]);
+        if (size2 > 0)
+            std::copy(inputRing.getReadPointer(ch, start2), inputRing.getReadPointer(ch, start2) + size2, current[ch] + size1);
+    }
+    inputFifo.finishedRead(size1 + size2);
+
+    const bool hasTail = activeKernel != nullptr && activeKernel->numPartitions > 0;
+    const int numPartitions = hasTail ? activeKernel->numPartitions : 0;
+
+    outputFifo.prepareToWrite(tailPartitionSize, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const float* result = nullptr;
+
+        if (hasTail)
+        {
+            // Overlap-save: previous block followed by the current block
+            std::copy(previousInput[(size_t)ch].begin(), previousInput[(size_t)ch].end(), fftBuffer.begin());
+            std::copy(current[ch], current[ch] + tailPartitionSize, fftBuffer.begin() + tailPartitionSize);
+            std::fill(fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+
+            fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+            auto* spectrum = reinterpret_cast<std::complex<float>*>(fftBuffer.data());
+
+            auto& line = frequencyDelayLine[(size_t)ch];
+            std::copy(spectrum, spectrum + numBins, line.begin() + delayLineSlot * numBins);
+
+            std::fill(accumulator.begin(), accumulator.end(), std::complex<float>());
+            const auto& kernelSpectra = activeKernel->spectra[(size_t)juce::jmin(ch, activeKernel->numChannels - 1)];
+
+            for (int p = 0; p < numPartitions; ++p)
+            {
+                const int slot = (delayLineSlot - p + numPartitions) % numPartitions;
+                const auto* x = line.data() + slot * numBins;
+                const auto* h = kernelSpectra.data() + p * numBins;
+
+                for (int b = 0; b < numBins; ++b)
+                    accumulator[(size_t)b] += x[b] * h[b];
+            }
+
+            std::copy(accumulator.begin(), accumulator.end(), spectrum);
+            std::fill(spectrum + numBins, spectrum + fftSize, std::complex<float>());
+            fft.performRealOnlyInverseTransform(fftBuffer.data());
+
+            result = fftBuffer.data() + tailPartitionSize;
+        }
+
+        auto* ring = outputRing.getWritePointer(ch);
+        if (result != nullptr)
+        {
+            std::copy(result, result + size1, ring + start1);
+            std::copy(result + size1, result + size1 + size2, ring + start2);
+        }
+        else
+        {
+            std::fill(ring + start1, ring + start1 + size1, 0.0f);
+            std::fill(ring + start2, ring + start2 + size2, 0.0f);
+        }
+
+        std::copy(current[ch], current[ch] + tailPartitionSize, previousInput[(size_t)ch].begin());
+    }
+
+    outputFifo.finishedWrite(size1 + size2);
+
+    if (hasTail)
+        delayLineSlot = (delayLineSlot + 1) % numPartitions;
+}
+
+//==============================================================================
+void ConvolutionReverb::process(float* left, float* right, int numSamples)
+{
+    if (!hasImpulseResponse())
+        return;
+
+    if (mixSmoothed.getTargetValue() <= 0.0f && !mixSmoothed.isSmoothing())
+    {
+        engaged = false;
+        return;
+    }
+
+    if (!engaged)
+    {
+        // Whatever is queued in the tail path predates the bypass, so it is
+        // muted rather than played back on re-engage
+        engaged = true;
+        head.reset();
+        staleTailSamples = outputFifo.getNumReady() + tailPartitionSize;
+        clearTailHistory.store(true);
+    }
+
+    for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+        processChunk(left + offset, right != nullptr ? right + offset : nullptr,
+            juce::jmin(maxBlockSize, numSamples - offset));
+}
+
+void ConvolutionReverb::processChunk(float* left, float* right, int numSamples)
+{
+    auto* wetL = wetBuffer.getWritePointer(0);
+    auto* wetR = wetBuffer.getWritePointer(1);
+    juce::FloatVectorOperations::copy(wetL, left, numSamples);
+    juce::FloatVectorOperations::copy(wetR, right != nullptr ? right : left, numSamples);
+
+    pushTailInput(wetL, wetR, numSamples);
+
+    juce::dsp::AudioBlock<float> block(wetBuffer);
+    auto subBlock = block.getSubBlock(0, (size_t)numSamples);
+    head.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+
+    addTailOutput(wetL, wetR, numSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float mix = mixSmoothed.getNextValue();
+        left[i] = left[i] * (1.0f - mix) + wetL[i] * mix;
+        if (right != nullptr)
+            right[i] = right[i] * (1.0f - mix) + wetR[i] * mix;
+    }
+}
+
+void ConvolutionReverb::pushTailInput(const float* left, const float* right, int numSamples)
+{
+    const int toWrite = juce::jmin(numSamples, inputFifo.getFreeSpace());
+
+    int start1, size1, start2, size2;
+    inputFifo.prepareToWrite(toWrite, start1, size1, start2, size2);
+    inputRing.copyFrom(0, start1, left, size1);
+    inputRing.copyFrom(1, start1, right, size1);
+    if (size2 > 0)
+    {
+        inputRing.copyFrom(0, start2, left + size1, size2);
+        inputRing.copyFrom(1, start2, right + size1, size2);
+    }
+    inputFifo.finishedWrite(size1 + size2);
+
+    if (toWrite < numSamples)
+        droppedTailSamples.fetch_add(numSamples - toWrite, std::memory_order_relaxed);
+
+    if (inputFifo.getNumReady() >= tailPartitionSize)
+        notify();
+}
+
+void ConvolutionReverb::addTailOutput(float* left, float* right, int numSamples)
+{
+    // Samples the worker delivered late are thrown away to keep the tail aligned
+    if (tailDeficit > 0)
+    {
+        const int discard = juce::jmin(tailDeficit, outputFifo.getNumReady());
+        outputFifo.finishedRead(discard);
+        tailDeficit -= discard;
+    }
+
+    const int toRead = juce::jmin(numSamples, outputFifo.getNumReady());
+
+    int start1, size1, start2, size2;
+    outputFifo.prepareToRead(toRead, start1, size1, start2, size2);
+
+    auto addRange = [this, left, right](int ringStart, int destStart, int count)
+    {
+        const int skip = juce::jmin(count, staleTailSamples);
+        staleTailSamples -= skip;
+        if (count - skip > 0)
+        {
+            juce::FloatVectorOperations::add(left + destStart + skip, outputRing.getReadPointer(0, ringStart + skip), count - skip);
+            juce::FloatVectorOperations::add(right + destStart + skip, outputRing.getReadPointer(1, ringStart + skip), count - skip);
+        }
+    };
+
+    addRange(start1, 0, size1);
+    if (size2 > 0)
+        addRange(start2, size1, size2);
+
+    outputFifo.finishedRead(size1 + size2);
+
+    if (toRead < numSamples)
+    {
+        tailDeficit += numSamples - toRead;
+        droppedTailSamples.fetch_add(numSamples - toRead, std::memory_order_relaxed);
+    }
+}
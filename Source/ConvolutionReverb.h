@@ -0,0 +1,126 @@
+#pragma once
+#include <JuceHeader.h>
+#include "RealtimeOptions.h"
+#include <complex>
+#include <vector>
+
+// Two-stage partitioned convolution reverb.
+//
+// The first headLength samples of the impulse response run in the audio
+// callback through a zero-latency juce::dsp::Convolution. The remainder (the
+// tail) is convolved in large uniform partitions on a background thread. The
+// tail path is fed and drained through lock-free FIFOs that are offset by
+// exactly headLength samples, so the worker has roughly headLength - partition
+// samples of slack before its output is due. The worker sleeps until the audio
+// thread queues a whole partition, so it costs nothing while bypassed.
+//
+// Impulse responses are read and partitioned on a loader thread and handed to
+// the worker through an atomic pointer; nothing is allocated or freed on the
+// audio thread.
+class ConvolutionReverb : private juce::Thread
+{
+public:
+    ConvolutionReverb();
+    ~ConvolutionReverb() override;
+
+    // Longer blocks are processed in chunks of maximumBlockSize. Allocates,
+    // and starts the worker, the first time; after that only a longer block
+    // allocates.
+    void prepare(double sampleRate, int maximumBlockSize);
+    // Drops the wet signal and any tail in flight, keeping every buffer and
+    // the worker
+    void reset();
+
+    // Message thread: reads the file and swaps it in asynchronously
+    void loadImpulseResponse(const juce::File& wavFile);
+
+    // Audio thread
+    void setMix(float newMix) noexcept { mixSmoothed.setTargetValue(juce::jlimit(0.0f, 1.0f, newMix)); }
+    void process(float* left, float* right, int numSamples);
+
+    bool hasImpulseResponse() const noexcept   { return irLoaded.load(std::memory_order_acquire); }
+    int getTailLengthSamples() const noexcept  { return irLengthSamples.load(std::memory_order_relaxed); }
+    int getDroppedTailSamples() const noexcept { return droppedTailSamples.load(std::memory_order_relaxed); }
+    juce::String getImpulseResponseName() const;
+
+    // Scheduling the tail worker thread got from the worker real-time options
+    bool getThreadResult(RealtimeThreadResult& result) const noexcept
+    {
+        if (!threadConfigured.load(std::memory_order_acquire))
+            return false;
+        result = threadResult;
+        return true;
+    }
+
+    static constexpr int headLength = 8192;
+    static constexpr int tailPartitionSize = 2048;
+
+private:
+    struct TailKernel
+    {
+        int numChannels = 0;
+        int numPartitions = 0;
+        // [channel][partition * numBins + bin]
+        std::vector<std::vector<std::complex<float>>> spectra;
+    };
+
+    static constexpr int fftOrder = 12; // 2 * tailPartitionSize
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int fifoSize = headLength * 4;
+
+    void run() override;
+    void loadOnBackgroundThread(const juce::File& wavFile, double sampleRate, double headRate);
+    std::unique_ptr<TailKernel> buildTailKernel(const juce::AudioBuffer<float>& ir) const;
+    void adoptPendingKernel();
+    void processTailPartition();
+
+    void processChunk(float* left, float* right, int numSamples);
+    void pushTailInput(const float* left, const float* right, int numSamples);
+    void addTailOutput(float* left, float* right, int numSamples);
+
+    // Audio thread
+    juce::dsp::Convolution head;
+    juce::AudioBuffer<float> wetBuffer;
+    juce::SmoothedValue<float> mixSmoothed;
+    int maxBlockSize = 512;
+    double headSampleRate = 0.0;    // what head was prepared at
+    bool engaged = false;
+    int staleTailSamples = 0;
+    int tailDeficit = 0;
+
+    // Audio thread -> worker and back. The worker holds workerLock while it
+    // works through the FIFOs, so reset() can clear them without stopping it.
+    juce::CriticalSection workerLock;
+    juce::AbstractFifo inputFifo { fifoSize };
+    juce::AbstractFifo outputFifo { fifoSize };
+    juce::AudioBuffer<float> inputRing { 2, fifoSize };
+    juce::AudioBuffer<float> outputRing { 2, fifoSize };
+    std::atomic<bool> clearTailHistory { false };
+
+    // Worker thread
+    std::atomic<bool> threadConfigured { false };
+    RealtimeThreadResult threadResult;
+    juce::dsp::FFT fft { fftOrder };
+    std::unique_ptr<TailKernel> activeKernel;
+    std::vector<std::vector<std::complex<float>>> frequencyDelayLine;
+    std::vector<std::vector<float>> previousInput;
+    std::vector<float> fftBuffer;
+    std::vector<std::complex<float>> accumulator;
+    int delayLineSlot = 0;
+
+    // Loader -> worker
+    std::atomic<TailKernel*> pendingKernel { nullptr };
+
+    std::atomic<bool> irLoaded { false };
+    std::atomic<int> irLengthSamples { 0 };
+    std::atomic<int> droppedTailSamples { 0 };
+    double currentSampleRate = 44100.0;
+
+    juce::ThreadPool loaderPool { 1 };
+    juce::File currentIrFile;
+    juce::CriticalSection fileLock;
+
+    friend class ConvolutionReverbTests;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb)
+};
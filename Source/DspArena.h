@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+
+// One block of memory that a processor's delay lines and scratch buffers are
+// carved out of. It is reserved once for the worst case (reservedSampleRate
+// and the largest block the owner will use), so a later prepare at a new rate
+// just rewinds and lays the same memory out again.
+//
+// Every allocation is 64-byte aligned and zeroed. Asking for more than was
+// reserved is a sizing bug: it asserts and returns null.
+class DspArena
+{
+public:
+    // The highest rate buffers are reserved for up front. Higher rates still
+    // work, but reserving for them allocates again.
+    static constexpr double reservedSampleRate = 192000.0;
+
+    // Not the audio thread. Only allocates when numFloats is more than is
+    // already reserved, which invalidates every pointer handed out before.
+    void reserve(size_t numFloats)
+    {
+        if (numFloats > capacity)
+        {
+            storage.allocate(numFloats + alignmentFloats, false);
+            capacity = numFloats;
+        }
+        rewind();
+    }
+
+    // Forgets every allocation; the memory is reused by the next ones
+    void rewind() noexcept
+    {
+        const auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+        const auto misalignment = address % alignmentBytes;
+        base = storage.get() + (misalignment == 0 ? 0 : (alignmentBytes - misalignment) / sizeof(float));
+        used = 0;
+    }
+
+    float* allocate(size_t numFloats) noexcept
+    {
+        const auto size = getFootprint(numFloats);
+        if (base == nullptr || used + size > capacity)
+        {
+            jassertfalse;
+            return nullptr;
+        }
+
+        auto* block = base + used;
+        used += size;
+        juce::FloatVectorOperations::clear(block, (int)numFloats);
+        return block;
+    }
+
+    // What allocate(numFloats) takes out of the reservation
+    static constexpr size_t getFootprint(size_t numFloats) noexcept
+    {
+        return (numFloats + alignmentFloats - 1) / alignmentFloats * alignmentFloats;
+    }
+
+    size_t getCapacity() const noexcept     { return capacity; }
+
+private:
+    static constexpr size_t alignmentBytes = 64;
+    static constexpr size_t alignmentFloats = alignmentBytes / sizeof(float);
+
+    juce::HeapBlock<float> storage;
+    float* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+};
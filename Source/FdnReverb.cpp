@@ -0,0 +1,204 @@
+#include "FdnReverb.h"
+
+namespace
+{
+    // Mutually prime-ish line lengths at size 1.0
+    constexpr float baseDelayMs[FdnReverb::numLines] = { 31.7f, 37.3f, 41.9f, 47.1f, 53.3f, 59.9f, 67.1f, 73.7f };
+    constexpr float modRatesHz[FdnReverb::numLines]  = { 0.11f, 0.17f, 0.23f, 0.29f, 0.31f, 0.37f, 0.41f, 0.47f };
+    constexpr float inputGains[FdnReverb::numLines]  = { 0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f, 0.5f };
+
+    constexpr float minSizeScale = 0.35f;
+    constexpr float maxSizeScale = 1.6f;
+    constexpr float modDepthMs = 0.35f;
+    constexpr float maxDampingCoefficient = 0.85f;
+    constexpr double minDecaySeconds = 0.3;
+    constexpr double decayRange = 40.0;     // decay 1.0 -> 12 s T60
+    constexpr int renormaliseInterval = 4096;
+}
+
+//==============================================================================
+int FdnReverb::getLineLength(double rate) noexcept
+{
+    const double longest = baseDelayMs[numLines - 1] * 0.001 * maxSizeScale * rate + 2.0 * modDepthMs * 0.001 * rate + 4.0;
+    return juce::nextPowerOfTwo((int)std::ceil(longest));
+}
+
+size_t FdnReverb::getArenaFootprint(double rate) noexcept
+{
+    return DspArena::getFootprint((size_t)(getLineLength(rate) * numLines));
+}
+
+void FdnReverb::prepare(double newSampleRate, DspArena& arena)
+{
+    sampleRate = newSampleRate;
+
+    modDepthSamples = modDepthMs * 0.001f * (float)sampleRate;
+    lineLength = getLineLength(sampleRate);
+    lineMask = lineLength - 1;
+    lines = arena.allocate((size_t)(lineLength * numLines));
+    if (lines == nullptr)
+        lineLength = lineMask = 0;
+
+    for (int k = 0; k < numLines; ++k)
+    {
+        baseDelaySamples[k] = baseDelayMs[k] * 0.001f * (float)sampleRate;
+
+        const float startAngle = 0.7f * (float)k;
+        modCos[k] = std::cos(startAngle);
+        modSin[k] = std::sin(startAngle);
+
+        const float step = juce::MathConstants<float>::twoPi * modRatesHz[k] / (float)sampleRate;
+        modStepCos[k] = std::cos(step);
+        modStepSin[k] = std::sin(step);
+    }
+
+    sizeSmoothed.reset(sampleRate, 0.3);
+    mixSmoothed.reset(sampleRate, 0.05);
+    freezeSmoothed.reset(sampleRate, 0.05);
+    sizeSmoothed.setCurrentAndTargetValue(1.0f);
+    mixSmoothed.setCurrentAndTargetValue(0.0f);
+    freezeSmoothed.setCurrentAndTargetValue(0.0f);
+    currentDecay = -1.0f;
+    currentSize = -1.0f;
+
+    reset();
+}
+
+void FdnReverb::reset()
+{
+    if (lines != nullptr)
+        juce::FloatVectorOperations::clear(lines, lineLength * numLines);
+    std::fill(std::begin(lowpassState), std::end(lowpassState), 0.0f);
+    writeIndex = 0;
+}
+
+int FdnReverb::getTailLengthSamples() const noexcept
+{
+    return lineLength;
+}
+
+void FdnReverb::setParameters(float size, float decay, float damping, float mix, bool freeze)
+{
+    const float sizeScale = juce::jmap(juce::jlimit(0.0f, 1.0f, size), minSizeScale, maxSizeScale);
+    sizeSmoothed.setTargetValue(sizeScale);
+    mixSmoothed.setTargetValue(juce::jlimit(0.0f, 1.0f, mix));
+    freezeSmoothed.setTargetValue(freeze ? 1.0f : 0.0f);
+    frozen = freeze;
+    dampingCoefficient = juce::jmap(juce::jlimit(0.0f, 1.0f, damping), 0.0f, maxDampingCoefficient);
+
+    if (decay != currentDecay || sizeScale != currentSize)
+    {
+        currentDecay = juce::jlimit(0.0f, 1.0f, decay);
+        currentSize = sizeScale;
+        updateLoopGains();
+    }
+}
+
+void FdnReverb::updateLoopGains()
+{
+    // Per-line gain for -60 dB after T60 seconds, whatever the line length
+    const double t60 = minDecaySeconds * std::pow(decayRange, (double)currentDecay);
+    for (int k = 0; k < numLines; ++k)
+    {
+        const double lengthSamples = (double)baseDelaySamples[k] * (double)currentSize;
+        loopGain[k] = (float)std::pow(10.0, -3.0 * lengthSamples / (t60 * sampleRate));
+    }
+}
+
+void FdnReverb::renormaliseModulators()
+{
+    for (int k = 0; k < numLines; ++k)
+    {
+        const float norm = 1.0f / std::sqrt(modCos[k] * modCos[k] + modSin[k] * modSin[k]);
+        modCos[k] *= norm;
+        modSin[k] *= norm;
+    }
+}
+
+//==============================================================================
+void FdnReverb::processSample(float& left, float& right) noexcept
+{
+    if (lines == nullptr || (mixSmoothed.getTargetValue() <= 0.0f && !mixSmoothed.isSmoothing() && !frozen))
+    {
+        // Drop the old tail once so re-engaging starts from silence
+        if (active)
+        {
+            reset();
+            active = false;
+        }
+        return;
+    }
+    active = true;
+
+    const float scale = sizeSmoothed.getNextValue();
+    const float mix = mixSmoothed.getNextValue();
+    const float freeze = freezeSmoothed.getNextValue();
+
+    alignas(32) float taps[numLines];
+    for (int k = 0; k < numLines; ++k)
+    {
+        const float delay = baseDelaySamples[k] * scale + modDepthSamples * (1.0f + modSin[k]);
+        const float readPos = (float)writeIndex - delay;
+        const float base = std::floor(readPos);
+        const float frac = readPos - base;
+        const int i0 = (int)base;
+
+        const float a = lines[(size_t)((i0 & lineMask) * numLines + k)];
+        const float b = lines[(size_t)(((i0 + 1) & lineMask) * numLines + k)];
+        taps[k] = a + frac * (b - a);
+    }
+
+    // Damping, loop gain and the Householder reflection (I - 2/N * 11^T) in SIMD lanes
+    const Vec one = Vec::expand(1.0f);
+    const Vec freezeVec = Vec::expand(freeze);
+    const Vec damp = Vec::expand(dampingCoefficient * (1.0f - freeze));
+
+    Vec shaped[numVecs];
+    Vec total = Vec::expand(0.0f);
+    for (int v = 0; v < numVecs; ++v)
+    {
+        const Vec x = Vec::fromRawArray(taps + v * lanes);
+        Vec lp = Vec::fromRawArray(lowpassState + v * lanes);
+        lp = x + (lp - x) * damp;
+        lp.copyToRawArray(lowpassState + v * lanes);
+
+        Vec g = Vec::fromRawArray(loopGain + v * lanes);
+        g = g + (one - g) * freezeVec;
+
+        shaped[v] = lp * g;
+        total += shaped[v];
+    }
+
+    const Vec reflection = Vec::expand(total.sum() * (2.0f / (float)numLines));
+    alignas(32) float feedback[numLines];
+    for (int v = 0; v < numVecs; ++v)
+        (shaped[v] - reflection).copyToRawArray(feedback + v * lanes);
+
+    const float input = 0.5f * (left + right) * (1.0f - freeze);
+    float* frame = lines + writeIndex * numLines;
+    for (int k = 0; k < numLines; ++k)
+        frame[k] = feedback[k] + input * inputGains[k];
+    writeIndex = (writeIndex + 1) & lineMask;
+
+    // Quadrature line modulators, rotated in place
+    for (int v = 0; v < numVecs; ++v)
+    {
+        const Vec c = Vec::fromRawArray(modCos + v * lanes);
+        const Vec s = Vec::fromRawArray(modSin + v * lanes);
+        const Vec sc = Vec::fromRawArray(modStepCos + v * lanes);
+        const Vec ss = Vec::fromRawArray(modStepSin + v * lanes);
+        (c * sc - s * ss).copyToRawArray(modCos + v * lanes);
+        (s * sc + c * ss).copyToRawArray(modSin + v * lanes);
+    }
+
+    if (++samplesSinceRenormalise >= renormaliseInterval)
+    {
+        samplesSinceRenormalise = 0;
+        renormaliseModulators();
+    }
+
+    const float wetL = 0.5f * (taps[0] - taps[2] + taps[4] - taps[6]);
+    const float wetR = 0.5f * (taps[1] - taps[3] + taps[5] - taps[7]);
+    left = left * (1.0f - mix) + wetL * mix;
+    right = right * (1.0f - mix) + wetR * mix;
+}
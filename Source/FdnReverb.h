@@ -0,0 +1,66 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DspArena.h"
+
+// Eight-line feedback delay network reverb.
+//
+// Lines are stored interleaved so every line is written at the same index each
+// sample. Damping, decay gain, the Householder feedback matrix and the line
+// modulators all run on juce::dsp::SIMDRegister lanes; only the fractional
+// line reads are scalar. The matrix is orthogonal and every loop gain is below
+// one, so the network cannot blow up at any setting. Freeze raises the loop
+// gain to exactly one and mutes the input.
+class FdnReverb
+{
+public:
+    static constexpr int numLines = 8;
+
+    // The lines are taken from arena, which needs getArenaFootprint(sampleRate) free
+    void prepare(double sampleRate, DspArena& arena);
+    void reset();
+    static size_t getArenaFootprint(double sampleRate) noexcept;
+
+    // Audio thread, once per block. All values are 0..1.
+    void setParameters(float size, float decay, float damping, float mix, bool freeze);
+
+    // Audio thread
+    void processSample(float& left, float& right) noexcept;
+
+    bool isFrozen() const noexcept        { return frozen; }
+    int getTailLengthSamples() const noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int)Vec::SIMDNumElements;
+    static constexpr int numVecs = numLines / lanes;
+    static_assert(numLines % lanes == 0, "Line count must fill whole SIMD registers");
+
+    static int getLineLength(double sampleRate) noexcept;
+    void updateLoopGains();
+    void renormaliseModulators();
+
+    double sampleRate = 44100.0;
+    float* lines = nullptr;     // [position * numLines + line], owned by the arena
+    int lineLength = 0;
+    int lineMask = 0;
+    int writeIndex = 0;
+
+    alignas(32) float baseDelaySamples[numLines] {};
+    alignas(32) float lowpassState[numLines] {};
+    alignas(32) float loopGain[numLines] {};
+    alignas(32) float modCos[numLines] {};
+    alignas(32) float modSin[numLines] {};
+    alignas(32) float modStepCos[numLines] {};
+    alignas(32) float modStepSin[numLines] {};
+
+    juce::SmoothedValue<float> sizeSmoothed;
+    juce::SmoothedValue<float> mixSmoothed;
+    juce::SmoothedValue<float> freezeSmoothed;
+    float currentDecay = -1.0f;
+    float currentSize = -1.0f;
+    float dampingCoefficient = 0.0f;
+    float modDepthSamples = 0.0f;
+    bool frozen = false;
+    bool active = false;
+    int samplesSinceRenormalise = 0;
+};
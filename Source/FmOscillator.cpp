@@ -0,0 +1,229 @@
+#include "FmOscillator.h"
+
+namespace
+{
+    constexpr int sineTableSize = 4096;
+    constexpr float maxModulationCycles = 2.0f;
+    constexpr float maxFeedbackCycles = 0.25f;
+
+    const std::array<float, sineTableSize + 1>& getSineTable()
+    {
+        static const auto table = []
+        {
+            std::array<float, sineTableSize + 1> t {};
+            for (int i = 0; i <= sineTableSize; ++i)
+                t[(size_t)i] = (float)std::sin(juce::MathConstants<double>::twoPi * i / sineTableSize);
+            return t;
+        }();
+        return table;
+    }
+
+    // modulators[op] is a bitmask of the operators feeding op; every
+    // modulator has a higher index than its target
+    struct Route
+    {
+        const char* name;
+        std::array<int, FmOscillator::numOperators> modulators;
+        int carriers;
+    };
+
+    constexpr Route routes[FmOscillator::numAlgorithms] =
+    {
+        { "Stack",         { 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 0 },       1 << 0 },
+        { "Two stacks",    { 1 << 1, 1 << 2, 0, 1 << 4, 1 << 5, 0 },            (1 << 0) | (1 << 3) },
+        { "Three pairs",   { 1 << 1, 0, 1 << 3, 0, 1 << 5, 0 },                 (1 << 0) | (1 << 2) | (1 << 4) },
+        { "Tree",          { (1 << 1) | (1 << 3), 1 << 2, 0, (1 << 4) | (1 << 5), 0, 0 }, 1 << 0 },
+        { "Bell",          { (1 << 1) | (1 << 2), 0, 0, 1 << 4, 1 << 5, 0 },    (1 << 0) | (1 << 3) },
+        { "Fan",           { 1 << 5, 1 << 5, 1 << 5, 1 << 5, 1 << 5, 0 },       0x1f },
+        { "Stack + organ", { 1 << 1, 1 << 2, 0, 0, 0, 0 },                      (1 << 0) | (1 << 3) | (1 << 4) | (1 << 5) },
+        { "Organ",         { 0, 0, 0, 0, 0, 0 },                                0x3f }
+    };
+}
+
+//==============================================================================
+FmOscillator::FmOscillator()
+{
+    // Build the shared table here rather than on the first audio callback
+    getSineTable();
+}
+
+void FmOscillator::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void FmOscillator::setSampleRate(double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+
+    // Envelope rates are per sample
+    for (int op = 0; op < numOperators; ++op)
+        updateStageTargets(op);
+}
+
+void FmOscillator::reset()
+{
+    phases.fill(0.0f);
+    envelopes.fill(0.0f);
+    envTargets.fill(0.0f);
+    envRates.fill(0.0f);
+    gains.fill(0.0f);
+    stages.fill(Stage::idle);
+    outputs.fill(0.0f);
+    feedbackHistory[0] = feedbackHistory[1] = 0.0f;
+}
+
+void FmOscillator::setParameters(int newAlgorithm, float feedback, float depth, const Operators& operators)
+{
+    algorithm = juce::jlimit(0, numAlgorithms - 1, newAlgorithm);
+    feedbackAmount = juce::jlimit(0.0f, 1.0f, feedback);
+    modulationDepth = juce::jmax(0.0f, depth);
+    params = operators;
+
+    const int carriers = routes[algorithm].carriers;
+    for (int op = 0; op < numOperators; ++op)
+    {
+        const auto& p = params[(size_t)op];
+        const bool isCarrier = (carriers & (1 << op)) != 0;
+        ratios[(size_t)op] = juce::jlimit(0.125f, 16.0f, p.ratio);
+        levels[(size_t)op] = juce::jlimit(0.0f, 1.0f, p.level) * (isCarrier ? 1.0f : modulationDepth);
+
+        // Release keeps the slope it started with
+        if (stages[(size_t)op] != Stage::release)
+            updateStageTargets(op);
+    }
+}
+
+void FmOscillator::noteOn() noexcept
+{
+    phases.fill(0.0f);
+    feedbackHistory[0] = feedbackHistory[1] = 0.0f;
+
+    for (int op = 0; op < numOperators; ++op)
+    {
+        stages[(size_t)op] = Stage::attack;
+        updateStageTargets(op);
+    }
+}
+
+void FmOscillator::noteOff() noexcept
+{
+    for (int op = 0; op < numOperators; ++op)
+    {
+        if (stages[(size_t)op] == Stage::idle || stages[(size_t)op] == Stage::release)
+            continue;
+
+        stages[(size_t)op] = Stage::release;
+        updateStageTargets(op);
+    }
+}
+
+void FmOscillator::updateStageTargets(int op) noexcept
+{
+    const auto& p = params[(size_t)op];
+    const auto msToSamples = [this](float ms) { return juce::jmax(1.0f, ms * 0.001f * (float)sampleRate); };
+    const float sustain = juce::jlimit(0.0f, 1.0f, p.sustain);
+    auto& target = envTargets[(size_t)op];
+    auto& rate = envRates[(size_t)op];
+
+    switch (stages[(size_t)op])
+    {
+        case Stage::attack:  target = 1.0f;    rate = 1.0f / msToSamples(p.attackMs); break;
+        case Stage::decay:
+        case Stage::sustain: target = sustain; rate = juce::jmax(1.0e-6f, 1.0f - sustain) / msToSamples(p.decayMs); break;
+        case Stage::release: target = 0.0f;    rate = juce::jmax(1.0e-6f, envelopes[(size_t)op]) / msToSamples(p.releaseMs); break;
+        case Stage::idle:    target = 0.0f;    rate = 0.0f; break;
+    }
+}
+
+float FmOscillator::lookupSine(float phase) const noexcept
+{
+    const auto& table = getSineTable();
+    phase -= std::floor(phase);
+    const float index = phase * (float)sineTableSize;
+    const int i0 = juce::jmin(sineTableSize - 1, (int)index);
+    const float frac = index - (float)i0;
+    return table[(size_t)i0] + frac * (table[(size_t)i0 + 1] - table[(size_t)i0]);
+}
+
+//==============================================================================
+float FmOscillator::renderSample(float phaseInc) noexcept
+{
+    const Lanes baseInc(phaseInc / juce::MathConstants<float>::twoPi);
+    const Lanes zero(0.0f);
+
+    for (size_t k = 0; k < (size_t)numLanes; k += Lanes::SIZE)
+    {
+        (Lanes::fromRawArray(phases.data() + k) + Lanes::fromRawArray(ratios.data() + k) * baseInc).copyToRawArray(phases.data() + k);
+
+        // Linear segments: move toward the target by at most the stage rate
+        auto env = Lanes::fromRawArray(envelopes.data() + k);
+        const auto rate = Lanes::fromRawArray(envRates.data() + k);
+        const auto delta = Lanes::fromRawArray(envTargets.data() + k) - env;
+        env = env + Lanes::max(zero - rate, Lanes::min(rate, delta));
+        env.copyToRawArray(envelopes.data() + k);
+
+        (Lanes::fromRawArray(levels.data() + k) * env).copyToRawArray(gains.data() + k);
+    }
+
+    // A high ratio on a high note can step more than a whole cycle, so wrap
+    // by the whole part rather than subtracting one
+    for (auto& phase : phases)
+        phase -= std::floor(phase);
+
+    for (int op = 0; op < numOperators; ++op)
+    {
+        auto& stage = stages[(size_t)op];
+        const float env = envelopes[(size_t)op];
+
+        if (stage == Stage::attack && env >= 1.0f)
+        {
+            stage = Stage::decay;
+            updateStageTargets(op);
+        }
+        else if (stage == Stage::decay && env <= envTargets[(size_t)op])
+        {
+            stage = Stage::sustain;
+        }
+        else if (stage == Stage::release && env <= 0.0f)
+        {
+            stage = Stage::idle;
+            updateStageTargets(op);
+        }
+    }
+
+    const auto& route = routes[algorithm];
+    float sum = 0.0f;
+    int numCarriers = 0;
+
+    for (int op = numOperators - 1; op >= 0; --op)
+    {
+        float modulation = 0.0f;
+        for (int m = op + 1; m < numOperators; ++m)
+            if ((route.modulators[(size_t)op] & (1 << m)) != 0)
+                modulation += outputs[(size_t)m];
+
+        float opPhase = phases[(size_t)op] + modulation * maxModulationCycles;
+        if (op == numOperators - 1)
+            opPhase += feedbackAmount * maxFeedbackCycles * (feedbackHistory[0] + feedbackHistory[1]);
+
+        outputs[(size_t)op] = lookupSine(opPhase) * gains[(size_t)op];
+
+        if ((route.carriers & (1 << op)) != 0)
+        {
+            sum += outputs[(size_t)op];
+            ++numCarriers;
+        }
+    }
+
+    feedbackHistory[1] = feedbackHistory[0];
+    feedbackHistory[0] = outputs[numOperators - 1];
+
+    return numCarriers > 1 ? sum / (float)numCarriers : sum;
+}
+
+juce::String FmOscillator::getAlgorithmName(int index)
+{
+    return juce::String(index + 1) + ": " + routes[juce::jlimit(0, numAlgorithms - 1, index)].name;
+}
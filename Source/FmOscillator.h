@@ -0,0 +1,77 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+// Six-operator phase-modulation oscillator. Higher-numbered operators modulate
+// lower-numbered ones; the algorithm picks which links exist and which
+// operators are heard. Operator 6 carries the feedback loop.
+//
+// Phase, envelope and gain state is kept in lanes and advanced with
+// SIMDRegister ops. The routing itself is a short scalar pass over a shared
+// sine table.
+class FmOscillator
+{
+public:
+    static constexpr int numOperators = 6;
+    static constexpr int numAlgorithms = 8;
+
+    struct OperatorParams
+    {
+        float ratio = 1.0f;
+        float level = 1.0f;
+        float attackMs = 2.0f;
+        float decayMs = 400.0f;
+        float sustain = 0.7f;
+        float releaseMs = 300.0f;
+    };
+
+    using Operators = std::array<OperatorParams, numOperators>;
+
+    FmOscillator();
+
+    void prepare(double sampleRate);
+    void reset();
+    // Follows a rate change without interrupting a sounding note
+    void setSampleRate(double sampleRate) noexcept;
+
+    // Audio thread, once per block. depth scales every modulator's level.
+    void setParameters(int algorithm, float feedback, float depth, const Operators& operators);
+
+    void noteOn() noexcept;
+    void noteOff() noexcept;
+
+    // phaseInc is the fundamental's increment in radians per sample
+    float renderSample(float phaseInc) noexcept;
+
+    static juce::String getAlgorithmName(int algorithm);
+
+private:
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static constexpr int numLanes = 8;
+    static_assert(numLanes % Lanes::SIZE == 0, "lanes must fill whole registers");
+
+    enum class Stage { idle, attack, decay, sustain, release };
+
+    void updateStageTargets(int op) noexcept;
+    float lookupSine(float phase) const noexcept;
+
+    double sampleRate = 44100.0;
+    int algorithm = 0;
+    float feedbackAmount = 0.0f;
+    float modulationDepth = 1.0f;
+    Operators params;
+
+    alignas(32) std::array<float, numLanes> phases {};
+    alignas(32) std::array<float, numLanes> ratios {};
+    alignas(32) std::array<float, numLanes> levels {};
+    alignas(32) std::array<float, numLanes> envelopes {};
+    alignas(32) std::array<float, numLanes> envTargets {};
+    alignas(32) std::array<float, numLanes> envRates {};
+    alignas(32) std::array<float, numLanes> gains {};
+
+    std::array<Stage, numOperators> stages {};
+    std::array<float, numOperators> outputs {};
+    float feedbackHistory[2] = { 0.0f, 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FmOscillator)
+};
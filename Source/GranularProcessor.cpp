@@ -0,0 +1,190 @@
+#include "GranularProcessor.h"
+
+//==============================================================================
+size_t GranularProcessor::getArenaFootprint(int maximumBlockSize) noexcept
+{
+    return 3 * DspArena::getFootprint((size_t)juce::jmax(1, maximumBlockSize));
+}
+
+void GranularProcessor::prepare(double newSampleRate, int maximumBlockSize, DspArena& arena)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    for (auto*& channel : scratchChannels)
+        channel = arena.allocate((size_t)maxBlockSize);
+    scratch.setDataToReferTo(scratchChannels, 3, maxBlockSize);
+
+    for (int i = 0; i <= windowSize; ++i)
+        window[(size_t)i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)i / (float)windowSize);
+
+    mixSmoothed.reset(sampleRate, 0.05);
+    mixSmoothed.setCurrentAndTargetValue(0.0f);
+    reset();
+}
+
+void GranularProcessor::reset()
+{
+    numActive = 0;
+    numFree = maxGrains;
+    for (int i = 0; i < maxGrains; ++i)
+        freeList[(size_t)i] = maxGrains - 1 - i;
+
+    samplesUntilNextGrain = 0.0f;
+}
+
+void GranularProcessor::setParameters(float grainSizeMs, float grainsPerSecond, float pitchSemitones,
+                                      float spray, float reverseProbability, float mix)
+{
+    grainLengthSamples = juce::jlimit(5.0f, 500.0f, grainSizeMs) * 0.001f * (float)sampleRate;
+    spawnInterval = (float)sampleRate / juce::jlimit(0.5f, 1000.0f, grainsPerSecond);
+    pitchRatio = std::pow(2.0, juce::jlimit(-24.0f, 24.0f, pitchSemitones) / 12.0);
+    sprayAmount = juce::jlimit(0.0f, 1.0f, spray);
+    reverseChance = juce::jlimit(0.0f, 1.0f, reverseProbability);
+    mixSmoothed.setTargetValue(juce::jlimit(0.0f, 1.0f, mix));
+}
+
+//==============================================================================
+void GranularProcessor::process(const juce::AudioBuffer<float>& history, int writePosition,
+                                float* left, float* right, int numSamples)
+{
+    if (mixSmoothed.getTargetValue() <= 0.0f && !mixSmoothed.isSmoothing())
+    {
+        if (engaged)
+        {
+            reset();
+            engaged = false;
+        }
+        return;
+    }
+    engaged = true;
+
+    for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+    {
+        const int count = juce::jmin(maxBlockSize, numSamples - offset);
+        // History index just past the last sample of this chunk
+        const int chunkWritePos = writePosition - (numSamples - (offset + count));
+        processChunk(history, chunkWritePos, left + offset, right != nullptr ? right + offset : nullptr, count);
+    }
+}
+
+void GranularProcessor::processChunk(const juce::AudioBuffer<float>& history, int writePosition,
+                                     float* left, float* right, int numSamples)
+{
+    const int historyLength = history.getNumSamples();
+    if (historyLength < 2)
+        return;
+
+    auto* wetL = scratch.getWritePointer(1);
+    auto* wetR = scratch.getWritePointer(2);
+    juce::FloatVectorOperations::clear(wetL, numSamples);
+    juce::FloatVectorOperations::clear(wetR, numSamples);
+
+    // Schedule this chunk's grains with +/-50% jitter on the spacing
+    while (samplesUntilNextGrain < (float)numSamples)
+    {
+        const int offset = juce::jmax(0, (int)samplesUntilNextGrain);
+        const int spawnWritePos = ((writePosition - numSamples + offset + 1) % historyLength + historyLength) % historyLength;
+        spawnGrain(historyLength, spawnWritePos, offset);
+        samplesUntilNextGrain += spawnInterval * (0.5f + random.nextFloat());
+    }
+    samplesUntilNextGrain -= (float)numSamples;
+
+    for (int a = 0; a < numActive;)
+    {
+        const int index = active[(size_t)a];
+        if (renderGrain(pool[(size_t)index], history, numSamples))
+        {
+            ++a;
+        }
+        else
+        {
+            freeList[(size_t)numFree++] = index;
+            active[(size_t)a] = active[(size_t)--numActive];
+        }
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float mix = mixSmoothed.getNextValue();
+        left[i] = left[i] * (1.0f - mix) + wetL[i] * mix;
+        if (right != nullptr)
+            right[i] = right[i] * (1.0f - mix) + wetR[i] * mix;
+    }
+}
+
+void GranularProcessor::spawnGrain(int historyLength, int spawnWritePos, int offset)
+{
+    // A full pool drops the grain rather than stealing one mid-window
+    if (numFree == 0)
+        return;
+
+    const int index = freeList[(size_t)--numFree];
+    auto& grain = pool[(size_t)index];
+
+    const bool reverse = random.nextFloat() < reverseChance;
+    grain.increment = reverse ? -pitchRatio : pitchRatio;
+
+    // Keep the whole grain behind the write head and inside the history
+    const double length = (double)grainLengthSamples;
+    double startDelay = 1.0 + (double)(sprayAmount * maxSprayMs * 0.001f) * sampleRate * (double)random.nextFloat();
+    if (!reverse)
+        startDelay += juce::jmax(0.0, (pitchRatio - 1.0) * length);
+    const double reach = reverse ? (1.0 + pitchRatio) * length : 0.0;
+    startDelay = juce::jlimit(1.0, juce::jmax(1.0, (double)historyLength - reach - 2.0), startDelay);
+
+    grain.readPos = (double)spawnWritePos - startDelay;
+    if (grain.readPos < 0.0)
+        grain.readPos += (double)historyLength;
+
+    grain.windowPos = 0.0f;
+    grain.windowInc = (float)windowSize / grainLengthSamples;
+
+    // Equal-power random pan, scaled down as grains overlap
+    const float overlap = juce::jmax(1.0f, grainLengthSamples / spawnInterval);
+    const float level = 1.0f / std::sqrt(overlap);
+    const float pan = random.nextFloat() * juce::MathConstants<float>::halfPi;
+    grain.gainL = std::cos(pan) * level;
+    grain.gainR = std::sin(pan) * level;
+    grain.startOffset = offset;
+
+    active[(size_t)numActive++] = index;
+}
+
+bool GranularProcessor::renderGrain(Grain& grain, const juce::AudioBuffer<float>& history, int numSamples)
+{
+    const int historyLength = history.getNumSamples();
+    const auto* histL = history.getReadPointer(0);
+    const auto* histR = history.getReadPointer(juce::jmin(1, history.getNumChannels() - 1));
+    auto* out = scratch.getWritePointer(0);
+
+    const int start = grain.startOffset;
+    grain.startOffset = 0;
+
+    int i = start;
+    for (; i < numSamples && grain.windowPos < (float)windowSize; ++i)
+    {
+        const int wi = (int)grain.windowPos;
+        const float wf = grain.windowPos - (float)wi;
+        const float w = window[(size_t)wi] + wf * (window[(size_t)wi + 1] - window[(size_t)wi]);
+
+        const int i0 = (int)grain.readPos;
+        const int i1 = (i0 + 1 == historyLength) ? 0 : i0 + 1;
+        const float frac = (float)(grain.readPos - (double)i0);
+        const float a = histL[i0] + histR[i0];
+        const float b = histL[i1] + histR[i1];
+        out[i] = 0.5f * (a + frac * (b - a)) * w;
+
+        grain.readPos += grain.increment;
+        if (grain.readPos >= (double)historyLength) grain.readPos -= (double)historyLength;
+        if (grain.readPos < 0.0) grain.readPos += (double)historyLength;
+        grain.windowPos += grain.windowInc;
+    }
+
+    if (i > start)
+    {
+        juce::FloatVectorOperations::addWithMultiply(scratch.getWritePointer(1, start), out + start, grain.gainL, i - start);
+        juce::FloatVectorOperations::addWithMultiply(scratch.getWritePointer(2, start), out + start, grain.gainR, i - start);
+    }
+
+    return grain.windowPos < (float)windowSize;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include "DspArena.h"
+
+// Granular cloud that reads grains out of an existing history ring buffer (the
+// engine's delay line) instead of keeping its own copy.
+//
+// Grains live in a fixed pool, so spawning never allocates. Windows come from
+// a precomputed Hann table. Each grain renders a block into scratch and is
+// summed into the output with vectorised multiply-adds.
+class GranularProcessor
+{
+public:
+    static constexpr int maxGrains = 512;
+
+    // Scratch is taken from arena, which needs getArenaFootprint(maximumBlockSize) free.
+    // Longer blocks are processed in chunks of maximumBlockSize.
+    void prepare(double sampleRate, int maximumBlockSize, DspArena& arena);
+    void reset();
+    static size_t getArenaFootprint(int maximumBlockSize) noexcept;
+
+    // Audio thread, once per block
+    void setParameters(float grainSizeMs, float grainsPerSecond, float pitchSemitones,
+                       float spray, float reverseProbability, float mix);
+
+    // writePosition is the history index the next sample will be written to
+    void process(const juce::AudioBuffer<float>& history, int writePosition,
+                 float* left, float* right, int numSamples);
+
+    int getActiveGrainCount() const noexcept     { return numActive; }
+    void setRandomSeed(juce::int64 seed)         { random.setSeed(seed); }
+
+private:
+    struct Grain
+    {
+        double readPos = 0.0;
+        double increment = 1.0;
+        float windowPos = 0.0f;
+        float windowInc = 0.0f;
+        float gainL = 0.0f;
+        float gainR = 0.0f;
+        int startOffset = 0;
+    };
+
+    static constexpr int windowSize = 2048;
+    static constexpr float maxSprayMs = 1000.0f;
+
+    void processChunk(const juce::AudioBuffer<float>& history, int writePosition,
+                      float* left, float* right, int numSamples);
+    void spawnGrain(int historyLength, int spawnWritePos, int offset);
+    bool renderGrain(Grain& grain, const juce::AudioBuffer<float>& history, int numSamples);
+
+    double sampleRate = 44100.0;
+    int maxBlockSize = 512;
+
+    std::array<Grain, maxGrains> pool;
+    std::array<int, maxGrains> active {};
+    std::array<int, maxGrains> freeList {};
+    int numActive = 0;
+    int numFree = 0;
+
+    std::array<float, windowSize + 1> window {};
+    float* scratchChannels[3] {};
+    juce::AudioBuffer<float> scratch;   // [0] grain, [1..2] wet L/R, in the arena
+
+    float grainLengthSamples = 0.0f;
+    float spawnInterval = 0.0f;
+    double pitchRatio = 1.0;
+    float sprayAmount = 0.0f;
+    float reverseChance = 0.0f;
+    float samplesUntilNextGrain = 0.0f;
+    juce::SmoothedValue<float> mixSmoothed;
+    bool engaged = false;
+    juce::Random random;
+};
@@ -0,0 +1,145 @@
+#include "LookaheadLimiter.h"
+#include "DspArena.h"
+
+void LookaheadLimiter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+
+    // Sized for the longest look-ahead at the highest rate, so neither a new
+    // look-ahead nor a later prepare at a lower rate allocates
+    const int maxWindow = (int)std::ceil(maxLookaheadMs * 0.001 * juce::jmax(sampleRate, DspArena::reservedSampleRate)) + 1;
+    dequeGains.assign((size_t)maxWindow, 1.0f);
+    dequeIndices.assign((size_t)maxWindow, 0);
+    averageHistory.assign((size_t)maxWindow, 1.0f);
+    delayLine.setSize(2, maxWindow);
+
+    appliedLookaheadMs = -1.0f;
+    appliedReleaseMs = -1.0f;
+    applyParameters();
+}
+
+void LookaheadLimiter::reset() noexcept
+{
+    dequeFront = dequeSize = 0;
+    sampleIndex = 0;
+    delayLine.clear();
+    delayPos = 0;
+    settle();
+}
+
+void LookaheadLimiter::settle() noexcept
+{
+    releasedGain = 1.0f;
+    std::fill(averageHistory.begin(), averageHistory.begin() + window, 1.0f);
+    averageSum = (double)window;
+    averagePos = 0;
+    silentRun = window;
+    drained = true;
+    gainReductionDb.store(0.0f, std::memory_order_relaxed);
+}
+
+void LookaheadLimiter::setParameters(float ceilingDb, float lookaheadMs, float releaseMs) noexcept
+{
+    requestedCeilingDb.store(juce::jlimit(-24.0f, 0.0f, ceilingDb), std::memory_order_relaxed);
+    requestedLookaheadMs.store(juce::jlimit(0.1f, maxLookaheadMs, lookaheadMs), std::memory_order_relaxed);
+    requestedReleaseMs.store(juce::jlimit(1.0f, 2000.0f, releaseMs), std::memory_order_relaxed);
+}
+
+void LookaheadLimiter::applyParameters() noexcept
+{
+    ceiling = juce::Decibels::decibelsToGain(requestedCeilingDb.load(std::memory_order_relaxed));
+
+    const float releaseMs = requestedReleaseMs.load(std::memory_order_relaxed);
+    if (releaseMs != appliedReleaseMs)
+    {
+        appliedReleaseMs = releaseMs;
+        releaseCoefficient = (float)(1.0 - std::exp(-1.0 / (releaseMs * 0.001 * sampleRate)));
+    }
+
+    const float lookaheadMs = requestedLookaheadMs.load(std::memory_order_relaxed);
+    if (lookaheadMs != appliedLookaheadMs)
+    {
+        appliedLookaheadMs = lookaheadMs;
+        window = juce::jlimit(1, (int)averageHistory.size(), juce::roundToInt(lookaheadMs * 0.001 * sampleRate) + 1);
+        latencySamples.store(window - 1, std::memory_order_relaxed);
+        reset();
+    }
+}
+
+void LookaheadLimiter::process(float* left, float* right, int numSamples) noexcept
+{
+    applyParameters();
+
+    const int capacity = (int)dequeGains.size();
+    const int delay = window - 1;
+    float* delayL = delayLine.getWritePointer(0);
+    float* delayR = delayLine.getWritePointer(1);
+    float minGain = 1.0f;
+    int lastSignal = -1;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float inL = left[i];
+        const float inR = right != nullptr ? right[i] : inL;
+        const float level = juce::jmax(std::abs(inL), std::abs(inR));
+        const float required = level > ceiling ? ceiling / level : 1.0f;
+        if (level > 0.0f)
+            lastSignal = i;
+
+        // Drop gains the new one makes irrelevant, then anything that left the window
+        while (dequeSize > 0 && dequeGains[(size_t)((dequeFront + dequeSize - 1) % capacity)] >= required)
+            --dequeSize;
+        const int back = (dequeFront + dequeSize) % capacity;
+        dequeGains[(size_t)back] = required;
+        dequeIndices[(size_t)back] = sampleIndex;
+        ++dequeSize;
+        if (dequeIndices[(size_t)dequeFront] <= sampleIndex - window)
+        {
+            dequeFront = (dequeFront + 1) % capacity;
+            --dequeSize;
+        }
+        ++sampleIndex;
+
+        // Attack is instant, release glides; either way it never rises above the window minimum
+        const float held = dequeGains[(size_t)dequeFront];
+        releasedGain = held < releasedGain ? held : releasedGain + (held - releasedGain) * releaseCoefficient;
+
+        averageSum += releasedGain - averageHistory[(size_t)averagePos];
+        averageHistory[(size_t)averagePos] = releasedGain;
+        averagePos = averagePos + 1 < window ? averagePos + 1 : 0;
+        const float gain = (float)(averageSum / window);
+        minGain = juce::jmin(minGain, gain);
+
+        float outL = inL, outR = inR;
+        if (delay > 0)
+        {
+            outL = delayL[delayPos];
+            outR = delayR[delayPos];
+            delayL[delayPos] = inL;
+            delayR[delayPos] = inR;
+            delayPos = delayPos + 1 < delay ? delayPos + 1 : 0;
+        }
+
+        left[i] = juce::jlimit(-ceiling, ceiling, outL * gain);
+        if (right != nullptr)
+            right[i] = juce::jlimit(-ceiling, ceiling, outR * gain);
+    }
+
+    gainReductionDb.store(juce::Decibels::gainToDecibels(minGain), std::memory_order_relaxed);
+
+    if (lastSignal >= 0)
+    {
+        silentRun = numSamples - 1 - lastSignal;
+        drained = false;
+    }
+    else
+    {
+        silentRun = juce::jmin(window, silentRun + numSamples);
+    }
+
+    // With only silence in the delay line the gain can't be heard until new
+    // input arrives, and the look-ahead pulls it down in time for any peak,
+    // so it can finish its release at once
+    if (!drained && silentRun >= window)
+        settle();
+}
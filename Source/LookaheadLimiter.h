@@ -0,0 +1,72 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// Final-stage brickwall limiter. The gain needed to keep each sample under the
+// ceiling goes through a sliding-window minimum (a monotonic deque, O(1)
+// amortised per sample whatever the window), a release follower and a
+// window-length moving average. Every gain the average sees while a peak
+// is in the delay line is at most that peak's own gain, so the ramp finishes
+// before the peak comes out. A final clamp catches rounding error.
+class LookaheadLimiter
+{
+public:
+    static constexpr float maxLookaheadMs = 10.0f;
+
+    void prepare(double sampleRate);
+    void reset() noexcept;
+
+    // Any thread; applied at the start of the next block. A look-ahead change
+    // resizes the delay line, which restarts the limiter.
+    void setParameters(float ceilingDb, float lookaheadMs, float releaseMs) noexcept;
+
+    // Audio thread. right may be null for a mono output.
+    void process(float* left, float* right, int numSamples) noexcept;
+
+    int getLatencySamples() const noexcept      { return latencySamples.load(std::memory_order_relaxed); }
+    float getGainReductionDb() const noexcept   { return gainReductionDb.load(std::memory_order_relaxed); }
+
+    // Audio thread. True once a look-ahead of silence has gone in: the delay
+    // line holds nothing, so process() would only write zeros over zeros.
+    bool isDrained() const noexcept             { return drained; }
+
+    float getCeilingDb() const noexcept         { return requestedCeilingDb.load(std::memory_order_relaxed); }
+    float getLookaheadMs() const noexcept       { return requestedLookaheadMs.load(std::memory_order_relaxed); }
+    float getReleaseMs() const noexcept         { return requestedReleaseMs.load(std::memory_order_relaxed); }
+
+private:
+    void applyParameters() noexcept;
+    void settle() noexcept;
+
+    std::atomic<float> requestedCeilingDb { -1.0f };
+    std::atomic<float> requestedLookaheadMs { 5.0f };
+    std::atomic<float> requestedReleaseMs { 80.0f };
+    std::atomic<int> latencySamples { 0 };
+    std::atomic<float> gainReductionDb { 0.0f };
+
+    double sampleRate = 44100.0;
+    float ceiling = 1.0f;
+    float releaseCoefficient = 1.0f;
+    float appliedLookaheadMs = -1.0f;
+    float appliedReleaseMs = -1.0f;
+    int window = 1;     // look-ahead + 1 samples
+
+    // Sliding minimum: ring of (gain, sample index) pairs, gains increasing front to back
+    std::vector<float> dequeGains;
+    std::vector<juce::int64> dequeIndices;
+    int dequeFront = 0, dequeSize = 0;
+    juce::int64 sampleIndex = 0;
+
+    float releasedGain = 1.0f;
+    std::vector<float> averageHistory;
+    double averageSum = 0.0;
+    int averagePos = 0;
+
+    juce::AudioBuffer<float> delayLine;
+    int delayPos = 0;
+
+    int silentRun = 0;      // input samples since the last non-zero one, up to window
+    bool drained = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LookaheadLimiter)
+};
@@ -8,6 +8,9 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "BatchRenderer.h"
+#include "PerformanceTrace.h"
+#include "RealtimeOptions.h"
 
 //==============================================================================
 class NewProjectApplication  : public juce::JUCEApplication
@@ -23,8 +26,34 @@ public:
     //==============================================================================
     void initialise (const juce::String& commandLine) override
     {
-        juce::ignoreUnused(commandLine);
-        // This method is where you should put your application's initialisation code..
+        // Headless sample-library export: --batch <job.json>
+        const auto args = juce::StringArray::fromTokens(commandLine, true);
+        const int batchIndex = args.indexOf("--batch");
+        if (batchIndex >= 0)
+        {
+            setApplicationReturnValue(runBatch(args[batchIndex + 1].unquoted()) ? 0 : 1);
+            quit();
+            return;
+        }
+
+        // Headless trace replay: --replay <trace> [output.wav]
+        const int replayIndex = args.indexOf("--replay");
+        if (replayIndex >= 0)
+        {
+            const auto cwd = juce::File::getCurrentWorkingDirectory();
+            const auto tracePath = args[replayIndex + 1].unquoted();
+            const auto wavPath = args[replayIndex + 2].unquoted();
+            const bool exact = tracePath.isNotEmpty()
+                && PerformanceTrace::replay(cwd.getChildFile(tracePath), wavPath.isNotEmpty() ? cwd.getChildFile(wavPath) : juce::File());
+            setApplicationReturnValue(exact ? 0 : 1);
+            quit();
+            return;
+        }
+
+        // Linux real-time options: the environment first, then the command line
+        auto realtimeArgs = juce::StringArray::fromTokens(juce::SystemStats::getEnvironmentVariable("SPECTRAL_LAB_REALTIME", {}), true);
+        realtimeArgs.addArray(args);
+        RealtimeOptions::setCurrent(RealtimeOptions::parse(realtimeArgs));
 
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
@@ -52,6 +81,26 @@ public:
         // the other instance's command-line arguments were.
     }
 
+    static bool runBatch(const juce::String& jobPath)
+    {
+        if (jobPath.isEmpty())
+        {
+            juce::Logger::writeToLog("Usage: --batch <job.json>");
+            return false;
+        }
+
+        const auto jobFile = juce::File::getCurrentWorkingDirectory().getChildFile(jobPath);
+        BatchRenderer::Job job;
+        const auto error = BatchRenderer::parseJob(jobFile, job);
+        if (error.isNotEmpty())
+        {
+            juce::Logger::writeToLog("Batch: " + error);
+            return false;
+        }
+
+        return BatchRenderer::run(job);
+    }
+
     //==============================================================================
     /*
         This class implements the desktop window that contains an instance of
@@ -3,19 +3,37 @@
 
 namespace
 {
-    constexpr int defaultWidth = 960;
+    constexpr int defaultWidth = 1280;
     constexpr int defaultHeight = 600;
-    constexpr int minWidth = 720;
+    constexpr int minWidth = 860;
     constexpr int minHeight = 420;
     constexpr int headerBarHeight = 36;
     constexpr int headerMargin = 16;
     constexpr int audioButtonWidth = 96;
     constexpr int audioButtonHeight = 28;
+    constexpr int headerButtonWidth = 64;
+    constexpr int headerButtonGap = 8;
     constexpr int controlStripHeight = 110;
     constexpr int knobSize = 48;
-    constexpr int totalControlKnobs = 22;
+    constexpr int totalControlKnobs = 27;
     constexpr int keyboardMinHeight = 60;
-    constexpr int scopeTimerHz = 60;
+    constexpr int defaultFrameRateCap = 60;
+    constexpr int frameRateCaps[] = { 24, 30, 60, 120, 0 };
+    // A vsync arriving this early still counts, so a 30 fps cap on a 60 Hz display lands on every other frame
+    constexpr double frameCapSlackSeconds = 0.002;
+    constexpr double headerRefreshHz = 15.0;
+    constexpr double scanSpeedReferenceHz = 60.0;
+    constexpr float scopeSilenceThreshold = 1.0e-4f;
+    constexpr int housekeepingTimerHz = 1;
+    constexpr int meterAreaWidth = 250;
+    constexpr float meterFloorDb = -60.0f;
+    constexpr float truePeakWarningDb = -1.0f;
+    constexpr int midiBufferReserveBytes = 4096;
+    constexpr int renderRates[] = { 0, 44100, 48000, 88200, 96000 };
+    // Device blocks beyond this go through the converter and the vocoder in pieces
+    constexpr int minConverterBlock = 2048;
+    // Live input channels mixed into the vocoder's modulator
+    constexpr int maxInputChannels = 2;
 
     namespace Theme
     {
@@ -34,53 +52,67 @@ namespace
         const juce::Colour glitchColour     = juce::Colour::fromFloatRGBA(0.9f, 0.2f, 1.0f, 0.4f);
         const juce::Colour scanColour       = juce::Colour::fromFloatRGBA(0.3f, 1.0f, 0.85f, 0.22f);
     }
+
+    // Initialised with the other statics before main(), so close enough to process start
+    const double processStartMs = juce::Time::getMillisecondCounterHiRes();
+    double millisecondsSinceStart()     { return juce::Time::getMillisecondCounterHiRes() - processStartMs; }
+
+    constexpr int firstCallbackWaitMs = 10000;
+
+    constexpr int memoryLockNotRequested = -2;
+
+    constexpr float jitterSmoothing = 0.05f;
+
+    struct ScopedTickCounter
+    {
+        explicit ScopedTickCounter(juce::int64& t) : total(t) {}
+        ~ScopedTickCounter() { total += juce::Time::getHighResolutionTicks() - start; }
+
+        juce::int64& total;
+        const juce::int64 start = juce::Time::getHighResolutionTicks();
+    };
 }
 
 //==============================================================================
 MainComponent::MainComponent()
+    : frameRateCap(defaultFrameRateCap),
+      memoryLockResult(memoryLockNotRequested)
 {
+   #if SPECTRAL_TRACE_ZONES
+    TRACE_THREAD_NAME("Message");
+    zoneSession = std::make_unique<TraceEvents::Session>(
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+            .getChildFile("Spectral Lab Traces")
+            .getChildFile("Zones " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H%M%S") + ".json"));
+   #endif
+
     setSize(defaultWidth, defaultHeight);
-    setAudioChannels(0, 2);
+
+    if (RealtimeOptions::getCurrent().lockMemory)
+        memoryLockResult = Realtime::lockAllMemory();
 
     visualRandom.setSeedRandomly();
 
     scopeBuffer.clear();
 
-    ampEnvParams.attack = attackMs * 0.001f;
-    ampEnvParams.decay = decayMs * 0.001f;
-    ampEnvParams.sustain = sustainLevel;
-    ampEnvParams.release = releaseMs * 0.001f;
-    amplitudeEnvelope.setParameters(ampEnvParams);
-
-    frequencySmoothed.setCurrentAndTargetValue(targetFrequency);
-    gainSmoothed.setCurrentAndTargetValue(outputGain);
-    cutoffSmoothed.setCurrentAndTargetValue(cutoffHz);
-    resonanceSmoothed.setCurrentAndTargetValue(resonanceQ);
-    stereoWidthSmoothed.setCurrentAndTargetValue(stereoWidth);
-    lfoDepthSmoothed.setCurrentAndTargetValue(lfoDepth);
-    driveSmoothed.setCurrentAndTargetValue(driveAmount);
-    chorusMixSmoothed.setCurrentAndTargetValue(chorusMix);
-
-    chorus.setMix(1.0f);
-    chorus.setRate(0.35f);
-    chorus.setDepth(0.45f);
-    chorus.setFeedback(0.12f);
-    chorus.setCentreDelay(7.5f);
-    chorus.setSpread(0.7f);
+    // Sized once; longer device blocks are rendered and vocoded in chunks of this
+    modulatorBuffer.setSize(1, minConverterBlock);
 
     initialiseUi();
-    initialiseMidiInputs();
     initialiseKeyboard();
+    startupTimes.controlsBuilt = millisecondsSinceStart();
 
-    startTimerHz(scopeTimerHz);
+    // The audio device opens after the first paint; MIDI inputs are
+    // enumerated on their own thread meanwhile
+    midiInputs.start();
+
+    statsStartTicks = juce::Time::getHighResolutionTicks();
+    startTimerHz(housekeepingTimerHz);
+    startupTimes.constructed = millisecondsSinceStart();
 }
 
 MainComponent::~MainComponent()
 {
-    auto devices = juce::MidiInput::getAvailableDevices();
-    for (auto& d : devices)
-        deviceManager.removeMidiInputDeviceCallback(d.identifier, this);
-
     keyboardState.removeListener(this);
     shutdownAudio();
 }
@@ -88,331 +120,209 @@ MainComponent::~MainComponent()
 //==============================================================================
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
-    currentSR = sampleRate;
-    phase = 0.0f;
-    lfoPhase = 0.0f;
     scopeWritePos = 0;
-    filterUpdateCount = 0;
-    subPhase = 0.0f;
-    detunePhase = 0.0f;
-    autoPanPhase = 0.0f;
-    crushCounter = 0;
-    crushHoldL = 0.0f;
-    crushHoldR = 0.0f;
-    chaosValue = 0.0f;
-    chaosSamplesRemaining = 0;
-    glitchSamplesRemaining = 0;
-    glitchHeldL = glitchHeldR = 0.0f;
-    resetSmoothers(sampleRate);
-    updateFilterStatic();
-    amplitudeEnvelope.setSampleRate(sampleRate);
-    updateAmplitudeEnvelope();
-    amplitudeEnvelope.reset();
-
-    maxDelaySamples = juce::jmax(1, (int)std::ceil(sampleRate * 2.0));
-    delayBuffer.setSize(2, maxDelaySamples);
-    delayBuffer.clear();
-    delayWritePosition = 0;
-
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = (juce::uint32)juce::jmax(1, samplesPerBlockExpected);
-    spec.numChannels = 2;
-    chorus.reset();
-    chorus.prepare(spec);
-}
-
-void MainComponent::updateFilterCoeffs(double cutoff, double Q)
-{
-    cutoff = juce::jlimit(20.0, 20000.0, cutoff);
-    Q = juce::jlimit(0.1, 12.0, Q);
-
-    const double w0 = juce::MathConstants<double>::twoPi * cutoff / currentSR;
-    const double cw = std::cos(w0);
-    const double sw = std::sin(w0);
-    const double alpha = sw / (2.0 * Q);
-
-    double b0 = (1.0 - cw) * 0.5;
-    double b1 = 1.0 - cw;
-    double b2 = (1.0 - cw) * 0.5;
-    double a0 = 1.0 + alpha;
-    double a1 = -2.0 * cw;
-    double a2 = 1.0 - alpha;
-
-    juce::IIRCoefficients c(b0 / a0, b1 / a0, b2 / a0,
-        1.0, a1 / a0, a2 / a0);
-
-    filterL.setCoefficients(c);
-    filterR.setCoefficients(c);
+    scopeSilentRun = 0;
+    qualityGovernor.prepare(sampleRate);
+    midiCollector.reset(sampleRate);
+    incomingMidi.ensureSize(midiBufferReserveBytes);
+    resampledMidi.ensureSize(midiBufferReserveBytes);
+    chunkMidi.ensureSize(midiBufferReserveBytes);
+
+    // The engine, and so the trace, run at the internal rate when one is set
+    const int renderRate = requestedRenderRate.load();
+    const bool convert = renderRate > 0
+        && rateConverter.prepare(renderRate, sampleRate, juce::jmax(samplesPerBlockExpected, minConverterBlock));
+    const double engineRate = convert ? (double)renderRate : sampleRate;
+    const int engineBlock = convert ? rateConverter.getMaxInputBlock() : samplesPerBlockExpected;
+    resampling = convert;
+
+    engine.prepare(engineRate, engineBlock);
+    performanceTrace.beginSegment(engine, engineRate, engineBlock);
+    outputRecorder.prepare(sampleRate);
+    limiter.prepare(sampleRate);
+    outputMeter.prepare(sampleRate);
+    vocoder.prepare(sampleRate);
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+    activeInputChannels = device != nullptr ? juce::jmin(maxInputChannels, device->getActiveInputChannels().countNumberOfSetBits()) : 0;
+
+    // Locking again faults in and pins everything prepare just allocated,
+    // so the first pass over the delay lines doesn't page-fault on the audio thread
+    if (RealtimeOptions::getCurrent().lockMemory)
+        memoryLockResult = Realtime::lockAllMemory();
+
+    deviceSampleRate = sampleRate;
+    lastCallbackTicks = 0;
+    worstCallbackJitterMicros = 0.0f;
+    audioThreadConfigured = false;
 }
 
-void MainComponent::updateFilterStatic()
-{
-    updateFilterCoeffs(cutoffHz, resonanceQ);
-}
-
-void MainComponent::resetSmoothers(double sampleRate)
-{
-    const double fastRampSeconds = 0.02;
-    const double filterRampSeconds = 0.06;
-    const double spatialRampSeconds = 0.1;
-
-    frequencySmoothed.reset(sampleRate, fastRampSeconds);
-    gainSmoothed.reset(sampleRate, fastRampSeconds);
-    cutoffSmoothed.reset(sampleRate, filterRampSeconds);
-    resonanceSmoothed.reset(sampleRate, filterRampSeconds);
-    stereoWidthSmoothed.reset(sampleRate, spatialRampSeconds);
-    lfoDepthSmoothed.reset(sampleRate, spatialRampSeconds);
-    driveSmoothed.reset(sampleRate, fastRampSeconds);
-    chorusMixSmoothed.reset(sampleRate, spatialRampSeconds);
-
-    frequencySmoothed.setCurrentAndTargetValue(targetFrequency);
-    gainSmoothed.setCurrentAndTargetValue(outputGain);
-    cutoffSmoothed.setCurrentAndTargetValue(cutoffHz);
-    resonanceSmoothed.setCurrentAndTargetValue(resonanceQ);
-    stereoWidthSmoothed.setCurrentAndTargetValue(stereoWidth);
-    lfoDepthSmoothed.setCurrentAndTargetValue(lfoDepth);
-    driveSmoothed.setCurrentAndTargetValue(driveAmount);
-    chorusMixSmoothed.setCurrentAndTargetValue(chorusMix);
-
-    filterL.reset();
-    filterR.reset();
-}
-
-void MainComponent::setTargetFrequency(float newFrequency, bool force)
+void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    targetFrequency = juce::jlimit(20.0f, 20000.0f, newFrequency);
-
-    if (force)
-        frequencySmoothed.setCurrentAndTargetValue(targetFrequency);
-    else
-        frequencySmoothed.setTargetValue(targetFrequency);
-}
+    if (bufferToFill.buffer == nullptr || bufferToFill.buffer->getNumChannels() == 0)
+        return;
 
-inline float MainComponent::renderMorphSample(float ph, float morph) const
-{
-    while (ph >= juce::MathConstants<float>::twoPi) ph -= juce::MathConstants<float>::twoPi;
-    if (ph < 0.0f) ph += juce::MathConstants<float>::twoPi;
+    TRACE_THREAD_NAME("Audio");
+    TRACE_ZONE("getNextAudioBlock");
+    if (firstCallbackMs.load(std::memory_order_relaxed) == 0.0)
+        firstCallbackMs.store(millisecondsSinceStart(), std::memory_order_relaxed);
 
-    const float m = juce::jlimit(0.0f, 1.0f, morph);
-    const float seg = 1.0f / 3.0f;
+    if (!audioThreadConfigured.load(std::memory_order_relaxed))
+    {
+        audioThreadResult = Realtime::configureAudioThread();
+        audioThreadConfigured.store(true, std::memory_order_release);
+    }
+    measureCallbackJitter(bufferToFill.numSamples);
 
-    if (m < seg)
-        return juce::jmap(m / seg, sine(ph), tri(ph));
-    else if (m < 2.0f * seg)
-        return juce::jmap((m - seg) / seg, tri(ph), saw(ph));
-    else
-        return std::tanh(juce::jmap((m - 2.0f * seg) / seg, saw(ph), sqr(ph)));
-}
+    QualityGovernor::ScopedMeasurement callbackTimer(qualityGovernor, bufferToFill.numSamples);
+    const auto tier = qualityGovernor.getTier();
+    engine.setQualityTier(tier);
 
-void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
-{
-    if (bufferToFill.buffer == nullptr || bufferToFill.buffer->getNumChannels() == 0)
-        return;
+    const bool enabled = audioEnabled.load(std::memory_order_relaxed);
+    if (enabled != engine.isAudioEnabled())
+        engine.setAudioEnabled(enabled);
 
-    bufferToFill.buffer->clear(bufferToFill.startSample, bufferToFill.numSamples);
+    midiCollector.removeNextBlockOfMessages(incomingMidi, bufferToFill.numSamples);
 
     auto* l = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
     auto* r = bufferToFill.buffer->getNumChannels() > 1
         ? bufferToFill.buffer->getWritePointer(1, bufferToFill.startSample) : nullptr;
-
-    const float lfoInc = juce::MathConstants<float>::twoPi * lfoRateHz / (float)currentSR;
-    const float autoPanInc = juce::MathConstants<float>::twoPi * autoPanRateHz / (float)currentSR;
-    const float crushAmt = juce::jlimit(0.0f, 1.0f, crushAmount);
-    const float subMixAmt = juce::jlimit(0.0f, 1.0f, subMixAmount);
-    const float envFilterAmt = juce::jlimit(-1.0f, 1.0f, envFilterAmount);
-    const float chaosAmt = juce::jlimit(0.0f, 1.0f, chaosAmount);
-    const float delayAmtLocal = juce::jlimit(0.0f, 1.0f, delayAmount);
-    const float autoPanAmt = juce::jlimit(0.0f, 1.0f, autoPanAmount);
-    const float glitchProbLocal = juce::jlimit(0.0f, 1.0f, glitchProbability);
-    const float delayMix = juce::jmap(delayAmtLocal, 0.0f, 1.0f, 0.0f, 0.65f);
-    const float delayFeedback = juce::jmap(delayAmtLocal, 0.0f, 1.0f, 0.05f, 0.88f);
-    const int delaySamples = (maxDelaySamples > 1)
-        ? juce::jlimit(1, maxDelaySamples - 1,
-            (int)std::round(juce::jmap((double)delayAmtLocal, 0.0, 1.0,
-                currentSR * 0.03,
-                juce::jmin(currentSR * 1.25, (double)maxDelaySamples - 1.0))))
-        : 1;
-
-    for (int i = 0; i < bufferToFill.numSamples; ++i)
+    const float* recordChannels[] = { l, r != nullptr ? r : l };
+
+    // The input arrives in the same buffer the synth renders into, so each
+    // chunk's input is taken out before the synth renders over it
+    const int chunkSize = modulatorBuffer.getNumSamples();
+    const int inputChannels = juce::jmin(activeInputChannels, bufferToFill.buffer->getNumChannels());
+    auto* modulator = modulatorBuffer.getWritePointer(0);
+    for (int start = 0; start < bufferToFill.numSamples; start += chunkSize)
     {
-        if (!audioEnabled && amplitudeEnvelope.isActive())
-            amplitudeEnvelope.noteOff();
-
-        const float baseFrequency = frequencySmoothed.getNextValue();
-        const float gain = gainSmoothed.getNextValue() * currentVelocity;
-        const float depth = lfoDepthSmoothed.getNextValue();
-        const float width = stereoWidthSmoothed.getNextValue();
-        const float baseCutoff = cutoffSmoothed.getNextValue();
-        const float baseResonance = resonanceSmoothed.getNextValue();
-        const float ampEnv = amplitudeEnvelope.getNextSample();
-        const float drive = driveSmoothed.getNextValue();
-
-        float lfoS = std::sin(lfoPhase);
-        float vibrato = 1.0f + (depth * lfoS);
-        lfoPhase += lfoInc;
-        if (lfoPhase >= juce::MathConstants<float>::twoPi) lfoPhase -= juce::MathConstants<float>::twoPi;
-
-        float chaosScale = 1.0f;
-        if (chaosAmt > 0.0f)
-        {
-            if (chaosSamplesRemaining <= 0)
-            {
-                const int span = juce::jmax(1, (int)std::round(juce::jmap(chaosAmt, 0.0f, 1.0f,
-                    (float)currentSR * 0.18f,
-                    (float)currentSR * 0.01f)));
-                chaosSamplesRemaining = span;
-                chaosValue = random.nextFloat() * 2.0f - 1.0f;
-            }
-            chaosScale = juce::jlimit(0.5f, 1.5f, 1.0f + chaosValue * chaosAmt * 0.12f);
-            --chaosSamplesRemaining;
-        }
-        else
-        {
-            chaosValue = 0.0f;
-            chaosSamplesRemaining = 0;
-        }
-
-        const float effectiveFrequency = baseFrequency * chaosScale;
-        const float phaseInc = juce::MathConstants<float>::twoPi * (effectiveFrequency * vibrato) / (float)currentSR;
-        phase += phaseInc;
+        const int n = juce::jmin(chunkSize, bufferToFill.numSamples - start);
+        juce::FloatVectorOperations::clear(modulator, n);
+        for (int ch = 0; ch < inputChannels; ++ch)
+            juce::FloatVectorOperations::addWithMultiply(modulator, bufferToFill.buffer->getReadPointer(ch, bufferToFill.startSample + start),
+                                                         1.0f / (float)inputChannels, n);
 
-        float subPhaseInc = phaseInc * 0.5f;
-        float detunePhaseInc = phaseInc * 1.01f;
-        subPhase += subPhaseInc;
-        detunePhase += detunePhaseInc;
-        if (subPhase >= juce::MathConstants<float>::twoPi) subPhase -= juce::MathConstants<float>::twoPi;
-        if (detunePhase >= juce::MathConstants<float>::twoPi) detunePhase -= juce::MathConstants<float>::twoPi;
+        bufferToFill.buffer->clear(bufferToFill.startSample + start, n);
 
-        float primary = renderMorphSample(phase, waveMorph);
-        float subSample = renderMorphSample(subPhase, waveMorph);
-        float detuneSample = renderMorphSample(detunePhase, waveMorph);
-        float combined = juce::jmap(subMixAmt, primary, 0.5f * (primary + subSample + detuneSample));
-        float s = combined * gain;
-
-        if (drive > 0.0f)
+        // Events move to the chunk they fall in
+        const juce::MidiBuffer* midi = &incomingMidi;
+        if (n < bufferToFill.numSamples)
         {
-            float shaped = std::tanh(s * (1.0f + drive * 10.0f));
-            s = juce::jmap(drive, 0.0f, 1.0f, s, shaped);
+            chunkMidi.clear();
+            chunkMidi.addEvents(incomingMidi, start, n, -start);
+            midi = &chunkMidi;
         }
 
-        if (++filterUpdateCount >= filterUpdateStep)
+        auto* chunkL = l + start;
+        auto* chunkR = r != nullptr ? r + start : nullptr;
+        if (resampling.load(std::memory_order_relaxed))
         {
-            filterUpdateCount = 0;
-            const double modFactor = std::pow(2.0, (double)lfoCutModAmt * (double)lfoS);
-            const double envFactor = juce::jlimit(0.1, 4.0, 1.0 + (double)envFilterAmt * (double)ampEnv);
-            const double effCut = juce::jlimit(80.0, 14000.0, (double)baseCutoff * modFactor * envFactor);
-            updateFilterCoeffs(effCut, (double)baseResonance);
+            TRACE_ZONE("engine + resampler");
+            renderResampled(chunkL, chunkR, n, *midi, tier, enabled);
         }
-
-        float fL = filterL.processSingleSampleRaw(s);
-        float fR = (r ? filterR.processSingleSampleRaw(s) : fL);
-
-        if (crushAmt > 0.0f)
+        else
         {
-            if (crushCounter <= 0)
+            performanceTrace.beginBlock(n, tier, enabled, chunkR == nullptr, *midi);
             {
-                const int downsampleFactor = juce::jmax(1, (int)std::round(juce::jmap(crushAmt, 0.0f, 1.0f, 1.0f, 32.0f)));
-                crushCounter = downsampleFactor;
-                crushHoldL = fL;
-                crushHoldR = fR;
+                TRACE_ZONE("engine");
+                engine.render(chunkL, chunkR, n, *midi);
             }
-
-            float levels = juce::jmap(crushAmt, 0.0f, 1.0f, 2048.0f, 6.0f);
-            float crushedL = std::round(crushHoldL * levels) / levels;
-            float crushedR = std::round(crushHoldR * levels) / levels;
-            fL = juce::jmap(crushAmt, 0.0f, 1.0f, fL, crushedL);
-            fR = juce::jmap(crushAmt, 0.0f, 1.0f, fR, crushedR);
-            --crushCounter;
+            performanceTrace.endBlock(engine, chunkL, chunkR, n);
         }
-        else
         {
-            crushCounter = 0;
-        }
-
-        fL *= ampEnv;
-        fR *= ampEnv;
-
-        float panMod = autoPanAmt * std::sin(autoPanPhase);
-        autoPanPhase += autoPanInc;
-        if (autoPanPhase >= juce::MathConstants<float>::twoPi) autoPanPhase -= juce::MathConstants<float>::twoPi;
-
-        float dynamicWidth = width * juce::jlimit(0.0f, 3.0f, 1.0f + panMod);
-        float mid = 0.5f * (fL + fR);
-        float side = 0.5f * (fL - fR) * dynamicWidth;
-
-        float dryL = mid + side;
-        float dryR = r ? (mid - side) : dryL;
-
-        float chorusMixValue = chorusMixSmoothed.getNextValue();
-        float chorusWetL = chorus.processSample(0, dryL);
-        float chorusWetR = chorus.processSample(1, dryR);
-        if (!r)
-            chorusWetR = chorusWetL;
-        if (chorusMixValue > 0.0001f)
-        {
-            dryL = juce::jmap(chorusMixValue, dryL, chorusWetL);
-            dryR = juce::jmap(chorusMixValue, dryR, chorusWetR);
+            TRACE_ZONE("vocoder");
+            vocoder.process(modulator, chunkL, chunkR, n);
         }
+    }
 
-        float wetL = 0.0f;
-        float wetR = 0.0f;
-        if (delayAmtLocal > 0.0f && maxDelaySamples > 1)
-        {
-            const int readPos = (delayWritePosition - delaySamples + maxDelaySamples) % maxDelaySamples;
-            wetL = delayBuffer.getSample(0, readPos);
-            wetR = delayBuffer.getNumChannels() > 1 ? delayBuffer.getSample(1, readPos) : wetL;
+    // Nothing left to limit or draw: the engine is idle, the limiter's delay
+    // line has emptied, the scope already shows a flat line and the block is
+    // silent (a resampler or vocoder tail, or a round-trip click, isn't)
+    const bool quiet = engine.isIdle() && limiter.isDrained() && scopeSilentRun >= scopeBuffer.getNumSamples()
+                       && bufferToFill.buffer->getMagnitude(bufferToFill.startSample, bufferToFill.numSamples) == 0.0f;
+    if (!quiet)
+    {
+        TRACE_ZONE("limiter");
+        limiter.process(l, r, bufferToFill.numSamples);
+    }
+    {
+        TRACE_ZONE("recorder + meter");
+        outputRecorder.pushBlock(recordChannels, bufferToFill.numSamples);
+        outputMeter.pushBlock(l, r, bufferToFill.numSamples);
+    }
 
-            delayBuffer.setSample(0, delayWritePosition, dryL + wetL * delayFeedback);
-            delayBuffer.setSample(1, delayWritePosition, dryR + wetR * delayFeedback);
-            delayWritePosition = (delayWritePosition + 1) % maxDelaySamples;
+    if (quiet)
+    {
+        scopeSilentRun = juce::jmin(scopeSilentRun + bufferToFill.numSamples, 1 << 30);
+        return;
+    }
 
-            dryL = dryL * (1.0f - delayMix) + wetL * delayMix;
-            dryR = dryR * (1.0f - delayMix) + wetR * delayMix;
-        }
-        else if (maxDelaySamples > 1)
-        {
-            delayBuffer.setSample(0, delayWritePosition, dryL);
-            delayBuffer.setSample(1, delayWritePosition, dryR);
-            delayWritePosition = (delayWritePosition + 1) % maxDelaySamples;
-        }
+    float scopePeak = 0.0f;
+    for (int i = 0; i < bufferToFill.numSamples; ++i)
+    {
+        scopeBuffer.setSample(0, scopeWritePos, l[i]);
+        scopeWritePos = (scopeWritePos + 1) % scopeBuffer.getNumSamples();
+        scopePeak = juce::jmax(scopePeak, std::abs(l[i]));
+    }
 
-        if (glitchProbLocal > 0.0f)
-        {
-            if (glitchSamplesRemaining > 0)
-            {
-                --glitchSamplesRemaining;
-                dryL = glitchHeldL;
-                dryR = glitchHeldR;
-            }
-            else if (random.nextFloat() < glitchProbLocal * 0.004f)
-            {
-                glitchSamplesRemaining = juce::jmax(4, (int)std::round(juce::jmap(glitchProbLocal, 0.0f, 1.0f,
-                    12.0f,
-                    (float)currentSR * 0.08f)));
-                glitchHeldL = dryL;
-                glitchHeldR = dryR;
-            }
-        }
-        else
-        {
-            glitchSamplesRemaining = 0;
-        }
+    // Once a whole scope's worth of silence has gone in, the picture is a flat
+    // line that no longer changes and the UI can stop drawing it
+    const int previousSilentRun = scopeSilentRun;
+    scopeSilentRun = scopePeak < scopeSilenceThreshold ? juce::jmin(scopeSilentRun + bufferToFill.numSamples, 1 << 30) : 0;
+    if (previousSilentRun < scopeBuffer.getNumSamples())
+        scopeVersion.fetch_add(1, std::memory_order_release);
+}
 
-        l[i] = dryL;
-        if (r) r[i] = dryR;
+void MainComponent::renderResampled(float* left, float* right, int numSamples, const juce::MidiBuffer& midi,
+                                    QualityGovernor::Tier tier, bool enabled) noexcept
+{
+    for (int start = 0; start < numSamples;)
+    {
+        const int n = juce::jmin(numSamples - start, rateConverter.getMaxOutputBlock());
+        const int inputs = rateConverter.getInputSamplesNeeded(n);
+
+        // Each event moves to the matching sample of the internal-rate block
+        resampledMidi.clear();
+        for (const auto metadata : midi)
+            if (metadata.samplePosition >= start && metadata.samplePosition < start + n)
+                resampledMidi.addEvent(metadata.data, metadata.numBytes,
+                    juce::jlimit(0, juce::jmax(0, inputs - 1), (int)((juce::int64)(metadata.samplePosition - start) * inputs / n)));
+
+        float* inL = rateConverter.getInputBuffer(0);
+        float* inR = right != nullptr ? rateConverter.getInputBuffer(1) : nullptr;
+        juce::FloatVectorOperations::clear(inL, inputs);
+        if (inR != nullptr)
+            juce::FloatVectorOperations::clear(inR, inputs);
+
+        performanceTrace.beginBlock(inputs, tier, enabled, inR == nullptr, resampledMidi);
+        engine.render(inL, inR, inputs, resampledMidi);
+        performanceTrace.endBlock(engine, inL, inR, inputs);
+
+        rateConverter.process(left + start, right != nullptr ? right + start : nullptr, n);
+        start += n;
+    }
+}
 
-        scopeBuffer.setSample(0, scopeWritePos, l[i]);
-        scopeWritePos = (scopeWritePos + 1) % scopeBuffer.getNumSamples();
+void MainComponent::measureCallbackJitter(int numSamples) noexcept
+{
+    const auto now = juce::Time::getHighResolutionTicks();
+    if (lastCallbackTicks != 0)
+    {
+        const double interval = juce::Time::highResolutionTicksToSeconds(now - lastCallbackTicks);
+        const float jitter = (float)(std::abs(interval - lastBlockSeconds) * 1.0e6);
+        const float smoothed = callbackJitterMicros.load(std::memory_order_relaxed);
+        callbackJitterMicros.store(smoothed + jitterSmoothing * (jitter - smoothed), std::memory_order_relaxed);
+        if (jitter > worstCallbackJitterMicros.load(std::memory_order_relaxed))
+            worstCallbackJitterMicros.store(jitter, std::memory_order_relaxed);
     }
+    lastCallbackTicks = now;
+    lastBlockSeconds = deviceSampleRate > 0.0 ? numSamples / deviceSampleRate : 0.0;
 }
 
 void MainComponent::releaseResources()
 {
-    filterL.reset();
-    filterR.reset();
-    amplitudeEnvelope.reset();
-    chorus.reset();
+    // Nothing is freed or reset, so held notes and tails survive a device
+    // restart that keeps the rate
 }
 
 int MainComponent::findZeroCrossingIndex(int searchSpan) const
@@ -434,6 +344,21 @@ int MainComponent::findZeroCrossingIndex(int searchSpan) const
 
 void MainComponent::paint(juce::Graphics& g)
 {
+    TRACE_ZONE("paint");
+    const ScopedTickCounter paintTimer(paintTicks);
+    ++paintCount;
+    if (startupTimes.firstPaint == 0.0)
+    {
+        startupTimes.firstPaint = millisecondsSinceStart();
+
+        // Posted, so the frame reaches the screen before the device blocks the message thread
+        juce::MessageManager::callAsync([safeThis = juce::Component::SafePointer<MainComponent>(this)]
+        {
+            if (safeThis != nullptr)
+                safeThis->startDevices();
+        });
+    }
+
     auto bounds = getLocalBounds().toFloat();
 
     juce::ColourGradient backgroundGradient(Theme::backgroundTop, 0.0f, 0.0f,
@@ -464,18 +389,86 @@ void MainComponent::paint(juce::Graphics& g)
     drawPanel(controlStripRect);
     drawPanel(keyboardRect);
 
-    if (!headerRect.isEmpty())
+    if (!headerRect.isEmpty() && g.clipRegionIntersects(headerRect))
     {
-        auto headerTextBounds = headerRect.reduced(18, 6);
+        auto headerTextBounds = headerRect.withRight(headerButtonsLeft).reduced(18, 6);
         auto statusArea = headerTextBounds.removeFromRight(audioToggle.getWidth() + 24);
+        auto qualityArea = headerTextBounds.removeFromRight(200);
+        qualityRect = qualityArea;
+        meterRect = headerTextBounds.removeFromRight(meterAreaWidth);
+        auto recordArea = outputRecorder.isRecording() || performanceTrace.isActive()
+                              ? headerTextBounds.removeFromRight(110) : juce::Rectangle<int>();
 
         g.setColour(Theme::textSecondary.withAlpha(0.9f));
         g.setFont(juce::FontOptions(17.0f).withStyle("Bold"));
         g.drawFittedText("SPECTRAL LAB", headerTextBounds, juce::Justification::left, 1);
 
-        g.setColour(audioEnabled ? Theme::accent : Theme::glitchColour.withAlpha(0.7f));
         g.setFont(juce::FontOptions(13.0f).withStyle("Regular"));
-        g.drawFittedText(audioEnabled ? "AUDIO: ONLINE" : "AUDIO: STANDBY", statusArea, juce::Justification::centredRight, 1);
+        if (!audioStarted)
+        {
+            g.setColour(Theme::textSecondary);
+            g.drawFittedText("AUDIO: STARTING", statusArea, juce::Justification::centredRight, 1);
+        }
+        else
+        {
+            g.setColour(audioEnabled ? Theme::accent : Theme::glitchColour.withAlpha(0.7f));
+            g.drawFittedText(audioEnabled ? "AUDIO: ONLINE" : "AUDIO: STANDBY", statusArea, juce::Justification::centredRight, 1);
+        }
+
+        const auto tier = qualityGovernor.getTier();
+        const auto cpuPercent = juce::roundToInt(qualityGovernor.getLoad() * 100.0f);
+        g.setColour(tier == QualityGovernor::Tier::full ? Theme::textSecondary : Theme::glitchColour.withAlpha(0.9f));
+        g.drawFittedText(juce::String("Q: ") + QualityGovernor::getTierName(tier) + "  CPU " + juce::String(cpuPercent) + "%"
+                         + "  LAT " + juce::String(getOutputLatencyMs(), 1) + "ms",
+            qualityArea, juce::Justification::centredRight, 1);
+
+        if (outputRecorder.isRecording() || performanceTrace.isActive())
+        {
+            juce::String recordText;
+            if (outputRecorder.isRecording())
+            {
+                const int seconds = (int)outputRecorder.getRecordedSeconds();
+                const int dropped = outputRecorder.getDroppedBlocks();
+                recordText << "REC " << juce::String(seconds / 60).paddedLeft('0', 2)
+                           << ":" << juce::String(seconds % 60).paddedLeft('0', 2);
+                if (dropped > 0)
+                    recordText << "  DROP " << dropped;
+            }
+            if (performanceTrace.isActive())
+                recordText << (recordText.isEmpty() ? "" : "  ") << "TRACE";
+
+            g.setColour(Theme::glitchColour.withAlpha(0.95f));
+            g.drawFittedText(recordText, recordArea, juce::Justification::centredRight, 1);
+        }
+
+        // Output meter: RMS bar with a sample-peak tick, then true peak and
+        // loudness. Outlined while the limiter is working. Click for options.
+        const auto meter = outputMeter.getReadings();
+        auto meterArea = meterRect;
+        auto barArea = meterArea.removeFromLeft(72).withSizeKeepingCentre(72, 8).toFloat();
+        const auto dbToX = [&barArea](float db)
+        {
+            return barArea.getX() + barArea.getWidth() * juce::jlimit(0.0f, 1.0f, (db - meterFloorDb) / -meterFloorDb);
+        };
+        const bool truePeakHot = meter.truePeakDb > truePeakWarningDb;
+
+        g.setColour(Theme::gridMinor.withAlpha(0.6f));
+        g.fillRoundedRectangle(barArea, 2.0f);
+        if (limiter.getGainReductionDb() < -0.1f)
+        {
+            g.setColour(Theme::accent.withAlpha(0.8f));
+            g.drawRoundedRectangle(barArea.expanded(1.5f), 2.5f, 1.0f);
+        }
+        g.setColour(Theme::accentDim);
+        g.fillRect(barArea.withRight(dbToX(meter.rmsDb)));
+        g.setColour(truePeakHot ? Theme::glitchColour.withAlpha(0.95f) : Theme::accent);
+        g.fillRect(juce::Rectangle<float>(dbToX(meter.peakDb) - 1.0f, barArea.getY() - 2.0f, 2.0f, barArea.getHeight() + 4.0f));
+
+        const auto formatDb = [](float db) { return db <= OutputMeter::silenceDb ? juce::String("-inf") : juce::String(db, 1); };
+        g.setColour(meter.maxTruePeakDb > 0.0f ? Theme::glitchColour.withAlpha(0.95f) : Theme::textSecondary);
+        g.drawFittedText("TP " + formatDb(meter.truePeakDb) + "  S " + formatDb(meter.shortTermLufs)
+                         + "  I " + formatDb(meter.integratedLufs) + " LUFS",
+            meterArea, juce::Justification::centredRight, 1);
     }
 
     if (!controlStripRect.isEmpty())
@@ -500,7 +493,7 @@ void MainComponent::paint(juce::Graphics& g)
         g.drawRoundedRectangle(kbBounds, 10.0f, 1.0f);
     }
 
-    if (scopeRect.isEmpty())
+    if (scopeRect.isEmpty() || !g.clipRegionIntersects(scopeRect))
         return;
 
     auto scopeBounds = scopeRect.toFloat();
@@ -542,7 +535,7 @@ void MainComponent::paint(juce::Graphics& g)
         const float H = scopeInner.getHeight();
         const float Y0 = scopeInner.getY();
         const float X0 = scopeInner.getX();
-        const float glitchMagnitude = juce::jmap(glitchProbability, 0.0f, 1.0f, 0.0025f, 0.08f);
+        const float glitchMagnitude = juce::jmap(params.glitchProbability, 0.0f, 1.0f, 0.0025f, 0.08f);
 
         for (int x = 0; x < W; ++x)
         {
@@ -564,7 +557,7 @@ void MainComponent::paint(juce::Graphics& g)
                 glowPath.lineTo(px, y);
             }
 
-            if (visualRandom.nextFloat() < juce::jlimit(0.025f, 0.22f, glitchProbability * 0.25f + 0.02f))
+            if (visualRandom.nextFloat() < juce::jlimit(0.025f, 0.22f, params.glitchProbability * 0.25f + 0.02f))
             {
                 const float burstHeight = juce::jmap(visualRandom.nextFloat(), 0.0f, 1.0f, H * 0.04f, H * 0.18f);
                 const float burstY = juce::jlimit(scopeInner.getY(), scopeInner.getBottom() - burstHeight, y - burstHeight * 0.5f);
@@ -578,7 +571,7 @@ void MainComponent::paint(juce::Graphics& g)
         g.setColour(Theme::scopeTrace);
         g.strokePath(waveformPath, juce::PathStrokeType(2.0f, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
 
-        const float glitchAlpha = juce::jmap(glitchProbability, 0.0f, 1.0f, 0.18f, 0.65f);
+        const float glitchAlpha = juce::jmap(params.glitchProbability, 0.0f, 1.0f, 0.18f, 0.65f);
         g.setColour(Theme::glitchColour.withAlpha(glitchAlpha));
         g.fillPath(glitchBursts);
 
@@ -593,17 +586,97 @@ void MainComponent::paint(juce::Graphics& g)
 
 void MainComponent::timerCallback()
 {
-    const float speed = juce::jmap(glitchProbability, 0.0f, 1.0f, 0.006f, 0.03f);
-    scanProgress += speed;
-    while (scanProgress > 1.0f)
-        scanProgress -= 1.0f;
+    TRACE_ZONE("timerCallback");
+    engine.getWavetableBank().collectGarbage();
+    engine.getTuningBank().collectGarbage();
+
+    // A window that isn't painted (minimised at launch) still gets sound
+    if (!devicesRequested && !isShowing())
+        startDevices();
+    logStartupTimes();
+
+    const auto now = juce::Time::getHighResolutionTicks();
+    const double elapsed = juce::Time::highResolutionTicksToSeconds(now - statsStartTicks);
+    if (elapsed > 0.0)
+    {
+        drawnFramesPerSecond = (float)(paintCount / elapsed);
+        paintLoadPercent = (float)(100.0 * juce::Time::highResolutionTicksToSeconds(paintTicks) / elapsed);
+    }
+    statsStartTicks = now;
+    paintTicks = 0;
+    paintCount = 0;
+}
 
-    repaint();
+void MainComponent::onVBlank(double timestampSeconds)
+{
+    auto* peer = getPeer();
+    if (!isShowing() || peer == nullptr || peer->isMinimised())
+        return;
+
+    const double sinceLastFrame = timestampSeconds - lastFrameSeconds;
+    if (frameRateCap > 0 && sinceLastFrame < 1.0 / frameRateCap - frameCapSlackSeconds)
+        return;
+
+    TRACE_ZONE("vblank");
+    lastFrameSeconds = timestampSeconds;
+
+    const auto version = scopeVersion.load(std::memory_order_acquire);
+    if (version != drawnScopeVersion)
+    {
+        drawnScopeVersion = version;
+
+        // The scan line keeps the same speed whatever the frame rate
+        const float speed = juce::jmap(params.glitchProbability, 0.0f, 1.0f, 0.006f, 0.03f);
+        scanProgress += speed * (float)(juce::jlimit(0.0, 0.1, sinceLastFrame) * scanSpeedReferenceHz);
+        while (scanProgress > 1.0f)
+            scanProgress -= 1.0f;
+
+        repaint(scopeRect);
+    }
+
+    if (timestampSeconds - lastHeaderSeconds >= 1.0 / headerRefreshHz)
+    {
+        lastHeaderSeconds = timestampSeconds;
+        const auto state = getHeaderState();
+        if (state != drawnHeaderState)
+        {
+            drawnHeaderState = state;
+            repaint(headerRect.withRight(headerButtonsLeft));
+        }
+    }
+}
+
+MainComponent::HeaderState MainComponent::getHeaderState()
+{
+    // Everything the header text and meter show, at the resolution they show it
+    const auto meter = outputMeter.getReadings();
+    const auto tenths = [](float db) { return juce::roundToInt(juce::jmax(db, OutputMeter::silenceDb) * 10.0f); };
+
+    return { tenths(meter.rmsDb), tenths(meter.peakDb), tenths(meter.truePeakDb), tenths(meter.maxTruePeakDb),
+             tenths(meter.shortTermLufs), tenths(meter.integratedLufs),
+             (int)qualityGovernor.getTier(), juce::roundToInt(qualityGovernor.getLoad() * 100.0f),
+             juce::roundToInt(getOutputLatencyMs() * 10.0),
+             outputRecorder.isRecording() ? (int)outputRecorder.getRecordedSeconds() : -1,
+             outputRecorder.getDroppedBlocks(),
+             performanceTrace.isActive() ? 1 : 0,
+             limiter.getGainReductionDb() < -0.1f ? 1 : 0,
+             audioStarted ? (audioEnabled ? 1 : 0) : -1 };
+}
+
+void MainComponent::mouseDown(const juce::MouseEvent& e)
+{
+    if (meterRect.contains(e.getPosition()))
+        showOutputMenu();
+    else if (qualityRect.contains(e.getPosition()))
+        showDisplayMenu();
+    else if (unisonValue.getBounds().contains(e.getPosition()))
+        showUnisonMenu();
 }
 
 // ✅ FINAL DEFINITIVE FIX FOR ALL JUCE VERSIONS ✅
 void MainComponent::resized()
 {
+    TRACE_ZONE("resized");
     // Enforce survival layout — prevents overlap
     if (getWidth() < minWidth || getHeight() < minHeight)
         setSize(std::max(getWidth(), minWidth), std::max(getHeight(), minHeight));
@@ -613,6 +686,12 @@ void MainComponent::resized()
     auto bar = area.removeFromTop(headerBarHeight);
     headerRect = bar;
     audioToggle.setBounds(bar.getRight() - audioButtonWidth, bar.getY() + 4, audioButtonWidth, audioButtonHeight);
+    headerButtonsLeft = audioToggle.getX();
+    for (auto* button : { &recordButton, &vocoderButton, &spectralButton, &tuningButton, &arpButton, &fmButton, &wavetableButton, &loadSamplesButton, &loadIrButton, &freezeButton })
+    {
+        headerButtonsLeft -= headerButtonGap + headerButtonWidth;
+        button->setBounds(headerButtonsLeft, bar.getY() + 4, headerButtonWidth, audioButtonHeight);
+    }
 
     auto strip = area.removeFromTop(controlStripHeight);
     controlStripRect = strip;
@@ -645,14 +724,19 @@ void MainComponent::resized()
         { &delayLabel, &delayKnob, &delayValue },   // 18
         { &chorusLabel, &chorusKnob, &chorusValue }, // 19
         { &autoPanLabel, &autoPanKnob, &autoPanValue }, // 20
-        { &glitchLabel, &glitchKnob, &glitchValue } // 21
+        { &glitchLabel, &glitchKnob, &glitchValue }, // 21
+        { &reverbLabel, &reverbKnob, &reverbValue }, // 22
+        { &roomLabel, &roomKnob, &roomValue }, // 23
+        { &sampleLabel, &sampleKnob, &sampleValue }, // 24
+        { &grainLabel, &grainKnob, &grainValue }, // 25
+        { &unisonLabel, &unisonKnob, &unisonValue } // 26
     };
 
     // Index lists per group (match your chosen mapping)
-    const int oscIdx[]   = { 0, 15, 1, 6 };                // Waveform, Sub Mix, Gain, Pitch
+    const int oscIdx[]   = { 0, 26, 15, 24, 1, 6 };        // Waveform, Unison, Sub Mix, Sample, Gain, Pitch
     const int filtIdx[]  = { 7, 8, 12 };                   // Cutoff, Resonance, Filter Mod
     const int adsrIdx[]  = { 2, 3, 4, 9 };                 // Attack, Decay, Sustain, Release
-    const int fxIdx[]    = { 16, 13, 14, 18, 19, 5, 20, 17, 21, 10, 11 }; // Env->Filter, Drive, Crush, Delay, Chorus, Width, Auto-Pan, Chaos, Glitch, LFO Rate, LFO Depth
+    const int fxIdx[]    = { 16, 13, 14, 18, 23, 22, 19, 5, 20, 17, 21, 25, 10, 11 }; // Env->Filter, Drive, Crush, Delay, Room, Reverb, Chorus, Width, Auto-Pan, Chaos, Glitch, Grains, LFO Rate, LFO Depth
 
     const int grpCount = 4;
     const int grpSizes[grpCount] = { (int)std::size(oscIdx), (int)std::size(filtIdx), (int)std::size(adsrIdx), (int)std::size(fxIdx) };
@@ -714,6 +798,7 @@ void MainComponent::initialiseUi()
 {
     initialiseSliders();
     initialiseToggle();
+    initialiseHeaderButtons();
 }
 
 void MainComponent::initialiseSliders()
@@ -726,80 +811,75 @@ void MainComponent::initialiseSliders()
     configureValueLabel(waveValue);
     waveKnob.onValueChange = [this]
     {
-        waveMorph = (float)waveKnob.getValue();
-        waveValue.setText(juce::String(waveMorph, 2), juce::dontSendNotification);
+        params.waveMorph = (float)waveKnob.getValue();
+        waveValue.setText(juce::String(params.waveMorph, 2), juce::dontSendNotification);
     };
     waveKnob.onValueChange();
 
     configureRotarySlider(gainKnob);
     gainKnob.setRange(0.0, 1.0);
-    gainKnob.setValue(outputGain);
+    gainKnob.setValue(params.outputGain);
     addAndMakeVisible(gainKnob);
     configureCaptionLabel(gainLabel, "Gain");
     configureValueLabel(gainValue);
     gainKnob.onValueChange = [this]
     {
-        outputGain = (float)gainKnob.getValue();
-        gainSmoothed.setTargetValue(outputGain);
-        gainValue.setText(juce::String(outputGain * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.outputGain = (float)gainKnob.getValue();
+        gainValue.setText(juce::String(params.outputGain * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     gainKnob.onValueChange();
 
     configureRotarySlider(attackKnob);
     attackKnob.setRange(0.0, 2000.0, 1.0);
     attackKnob.setSkewFactorFromMidPoint(40.0);
-    attackKnob.setValue(attackMs);
+    attackKnob.setValue(params.attackMs);
     addAndMakeVisible(attackKnob);
     configureCaptionLabel(attackLabel, "Attack");
     configureValueLabel(attackValue);
     attackKnob.onValueChange = [this]
     {
-        attackMs = (float)attackKnob.getValue();
-        attackValue.setText(juce::String(attackMs, 0) + " ms", juce::dontSendNotification);
-        updateAmplitudeEnvelope();
+        params.attackMs = (float)attackKnob.getValue();
+        attackValue.setText(juce::String(params.attackMs, 0) + " ms", juce::dontSendNotification);
     };
     attackKnob.onValueChange();
 
     configureRotarySlider(decayKnob);
     decayKnob.setRange(5.0, 4000.0, 1.0);
     decayKnob.setSkewFactorFromMidPoint(200.0);
-    decayKnob.setValue(decayMs);
+    decayKnob.setValue(params.decayMs);
     addAndMakeVisible(decayKnob);
     configureCaptionLabel(decayLabel, "Decay");
     configureValueLabel(decayValue);
     decayKnob.onValueChange = [this]
     {
-        decayMs = (float)decayKnob.getValue();
-        decayValue.setText(juce::String(decayMs, 0) + " ms", juce::dontSendNotification);
-        updateAmplitudeEnvelope();
+        params.decayMs = (float)decayKnob.getValue();
+        decayValue.setText(juce::String(params.decayMs, 0) + " ms", juce::dontSendNotification);
     };
     decayKnob.onValueChange();
 
     configureRotarySlider(sustainKnob);
     sustainKnob.setRange(0.0, 1.0, 0.01);
-    sustainKnob.setValue(sustainLevel);
+    sustainKnob.setValue(params.sustainLevel);
     addAndMakeVisible(sustainKnob);
     configureCaptionLabel(sustainLabel, "Sustain");
     configureValueLabel(sustainValue);
     sustainKnob.onValueChange = [this]
     {
-        sustainLevel = (float)sustainKnob.getValue();
-        sustainValue.setText(juce::String(sustainLevel * 100.0f, 0) + "%", juce::dontSendNotification);
-        updateAmplitudeEnvelope();
+        params.sustainLevel = (float)sustainKnob.getValue();
+        sustainValue.setText(juce::String(params.sustainLevel * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     sustainKnob.onValueChange();
 
     configureRotarySlider(widthKnob);
     widthKnob.setRange(0.0, 2.0, 0.01);
-    widthKnob.setValue(stereoWidth);
+    widthKnob.setValue(params.stereoWidth);
     addAndMakeVisible(widthKnob);
     configureCaptionLabel(widthLabel, "Width");
     configureValueLabel(widthValue);
     widthKnob.onValueChange = [this]
     {
-        stereoWidth = (float)widthKnob.getValue();
-        stereoWidthSmoothed.setTargetValue(stereoWidth);
-        widthValue.setText(juce::String(stereoWidth, 2) + "x", juce::dontSendNotification);
+        params.stereoWidth = (float)widthKnob.getValue();
+        widthValue.setText(juce::String(params.stereoWidth, 2) + "x", juce::dontSendNotification);
     };
     widthKnob.onValueChange();
 
@@ -812,217 +892,278 @@ void MainComponent::initialiseSliders()
     configureValueLabel(pitchValue);
     pitchKnob.onValueChange = [this]
     {
-        setTargetFrequency((float)pitchKnob.getValue());
-        pitchValue.setText(juce::String(targetFrequency, 1) + " Hz", juce::dontSendNotification);
+        params.pitchHz = (float)pitchKnob.getValue();
+        pitchValue.setText(juce::String(params.pitchHz, 1) + " Hz", juce::dontSendNotification);
     };
     pitchKnob.onValueChange();
 
     configureRotarySlider(cutoffKnob);
     cutoffKnob.setRange(80.0, 10000.0, 1.0);
     cutoffKnob.setSkewFactorFromMidPoint(1000.0);
-    cutoffKnob.setValue(cutoffHz);
+    cutoffKnob.setValue(params.cutoffHz);
     addAndMakeVisible(cutoffKnob);
     configureCaptionLabel(cutoffLabel, "Cutoff");
     configureValueLabel(cutoffValue);
     cutoffKnob.onValueChange = [this]
     {
-        cutoffHz = (float)cutoffKnob.getValue();
-        cutoffSmoothed.setTargetValue(cutoffHz);
-        cutoffValue.setText(juce::String(cutoffHz, 1) + " Hz", juce::dontSendNotification);
-        filterUpdateCount = filterUpdateStep;
+        params.cutoffHz = (float)cutoffKnob.getValue();
+        cutoffValue.setText(juce::String(params.cutoffHz, 1) + " Hz", juce::dontSendNotification);
     };
     cutoffKnob.onValueChange();
 
     configureRotarySlider(resonanceKnob);
     resonanceKnob.setRange(0.1, 10.0, 0.01);
     resonanceKnob.setSkewFactorFromMidPoint(0.707);
-    resonanceKnob.setValue(resonanceQ);
+    resonanceKnob.setValue(params.resonanceQ);
     addAndMakeVisible(resonanceKnob);
     configureCaptionLabel(resonanceLabel, "Resonance (Q)");
     configureValueLabel(resonanceValue);
     resonanceKnob.onValueChange = [this]
     {
-        resonanceQ = (float)resonanceKnob.getValue();
-        if (resonanceQ < 0.1f) resonanceQ = 0.1f;
-        resonanceSmoothed.setTargetValue(resonanceQ);
-        resonanceValue.setText(juce::String(resonanceQ, 2), juce::dontSendNotification);
-        filterUpdateCount = filterUpdateStep;
+        params.resonanceQ = (float)resonanceKnob.getValue();
+        if (params.resonanceQ < 0.1f) params.resonanceQ = 0.1f;
+        resonanceValue.setText(juce::String(params.resonanceQ, 2), juce::dontSendNotification);
     };
     resonanceKnob.onValueChange();
 
     configureRotarySlider(releaseKnob);
     releaseKnob.setRange(1.0, 4000.0, 1.0);
     releaseKnob.setSkewFactorFromMidPoint(200.0);
-    releaseKnob.setValue(releaseMs);
+    releaseKnob.setValue(params.releaseMs);
     addAndMakeVisible(releaseKnob);
     configureCaptionLabel(releaseLabel, "Release");
     configureValueLabel(releaseValue);
     releaseKnob.onValueChange = [this]
     {
-        releaseMs = (float)releaseKnob.getValue();
-        releaseValue.setText(juce::String(releaseMs, 0) + " ms", juce::dontSendNotification);
-        updateAmplitudeEnvelope();
+        params.releaseMs = (float)releaseKnob.getValue();
+        releaseValue.setText(juce::String(params.releaseMs, 0) + " ms", juce::dontSendNotification);
     };
     releaseKnob.onValueChange();
 
     configureRotarySlider(lfoKnob);
     lfoKnob.setRange(0.05, 15.0);
-    lfoKnob.setValue(lfoRateHz);
+    lfoKnob.setValue(params.lfoRateHz);
     addAndMakeVisible(lfoKnob);
     configureCaptionLabel(lfoLabel, "LFO Rate");
     configureValueLabel(lfoValue);
     lfoKnob.onValueChange = [this]
     {
-        lfoRateHz = (float)lfoKnob.getValue();
-        lfoValue.setText(juce::String(lfoRateHz, 2) + " Hz", juce::dontSendNotification);
+        params.lfoRateHz = (float)lfoKnob.getValue();
+        lfoValue.setText(juce::String(params.lfoRateHz, 2) + " Hz", juce::dontSendNotification);
     };
     lfoKnob.onValueChange();
 
     configureRotarySlider(lfoDepthKnob);
     lfoDepthKnob.setRange(0.0, 1.0);
-    lfoDepthKnob.setValue(lfoDepth);
+    lfoDepthKnob.setValue(params.lfoDepth);
     addAndMakeVisible(lfoDepthKnob);
     configureCaptionLabel(lfoDepthLabel, "LFO Depth");
     configureValueLabel(lfoDepthValue);
     lfoDepthKnob.onValueChange = [this]
     {
-        lfoDepth = (float)lfoDepthKnob.getValue();
-        lfoDepthSmoothed.setTargetValue(lfoDepth);
-        lfoDepthValue.setText(juce::String(lfoDepth, 2), juce::dontSendNotification);
+        params.lfoDepth = (float)lfoDepthKnob.getValue();
+        lfoDepthValue.setText(juce::String(params.lfoDepth, 2), juce::dontSendNotification);
     };
     lfoDepthKnob.onValueChange();
 
     configureRotarySlider(filterModKnob);
     filterModKnob.setRange(0.0, 1.0, 0.001);
-    filterModKnob.setValue(lfoCutModAmt);
+    filterModKnob.setValue(params.lfoCutModAmt);
     addAndMakeVisible(filterModKnob);
     configureCaptionLabel(filterModLabel, "Filter Mod");
     configureValueLabel(filterModValue);
     filterModKnob.onValueChange = [this]
     {
-        lfoCutModAmt = (float)filterModKnob.getValue();
-        filterModValue.setText(juce::String(lfoCutModAmt, 2), juce::dontSendNotification);
+        params.lfoCutModAmt = (float)filterModKnob.getValue();
+        filterModValue.setText(juce::String(params.lfoCutModAmt, 2), juce::dontSendNotification);
     };
     filterModKnob.onValueChange();
 
     configureRotarySlider(driveKnob);
     driveKnob.setRange(0.0, 1.0);
-    driveKnob.setValue(driveAmount);
+    driveKnob.setValue(params.driveAmount);
     addAndMakeVisible(driveKnob);
     configureCaptionLabel(driveLabel, "Drive");
     configureValueLabel(driveValue);
     driveKnob.onValueChange = [this]
     {
-        driveAmount = (float)driveKnob.getValue();
-        driveSmoothed.setTargetValue(driveAmount);
-        driveValue.setText(juce::String(driveAmount, 2), juce::dontSendNotification);
+        params.driveAmount = (float)driveKnob.getValue();
+        driveValue.setText(juce::String(params.driveAmount, 2), juce::dontSendNotification);
     };
     driveKnob.onValueChange();
 
     configureRotarySlider(crushKnob);
     crushKnob.setRange(0.0, 1.0);
-    crushKnob.setValue(crushAmount);
+    crushKnob.setValue(params.crushAmount);
     addAndMakeVisible(crushKnob);
     configureCaptionLabel(crushLabel, "Crush");
     configureValueLabel(crushValue);
     crushKnob.onValueChange = [this]
     {
-        crushAmount = (float)crushKnob.getValue();
-        crushValue.setText(juce::String(crushAmount * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.crushAmount = (float)crushKnob.getValue();
+        crushValue.setText(juce::String(params.crushAmount * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     crushKnob.onValueChange();
 
     configureRotarySlider(subMixKnob);
     subMixKnob.setRange(0.0, 1.0);
-    subMixKnob.setValue(subMixAmount);
+    subMixKnob.setValue(params.subMixAmount);
     addAndMakeVisible(subMixKnob);
     configureCaptionLabel(subMixLabel, "Sub Mix");
     configureValueLabel(subMixValue);
     subMixKnob.onValueChange = [this]
     {
-        subMixAmount = (float)subMixKnob.getValue();
-        subMixValue.setText(juce::String(subMixAmount * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.subMixAmount = (float)subMixKnob.getValue();
+        subMixValue.setText(juce::String(params.subMixAmount * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     subMixKnob.onValueChange();
 
     configureRotarySlider(envFilterKnob);
     envFilterKnob.setRange(-1.0, 1.0, 0.01);
-    envFilterKnob.setValue(envFilterAmount);
+    envFilterKnob.setValue(params.envFilterAmount);
     addAndMakeVisible(envFilterKnob);
     configureCaptionLabel(envFilterLabel, "Env->Filter");
     configureValueLabel(envFilterValue);
     envFilterKnob.onValueChange = [this]
     {
-        envFilterAmount = (float)envFilterKnob.getValue();
-        envFilterValue.setText(juce::String(envFilterAmount, 2), juce::dontSendNotification);
+        params.envFilterAmount = (float)envFilterKnob.getValue();
+        envFilterValue.setText(juce::String(params.envFilterAmount, 2), juce::dontSendNotification);
     };
     envFilterKnob.onValueChange();
 
     configureRotarySlider(chaosKnob);
     chaosKnob.setRange(0.0, 1.0);
-    chaosKnob.setValue(chaosAmount);
+    chaosKnob.setValue(params.chaosAmount);
     addAndMakeVisible(chaosKnob);
     configureCaptionLabel(chaosLabel, "Chaos");
     configureValueLabel(chaosValueLabel);
     chaosKnob.onValueChange = [this]
     {
-        chaosAmount = (float)chaosKnob.getValue();
-        chaosValueLabel.setText(juce::String(chaosAmount * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.chaosAmount = (float)chaosKnob.getValue();
+        chaosValueLabel.setText(juce::String(params.chaosAmount * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     chaosKnob.onValueChange();
 
     configureRotarySlider(delayKnob);
     delayKnob.setRange(0.0, 1.0);
-    delayKnob.setValue(delayAmount);
+    delayKnob.setValue(params.delayAmount);
     addAndMakeVisible(delayKnob);
     configureCaptionLabel(delayLabel, "Delay");
     configureValueLabel(delayValue);
     delayKnob.onValueChange = [this]
     {
-        delayAmount = (float)delayKnob.getValue();
-        delayValue.setText(juce::String(delayAmount * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.delayAmount = (float)delayKnob.getValue();
+        delayValue.setText(juce::String(params.delayAmount * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     delayKnob.onValueChange();
 
     configureRotarySlider(chorusKnob);
     chorusKnob.setRange(0.0, 1.0);
-    chorusKnob.setValue(chorusMix);
+    chorusKnob.setValue(params.chorusMix);
     addAndMakeVisible(chorusKnob);
     configureCaptionLabel(chorusLabel, "Chorus");
     configureValueLabel(chorusValue);
     chorusKnob.onValueChange = [this]
     {
-        chorusMix = (float)chorusKnob.getValue();
-        chorusMixSmoothed.setTargetValue(chorusMix);
-        chorusValue.setText(juce::String(chorusMix * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.chorusMix = (float)chorusKnob.getValue();
+        chorusValue.setText(juce::String(params.chorusMix * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     chorusKnob.onValueChange();
 
     configureRotarySlider(autoPanKnob);
     autoPanKnob.setRange(0.0, 1.0);
-    autoPanKnob.setValue(autoPanAmount);
+    autoPanKnob.setValue(params.autoPanAmount);
     addAndMakeVisible(autoPanKnob);
     configureCaptionLabel(autoPanLabel, "Auto-Pan");
     configureValueLabel(autoPanValue);
     autoPanKnob.onValueChange = [this]
     {
-        autoPanAmount = (float)autoPanKnob.getValue();
-        autoPanValue.setText(juce::String(autoPanAmount * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.autoPanAmount = (float)autoPanKnob.getValue();
+        autoPanValue.setText(juce::String(params.autoPanAmount * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     autoPanKnob.onValueChange();
 
     configureRotarySlider(glitchKnob);
     glitchKnob.setRange(0.0, 1.0);
-    glitchKnob.setValue(glitchProbability);
+    glitchKnob.setValue(params.glitchProbability);
     addAndMakeVisible(glitchKnob);
     configureCaptionLabel(glitchLabel, "Glitch");
     configureValueLabel(glitchValue);
     glitchKnob.onValueChange = [this]
     {
-        glitchProbability = (float)glitchKnob.getValue();
-        glitchValue.setText(juce::String(glitchProbability * 100.0f, 0) + "%", juce::dontSendNotification);
+        params.glitchProbability = (float)glitchKnob.getValue();
+        glitchValue.setText(juce::String(params.glitchProbability * 100.0f, 0) + "%", juce::dontSendNotification);
     };
     glitchKnob.onValueChange();
+
+    configureRotarySlider(reverbKnob);
+    reverbKnob.setRange(0.0, 1.0);
+    reverbKnob.setValue(params.reverbMix);
+    addAndMakeVisible(reverbKnob);
+    configureCaptionLabel(reverbLabel, "Reverb");
+    configureValueLabel(reverbValue);
+    reverbKnob.onValueChange = [this]
+    {
+        params.reverbMix = (float)reverbKnob.getValue();
+        reverbValue.setText(juce::String(params.reverbMix * 100.0f, 0) + "%", juce::dontSendNotification);
+    };
+    reverbKnob.onValueChange();
+
+    configureRotarySlider(roomKnob);
+    roomKnob.setRange(0.0, 1.0);
+    roomKnob.setValue(params.roomMix);
+    addAndMakeVisible(roomKnob);
+    configureCaptionLabel(roomLabel, "Room");
+    configureValueLabel(roomValue);
+    roomKnob.onValueChange = [this]
+    {
+        params.roomMix = (float)roomKnob.getValue();
+        roomValue.setText(juce::String(params.roomMix * 100.0f, 0) + "%", juce::dontSendNotification);
+    };
+    roomKnob.onValueChange();
+
+    configureRotarySlider(sampleKnob);
+    sampleKnob.setRange(0.0, 1.0);
+    sampleKnob.setValue(params.sampleMix);
+    addAndMakeVisible(sampleKnob);
+    configureCaptionLabel(sampleLabel, "Sample");
+    configureValueLabel(sampleValue);
+    sampleKnob.onValueChange = [this]
+    {
+        params.sampleMix = (float)sampleKnob.getValue();
+        sampleValue.setText(juce::String(params.sampleMix * 100.0f, 0) + "%", juce::dontSendNotification);
+    };
+    sampleKnob.onValueChange();
+
+    configureRotarySlider(grainKnob);
+    grainKnob.setRange(0.0, 1.0);
+    grainKnob.setValue(params.grainMix);
+    addAndMakeVisible(grainKnob);
+    configureCaptionLabel(grainLabel, "Grains");
+    configureValueLabel(grainValue);
+    grainKnob.onValueChange = [this]
+    {
+        params.grainMix = (float)grainKnob.getValue();
+        grainValue.setText(juce::String(params.grainMix * 100.0f, 0) + "%", juce::dontSendNotification);
+    };
+    grainKnob.onValueChange();
+
+    configureRotarySlider(unisonKnob);
+    unisonKnob.setRange(1.0, (double)UnisonOscillator::maxVoices, 1.0);
+    unisonKnob.setValue(params.unisonVoices);
+    addAndMakeVisible(unisonKnob);
+    configureCaptionLabel(unisonLabel, "Unison");
+    configureValueLabel(unisonValue);
+    unisonKnob.onValueChange = [this]
+    {
+        params.unisonVoices = (int)unisonKnob.getValue();
+        unisonValue.setText(params.unisonVoices > 1 ? juce::String(params.unisonVoices) + "x" : "Off", juce::dontSendNotification);
+    };
+    unisonKnob.onValueChange();
+
+    // Detune, spread and phase live behind a click on the value
+    unisonValue.setInterceptsMouseClicks(false, false);
+    unisonValue.setMouseCursor(juce::MouseCursor::PointingHandCursor);
 }
 
 void MainComponent::initialiseToggle()
@@ -1037,24 +1178,563 @@ void MainComponent::initialiseToggle()
     {
         audioEnabled = audioToggle.getToggleState();
         audioToggle.setButtonText(audioEnabled ? "Audio ON" : "Audio OFF");
-        if (!audioEnabled)
-        {
-            midiGate = false;
-            amplitudeEnvelope.noteOff();
-        }
     };
     audioToggle.setButtonText("Audio ON");
     addAndMakeVisible(audioToggle);
 }
 
-void MainComponent::initialiseMidiInputs()
+void MainComponent::initialiseHeaderButtons()
+{
+    configureHeaderButton(loadIrButton);
+    loadIrButton.onClick = [this]
+    {
+        fileChooser = std::make_unique<juce::FileChooser>("Load impulse response", juce::File(), "*.wav;*.aif;*.aiff;*.flac");
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file.existsAsFile())
+                    engine.getConvolutionReverb().loadImpulseResponse(file);
+            });
+    };
+
+    configureHeaderButton(loadSamplesButton);
+    loadSamplesButton.onClick = [this]
+    {
+        fileChooser = std::make_unique<juce::FileChooser>("Load a sample or multisample folder", juce::File(), "*.wav;*.aif;*.aiff");
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode
+                                     | juce::FileBrowserComponent::canSelectFiles
+                                     | juce::FileBrowserComponent::canSelectDirectories,
+            [this](const juce::FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file.exists())
+                    engine.getSampleOscillator().loadSamples(file);
+            });
+    };
+
+    configureHeaderButton(wavetableButton);
+    wavetableButton.onClick = [this] { showWavetableMenu(); };
+
+    configureHeaderButton(fmButton);
+    fmButton.onClick = [this] { showFmMenu(); };
+
+    configureHeaderButton(arpButton);
+    arpButton.onClick = [this] { showArpMenu(); };
+
+    configureHeaderButton(tuningButton);
+    tuningButton.onClick = [this] { showTuningMenu(); };
+
+    configureHeaderButton(spectralButton);
+    spectralButton.onClick = [this] { showSpectralMenu(); };
+
+    configureHeaderButton(vocoderButton);
+    vocoderButton.onClick = [this] { showVocoderMenu(); };
+
+    configureHeaderButton(freezeButton);
+    freezeButton.setClickingTogglesState(true);
+    freezeButton.onClick = [this] { params.roomFreeze = freezeButton.getToggleState(); };
+
+    configureHeaderButton(recordButton);
+    recordButton.setClickingTogglesState(true);
+    recordButton.onClick = [this]
+    {
+        if (recordButton.getToggleState())
+            chooseRecordingFile();
+        else
+            outputRecorder.stopRecording();
+    };
+}
+
+void MainComponent::showWavetableMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem("Load wavetable...", [this]
+    {
+        fileChooser = std::make_unique<juce::FileChooser>("Load wavetable", juce::File(), "*.wav;*.aif;*.aiff;*.flac");
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file.existsAsFile())
+                    engine.getWavetableBank().loadFromFile(file);
+            });
+    });
+    menu.addItem("Use built-in shapes", engine.getWavetableBank().getName().isNotEmpty(), false,
+        [this] { engine.getWavetableBank().useBuiltInShapes(); });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&wavetableButton));
+}
+
+void MainComponent::showTuningMenu()
+{
+    auto& tuning = engine.getTuningBank();
+    const auto chooseFile = [this](const juce::String& title, const juce::String& pattern, std::function<void(const juce::File&)> load)
+    {
+        fileChooser = std::make_unique<juce::FileChooser>(title, juce::File(), pattern);
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [load](const juce::FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file.existsAsFile())
+                    load(file);
+            });
+    };
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader(tuning.getName());
+    menu.addItem("Load Scala scale...", [this, chooseFile]
+    {
+        chooseFile("Load Scala scale", "*.scl", [this](const juce::File& file) { engine.getTuningBank().loadScale(file); });
+    });
+    menu.addItem("Load keyboard mapping...", [this, chooseFile]
+    {
+        chooseFile("Load keyboard mapping", "*.kbm", [this](const juce::File& file) { engine.getTuningBank().loadKeyboardMapping(file); });
+    });
+    menu.addItem("Clear keyboard mapping", tuning.hasKeyboardMapping(), false,
+        [this] { engine.getTuningBank().loadKeyboardMapping({}); });
+    menu.addSeparator();
+    menu.addItem("12-TET", [this] { engine.getTuningBank().useEqualTemperament(); });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&tuningButton));
+}
+
+void MainComponent::showSpectralMenu()
+{
+    const int fftSize = 1 << params.spectralFftOrder;
+    const int hop = fftSize / params.spectralOverlap;
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Latency " + juce::String(1000.0 * (fftSize + hop) / engine.getSampleRate(), 1) + " ms");
+    for (float mix : { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f })
+        menu.addItem(mix == 0.0f ? juce::String("Off") : "Mix " + juce::String(mix * 100.0f, 0) + "%", true, params.spectralMix == mix, [this, mix]
+        {
+            params.spectralMix = mix;
+            spectralButton.setToggleState(mix > 0.0f, juce::dontSendNotification);
+        });
+    menu.addItem("Freeze", true, params.spectralFreeze, [this] { params.spectralFreeze = !params.spectralFreeze; });
+    menu.addSeparator();
+
+    juce::PopupMenu sizeMenu, hopMenu, blurMenu, gateMenu;
+    for (int order = SpectralProcessor::minFftOrder; order <= SpectralProcessor::maxFftOrder; ++order)
+        sizeMenu.addItem(juce::String(1 << order) + " points", true, params.spectralFftOrder == order,
+            [this, order] { params.spectralFftOrder = order; });
+    for (int overlap : { 2, 4, 8 })
+        hopMenu.addItem(juce::String(fftSize / overlap) + " samples (" + juce::String(overlap) + "x overlap)", true,
+            params.spectralOverlap == overlap, [this, overlap] { params.spectralOverlap = overlap; });
+    for (float blur : { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f })
+        blurMenu.addItem(blur == 0.0f ? juce::String("Off") : juce::String(blur * 100.0f, 0) + "%", true, params.spectralBlur == blur,
+            [this, blur] { params.spectralBlur = blur; });
+    for (float db : { SpectralProcessor::gateOffDb, -80.0f, -70.0f, -60.0f, -50.0f, -40.0f })
+        gateMenu.addItem(db <= SpectralProcessor::gateOffDb ? juce::String("Off") : juce::String(db, 0) + " dB", true,
+            params.spectralGateDb == db, [this, db] { params.spectralGateDb = db; });
+
+    menu.addSubMenu("FFT size", sizeMenu);
+    menu.addSubMenu("Hop", hopMenu);
+    menu.addSubMenu("Blur", blurMenu);
+    menu.addSubMenu("Gate", gateMenu);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&spectralButton));
+}
+
+void MainComponent::showVocoderMenu()
+{
+    const int bands = vocoder.getNumBands();
+    const float mix = vocoder.getMix();
+    const float inputGainDb = vocoder.getInputGainDb();
+    const float roundTripMs = vocoder.getRoundTripMs();
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader(activeInputChannels > 0 ? "Modulator: " + juce::String(activeInputChannels) + " input channel(s)"
+                          : mix > 0.0f ? juce::String("No audio input open") : juce::String("Audio input opens with the vocoder"));
+    for (float value : { 0.0f, 0.5f, 0.75f, 1.0f })
+        menu.addItem(value == 0.0f ? juce::String("Off") : "Mix " + juce::String(value * 100.0f, 0) + "%", true, mix == value,
+            [this, bands, value, inputGainDb]
+            {
+                vocoder.setParameters(bands, value, inputGainDb);
+                vocoderButton.setToggleState(value > 0.0f, juce::dontSendNotification);
+                if (audioStarted)
+                    setInputEnabled(value > 0.0f);
+            });
+    menu.addSeparator();
+
+    juce::PopupMenu bandsMenu, gainMenu;
+    for (int count : { 16, 24, 32 })
+        bandsMenu.addItem(juce::String(count) + " bands", true, bands == count,
+            [this, count, mix, inputGainDb] { vocoder.setParameters(count, mix, inputGainDb); });
+    for (float db : { 0.0f, 6.0f, 12.0f, 18.0f, 24.0f })
+        gainMenu.addItem("+" + juce::String(db, 0) + " dB", true, inputGainDb == db,
+            [this, bands, mix, db] { vocoder.setParameters(bands, mix, db); });
+    menu.addSubMenu("Bands", bandsMenu);
+    menu.addSubMenu("Input gain", gainMenu);
+    menu.addSeparator();
+
+    // Needs the output looped back to the input, by cable or speaker and mic
+    const auto lastRoundTrip = roundTripMs > 0.0f ? " (last " + juce::String(roundTripMs, 1) + " ms)"
+                             : roundTripMs < 0.0f ? juce::String(" (last: nothing came back)") : juce::String();
+    menu.addItem("Measure input-to-output latency" + lastRoundTrip, activeInputChannels > 0 && !vocoder.isMeasuringRoundTrip(), false,
+        [this] { vocoder.measureRoundTrip(); });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&vocoderButton));
+}
+
+void MainComponent::showUnisonMenu()
+{
+    // Plain values, latched by the audio thread at the start of each block
+    juce::PopupMenu detuneMenu, spreadMenu, phaseMenu;
+    for (float cents : { 5.0f, 10.0f, 18.0f, 25.0f, 35.0f, 50.0f, 75.0f, 100.0f })
+        detuneMenu.addItem("+/-" + juce::String(cents, 0) + " cents", true, params.unisonDetuneCents == cents,
+            [this, cents] { params.unisonDetuneCents = cents; });
+    for (float spread : { 0.0f, 0.25f, 0.5f, 0.8f, 1.0f })
+        spreadMenu.addItem(spread == 0.0f ? juce::String("Mono") : juce::String(juce::roundToInt(spread * 100.0f)) + "%", true,
+            params.unisonStereoSpread == spread, [this, spread] { params.unisonStereoSpread = spread; });
+    for (float random : { 0.0f, 0.25f, 0.5f, 1.0f })
+        phaseMenu.addItem(random == 0.0f ? juce::String("All in phase") : juce::String(juce::roundToInt(random * 100.0f)) + "% random", true,
+            params.unisonPhaseRandom == random, [this, random] { params.unisonPhaseRandom = random; });
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Unison " + (params.unisonVoices > 1 ? juce::String(params.unisonVoices) + " copies" : juce::String("off")));
+    menu.addSubMenu("Detune", detuneMenu);
+    menu.addSubMenu("Stereo spread", spreadMenu);
+    menu.addSubMenu("Start phase", phaseMenu);
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&unisonValue));
+}
+
+void MainComponent::showFmMenu()
+{
+    const auto selectEngine = [this](bool enabled, int algorithm)
+    {
+        params.fmAlgorithm = algorithm;
+        params.fmEnabled = enabled;
+        fmButton.setToggleState(enabled, juce::dontSendNotification);
+    };
+
+    juce::PopupMenu menu;
+    menu.addItem("Morph oscillator", true, !params.fmEnabled, [selectEngine, this] { selectEngine(false, params.fmAlgorithm); });
+    menu.addSeparator();
+    for (int i = 0; i < FmOscillator::numAlgorithms; ++i)
+        menu.addItem(FmOscillator::getAlgorithmName(i), true, params.fmEnabled && params.fmAlgorithm == i,
+            [selectEngine, i] { selectEngine(true, i); });
+    menu.addSeparator();
+
+    // Plain values, latched by the audio thread at the start of each block
+    const auto percent = [](float value) { return juce::String(juce::roundToInt(value * 100.0f)) + "%"; };
+    const auto millis = [](float ms) { return ms >= 1000.0f ? juce::String(ms / 1000.0f, 1) + " s" : juce::String(juce::roundToInt(ms)) + " ms"; };
+
+    for (int op = 0; op < FmOscillator::numOperators; ++op)
+    {
+        const auto& current = params.fmOperators[(size_t)op];
+        const auto setter = [this, op](float FmOscillator::OperatorParams::* field, float value)
+        {
+            return [this, op, field, value] { params.fmOperators[(size_t)op].*field = value; };
+        };
+
+        juce::PopupMenu ratioMenu, levelMenu, attackMenu, decayMenu, sustainMenu, releaseMenu;
+        for (float ratio : { 0.5f, 1.0f, 1.5f, 2.0f, 3.0f, 3.5f, 4.0f, 5.0f, 7.0f, 11.0f, 14.0f, 16.0f })
+            ratioMenu.addItem(juce::String(ratio) + "x", true, current.ratio == ratio,
+                setter(&FmOscillator::OperatorParams::ratio, ratio));
+        for (float level : { 0.0f, 0.1f, 0.25f, 0.5f, 0.75f, 1.0f })
+            levelMenu.addItem(percent(level), true, current.level == level, setter(&FmOscillator::OperatorParams::level, level));
+        for (float ms : { 1.0f, 2.0f, 10.0f, 50.0f, 200.0f, 1000.0f })
+            attackMenu.addItem(millis(ms), true, current.attackMs == ms, setter(&FmOscillator::OperatorParams::attackMs, ms));
+        for (float ms : { 50.0f, 150.0f, 400.0f, 1000.0f, 3000.0f })
+            decayMenu.addItem(millis(ms), true, current.decayMs == ms, setter(&FmOscillator::OperatorParams::decayMs, ms));
+        for (float sustain : { 0.0f, 0.25f, 0.5f, 0.7f, 1.0f })
+            sustainMenu.addItem(percent(sustain), true, current.sustain == sustain, setter(&FmOscillator::OperatorParams::sustain, sustain));
+        for (float ms : { 50.0f, 150.0f, 300.0f, 1000.0f, 3000.0f })
+            releaseMenu.addItem(millis(ms), true, current.releaseMs == ms, setter(&FmOscillator::OperatorParams::releaseMs, ms));
+
+        juce::PopupMenu operatorMenu;
+        operatorMenu.addSubMenu("Ratio", ratioMenu);
+        operatorMenu.addSubMenu("Level", levelMenu);
+        operatorMenu.addSubMenu("Attack", attackMenu);
+        operatorMenu.addSubMenu("Decay", decayMenu);
+        operatorMenu.addSubMenu("Sustain", sustainMenu);
+        operatorMenu.addSubMenu("Release", releaseMenu);
+        menu.addSubMenu("Operator " + juce::String(op + 1) + " (" + juce::String(current.ratio) + "x, " + percent(current.level) + ")", operatorMenu);
+    }
+
+    juce::PopupMenu feedbackMenu;
+    for (float feedback : { 0.0f, 0.1f, 0.2f, 0.35f, 0.5f, 0.75f, 1.0f })
+        feedbackMenu.addItem(percent(feedback), true, params.fmFeedback == feedback, [this, feedback] { params.fmFeedback = feedback; });
+    menu.addSubMenu("Operator 6 feedback", feedbackMenu);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&fmButton));
+}
+
+void MainComponent::showArpMenu()
+{
+    // Plain values, latched by the audio thread at the start of each block
+    auto& arp = params.arp;
+
+    juce::PopupMenu menu;
+    for (int mode = 0; mode < Arpeggiator::numModes; ++mode)
+        menu.addItem(Arpeggiator::getModeName(mode), true, arp.mode == mode, [this, mode]
+        {
+            params.arp.mode = mode;
+            arpButton.setToggleState(mode != Arpeggiator::off, juce::dontSendNotification);
+        });
+    menu.addSeparator();
+
+    juce::PopupMenu tempoMenu, rateMenu, gateMenu, swingMenu, octaveMenu, patternMenu;
+    for (float bpm : { 80.0f, 100.0f, 110.0f, 120.0f, 128.0f, 140.0f, 160.0f, 174.0f })
+        tempoMenu.addItem(juce::String(bpm, 0) + " BPM", true, arp.tempoBpm == bpm, [this, bpm] { params.arp.tempoBpm = bpm; });
+    for (int division = 0; division < Arpeggiator::numDivisions; ++division)
+        rateMenu.addItem(Arpeggiator::getDivisionName(division), true, arp.division == division, [this, division] { params.arp.division = division; });
+    for (float gate : { 0.1f, 0.25f, 0.5f, 0.75f, 1.0f })
+        gateMenu.addItem(gate >= 1.0f ? juce::String("Tie") : juce::String(juce::roundToInt(gate * 100.0f)) + "%", true, arp.gate == gate,
+            [this, gate] { params.arp.gate = gate; });
+    for (float swing : { 0.0f, 0.16f, 0.33f, 0.5f, 0.75f, 1.0f })
+        swingMenu.addItem(swing == 0.0f ? juce::String("Straight") : juce::String(juce::roundToInt(50.0f + 25.0f * swing)) + "%", true, arp.swing == swing,
+            [this, swing] { params.arp.swing = swing; });
+    for (int octaves = 1; octaves <= 4; ++octaves)
+        octaveMenu.addItem(juce::String(octaves) + (octaves == 1 ? " octave" : " octaves"), true, arp.octaves == octaves,
+            [this, octaves] { params.arp.octaves = octaves; });
+
+    for (int steps : { 16, Arpeggiator::maxSteps })
+        patternMenu.addItem(juce::String(steps) + " steps", true, arp.steps == steps, [this, steps] { params.arp.steps = steps; });
+    patternMenu.addSeparator();
+    for (int i = 0; i < Arpeggiator::getNumPresetPatterns(); ++i)
+        patternMenu.addItem(Arpeggiator::getPresetPatternName(i), [this, i] { Arpeggiator::applyPresetPattern(i, params.arp); });
+
+    menu.addSubMenu("Tempo", tempoMenu);
+    menu.addSubMenu("Rate", rateMenu);
+    menu.addSubMenu("Gate", gateMenu);
+    menu.addSubMenu("Swing", swingMenu);
+    menu.addSubMenu("Octave range", octaveMenu);
+    menu.addSubMenu("Sequencer pattern", patternMenu);
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&arpButton));
+}
+
+void MainComponent::showOutputMenu()
 {
-    auto devices = juce::MidiInput::getAvailableDevices();
-    for (auto& d : devices)
+    const float ceilingDb = limiter.getCeilingDb();
+    const float lookaheadMs = limiter.getLookaheadMs();
+    const float releaseMs = limiter.getReleaseMs();
+
+    juce::PopupMenu ceilingMenu, lookaheadMenu, releaseMenu;
+    for (float db : { -0.1f, -0.3f, -1.0f, -2.0f, -3.0f, -6.0f })
+        ceilingMenu.addItem(juce::String(db, 1) + " dBTP", true, db == ceilingDb,
+            [this, db, lookaheadMs, releaseMs] { limiter.setParameters(db, lookaheadMs, releaseMs); });
+    for (float ms : { 1.0f, 2.0f, 5.0f, 10.0f })
+        lookaheadMenu.addItem(juce::String(ms, 0) + " ms", true, ms == lookaheadMs,
+            [this, ceilingDb, ms, releaseMs] { limiter.setParameters(ceilingDb, ms, releaseMs); });
+    for (float ms : { 20.0f, 50.0f, 80.0f, 150.0f, 300.0f, 600.0f })
+        releaseMenu.addItem(juce::String(ms, 0) + " ms", true, ms == releaseMs,
+            [this, ceilingDb, lookaheadMs, ms] { limiter.setParameters(ceilingDb, lookaheadMs, ms); });
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Limiter");
+    menu.addSubMenu("Ceiling", ceilingMenu);
+    menu.addSubMenu("Look-ahead", lookaheadMenu);
+    menu.addSubMenu("Release", releaseMenu);
+    menu.addSeparator();
+    menu.addItem("Reset integrated loudness", [this] { outputMeter.resetIntegrated(); });
+
+    juce::PopupMenu rateMenu;
+    const int renderRate = requestedRenderRate.load();
+    for (int rate : renderRates)
+        rateMenu.addItem(rate > 0 ? juce::String(rate / 1000.0, 1) + " kHz" : juce::String("Device rate"),
+            audioStarted.load(), rate == renderRate, [this, rate] { setRenderRate(rate); });
+    menu.addSubMenu("Render rate", rateMenu);
+
+    if (performanceTrace.isActive())
+        menu.addItem("Stop performance trace", [this]
+        {
+            performanceTrace.stop();
+            juce::Logger::writeToLog("Trace: " + performanceTrace.getFile().getFullPathName()
+                                     + ", audio thread avg " + juce::String(performanceTrace.getAverageCostMicros(), 2)
+                                     + " us, worst " + juce::String(performanceTrace.getWorstCostMicros(), 2)
+                                     + " us per block, " + juce::String(performanceTrace.getLostRecords()) + " records lost");
+        });
+    else
+        menu.addItem("Start performance trace", audioStarted.load(), false, [this] { startPerformanceTrace(); });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetScreenArea(localAreaToGlobal(meterRect)));
+}
+
+void MainComponent::showDisplayMenu()
+{
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Drawing " + juce::String(drawnFramesPerSecond, 0) + " fps, "
+                          + juce::String(paintLoadPercent, 1) + "% of the UI thread");
+
+    juce::PopupMenu capMenu;
+    for (int cap : frameRateCaps)
+        capMenu.addItem(cap > 0 ? juce::String(cap) + " fps" : juce::String("Display rate"), true, cap == frameRateCap,
+            [this, cap] { frameRateCap = cap; });
+    menu.addSubMenu("Frame rate cap", capMenu);
+
+    menu.addSectionHeader("Real-time");
+    const auto& realtime = RealtimeOptions::getCurrent();
+    if (audioThreadConfigured.load(std::memory_order_acquire))
+        menu.addItem("Audio thread: " + audioThreadResult.describe(realtime.audioCores), false, false, nullptr);
+    RealtimeThreadResult workerThread;
+    if (outputMeter.getThreadResult(workerThread))
+        menu.addItem("Meter thread: " + workerThread.describe(realtime.workerCores), false, false, nullptr);
+    if (engine.getConvolutionReverb().getThreadResult(workerThread))
+        menu.addItem("Convolution tail thread: " + workerThread.describe(realtime.workerCores), false, false, nullptr);
+    if (engine.getSampleOscillator().getThreadResult(workerThread))
+        menu.addItem("Sample prefetch thread: " + workerThread.describe(realtime.workerCores), false, false, nullptr);
+    const int memoryLock = memoryLockResult.load();
+    menu.addItem("Memory: " + (memoryLock == memoryLockNotRequested ? juce::String("not locked") : Realtime::describeMemoryLock(memoryLock)),
+        false, false, nullptr);
+    menu.addItem("Callback jitter: " + juce::String(callbackJitterMicros.load(), 0) + " us avg, "
+                 + juce::String(worstCallbackJitterMicros.load(), 0) + " us worst", false, false, nullptr);
+
+    menu.addSectionHeader("MIDI inputs");
+    const auto midiStats = midiInputs.getDeviceStats();
+    if (midiStats.isEmpty())
+        menu.addItem("None connected", false, false, nullptr);
+    for (auto& d : midiStats)
+        menu.addItem(d.name + "  " + juce::String(d.eventsPerSecond, 0) + " ev/s, "
+                     + juce::String(d.averageLatencyMs, 1) + " ms avg, " + juce::String(d.worstLatencyMs, 1) + " ms max",
+            false, false, nullptr);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetScreenArea(localAreaToGlobal(qualityRect)));
+}
+
+void MainComponent::setRenderRate(int rate)
+{
+    if (rate == requestedRenderRate.load())
+        return;
+
+    requestedRenderRate = rate;
+    deviceManager.closeAudioDevice();
+    deviceManager.restartLastAudioDevice();
+}
+
+void MainComponent::startPerformanceTrace()
+{
+    const auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+        .getChildFile("Spectral Lab Traces")
+        .getChildFile("Trace " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H%M%S") + ".sltrace");
+
+    if (!performanceTrace.start(file))
+        return;
+
+    // Restarting the device re-prepares the engine, which is the state a
+    // replay starts from
+    deviceManager.closeAudioDevice();
+    deviceManager.restartLastAudioDevice();
+}
+
+double MainComponent::getOutputLatencyMs()
+{
+    if (!audioStarted)
+        return 0.0;
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr || device->getCurrentSampleRate() <= 0.0)
+        return 0.0;
+
+    // The device can't be told about our processing delay, so it's added here.
+    // The engine's share is counted at its own rate, which differs when resampling.
+    const int samples = device->getOutputLatencyInSamples() + limiter.getLatencySamples()
+                        + (resampling ? rateConverter.getLatencySamples() : 0);
+    return 1000.0 * samples / device->getCurrentSampleRate()
+         + 1000.0 * engine.getLatencySamples() / engine.getSampleRate();
+}
+
+void MainComponent::chooseRecordingFile()
+{
+    const auto defaultFile = juce::File::getSpecialLocation(juce::File::userMusicDirectory)
+        .getChildFile("Take " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H%M%S") + ".wav");
+
+    fileChooser = std::make_unique<juce::FileChooser>("Record output to", defaultFile, "*.wav;*.flac");
+    fileChooser->launchAsync(juce::FileBrowserComponent::saveMode
+                                 | juce::FileBrowserComponent::canSelectFiles
+                                 | juce::FileBrowserComponent::warnAboutOverwriting,
+        [this](const juce::FileChooser& chooser)
+        {
+            const auto file = chooser.getResult();
+            const bool started = file != juce::File() && outputRecorder.startRecording(file);
+            recordButton.setToggleState(started, juce::dontSendNotification);
+        });
+}
+
+void MainComponent::configureHeaderButton(juce::TextButton& button)
+{
+    button.setColour(juce::TextButton::buttonColourId, Theme::panelColour.withAlpha(0.9f));
+    button.setColour(juce::TextButton::buttonOnColourId, Theme::accentDim.withAlpha(0.8f));
+    button.setColour(juce::TextButton::textColourOnId, Theme::accent);
+    button.setColour(juce::TextButton::textColourOffId, Theme::textPrimary);
+    addAndMakeVisible(button);
+}
+
+void MainComponent::startDevices()
+{
+    if (devicesRequested)
+        return;
+    devicesRequested = true;
+
+    // Inputs are only opened while the vocoder listens to them
+    setInputEnabled(vocoder.getMix() > 0.0f);
+}
+
+void MainComponent::setInputEnabled(bool enabled)
+{
+    const int numInputChannels = enabled ? maxInputChannels : 0;
+    if (audioStarted && numInputChannels == requestedInputChannels)
+        return;
+
+    // Without permission to record the device opens output-only
+    if (enabled && juce::RuntimePermissions::isRequired(juce::RuntimePermissions::recordAudio)
+        && !juce::RuntimePermissions::isGranted(juce::RuntimePermissions::recordAudio))
     {
-        deviceManager.setMidiInputDeviceEnabled(d.identifier, true);
-        deviceManager.addMidiInputDeviceCallback(d.identifier, this);
+        juce::RuntimePermissions::request(juce::RuntimePermissions::recordAudio,
+            [safeThis = juce::Component::SafePointer<MainComponent>(this)](bool granted)
+            {
+                if (safeThis != nullptr)
+                    safeThis->openDevices(granted ? maxInputChannels : 0);
+            });
+        return;
     }
+
+    openDevices(numInputChannels);
+}
+
+void MainComponent::openDevices(int numInputChannels)
+{
+    // Message thread: AudioDeviceManager isn't thread-safe and the WASAPI and
+    // ASIO drivers expect to be opened from the thread that set up COM
+    TRACE_ZONE("openDevices");
+    requestedInputChannels = numInputChannels;
+
+    if (!audioStarted)
+    {
+        setAudioChannels(numInputChannels, 2);
+        startupTimes.audioOpened = millisecondsSinceStart();
+        audioStarted = true;
+        repaint(headerRect);
+        return;
+    }
+
+    // Keeps whichever device the user chose; the restart prepares again
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.useDefaultInputChannels = false;
+    setup.inputChannels.clear();
+    setup.inputChannels.setRange(0, numInputChannels, true);
+    deviceManager.setAudioDeviceSetup(setup, true);
+}
+
+void MainComponent::logStartupTimes()
+{
+    if (startupTimes.logged || !audioStarted || startupTimes.firstPaint == 0.0)
+        return;
+
+    // Without a working output there is no callback to wait for
+    const double firstCallback = firstCallbackMs.load(std::memory_order_relaxed);
+    if (firstCallback == 0.0 && millisecondsSinceStart() - startupTimes.audioOpened < firstCallbackWaitMs)
+        return;
+
+    startupTimes.logged = true;
+    const auto ms = [](double t) { return t > 0.0 ? juce::String(juce::roundToInt(t)) + " ms" : juce::String("none"); };
+    juce::Logger::writeToLog("Startup: controls " + ms(startupTimes.controlsBuilt)
+                             + ", window ready " + ms(startupTimes.constructed)
+                             + ", first paint " + ms(startupTimes.firstPaint)
+                             + ", audio device " + ms(startupTimes.audioOpened)
+                             + ", first audio callback " + ms(firstCallback));
 }
 
 void MainComponent::initialiseKeyboard()
@@ -1103,79 +1783,27 @@ void MainComponent::configureValueLabel(juce::Label& label)
     addAndMakeVisible(label);
 }
 
-void MainComponent::updateAmplitudeEnvelope()
-{
-    ampEnvParams.attack = juce::jlimit(0.0005f, 20.0f, attackMs * 0.001f);
-    ampEnvParams.decay = juce::jlimit(0.0005f, 20.0f, decayMs * 0.001f);
-    ampEnvParams.sustain = juce::jlimit(0.0f, 1.0f, sustainLevel);
-    ampEnvParams.release = juce::jlimit(0.0005f, 20.0f, releaseMs * 0.001f);
-    amplitudeEnvelope.setParameters(ampEnvParams);
-}
-
 //==============================================================================
-// MIDI Input handlers stay unchanged
+// MIDI input: queued with timestamps and delivered at the next block.
+// Inputs open before the device does; until then there's nothing to play them.
 void MainComponent::handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& m)
 {
-    if (m.isNoteOn())
-    {
-        const auto noteNumber = m.getNoteNumber();
-        noteStack.addIfNotAlreadyThere(noteNumber);
-        currentMidiNote = noteNumber;
-        currentVelocity = juce::jlimit(0.0f, 1.0f, m.getVelocity() / 127.0f);
-        setTargetFrequency(midiNoteToFreq(currentMidiNote));
-        midiGate = true;
-        amplitudeEnvelope.noteOn();
-    }
-    else if (m.isNoteOff())
-    {
-        noteStack.removeFirstMatchingValue(m.getNoteNumber());
-        if (noteStack.isEmpty())
-        {
-            midiGate = false;
-            currentMidiNote = -1;
-            amplitudeEnvelope.noteOff();
-        }
-        else
-        {
-            currentMidiNote = noteStack.getLast();
-            setTargetFrequency(midiNoteToFreq(currentMidiNote));
-            midiGate = true;
-            amplitudeEnvelope.noteOn();
-        }
-    }
-    else if (m.isAllNotesOff() || m.isAllSoundOff())
-    {
-        noteStack.clear();
-        midiGate = false;
-        currentMidiNote = -1;
-        amplitudeEnvelope.noteOff();
-    }
+    if (audioStarted.load(std::memory_order_relaxed))
+        midiCollector.addMessageToQueue(m);
 }
 
-void MainComponent::handleNoteOn(juce::MidiKeyboardState*, int, int midiNoteNumber, float velocity)
+void MainComponent::handleNoteOn(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
 {
-    noteStack.addIfNotAlreadyThere(midiNoteNumber);
-    currentMidiNote = midiNoteNumber;
-    currentVelocity = juce::jlimit(0.0f, 1.0f, velocity);
-    setTargetFrequency(midiNoteToFreq(currentMidiNote));
-    midiGate = true;
-    amplitudeEnvelope.noteOn();
+    auto m = juce::MidiMessage::noteOn(midiChannel, midiNoteNumber, velocity);
+    m.setTimeStamp(juce::Time::getMillisecondCounterHiRes() * 0.001);
+    if (audioStarted.load(std::memory_order_relaxed))
+        midiCollector.addMessageToQueue(m);
 }
 
-void MainComponent::handleNoteOff(juce::MidiKeyboardState*, int, int midiNoteNumber, float)
+void MainComponent::handleNoteOff(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
 {
-    noteStack.removeFirstMatchingValue(midiNoteNumber);
-    if (noteStack.isEmpty())
-    {
-        midiGate = false;
-        currentMidiNote = -1;
-        amplitudeEnvelope.noteOff();
-    }
-    else
-    {
-        currentMidiNote = noteStack.getLast();
-        setTargetFrequency(midiNoteToFreq(currentMidiNote));
-        midiGate = true;
-        amplitudeEnvelope.noteOn();
-    }
+    auto m = juce::MidiMessage::noteOff(midiChannel, midiNoteNumber, velocity);
+    m.setTimeStamp(juce::Time::getMillisecondCounterHiRes() * 0.001);
+    if (audioStarted.load(std::memory_order_relaxed))
+        midiCollector.addMessageToQueue(m);
 }
@@ -1,5 +1,15 @@
 #pragma once
 #include <JuceHeader.h>
+#include "SynthEngine.h"
+#include "OutputRecorder.h"
+#include "OutputMeter.h"
+#include "LookaheadLimiter.h"
+#include "PerformanceTrace.h"
+#include "TraceEvents.h"
+#include "MidiInputManager.h"
+#include "RealtimeOptions.h"
+#include "RateConverter.h"
+#include "ChannelVocoder.h"
 
 class MainComponent : public juce::AudioAppComponent,
                       public juce::MidiInputCallback,
@@ -16,6 +26,7 @@ public:
 
     void paint(juce::Graphics&) override;
     void resized() override;
+    void mouseDown(const juce::MouseEvent&) override;
 
     // ===== MIDI callbacks =====
     void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
@@ -23,80 +34,45 @@ public:
     void handleNoteOff(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float /*velocity*/) override;
 
 private:
-    // ===== Synth state =====
-    float   phase = 0.0f;
-    float   targetFrequency = 220.0f;
-
-    // LFO (vibrato)
-    float   lfoPhase = 0.0f;
-    float   lfoRateHz = 5.0f;
-    float   lfoDepth = 0.03f;
-
-    // Smoothed parameters for a more polished response
-    juce::SmoothedValue<float> frequencySmoothed;
-    juce::SmoothedValue<float> gainSmoothed;
-    juce::SmoothedValue<float> cutoffSmoothed;
-    juce::SmoothedValue<float> resonanceSmoothed;
-    juce::SmoothedValue<float> stereoWidthSmoothed;
-    juce::SmoothedValue<float> lfoDepthSmoothed;
-    juce::SmoothedValue<float> driveSmoothed;
-    juce::SmoothedValue<float> chorusMixSmoothed;
-
-    // Output Gain
-    float   outputGain = 0.5f;
-    float   driveAmount = 0.0f;
-    float   crushAmount = 0.0f;
-    float   subMixAmount = 0.0f;
-    float   envFilterAmount = 0.0f;
-    float   chaosAmount = 0.0f;
-    float   delayAmount = 0.0f;
-    float   autoPanAmount = 0.0f;
-    float   chorusMix = 0.35f;
-    float   glitchProbability = 0.0f;
-
-    // Filter (cutoff + resonance + per-channel IIR)
-    float   cutoffHz = 1000.0f;
-    float   resonanceQ = 0.707f;
-    juce::IIRFilter filterL, filterR;
-
-    float   lfoCutModAmt = 0.0f;
-    float   chaosValue = 0.0f;
-    int     chaosSamplesRemaining = 0;
-    juce::Random random;
-
-    // Envelope
-    float   attackMs = 8.0f;
-    float   decayMs = 90.0f;
-    float   sustainLevel = 0.75f;
-    float   releaseMs = 280.0f;
-
-    juce::ADSR amplitudeEnvelope;
-    juce::ADSR::Parameters ampEnvParams;
-
-    // Stereo width
-    float   stereoWidth = 1.0f;
-
-    int filterUpdateStep = 16;
-    int filterUpdateCount = 0;
-    double currentSR = 44100.0;
-
-    float waveMorph = 0.0f;
+    SynthEngine engine;
+    SynthParameters& params { engine.params };
+
+    // CPU-adaptive quality tiers
+    QualityGovernor qualityGovernor;
+
+    OutputRecorder outputRecorder;
+    OutputMeter outputMeter;
+    LookaheadLimiter limiter;
+    PerformanceTrace performanceTrace;
+
+    // Live input as the vocoder's modulator, mixed to mono at the device rate.
+    // Inputs are only open while the vocoder's mix is above zero.
+    ChannelVocoder vocoder;
+    juce::AudioBuffer<float> modulatorBuffer;
+    juce::MidiBuffer chunkMidi;
+    int activeInputChannels = 0;
+    int requestedInputChannels = 0;     // message thread
+
+    // Optional fixed internal render rate (0 follows the device), converted to
+    // the device rate at the output. Takes effect when the device restarts.
+    std::atomic<int> requestedRenderRate { 0 };
+    std::atomic<bool> resampling { false };
+    RateConverter rateConverter;
+    juce::MidiBuffer resampledMidi;
+
+   #if SPECTRAL_TRACE_ZONES
+    // Zone trace for the whole run, written next to the performance traces
+    std::unique_ptr<TraceEvents::Session> zoneSession;
+   #endif
+
+    // MIDI from devices and the on-screen keyboard, handed to the engine with
+    // sample positions at the start of each block
+    juce::MidiMessageCollector midiCollector;
+    juce::MidiBuffer incomingMidi;
+    MidiInputManager midiInputs { *this };
+
     juce::AudioBuffer<float> scopeBuffer{ 1, 2048 };
     int scopeWritePos = 0;
-    float subPhase = 0.0f;
-    float detunePhase = 0.0f;
-    float autoPanPhase = 0.0f;
-    float autoPanRateHz = 0.35f;
-    int crushCounter = 0;
-    float crushHoldL = 0.0f;
-    float crushHoldR = 0.0f;
-    juce::AudioBuffer<float> delayBuffer{ 2, 1 };
-    juce::dsp::Chorus<float> chorus;
-    int delayWritePosition = 0;
-    int maxDelaySamples = 1;
-    int glitchSamplesRemaining = 0;
-    float glitchHeldL = 0.0f;
-    float glitchHeldR = 0.0f;
 
     // ===== UI Controls =====
     juce::Slider waveKnob, gainKnob, attackKnob, decayKnob, sustainKnob, widthKnob;
@@ -104,6 +80,7 @@ private:
     juce::Slider lfoKnob, lfoDepthKnob, filterModKnob;
     juce::Slider driveKnob, crushKnob, subMixKnob, envFilterKnob;
     juce::Slider chaosKnob, delayKnob, chorusKnob, autoPanKnob, glitchKnob;
+    juce::Slider reverbKnob, roomKnob, sampleKnob, grainKnob, unisonKnob;
 
     juce::Label waveLabel, waveValue;
     juce::Label gainLabel, gainValue;
@@ -127,58 +104,128 @@ private:
     juce::Label chorusLabel, chorusValue;
     juce::Label autoPanLabel, autoPanValue;
     juce::Label glitchLabel, glitchValue;
+    juce::Label reverbLabel, reverbValue;
+    juce::Label roomLabel, roomValue;
+    juce::Label sampleLabel, sampleValue;
+    juce::Label grainLabel, grainValue;
+    juce::Label unisonLabel, unisonValue;
 
     juce::TextButton audioToggle{ "Audio ON" };
-    bool audioEnabled = true;
+    std::atomic<bool> audioEnabled { true };
+
+    // The audio device is opened on the message thread just after the first
+    // paint so the window appears straight away; deviceManager is off limits
+    // until audioStarted.
+    // Times are milliseconds since the process started.
+    struct StartupTimes
+    {
+        double constructed = 0.0, controlsBuilt = 0.0, firstPaint = 0.0, audioOpened = 0.0;
+        bool logged = false;
+    };
+    bool devicesRequested = false;
+    std::atomic<bool> audioStarted { false };
+    std::atomic<double> firstCallbackMs { 0.0 };
+    StartupTimes startupTimes;
+
+    // Real-time options take effect on the audio thread at its first callback
+    // after each prepare. Callback jitter is how far the gap between callbacks
+    // strays from the previous block's length, to compare runs with and without.
+    std::atomic<bool> audioThreadConfigured { false };
+    RealtimeThreadResult audioThreadResult;
+    std::atomic<int> memoryLockResult;
+    double deviceSampleRate = 0.0;
+    juce::int64 lastCallbackTicks = 0;
+    double lastBlockSeconds = 0.0;
+    std::atomic<float> callbackJitterMicros { 0.0f };
+    std::atomic<float> worstCallbackJitterMicros { 0.0f };
+
+    juce::TextButton loadIrButton{ "Load IR" };
+    juce::TextButton freezeButton{ "Freeze" };
+    juce::TextButton recordButton{ "Rec" };
+    juce::TextButton loadSamplesButton{ "Samples" };
+    juce::TextButton wavetableButton{ "Wavetable" };
+    juce::TextButton fmButton{ "FM" };
+    juce::TextButton arpButton{ "Arp" };
+    juce::TextButton tuningButton{ "Tuning" };
+    juce::TextButton spectralButton{ "Spectral" };
+    juce::TextButton vocoderButton{ "Vocoder" };
+    std::unique_ptr<juce::FileChooser> fileChooser;
 
     // ===== MIDI keyboard UI =====
     juce::MidiKeyboardState keyboardState;
     juce::MidiKeyboardComponent keyboardComponent { keyboardState, juce::MidiKeyboardComponent::horizontalKeyboard };
 
-    // ===== MIDI state (monophonic, last-note priority) =====
-    juce::Array<int> noteStack;   // holds pressed MIDI notes
-    int currentMidiNote = -1;
-    float currentVelocity = 1.0f;
-    bool midiGate = false;        // gate controlled by MIDI
-
     // Scope area cache (so paint knows where to draw when keyboard steals space)
     juce::Rectangle<int> scopeRect;
     juce::Rectangle<int> headerRect;
     juce::Rectangle<int> controlStripRect;
     juce::Rectangle<int> keyboardRect;
+    juce::Rectangle<int> meterRect;
+    juce::Rectangle<int> qualityRect;
+    int headerButtonsLeft = 0;
 
     float scanProgress = 0.0f;
     juce::Random visualRandom;
 
+    // Frame scheduling. The audio thread bumps scopeVersion whenever the scope
+    // has something new to show; frames that would redraw the same picture are
+    // skipped, as is everything while the window is hidden or minimised.
+    using HeaderState = std::array<int, 14>;
+    std::atomic<juce::uint32> scopeVersion { 0 };
+    int scopeSilentRun = 0;
+    juce::uint32 drawnScopeVersion = 0;
+    HeaderState drawnHeaderState {};
+    int frameRateCap;
+    double lastFrameSeconds = 0.0;
+    double lastHeaderSeconds = 0.0;
+
+    // Message-thread drawing cost, summed by paint() and published once a second
+    juce::int64 paintTicks = 0;
+    int paintCount = 0;
+    juce::int64 statsStartTicks = 0;
+    float drawnFramesPerSecond = 0.0f;
+    float paintLoadPercent = 0.0f;
+
     // ===== Helpers =====
     void initialiseUi();
     void initialiseSliders();
     void initialiseToggle();
-    void initialiseMidiInputs();
+    void initialiseHeaderButtons();
+    void configureHeaderButton(juce::TextButton& button);
+    void chooseRecordingFile();
+    void showWavetableMenu();
+    void showFmMenu();
+    void showUnisonMenu();
+    void showArpMenu();
+    void showTuningMenu();
+    void showSpectralMenu();
+    void showVocoderMenu();
+    void showOutputMenu();
+    void showDisplayMenu();
+    void startPerformanceTrace();
+    void startDevices();
+    void setInputEnabled(bool enabled);
+    void openDevices(int numInputChannels);
+    void logStartupTimes();
     void initialiseKeyboard();
     void configureRotarySlider(juce::Slider& slider);
     void configureCaptionLabel(juce::Label& label, const juce::String& text);
     void configureValueLabel(juce::Label& label);
-    void updateAmplitudeEnvelope();
 
-    void resetSmoothers(double sampleRate);
-    void setTargetFrequency(float newFrequency, bool force = false);
-    void updateFilterCoeffs(double cutoff, double Q);
-    void updateFilterStatic();
-    inline float renderMorphSample(float ph, float morph) const;
     int findZeroCrossingIndex(int searchSpan) const;
+    double getOutputLatencyMs();
     void timerCallback() override;
+    void onVBlank(double timestampSeconds);
+    void measureCallbackJitter(int numSamples) noexcept;
+    void renderResampled(float* left, float* right, int numSamples, const juce::MidiBuffer& midi,
+                         QualityGovernor::Tier tier, bool enabled) noexcept;
+    void setRenderRate(int rate);
+    HeaderState getHeaderState();
 
-    inline float sine(float ph) const { return std::sin(ph); }
-    inline float tri(float ph)  const { return (2.0f / juce::MathConstants<float>::pi) * std::asin(std::sin(ph)); }
-    inline float saw(float ph)  const { return 2.0f * (ph / juce::MathConstants<float>::twoPi) - 1.0f; }
-    inline float sqr(float ph)  const { return std::tanh(3.0f * std::sin(ph)); }
+    // Last member, so it stops before anything it draws is torn down
+    juce::VBlankAttachment vBlankAttachment { this, [this](double timestampSeconds) { onVBlank(timestampSeconds); } };
 
-    static inline float midiNoteToFreq(int midiNote)
-    {
-        // A4 = 440 Hz, MIDI 69
-        return 440.0f * std::pow(2.0f, (midiNote - 69) / 12.0f);
-    }
+    friend class MainComponentTests;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 };
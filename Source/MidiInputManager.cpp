@@ -0,0 +1,190 @@
+#include "MidiInputManager.h"
+
+namespace
+{
+    constexpr int rescanIntervalMs = 1000;
+    constexpr int stopTimeoutMs = 2000;
+
+    void raiseToMax(std::atomic<juce::int64>& value, juce::int64 candidate) noexcept
+    {
+        auto current = value.load(std::memory_order_relaxed);
+        while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {}
+    }
+}
+
+struct MidiInputManager::Connection : public juce::MidiInputCallback
+{
+    Connection(juce::MidiInputCallback& t, const juce::MidiDeviceInfo& info) : target(t), device(info) {}
+
+    ~Connection() override
+    {
+        // Once stop() returns the driver won't call back again
+        if (input != nullptr)
+            input->stop();
+    }
+
+    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override
+    {
+        // Input timestamps are seconds on the getMillisecondCounterHiRes() clock
+        const double latencyMs = juce::Time::getMillisecondCounterHiRes() - message.getTimeStamp() * 1000.0;
+        const auto latencyMicros = (juce::int64)juce::jmax(0.0, latencyMs * 1000.0);
+        windowEvents.fetch_add(1, std::memory_order_relaxed);
+        windowLatencyMicros.fetch_add(latencyMicros, std::memory_order_relaxed);
+        raiseToMax(windowWorstMicros, latencyMicros);
+
+        target.handleIncomingMidiMessage(source, message);
+    }
+
+    juce::MidiInputCallback& target;
+    const juce::MidiDeviceInfo device;
+    std::unique_ptr<juce::MidiInput> input;
+
+    // Driver thread, collected and cleared once a second by run()
+    std::atomic<juce::int64> windowEvents { 0 };
+    std::atomic<juce::int64> windowLatencyMicros { 0 };
+    std::atomic<juce::int64> windowWorstMicros { 0 };
+
+    // Published by run()
+    std::atomic<juce::int64> totalEvents { 0 };
+    std::atomic<float> eventsPerSecond { 0.0f };
+    std::atomic<float> averageLatencyMs { 0.0f };
+    std::atomic<float> worstLatencyMs { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE(Connection)
+};
+
+//==============================================================================
+MidiInputManager::MidiInputManager(juce::MidiInputCallback& t)
+    : juce::Thread("MIDI inputs"), target(t)
+{
+}
+
+MidiInputManager::~MidiInputManager()
+{
+    deviceListConnection.reset();
+    stopThread(stopTimeoutMs);
+
+    const juce::ScopedLock sl(connectionsLock);
+    connections.clear();
+}
+
+void MidiInputManager::start()
+{
+    // Device changes arrive on the message thread; the rescan itself never does
+    deviceListConnection = juce::MidiDeviceListConnection::make([this] { notify(); });
+    startThread(juce::Thread::Priority::low);
+}
+
+juce::Array<MidiInputManager::DeviceStats> MidiInputManager::getDeviceStats() const
+{
+    juce::Array<DeviceStats> stats;
+    const juce::ScopedLock sl(connectionsLock);
+    for (auto* c : connections)
+    {
+        DeviceStats s;
+        s.name = c->device.name;
+        s.totalEvents = c->totalEvents.load(std::memory_order_relaxed);
+        s.eventsPerSecond = c->eventsPerSecond.load(std::memory_order_relaxed);
+        s.averageLatencyMs = c->averageLatencyMs.load(std::memory_order_relaxed);
+        s.worstLatencyMs = c->worstLatencyMs.load(std::memory_order_relaxed);
+        stats.add(s);
+    }
+    return stats;
+}
+
+void MidiInputManager::run()
+{
+    auto lastTicks = juce::Time::getHighResolutionTicks();
+    while (!threadShouldExit())
+    {
+        rescan();
+        wait(rescanIntervalMs);
+
+        const auto now = juce::Time::getHighResolutionTicks();
+        updateStats(juce::Time::highResolutionTicksToSeconds(now - lastTicks));
+        lastTicks = now;
+    }
+}
+
+void MidiInputManager::rescan()
+{
+    const auto available = juce::MidiInput::getAvailableDevices();
+    const auto isAvailable = [&available](const juce::String& identifier)
+    {
+        for (auto& info : available)
+            if (info.identifier == identifier)
+                return true;
+        return false;
+    };
+
+    for (int i = connections.size(); --i >= 0;)
+    {
+        if (isAvailable(connections[i]->device.identifier))
+            continue;
+
+        std::unique_ptr<Connection> removed;
+        {
+            const juce::ScopedLock sl(connectionsLock);
+            removed.reset(connections.removeAndReturn(i));
+        }
+        juce::Logger::writeToLog("MIDI: closed " + removed->device.name);
+    }
+
+    for (auto& info : available)
+    {
+        bool open = false;
+        for (auto* c : connections)
+            open = open || c->device.identifier == info.identifier;
+        if (open)
+            continue;
+
+        auto connection = std::make_unique<Connection>(target, info);
+        connection->input = juce::MidiInput::openDevice(info.identifier, connection.get());
+        if (connection->input == nullptr)
+        {
+            // Retried on every rescan, reported once
+            if (!failedIdentifiers.contains(info.identifier))
+            {
+                failedIdentifiers.add(info.identifier);
+                juce::Logger::writeToLog("MIDI: can't open " + info.name);
+            }
+            continue;
+        }
+
+        failedIdentifiers.removeString(info.identifier);
+        connection->input->start();
+        if (scannedOnce)
+            juce::Logger::writeToLog("MIDI: opened " + info.name);
+
+        const juce::ScopedLock sl(connectionsLock);
+        connections.add(connection.release());
+    }
+
+    if (!scannedOnce)
+    {
+        scannedOnce = true;
+        juce::Logger::writeToLog("MIDI: " + juce::String(connections.size()) + " of "
+                                 + juce::String(available.size()) + " inputs open");
+    }
+}
+
+void MidiInputManager::updateStats(double elapsedSeconds)
+{
+    if (elapsedSeconds <= 0.0)
+        return;
+
+    for (auto* c : connections)
+    {
+        const auto events = c->windowEvents.exchange(0, std::memory_order_relaxed);
+        const auto latencyMicros = c->windowLatencyMicros.exchange(0, std::memory_order_relaxed);
+        const auto worstMicros = c->windowWorstMicros.exchange(0, std::memory_order_relaxed);
+
+        c->totalEvents.fetch_add(events, std::memory_order_relaxed);
+        c->eventsPerSecond.store((float)(events / elapsedSeconds), std::memory_order_relaxed);
+        if (events > 0)
+        {
+            c->averageLatencyMs.store((float)(latencyMicros / events) * 0.001f, std::memory_order_relaxed);
+            c->worstLatencyMs.store((float)worstMicros * 0.001f, std::memory_order_relaxed);
+        }
+    }
+}
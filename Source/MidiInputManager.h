@@ -0,0 +1,48 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Keeps every connected MIDI input open. A background thread rescans when the
+// OS reports a device change, and once a second in case it doesn't. It opens
+// new inputs and closes ones that went away, so neither the message nor the
+// audio thread ever waits on a driver, and no callback outlives its device.
+//
+// Messages go straight to the target callback on the driver's thread. Each
+// input also counts its events and the delay between the driver's timestamp
+// and the callback, published once a second for the UI.
+class MidiInputManager : private juce::Thread
+{
+public:
+    struct DeviceStats
+    {
+        juce::String name;
+        juce::int64 totalEvents = 0;
+        float eventsPerSecond = 0.0f;   // over the last second
+        float averageLatencyMs = 0.0f;  // over the last second with events
+        float worstLatencyMs = 0.0f;
+    };
+
+    explicit MidiInputManager(juce::MidiInputCallback& target);
+    ~MidiInputManager() override;
+
+    // Message thread
+    void start();
+    juce::Array<DeviceStats> getDeviceStats() const;
+
+private:
+    struct Connection;
+
+    void run() override;
+    void rescan();
+    void updateStats(double elapsedSeconds);
+
+    juce::MidiInputCallback& target;
+    juce::MidiDeviceListConnection deviceListConnection;
+
+    // Only run() adds or removes; the lock is for readers on other threads
+    juce::OwnedArray<Connection> connections;
+    juce::CriticalSection connectionsLock;
+    juce::StringArray failedIdentifiers;
+    bool scannedOnce = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiInputManager)
+};
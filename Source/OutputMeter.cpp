@@ -0,0 +1,332 @@
+#include "OutputMeter.h"
+#include "DspArena.h"
+#include <cmath>
+
+namespace
+{
+    constexpr double fifoSeconds = 1.0;
+    constexpr int meterIntervalMs = 20;
+    constexpr double rmsWindowSeconds = 0.3;
+    constexpr float peakFallDbPerSecond = 20.0f;
+    constexpr double absoluteGateLufs = -70.0;
+    constexpr double relativeGateLu = -10.0;
+    constexpr double histogramStepLu = 0.1;
+
+    double energyToLufs(double energy)
+    {
+        return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : (double)OutputMeter::silenceDb;
+    }
+
+    float gainToDb(float gain)
+    {
+        return juce::Decibels::gainToDecibels(gain, OutputMeter::silenceDb);
+    }
+}
+
+//==============================================================================
+OutputMeter::OutputMeter()
+    : juce::Thread("Output meter")
+{
+    // 4x interpolator for true peak: windowed sinc, 12 taps per phase
+    const int numTaps = (int)interpolator.size();
+    const double centre = 0.5 * (numTaps - 1);
+    for (int n = 0; n < numTaps; ++n)
+    {
+        const double x = ((double)n - centre) / oversampling;
+        const double sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+        const double window = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * (n + 0.5) / numTaps);
+        interpolator[(size_t)n] = (float)(sinc * window);
+    }
+
+    // Unity DC gain for every phase
+    for (int p = 0; p < oversampling; ++p)
+    {
+        float sum = 0.0f;
+        for (int k = 0; k < tapsPerPhase; ++k)
+            sum += interpolator[(size_t)(p + k * oversampling)];
+        for (int k = 0; k < tapsPerPhase; ++k)
+            interpolator[(size_t)(p + k * oversampling)] /= sum;
+    }
+}
+
+OutputMeter::~OutputMeter()
+{
+    stop();
+}
+
+void OutputMeter::prepare(double newSampleRate)
+{
+    // Retuned under the lock rather than by restarting the thread
+    const juce::ScopedLock sl(stateLock);
+
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+
+    // The buffer keeps its highest-rate size, so a lower rate doesn't reallocate
+    const int fifoSize = juce::jmax(1024, (int)(sampleRate * fifoSeconds));
+    const int reservedSize = juce::jmax(fifoSize, (int)(DspArena::reservedSampleRate * fifoSeconds));
+    fifoBuffer.setSize(2, reservedSize, false, false, true);
+    fifo.setTotalSize(fifoSize);
+    fifo.reset();
+
+    // BS.1770 K-weighting: high shelf then high pass, derived for any rate
+    {
+        const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 1.7071352345773603;
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    subBlockSamples = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+    peakFall = juce::Decibels::decibelsToGain(-peakFallDbPerSecond / (float)sampleRate);
+    rmsCoefficient = (float)(1.0 - std::exp(-1.0 / (rmsWindowSeconds * sampleRate)));
+
+    resetMeasurements();
+    droppedBlocks.store(0, std::memory_order_relaxed);
+    averagePushMicros.store(0.0f, std::memory_order_relaxed);
+    worstPushMicros.store(0.0f, std::memory_order_relaxed);
+    pushMicrosAccumulator = 0.0;
+    pushCount = 0;
+
+    if (!isThreadRunning())
+        startThread(juce::Thread::Priority::low);
+}
+
+void OutputMeter::stop()
+{
+    stopThread(1000);
+}
+
+void OutputMeter::resetMeasurements()
+{
+    shelf.reset();
+    highPass.reset();
+    for (auto& h : truePeakHistory)
+        h.fill(0.0f);
+    historyPos = 0;
+
+    peakLevel = truePeakLevel = maxTruePeak = 0.0f;
+    meanSquare = 0.0;
+    subBlockCount = 0;
+    subBlockEnergy = 0.0;
+    subBlocks.fill(0.0);
+    subBlockPos = subBlocksFilled = 0;
+    histogramCounts.fill(0);
+    histogramEnergy.fill(0.0);
+
+    publish();
+}
+
+//==============================================================================
+void OutputMeter::pushBlock(const float* left, const float* right, int numSamples) noexcept
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    if (size1 + size2 < numSamples)
+    {
+        // The meter thread fell behind; skip the block rather than wait
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        if (right == nullptr)
+            right = left;
+
+        fifoBuffer.copyFrom(0, start1, left, size1);
+        fifoBuffer.copyFrom(1, start1, right, size1);
+        if (size2 > 0)
+        {
+            fifoBuffer.copyFrom(0, start2, left + size1, size2);
+            fifoBuffer.copyFrom(1, start2, right + size1, size2);
+        }
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    const auto micros = (float)(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+    pushMicrosAccumulator += micros;
+    ++pushCount;
+    averagePushMicros.store((float)(pushMicrosAccumulator / pushCount), std::memory_order_relaxed);
+    if (micros > worstPushMicros.load(std::memory_order_relaxed))
+        worstPushMicros.store(micros, std::memory_order_relaxed);
+}
+
+void OutputMeter::run()
+{
+    threadResult = Realtime::configureWorkerThread();
+    threadConfigured.store(true, std::memory_order_release);
+
+    while (!threadShouldExit())
+    {
+        wait(meterIntervalMs);
+        const juce::ScopedLock sl(stateLock);
+
+        if (resetRequested.exchange(false, std::memory_order_relaxed))
+            resetMeasurements();
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+        if (size1 > 0)
+            measure(fifoBuffer.getReadPointer(0, start1), fifoBuffer.getReadPointer(1, start1), size1);
+        if (size2 > 0)
+            measure(fifoBuffer.getReadPointer(0, start2), fifoBuffer.getReadPointer(1, start2), size2);
+
+        fifo.finishedRead(size1 + size2);
+
+        // Peaks keep falling through silence
+        if (size1 + size2 == 0)
+        {
+            const float fall = std::pow(peakFall, (float)(sampleRate * meterIntervalMs * 0.001));
+            peakLevel *= fall;
+            truePeakLevel *= fall;
+            publish();
+        }
+    }
+}
+
+//==============================================================================
+void OutputMeter::measure(const float* left, const float* right, int numSamples)
+{
+    if (right == nullptr)
+        right = left;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float l = left[i];
+        const float r = right[i];
+
+        const float samplePeak = juce::jmax(std::abs(l), std::abs(r));
+        peakLevel = juce::jmax(samplePeak, peakLevel * peakFall);
+
+        meanSquare += ((0.5 * ((double)l * l + (double)r * r)) - meanSquare) * rmsCoefficient;
+
+        const float interSamplePeak = juce::jmax(measureTruePeak(l, 0), measureTruePeak(r, 1));
+        historyPos = (historyPos + 1) % tapsPerPhase;
+        truePeakLevel = juce::jmax(interSamplePeak, truePeakLevel * peakFall);
+        maxTruePeak = juce::jmax(maxTruePeak, interSamplePeak);
+
+        const double kl = highPass.process(shelf.process(l, 0), 0);
+        const double kr = highPass.process(shelf.process(r, 1), 1);
+        subBlockEnergy += kl * kl + kr * kr;
+
+        if (++subBlockCount >= subBlockSamples)
+            completeSubBlock();
+    }
+
+    publish();
+}
+
+float OutputMeter::measureTruePeak(float sample, int channel) noexcept
+{
+    auto& history = truePeakHistory[(size_t)channel];
+    history[(size_t)historyPos] = sample;
+
+    // Each phase of the polyphase filter gives one of the four interpolated points
+    float peak = std::abs(sample);
+    for (int p = 0; p < oversampling; ++p)
+    {
+        float y = 0.0f;
+        for (int k = 0; k < tapsPerPhase; ++k)
+            y += interpolator[(size_t)(p + k * oversampling)] * history[(size_t)((historyPos - k + tapsPerPhase) % tapsPerPhase)];
+        peak = juce::jmax(peak, std::abs(y));
+    }
+    return peak;
+}
+
+void OutputMeter::completeSubBlock()
+{
+    subBlocks[(size_t)subBlockPos] = subBlockEnergy / subBlockCount;
+    subBlockPos = (subBlockPos + 1) % subBlocksPerShortTerm;
+    subBlocksFilled = juce::jmin(subBlocksFilled + 1, subBlocksPerShortTerm);
+    subBlockEnergy = 0.0;
+    subBlockCount = 0;
+
+    // 400 ms gating blocks with 75% overlap feed the integrated histogram
+    if (subBlocksFilled < subBlocksPerGatingBlock)
+        return;
+
+    double energy = 0.0;
+    for (int b = 1; b <= subBlocksPerGatingBlock; ++b)
+        energy += subBlocks[(size_t)((subBlockPos - b + subBlocksPerShortTerm) % subBlocksPerShortTerm)];
+    energy /= subBlocksPerGatingBlock;
+
+    const double lufs = energyToLufs(energy);
+    if (lufs <= absoluteGateLufs)
+        return;
+
+    const int bin = juce::jlimit(0, histogramBins - 1, (int)((lufs - absoluteGateLufs) / histogramStepLu));
+    ++histogramCounts[(size_t)bin];
+    histogramEnergy[(size_t)bin] += energy;
+}
+
+float OutputMeter::computeIntegrated() const
+{
+    juce::uint64 count = 0;
+    double energy = 0.0;
+    for (int b = 0; b < histogramBins; ++b)
+    {
+        count += histogramCounts[(size_t)b];
+        energy += histogramEnergy[(size_t)b];
+    }
+
+    if (count == 0)
+        return silenceDb;
+
+    const double relativeGate = energyToLufs(energy / (double)count) + relativeGateLu;
+    const int firstBin = juce::jmax(0, (int)((relativeGate - absoluteGateLufs) / histogramStepLu));
+
+    count = 0;
+    energy = 0.0;
+    for (int b = firstBin; b < histogramBins; ++b)
+    {
+        count += histogramCounts[(size_t)b];
+        energy += histogramEnergy[(size_t)b];
+    }
+
+    return count > 0 ? (float)energyToLufs(energy / (double)count) : silenceDb;
+}
+
+void OutputMeter::publish()
+{
+    double shortTerm = 0.0;
+    for (int b = 0; b < subBlocksFilled; ++b)
+        shortTerm += subBlocks[(size_t)b];
+
+    peakDb.store(gainToDb(peakLevel), std::memory_order_relaxed);
+    truePeakDb.store(gainToDb(truePeakLevel), std::memory_order_relaxed);
+    maxTruePeakDb.store(gainToDb(maxTruePeak), std::memory_order_relaxed);
+    rmsDb.store(gainToDb((float)std::sqrt(meanSquare)), std::memory_order_relaxed);
+    shortTermLufs.store(subBlocksFilled > 0 ? (float)energyToLufs(shortTerm / subBlocksFilled) : silenceDb,
+                        std::memory_order_relaxed);
+    integratedLufs.store(computeIntegrated(), std::memory_order_relaxed);
+}
+
+OutputMeter::Readings OutputMeter::getReadings() const noexcept
+{
+    Readings readings;
+    readings.peakDb = peakDb.load(std::memory_order_relaxed);
+    readings.truePeakDb = truePeakDb.load(std::memory_order_relaxed);
+    readings.maxTruePeakDb = maxTruePeakDb.load(std::memory_order_relaxed);
+    readings.rmsDb = rmsDb.load(std::memory_order_relaxed);
+    readings.shortTermLufs = shortTermLufs.load(std::memory_order_relaxed);
+    readings.integratedLufs = integratedLufs.load(std::memory_order_relaxed);
+    return readings;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include "RealtimeOptions.h"
+
+// Output level meters: sample peak, RMS, 4x oversampled true peak and EBU R128
+// short-term and integrated loudness. The audio thread only copies each block
+// into a lock-free FIFO. The K-weighting, oversampling and gating run on the
+// meter's own thread, which publishes readings as atomics for the UI.
+class OutputMeter : private juce::Thread
+{
+public:
+    struct Readings
+    {
+        float peakDb = -100.0f;         // sample peak, falling
+        float truePeakDb = -100.0f;     // dBTP, falling
+        float maxTruePeakDb = -100.0f;  // dBTP, held since the last reset
+        float rmsDb = -100.0f;          // 300 ms window
+        float shortTermLufs = -100.0f;  // 3 s window
+        float integratedLufs = -100.0f; // gated, since the last reset
+    };
+
+    OutputMeter();
+    ~OutputMeter() override;
+
+    // Not the audio thread. Starts the meter thread the first time; after
+    // that only retunes it, and allocates nothing up to 192 kHz.
+    void prepare(double sampleRate);
+    void stop();
+
+    // Audio thread. right may be null for a mono output.
+    void pushBlock(const float* left, const float* right, int numSamples) noexcept;
+
+    // Any thread
+    Readings getReadings() const noexcept;
+    void resetIntegrated() noexcept                     { resetRequested.store(true, std::memory_order_relaxed); }
+    int getDroppedBlocks() const noexcept               { return droppedBlocks.load(std::memory_order_relaxed); }
+
+    // Audio-thread cost of pushBlock, averaged and worst case since prepare
+    float getAveragePushMicros() const noexcept         { return averagePushMicros.load(std::memory_order_relaxed); }
+    float getWorstPushMicros() const noexcept           { return worstPushMicros.load(std::memory_order_relaxed); }
+
+    // Runs the full analysis synchronously on the calling thread. For headless
+    // use while the meter thread is stopped.
+    void measure(const float* left, const float* right, int numSamples);
+
+    // Scheduling the meter thread got from the worker real-time options
+    bool getThreadResult(RealtimeThreadResult& result) const noexcept
+    {
+        if (!threadConfigured.load(std::memory_order_acquire))
+            return false;
+        result = threadResult;
+        return true;
+    }
+
+    static constexpr float silenceDb = -100.0f;
+
+private:
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1[2] = { 0.0, 0.0 }, z2[2] = { 0.0, 0.0 };
+
+        double process(double x, int channel) noexcept
+        {
+            const double y = b0 * x + z1[channel];
+            z1[channel] = b1 * x - a1 * y + z2[channel];
+            z2[channel] = b2 * x - a2 * y;
+            return y;
+        }
+
+        void reset() noexcept { z1[0] = z1[1] = z2[0] = z2[1] = 0.0; }
+    };
+
+    static constexpr int oversampling = 4;
+    static constexpr int tapsPerPhase = 12;
+    static constexpr int subBlocksPerShortTerm = 30;   // 100 ms sub-blocks
+    static constexpr int subBlocksPerGatingBlock = 4;
+    static constexpr int histogramBins = 800;          // 0.1 LU from -70 LUFS
+
+    void run() override;
+    void resetMeasurements();
+    void publish();
+    float measureTruePeak(float sample, int channel) noexcept;
+    void completeSubBlock();
+    float computeIntegrated() const;
+
+    double sampleRate = 44100.0;
+
+    // The meter thread holds stateLock while it measures, so prepare() can
+    // retune it without stopping it
+    juce::CriticalSection stateLock;
+
+    // Audio -> meter thread
+    juce::AbstractFifo fifo { 1 };
+    juce::AudioBuffer<float> fifoBuffer;
+    std::atomic<int> droppedBlocks { 0 };
+    std::atomic<bool> resetRequested { false };
+    std::atomic<bool> threadConfigured { false };
+    RealtimeThreadResult threadResult;
+
+    std::atomic<float> averagePushMicros { 0.0f };
+    std::atomic<float> worstPushMicros { 0.0f };
+    double pushMicrosAccumulator = 0.0;
+    int pushCount = 0;
+
+    // Meter thread state
+    Biquad shelf, highPass;
+    std::array<float, oversampling * tapsPerPhase> interpolator {};
+    std::array<std::array<float, tapsPerPhase>, 2> truePeakHistory {};
+    int historyPos = 0;
+
+    float peakLevel = 0.0f, truePeakLevel = 0.0f, maxTruePeak = 0.0f;
+    double meanSquare = 0.0;
+    float peakFall = 0.0f, rmsCoefficient = 0.0f;
+
+    int subBlockSamples = 1, subBlockCount = 0;
+    double subBlockEnergy = 0.0;
+    std::array<double, subBlocksPerShortTerm> subBlocks {};
+    int subBlockPos = 0, subBlocksFilled = 0;
+    std::array<juce::uint32, histogramBins> histogramCounts {};
+    std::array<double, histogramBins> histogramEnergy {};
+
+    std::atomic<float> peakDb { silenceDb }, truePeakDb { silenceDb }, maxTruePeakDb { silenceDb };
+    std::atomic<float> rmsDb { silenceDb }, shortTermLufs { silenceDb }, integratedLufs { silenceDb };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutputMeter)
+};
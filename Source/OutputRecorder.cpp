@@ -0,0 +1,103 @@
+#include "OutputRecorder.h"
+
+namespace
+{
+    // Enough FIFO to ride out a few seconds of disk stall at any sample rate
+    constexpr double writerBufferSeconds = 4.0;
+}
+
+//==============================================================================
+OutputRecorder::OutputRecorder()
+{
+    writerThread.startThread();
+}
+
+OutputRecorder::~OutputRecorder()
+{
+    stopRecording();
+    writerThread.stopThread(2000);
+}
+
+void OutputRecorder::prepare(double newSampleRate)
+{
+    // A file can't change rate halfway through, so a rate change ends the take
+    if (newSampleRate != sampleRate)
+        stopRecording();
+
+    sampleRate = newSampleRate;
+}
+
+bool OutputRecorder::startRecording(const juce::File& file)
+{
+    stopRecording();
+
+    std::unique_ptr<juce::AudioFormat> format;
+    if (file.hasFileExtension("flac"))
+        format = std::make_unique<juce::FlacAudioFormat>();
+    else
+        format = std::make_unique<juce::WavAudioFormat>();
+
+    file.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+    if (stream == nullptr)
+        return false;
+
+    auto* writer = format->createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels, bitsPerSample, {}, 0);
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // now owned by the writer
+
+    const int bufferSamples = (int)(sampleRate * writerBufferSeconds);
+    threadedWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer, writerThread, bufferSamples);
+
+    {
+        const juce::ScopedLock sl(fileLock);
+        recordingFile = file;
+    }
+
+    droppedBlocks.store(0, std::memory_order_relaxed);
+    samplesRecorded.store(0, std::memory_order_relaxed);
+    activeWriter.store(threadedWriter.get(), std::memory_order_release);
+    return true;
+}
+
+void OutputRecorder::stopRecording()
+{
+    // Sequentially consistent on both sides: a callback either sees the null
+    // writer or is counted in flight before we check
+    activeWriter.store(nullptr);
+
+    // Let a callback that already picked up the writer finish its copy
+    while (writersInFlight.load() > 0)
+        juce::Thread::yield();
+
+    // Flushes the FIFO and finalises the file header
+    threadedWriter.reset();
+}
+
+void OutputRecorder::pushBlock(const float* const* channels, int numSamples) noexcept
+{
+    ++writersInFlight;
+
+    if (auto* writer = activeWriter.load())
+    {
+        if (writer->write(channels, numSamples))
+            samplesRecorded.fetch_add(numSamples, std::memory_order_relaxed);
+        else
+            droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    --writersInFlight;
+}
+
+double OutputRecorder::getRecordedSeconds() const noexcept
+{
+    return (double)samplesRecorded.load(std::memory_order_relaxed) / sampleRate;
+}
+
+juce::File OutputRecorder::getRecordingFile() const
+{
+    const juce::ScopedLock sl(fileLock);
+    return recordingFile;
+}
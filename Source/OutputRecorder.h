@@ -0,0 +1,44 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Streams the engine output to a WAV or FLAC file. The audio thread only copies
+// into the ThreadedWriter's FIFO; encoding and disk writes happen on a
+// TimeSliceThread. Blocks that don't fit because the disk stalled are counted
+// rather than waited for.
+class OutputRecorder
+{
+public:
+    OutputRecorder();
+    ~OutputRecorder();
+
+    // Any thread except the audio thread
+    void prepare(double sampleRate);
+    bool startRecording(const juce::File& file);    // format chosen by extension (.wav or .flac)
+    void stopRecording();
+
+    // Audio thread
+    void pushBlock(const float* const* channels, int numSamples) noexcept;
+
+    bool isRecording() const noexcept                { return activeWriter.load(std::memory_order_acquire) != nullptr; }
+    int getDroppedBlocks() const noexcept            { return droppedBlocks.load(std::memory_order_relaxed); }
+    double getRecordedSeconds() const noexcept;
+    juce::File getRecordingFile() const;
+
+    static constexpr int numChannels = 2;
+    static constexpr int bitsPerSample = 24;
+
+private:
+    juce::TimeSliceThread writerThread { "Recorder writer" };
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> threadedWriter;
+    std::atomic<juce::AudioFormatWriter::ThreadedWriter*> activeWriter { nullptr };
+    std::atomic<int> writersInFlight { 0 };
+
+    std::atomic<int> droppedBlocks { 0 };
+    std::atomic<juce::int64> samplesRecorded { 0 };
+    double sampleRate = 44100.0;
+
+    juce::CriticalSection fileLock;
+    juce::File recordingFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutputRecorder)
+};
@@ -0,0 +1,466 @@
+#include "PerformanceTrace.h"
+
+namespace
+{
+    constexpr int writerIntervalMs = 50;
+    constexpr int slowestBlocksReported = 5;
+    const char magic[4] = { 'S', 'L', 'T', 'R' };
+
+    // Counts an audio-thread call so stop() can wait for it to leave
+    struct CallGuard
+    {
+        explicit CallGuard(std::atomic<int>& c) noexcept : counter(c) { ++counter; }
+        ~CallGuard() { --counter; }
+        std::atomic<int>& counter;
+    };
+}
+
+// Fixed-size scratch for one record, filled on the audio thread without allocating
+struct PerformanceTrace::RecordWriter
+{
+    juce::uint8 data[1024];
+    int size = 0;
+
+    template <typename Type>
+    void write(Type value) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        jassert(size + (int)sizeof(Type) <= (int)sizeof(data));
+        // Every supported target is little-endian, which is the file order
+        std::memcpy(data + size, &value, sizeof(Type));
+        size += (int)sizeof(Type);
+    }
+};
+
+//==============================================================================
+PerformanceTrace::PerformanceTrace()
+    : juce::Thread("Trace writer")
+{
+    fifoData.calloc((size_t)fifo.getTotalSize());
+}
+
+PerformanceTrace::~PerformanceTrace()
+{
+    stop();
+}
+
+bool PerformanceTrace::start(const juce::File& file)
+{
+    stop();
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+    auto newStream = std::make_unique<juce::FileOutputStream>(file);
+    if (newStream->failedToOpen())
+        return false;
+
+    newStream->write(magic, sizeof(magic));
+    newStream->writeShort((short)version);
+
+    {
+        const juce::ScopedLock sl(fileLock);
+        traceFile = file;
+    }
+
+    stream = std::move(newStream);
+    fifo.reset();
+    lostRecords.store(0, std::memory_order_relaxed);
+    reportedLostRecords = 0;
+    costMicrosTotal = 0.0;
+    costCount = 0;
+    averageCostMicros.store(0.0f, std::memory_order_relaxed);
+    worstCostMicros.store(0.0f, std::memory_order_relaxed);
+    nextSeed.store(juce::Random::getSystemRandom().nextInt64(), std::memory_order_relaxed);
+
+    startThread(juce::Thread::Priority::low);
+    state.store(waitingForSegment);
+    return true;
+}
+
+void PerformanceTrace::stop()
+{
+    if (state.exchange(idle) == idle)
+        return;
+
+    // Let an audio-thread call that already saw the old state finish
+    while (callsInFlight.load() > 0)
+        juce::Thread::yield();
+
+    stopThread(2000);
+    drain();
+    stream->flush();
+    stream.reset();
+}
+
+juce::File PerformanceTrace::getFile() const
+{
+    const juce::ScopedLock sl(fileLock);
+    return traceFile;
+}
+
+//==============================================================================
+void PerformanceTrace::beginSegment(SynthEngine& engine, double sampleRate, int maximumBlockSize) noexcept
+{
+    CallGuard guard(callsInFlight);
+    if (state.load() == idle)
+        return;
+
+    // prepare() keeps whatever was playing, which replay couldn't rebuild,
+    // so a segment starts from a reset engine
+    engine.reset();
+    const auto seed = nextSeed.fetch_add(1, std::memory_order_relaxed);
+    engine.setRandomSeed(seed);
+
+    std::memcpy(lastParams.data(), &engine.params, sizeof(SynthParameters));
+
+    RecordWriter record;
+    record.write(segmentRecord);
+    record.write(sampleRate);
+    record.write((juce::int32)maximumBlockSize);
+    record.write(seed);
+    record.write(engine.getTargetFrequency());
+    record.write((juce::uint8)(engine.isAudioEnabled() ? 1 : 0));
+    record.write((juce::uint16)numParamWords);
+    for (auto word : lastParams)
+        record.write(word);
+    push(record);
+
+    state.store(capturing);
+}
+
+void PerformanceTrace::beginBlock(int numSamples, QualityGovernor::Tier tier, bool audioEnabled, bool mono, const juce::MidiBuffer& midi) noexcept
+{
+    CallGuard guard(callsInFlight);
+    if (state.load() != capturing)
+        return;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    RecordWriter record;
+    record.write(blockRecord);
+    record.write((juce::uint16)numSamples);
+    record.write((juce::uint8)tier);
+    record.write((juce::uint8)((audioEnabled ? audioEnabledFlag : 0) | (mono ? monoFlag : 0)));
+    push(record);
+
+    for (const auto metadata : midi)
+    {
+        if (metadata.numBytes > 3)
+            continue; // sysex never reaches the engine
+
+        RecordWriter event;
+        event.write(midiRecord);
+        event.write((juce::uint16)metadata.samplePosition);
+        event.write((juce::uint8)metadata.numBytes);
+        for (int i = 0; i < metadata.numBytes; ++i)
+            event.write(metadata.data[i]);
+        push(event);
+    }
+
+    blockStartTicks = juce::Time::getHighResolutionTicks();
+    blockCostTicks = blockStartTicks - startTicks;
+}
+
+void PerformanceTrace::endBlock(const SynthEngine& engine, const float* left, const float* right, int numSamples) noexcept
+{
+    CallGuard guard(callsInFlight);
+    if (state.load() != capturing)
+        return;
+
+    const auto endTicks = juce::Time::getHighResolutionTicks();
+    const auto renderMicros = (float)(juce::Time::highResolutionTicksToSeconds(endTicks - blockStartTicks) * 1.0e6);
+
+    // Only the words that changed since the last block
+    ParamWords current;
+    std::memcpy(current.data(), &engine.getBlockParameters(), sizeof(SynthParameters));
+
+    RecordWriter record;
+    record.write(paramsRecord);
+    record.write((juce::uint16)0);
+    juce::uint16 changed = 0;
+    for (int w = 0; w < numParamWords; ++w)
+    {
+        if (current[(size_t)w] == lastParams[(size_t)w])
+            continue;
+
+        record.write((juce::uint16)w);
+        record.write(current[(size_t)w]);
+        ++changed;
+    }
+    if (changed > 0)
+    {
+        std::memcpy(record.data + 1, &changed, sizeof(changed));
+        push(record);
+        lastParams = current;
+    }
+
+    RecordWriter end;
+    end.write(blockEndRecord);
+    end.write(renderMicros);
+    end.write(checksum(left, right, numSamples));
+    push(end);
+
+    recordCost(blockCostTicks + juce::Time::getHighResolutionTicks() - endTicks);
+}
+
+void PerformanceTrace::push(const RecordWriter& record) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(record.size, start1, size1, start2, size2);
+
+    // Records are all or nothing so the file never holds half of one
+    if (size1 + size2 < record.size)
+    {
+        lostRecords.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::memcpy(fifoData + start1, record.data, (size_t)size1);
+    if (size2 > 0)
+        std::memcpy(fifoData + start2, record.data + size1, (size_t)size2);
+    fifo.finishedWrite(size1 + size2);
+}
+
+void PerformanceTrace::recordCost(juce::int64 ticks) noexcept
+{
+    const auto micros = (float)(juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6);
+    costMicrosTotal += micros;
+    ++costCount;
+    averageCostMicros.store((float)(costMicrosTotal / costCount), std::memory_order_relaxed);
+    if (micros > worstCostMicros.load(std::memory_order_relaxed))
+        worstCostMicros.store(micros, std::memory_order_relaxed);
+}
+
+juce::uint32 PerformanceTrace::checksum(const float* left, const float* right, int numSamples) noexcept
+{
+    // FNV-1a over the raw sample bits
+    juce::uint32 hash = 2166136261u;
+    const auto add = [&hash](const float* channel, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, channel + i, sizeof(bits));
+            hash = (hash ^ bits) * 16777619u;
+        }
+    };
+
+    add(left, numSamples);
+    if (right != nullptr)
+        add(right, numSamples);
+    return hash;
+}
+
+//==============================================================================
+void PerformanceTrace::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(writerIntervalMs);
+        drain();
+    }
+}
+
+void PerformanceTrace::drain()
+{
+    if (stream == nullptr)
+        return;
+
+    const int lost = lostRecords.load(std::memory_order_relaxed);
+    if (lost != reportedLostRecords)
+    {
+        stream->writeByte((char)overflowRecord);
+        stream->writeInt(lost - reportedLostRecords);
+        reportedLostRecords = lost;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+    if (size1 > 0)
+        stream->write(fifoData + start1, (size_t)size1);
+    if (size2 > 0)
+        stream->write(fifoData + start2, (size_t)size2);
+    fifo.finishedRead(size1 + size2);
+}
+
+//==============================================================================
+bool PerformanceTrace::replay(const juce::File& file, const juce::File& wavFile)
+{
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data) || data.getSize() < sizeof(magic) + 2 || std::memcmp(data.getData(), magic, sizeof(magic)) != 0)
+    {
+        juce::Logger::writeToLog("Replay: " + file.getFullPathName() + " is not a trace");
+        return false;
+    }
+
+    juce::MemoryInputStream in(data, false);
+    in.skipNextBytes(sizeof(magic));
+    if (in.readShort() != version)
+    {
+        juce::Logger::writeToLog("Replay: unsupported trace version");
+        return false;
+    }
+
+    auto engine = std::make_unique<SynthEngine>();
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    ParamWords words {};
+    int blockSamples = 0;
+    auto blockTier = QualityGovernor::Tier::full;
+    bool blockAudioEnabled = true;
+    bool blockMono = false;
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    double segmentSampleRate = 0.0;
+
+    struct BlockTiming { int index; double seconds; float recordedMicros; };
+    std::vector<BlockTiming> timings;
+    double recordedMicrosTotal = 0.0, replayMicrosTotal = 0.0;
+    float replayMicrosWorst = 0.0f;
+    double position = 0.0;
+    int numBlocks = 0, firstMismatch = -1, lost = 0;
+
+    while (!in.isExhausted())
+    {
+        const auto type = (juce::uint8)in.readByte();
+
+        if (type == segmentRecord)
+        {
+            segmentSampleRate = in.readDouble();
+            const int maximumBlockSize = in.readInt();
+            const auto seed = in.readInt64();
+            const float targetFrequency = in.readFloat();
+            const bool audioEnabled = in.readByte() != 0;
+            const int numWords = (juce::uint16)in.readShort();
+            if (numWords != numParamWords)
+            {
+                juce::Logger::writeToLog("Replay: trace was captured with a different parameter layout");
+                return false;
+            }
+            for (auto& w : words)
+                w = (juce::uint32)in.readInt();
+
+            // Same order as a live capture: state, prepare, reset, seed
+            std::memcpy(&engine->params, words.data(), sizeof(SynthParameters));
+            engine->setTargetFrequency(targetFrequency, true);
+            engine->setAudioEnabled(audioEnabled);
+            engine->prepare(segmentSampleRate, maximumBlockSize);
+            engine->reset();
+            engine->setRandomSeed(seed);
+            buffer.setSize(2, juce::jmax(1, maximumBlockSize));
+
+            if (wavFile != juce::File() && writer == nullptr)
+            {
+                wavFile.deleteFile();
+                if (auto stream = std::unique_ptr<juce::FileOutputStream>(wavFile.createOutputStream()))
+                {
+                    juce::WavAudioFormat wav;
+                    writer.reset(wav.createWriterFor(stream.get(), segmentSampleRate, 2, 24, {}, 0));
+                    if (writer != nullptr)
+                        stream.release();
+                }
+            }
+        }
+        else if (type == blockRecord)
+        {
+            blockSamples = (juce::uint16)in.readShort();
+            blockTier = (QualityGovernor::Tier)in.readByte();
+            const int flags = in.readByte();
+            blockAudioEnabled = (flags & audioEnabledFlag) != 0;
+            blockMono = (flags & monoFlag) != 0;
+            midi.clear();
+        }
+        else if (type == midiRecord)
+        {
+            const int offset = (juce::uint16)in.readShort();
+            const int size = (juce::uint8)in.readByte();
+            juce::uint8 bytes[3] = {};
+            for (int i = 0; i < size; ++i)
+                bytes[i] = (juce::uint8)in.readByte();
+            midi.addEvent(bytes, size, offset);
+        }
+        else if (type == paramsRecord)
+        {
+            const int count = (juce::uint16)in.readShort();
+            for (int i = 0; i < count; ++i)
+            {
+                const int index = (juce::uint16)in.readShort();
+                const auto value = (juce::uint32)in.readInt();
+                if (index < numParamWords)
+                    words[(size_t)index] = value;
+            }
+        }
+        else if (type == blockEndRecord)
+        {
+            const float recordedMicros = in.readFloat();
+            const auto recordedChecksum = (juce::uint32)in.readInt();
+
+            if (buffer.getNumSamples() < blockSamples)
+                buffer.setSize(2, blockSamples);
+
+            std::memcpy(&engine->params, words.data(), sizeof(SynthParameters));
+            engine->setQualityTier(blockTier);
+            if (blockAudioEnabled != engine->isAudioEnabled())
+                engine->setAudioEnabled(blockAudioEnabled);
+
+            buffer.clear();
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            engine->render(buffer.getWritePointer(0), blockMono ? nullptr : buffer.getWritePointer(1), blockSamples, midi);
+            const auto replayMicros = (float)(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+
+            if (firstMismatch < 0 && checksum(buffer.getReadPointer(0), blockMono ? nullptr : buffer.getReadPointer(1), blockSamples) != recordedChecksum)
+                firstMismatch = numBlocks;
+            if (blockMono)
+                buffer.copyFrom(1, 0, buffer, 0, 0, blockSamples);
+
+            if (writer != nullptr)
+                writer->writeFromAudioSampleBuffer(buffer, 0, blockSamples);
+
+            timings.push_back({ numBlocks, position, recordedMicros });
+            recordedMicrosTotal += recordedMicros;
+            replayMicrosTotal += replayMicros;
+            replayMicrosWorst = juce::jmax(replayMicrosWorst, replayMicros);
+            position += blockSamples / segmentSampleRate;
+            ++numBlocks;
+        }
+        else if (type == overflowRecord)
+        {
+            lost += in.readInt();
+        }
+        else
+        {
+            juce::Logger::writeToLog("Replay: corrupt record at byte " + juce::String(in.getPosition() - 1));
+            return false;
+        }
+    }
+
+    if (numBlocks == 0)
+    {
+        juce::Logger::writeToLog("Replay: the trace holds no blocks");
+        return false;
+    }
+
+    std::sort(timings.begin(), timings.end(), [](const BlockTiming& a, const BlockTiming& b) { return a.recordedMicros > b.recordedMicros; });
+
+    juce::String report;
+    report << "Replay: " << numBlocks << " blocks, " << juce::String(position, 2) << " s\n"
+           << "  render time live   avg " << juce::String(recordedMicrosTotal / numBlocks, 1)
+           << " us, max " << juce::String(timings.front().recordedMicros, 1) << " us\n"
+           << "  render time replay avg " << juce::String(replayMicrosTotal / numBlocks, 1)
+           << " us, max " << juce::String(replayMicrosWorst, 1) << " us\n"
+           << "  slowest live blocks:";
+    for (int i = 0; i < juce::jmin(slowestBlocksReported, (int)timings.size()); ++i)
+        report << " #" << timings[(size_t)i].index << " @" << juce::String(timings[(size_t)i].seconds, 3)
+               << "s (" << juce::String(timings[(size_t)i].recordedMicros, 1) << " us)";
+    report << '\n';
+
+    if (lost > 0)
+        report << "  " << lost << " records were lost during capture; the replay can't be exact\n";
+    if (firstMismatch >= 0)
+        report << "  output differs from the capture from block #" << firstMismatch;
+    else
+        report << "  output matches the capture bit for bit";
+
+    juce::Logger::writeToLog(report);
+    return firstMismatch < 0 && lost == 0;
+}
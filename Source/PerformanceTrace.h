@@ -0,0 +1,95 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SynthEngine.h"
+
+// Compact binary record of a performance: every block boundary, MIDI event and
+// knob change with its sample position, so a glitch or CPU spike seen live can
+// be replayed bit for bit in a headless engine.
+//
+// The audio thread appends records to a lock-free byte FIFO and a background
+// thread appends them to the file. A capture starts from a freshly prepared,
+// freshly seeded engine, which is the state replay starts from too. Loaded
+// impulse responses, samples and wavetables are not part of the trace.
+//
+// File layout (little-endian): "SLTR", u16 version, then records, each a
+// one-byte type followed by its payload:
+//   segment    f64 sample rate, i32 max block, i64 seed, f32 target frequency,
+//              u8 audio enabled, u16 word count, SynthParameters as raw words
+//   block      u16 samples, u8 quality tier, u8 flags (audio enabled, mono)
+//   midi       u16 sample offset, u8 size, up to 3 bytes
+//   params     u16 count, count x (u16 word index, u32 word)
+//   blockEnd   f32 render microseconds, u32 checksum of the engine output
+//   overflow   u32 records lost to a full FIFO since the last overflow record
+class PerformanceTrace : private juce::Thread
+{
+public:
+    PerformanceTrace();
+    ~PerformanceTrace() override;
+
+    // Message thread. Recording begins at the next beginSegment().
+    bool start(const juce::File& file);
+    void stop();
+    bool isActive() const noexcept                  { return state.load(std::memory_order_relaxed) != idle; }
+    juce::File getFile() const;
+
+    // Audio device thread, right after engine.prepare(). Resets and seeds the
+    // engine when recording.
+    void beginSegment(SynthEngine& engine, double sampleRate, int maximumBlockSize) noexcept;
+
+    // Audio thread, either side of engine.render()
+    void beginBlock(int numSamples, QualityGovernor::Tier tier, bool audioEnabled, bool mono, const juce::MidiBuffer& midi) noexcept;
+    void endBlock(const SynthEngine& engine, const float* left, const float* right, int numSamples) noexcept;
+
+    // Audio-thread cost of beginBlock() + endBlock(), since start()
+    float getAverageCostMicros() const noexcept     { return averageCostMicros.load(std::memory_order_relaxed); }
+    float getWorstCostMicros() const noexcept       { return worstCostMicros.load(std::memory_order_relaxed); }
+    int getLostRecords() const noexcept             { return lostRecords.load(std::memory_order_relaxed); }
+
+    // Headless: renders a trace through a new engine, checks every block's
+    // checksum against the capture and compares render times. wavFile may be
+    // empty. Returns true if every block matched.
+    static bool replay(const juce::File& traceFile, const juce::File& wavFile);
+
+    static constexpr int version = 1;
+
+private:
+    enum RecordType : juce::uint8 { segmentRecord = 1, blockRecord, midiRecord, paramsRecord, blockEndRecord, overflowRecord };
+    enum State { idle, waitingForSegment, capturing };
+    enum BlockFlags { audioEnabledFlag = 1, monoFlag = 2 };
+
+    static constexpr int numParamWords = (int)(sizeof(SynthParameters) / sizeof(juce::uint32));
+    static_assert(sizeof(SynthParameters) % sizeof(juce::uint32) == 0, "SynthParameters must be whole words");
+    using ParamWords = std::array<juce::uint32, (size_t)numParamWords>;
+
+    struct RecordWriter;
+
+    void run() override;
+    void drain();
+    void push(const RecordWriter& record) noexcept;
+    void recordCost(juce::int64 ticks) noexcept;
+    static juce::uint32 checksum(const float* left, const float* right, int numSamples) noexcept;
+
+    std::atomic<int> state { idle };
+    std::atomic<int> callsInFlight { 0 };
+
+    juce::AbstractFifo fifo { 1 << 20 };
+    juce::HeapBlock<juce::uint8> fifoData;
+    std::atomic<int> lostRecords { 0 };
+    int reportedLostRecords = 0;
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::CriticalSection fileLock;
+    juce::File traceFile;
+
+    // Audio thread
+    ParamWords lastParams {};
+    juce::int64 blockStartTicks = 0;
+    juce::int64 blockCostTicks = 0;
+    double costMicrosTotal = 0.0;
+    int costCount = 0;
+    std::atomic<float> averageCostMicros { 0.0f };
+    std::atomic<float> worstCostMicros { 0.0f };
+    std::atomic<juce::int64> nextSeed { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerformanceTrace)
+};
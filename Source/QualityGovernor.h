@@ -0,0 +1,130 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Watches how much of each block's real-time budget the audio callback uses and
+// steps the engine down through cheaper quality tiers before it runs out of time.
+// Written only by the audio thread; the UI reads the published tier and load.
+class QualityGovernor
+{
+public:
+    enum class Tier
+    {
+        full = 0,
+        reduced,
+        economy,
+        survival
+    };
+
+    static constexpr int numTiers = 4;
+
+    void reset()
+    {
+        tier.store((int)Tier::full, std::memory_order_relaxed);
+        load.store(0.0f, std::memory_order_relaxed);
+        smoothedLoad = 0.0f;
+        overBudgetBlocks = 0;
+        underBudgetBlocks = 0;
+    }
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+        reset();
+    }
+
+    void recordCallback(double elapsedSeconds, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        const double budget = (double)numSamples / sampleRate;
+        const float blockLoad = (float)(elapsedSeconds / budget);
+
+        // Follow spikes immediately, relax slowly
+        if (blockLoad > smoothedLoad)
+            smoothedLoad = blockLoad;
+        else
+            smoothedLoad += (blockLoad - smoothedLoad) * releaseCoefficient;
+
+        load.store(smoothedLoad, std::memory_order_relaxed);
+
+        const int current = tier.load(std::memory_order_relaxed);
+
+        if (smoothedLoad > degradeThreshold)
+        {
+            underBudgetBlocks = 0;
+            if (++overBudgetBlocks >= degradeAfterBlocks && current < numTiers - 1)
+            {
+                tier.store(current + 1, std::memory_order_relaxed);
+                overBudgetBlocks = 0;
+                smoothedLoad = 0.5f * (degradeThreshold + recoverThreshold);
+            }
+        }
+        else if (smoothedLoad < recoverThreshold)
+        {
+            overBudgetBlocks = 0;
+            // Recover only after a sustained quiet stretch so we don't flap between tiers
+            const int recoverAfterBlocks = juce::jmax(1, (int)(recoverAfterSeconds * sampleRate / (double)numSamples));
+            if (++underBudgetBlocks >= recoverAfterBlocks && current > 0)
+            {
+                tier.store(current - 1, std::memory_order_relaxed);
+                underBudgetBlocks = 0;
+            }
+        }
+        else
+        {
+            overBudgetBlocks = 0;
+            underBudgetBlocks = 0;
+        }
+    }
+
+    Tier getTier() const noexcept      { return (Tier)tier.load(std::memory_order_relaxed); }
+    float getLoad() const noexcept     { return load.load(std::memory_order_relaxed); }
+
+    static const char* getTierName(Tier t) noexcept
+    {
+        switch (t)
+        {
+            case Tier::full:     return "FULL";
+            case Tier::reduced:  return "REDUCED";
+            case Tier::economy:  return "ECONOMY";
+            case Tier::survival: return "SURVIVAL";
+        }
+        return "";
+    }
+
+    // Times one callback and reports it to the governor on scope exit
+    struct ScopedMeasurement
+    {
+        ScopedMeasurement(QualityGovernor& g, int samples) noexcept
+            : governor(g), numSamples(samples), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedMeasurement()
+        {
+            const auto elapsed = juce::Time::getHighResolutionTicks() - startTicks;
+            governor.recordCallback(juce::Time::highResolutionTicksToSeconds(elapsed), numSamples);
+        }
+
+        QualityGovernor& governor;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedMeasurement)
+    };
+
+private:
+    static constexpr float degradeThreshold = 0.7f;
+    static constexpr float recoverThreshold = 0.35f;
+    static constexpr int degradeAfterBlocks = 3;
+    static constexpr double recoverAfterSeconds = 2.0;
+    static constexpr float releaseCoefficient = 0.05f;
+
+    std::atomic<int> tier { (int)Tier::full };
+    std::atomic<float> load { 0.0f };
+    double sampleRate = 44100.0;
+    float smoothedLoad = 0.0f;
+    int overBudgetBlocks = 0;
+    int underBudgetBlocks = 0;
+
+    friend class QualityGovernorTests;
+};
@@ -0,0 +1,153 @@
+#include "RateConverter.h"
+#include <numeric>
+
+namespace
+{
+    // Kaiser design target and the audible band the passband has to cover
+    constexpr double stopbandAttenuationDb = 90.0;
+    constexpr double maxPassbandHz = 20000.0;
+    constexpr double passbandFraction = 0.45;
+    constexpr int minTapsPerPhase = 8;
+    constexpr int maxTapsPerPhase = 256;
+
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+        {
+            const double t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+}
+
+bool RateConverter::prepare(double inputRate, double outputRate, int newMaxOutputBlock)
+{
+    const auto in = (juce::int64)std::llround(inputRate);
+    const auto out = (juce::int64)std::llround(outputRate);
+    const auto divisor = in > 0 && out > 0 ? std::gcd(in, out) : 1;
+
+    // The same conversion again keeps the filter and its history
+    if (active && upFactor == out / divisor && downFactor == in / divisor && newMaxOutputBlock <= maxOutputBlock)
+        return true;
+
+    active = false;
+    if (in <= 0 || out <= 0 || in == out)
+        return false;
+
+    if (out / divisor > maxPhases)
+        return false;
+
+    upFactor = (int)(out / divisor);
+    downFactor = (int)(in / divisor);
+    maxOutputBlock = juce::jmax(1, newMaxOutputBlock);
+
+    // Aliases and images may only land above the passband edge, so the
+    // transition runs from the edge to its mirror about the lower Nyquist
+    const double passEdge = getPassbandEdge(inputRate, outputRate);
+    const double stopEdge = juce::jmin(inputRate, outputRate) - passEdge;
+    const double transition = (stopEdge - passEdge) / inputRate;
+    tapsPerPhase = juce::jlimit(minTapsPerPhase, maxTapsPerPhase,
+                                (int)std::ceil((stopbandAttenuationDb - 7.95) / (14.36 * transition)) + 1);
+    historyLength = tapsPerPhase;
+
+    const int length = upFactor * tapsPerPhase;
+    const double beta = 0.1102 * (stopbandAttenuationDb - 8.7);
+    const double cutoff = 0.5 * (passEdge + stopEdge) / inputRate;
+    const double centre = 0.5 * (length - 1);
+    const double i0Beta = besselI0(beta);
+
+    coefficients.assign((size_t)length, 0.0f);
+    std::vector<double> phaseTaps((size_t)tapsPerPhase);
+    for (int p = 0; p < upFactor; ++p)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < tapsPerPhase; ++j)
+        {
+            const int i = p + j * upFactor;
+            const double t = (i - centre) / upFactor;
+            const double x = juce::MathConstants<double>::pi * 2.0 * cutoff * t;
+            const double sinc = t == 0.0 ? 1.0 : std::sin(x) / x;
+            const double r = (i - centre) / centre;
+            const double window = besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - r * r))) / i0Beta;
+            phaseTaps[(size_t)j] = 2.0 * cutoff * sinc * window;
+            sum += phaseTaps[(size_t)j];
+        }
+        for (int j = 0; j < tapsPerPhase; ++j)
+            coefficients[(size_t)(p * tapsPerPhase + j)] = (float)(sum != 0.0 ? phaseTaps[(size_t)j] / sum : 0.0);
+    }
+
+    latencySamples = juce::roundToInt((length - 1) / (2.0 * downFactor));
+
+    // A block can start up to M/L inputs past the last one rendered
+    const int maxInput = (int)(((juce::int64)(maxOutputBlock + 1) * downFactor) / upFactor) + 3;
+    for (auto& channel : work)
+        channel.assign((size_t)(historyLength + maxInput), 0.0f);
+
+    reset();
+    active = true;
+    return true;
+}
+
+void RateConverter::reset() noexcept
+{
+    for (auto& channel : work)
+        std::fill(channel.begin(), channel.end(), 0.0f);
+    baseOffset = 0;
+    phase = 0;
+}
+
+int RateConverter::getInputSamplesNeeded(int numOutputSamples) const noexcept
+{
+    if (numOutputSamples <= 0)
+        return 0;
+
+    const auto lastBase = baseOffset + (int)((phase + (juce::int64)(numOutputSamples - 1) * downFactor) / upFactor);
+    return juce::jmax(0, lastBase + 1);
+}
+
+void RateConverter::process(float* left, float* right, int numOutputSamples) noexcept
+{
+    jassert(numOutputSamples <= maxOutputBlock);
+    const int newInputs = getInputSamplesNeeded(numOutputSamples);
+    const float* inL = work[0].data();
+    const float* inR = work[1].data();
+
+    for (int k = 0; k < numOutputSamples; ++k)
+    {
+        const float* c = coefficients.data() + phase * tapsPerPhase;
+        const int newest = historyLength + baseOffset;
+        float sumL = 0.0f, sumR = 0.0f;
+        if (right != nullptr)
+        {
+            for (int j = 0; j < tapsPerPhase; ++j)
+            {
+                sumL += c[j] * inL[newest - j];
+                sumR += c[j] * inR[newest - j];
+            }
+            right[k] = sumR;
+        }
+        else
+        {
+            for (int j = 0; j < tapsPerPhase; ++j)
+                sumL += c[j] * inL[newest - j];
+        }
+        left[k] = sumL;
+
+        phase += downFactor;
+        baseOffset += phase / upFactor;
+        phase %= upFactor;
+    }
+
+    // Keep the newest inputs as history for the next block
+    for (int ch = 0; ch < (right != nullptr ? 2 : 1); ++ch)
+        std::memmove(work[ch].data(), work[ch].data() + newInputs, sizeof(float) * (size_t)historyLength);
+    baseOffset -= newInputs;
+}
+
+double RateConverter::getPassbandEdge(double inputRate, double outputRate) noexcept
+{
+    return juce::jmin(maxPassbandHz, passbandFraction * juce::jmin(inputRate, outputRate));
+}
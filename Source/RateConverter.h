@@ -0,0 +1,54 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Polyphase resampler from the engine's internal render rate to the device
+// rate, for any pair of rates whose ratio reduces to L/M with at most
+// maxPhases phases (every pair of standard rates does).
+//
+// Per block the caller asks how many input samples the next output block
+// needs, renders exactly that many into getInputBuffer(), then calls process().
+// The filter is a Kaiser-windowed sinc cut just below the lower Nyquist, with
+// each phase normalised to unity gain at DC.
+class RateConverter
+{
+public:
+    // Not the audio thread. Returns false, and leaves the converter inactive,
+    // if the ratio needs too many phases.
+    bool prepare(double inputRate, double outputRate, int maxOutputBlock);
+    void reset() noexcept;
+
+    // Audio thread
+    int getInputSamplesNeeded(int numOutputSamples) const noexcept;
+    float* getInputBuffer(int channel) noexcept          { return work[channel].data() + historyLength; }
+    void process(float* left, float* right, int numOutputSamples) noexcept;
+
+    bool isActive() const noexcept                       { return active; }
+    int getMaxOutputBlock() const noexcept               { return maxOutputBlock; }
+    int getMaxInputBlock() const noexcept                { return (int)work[0].size() - historyLength; }
+    // Group delay of the filter, in output samples
+    int getLatencySamples() const noexcept               { return latencySamples; }
+
+    // Top of the flat band for a rate pair: 20 kHz, or 45% of the lower rate
+    static double getPassbandEdge(double inputRate, double outputRate) noexcept;
+
+    static constexpr int maxPhases = 1024;
+
+private:
+    bool active = false;
+    int upFactor = 1, downFactor = 1;   // L and M
+    int tapsPerPhase = 0;
+    int historyLength = 0;
+    int maxOutputBlock = 0;
+    int latencySamples = 0;
+
+    // Phase-major: coefficients[phase * tapsPerPhase + tap]
+    std::vector<float> coefficients;
+    std::vector<float> work[2];
+
+    // Position of the next output: input sample baseOffset past the first new
+    // input of the next block, plus phase / L
+    int baseOffset = 0;
+    int phase = 0;
+
+    friend class RateConverterTests;
+};
@@ -0,0 +1,188 @@
+#include "RealtimeOptions.h"
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+ #include <sys/mman.h>
+ #include <cerrno>
+#endif
+
+namespace
+{
+    constexpr int workerPriorityOffset = 10;
+
+    RealtimeOptions currentOptions;
+
+    juce::Array<int> parseCores(const juce::String& list)
+    {
+        juce::Array<int> cores;
+        for (auto& token : juce::StringArray::fromTokens(list, ",", ""))
+            if (token.trim().containsOnly("0123456789") && token.trim().isNotEmpty())
+                cores.addIfNotAlreadyThere(token.trim().getIntValue());
+        return cores;
+    }
+
+    RealtimeThreadResult configureCurrentThread(RealtimeOptions::Policy policy, int priority, const juce::Array<int>& cores) noexcept
+    {
+        RealtimeThreadResult result;
+        result.policy = policy;
+        result.priority = priority;
+
+       #if JUCE_LINUX
+        if (policy != RealtimeOptions::Policy::normal)
+        {
+            result.attempted = true;
+            sched_param param {};
+            param.sched_priority = priority;
+            result.scheduleError = pthread_setschedparam(pthread_self(),
+                policy == RealtimeOptions::Policy::fifo ? SCHED_FIFO : SCHED_RR, &param);
+        }
+
+        if (!cores.isEmpty())
+        {
+            result.attempted = true;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int core : cores)
+                if (core >= 0 && core < CPU_SETSIZE)
+                    CPU_SET(core, &set);
+            result.affinityError = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            result.pinned = result.affinityError == 0;
+        }
+       #else
+        result.attempted = policy != RealtimeOptions::Policy::normal || !cores.isEmpty();
+        result.scheduleError = result.affinityError = -1;
+       #endif
+
+        return result;
+    }
+
+    juce::String describeError(int error)
+    {
+        if (error == -1)
+            return "not supported on this platform";
+       #if JUCE_LINUX
+        if (error == EPERM)
+            return "permission denied, raise rtprio in /etc/security/limits.conf";
+        if (error == EINVAL)
+            return "invalid value";
+       #endif
+        return "error " + juce::String(error);
+    }
+}
+
+//==============================================================================
+RealtimeOptions RealtimeOptions::parse(const juce::StringArray& args)
+{
+    RealtimeOptions options;
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const auto value = args[i + 1].unquoted();
+
+        if (arg == "--mlock")
+        {
+            options.lockMemory = true;
+        }
+        else if (arg == "--rt-policy")
+        {
+            options.policy = value == "fifo" ? Policy::fifo : value == "rr" ? Policy::roundRobin : Policy::normal;
+            ++i;
+        }
+        else if (arg == "--rt-priority")
+        {
+            options.priority = juce::jlimit(1, 99, value.getIntValue());
+            ++i;
+        }
+        else if (arg == "--audio-cores")
+        {
+            options.audioCores = parseCores(value);
+            ++i;
+        }
+        else if (arg == "--worker-cores")
+        {
+            options.workerCores = parseCores(value);
+            ++i;
+        }
+    }
+    return options;
+}
+
+bool RealtimeOptions::requestsAnything() const noexcept
+{
+    return policy != Policy::normal || lockMemory || !audioCores.isEmpty() || !workerCores.isEmpty();
+}
+
+void RealtimeOptions::setCurrent(const RealtimeOptions& options)   { currentOptions = options; }
+const RealtimeOptions& RealtimeOptions::getCurrent() noexcept      { return currentOptions; }
+
+const char* RealtimeOptions::getPolicyName(Policy p) noexcept
+{
+    switch (p)
+    {
+        case Policy::fifo:       return "SCHED_FIFO";
+        case Policy::roundRobin: return "SCHED_RR";
+        case Policy::normal:     break;
+    }
+    return "normal";
+}
+
+juce::String RealtimeThreadResult::describe(const juce::Array<int>& cores) const
+{
+    if (!attempted)
+        return "normal scheduling";
+
+    juce::String text;
+    if (policy == RealtimeOptions::Policy::normal)
+        text << "normal scheduling";
+    else if (scheduleError == 0)
+        text << RealtimeOptions::getPolicyName(policy) << " " << priority;
+    else
+        text << "normal scheduling (" << RealtimeOptions::getPolicyName(policy) << " " << describeError(scheduleError) << ")";
+
+    if (pinned)
+    {
+        juce::StringArray list;
+        for (int core : cores)
+            list.add(juce::String(core));
+        text << ", cores " << list.joinIntoString(",");
+    }
+    else if (!cores.isEmpty())
+    {
+        text << ", unpinned (" << describeError(affinityError) << ")";
+    }
+    return text;
+}
+
+//==============================================================================
+RealtimeThreadResult Realtime::configureAudioThread() noexcept
+{
+    const auto& options = RealtimeOptions::getCurrent();
+    return configureCurrentThread(options.policy, options.priority, options.audioCores);
+}
+
+RealtimeThreadResult Realtime::configureWorkerThread() noexcept
+{
+    const auto& options = RealtimeOptions::getCurrent();
+    return configureCurrentThread(options.policy, juce::jmax(1, options.priority - workerPriorityOffset), options.workerCores);
+}
+
+int Realtime::lockAllMemory() noexcept
+{
+   #if JUCE_LINUX
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : errno;
+   #else
+    return -1;
+   #endif
+}
+
+juce::String Realtime::describeMemoryLock(int result)
+{
+    if (result == 0)
+        return "locked";
+   #if JUCE_LINUX
+    if (result == EPERM || result == ENOMEM)
+        return "not locked (raise memlock in /etc/security/limits.conf)";
+   #endif
+    return "not locked (" + describeError(result) + ")";
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Linux real-time options, taken from the command line or from the
+// SPECTRAL_LAB_REALTIME environment variable (same syntax, for launchers):
+//
+//   --rt-policy fifo|rr     SCHED_FIFO or SCHED_RR for the audio and worker threads
+//   --rt-priority <1-99>    audio thread priority; the worker threads run 10 lower
+//   --audio-cores 2,3       pin the audio thread to these cores
+//   --worker-cores 1        pin the worker threads (meter, convolution tail,
+//                           sample prefetch) to these cores
+//   --mlock                 mlockall() at startup and again after each prepare,
+//                           which also faults in every buffer prepare allocated
+//
+// Each request either takes effect or is reported as refused, with the reason,
+// and the thread carries on with normal scheduling. Elsewhere every request is
+// reported as unsupported.
+struct RealtimeOptions
+{
+    enum class Policy { normal, fifo, roundRobin };
+
+    Policy policy = Policy::normal;
+    int priority = 70;
+    juce::Array<int> audioCores, workerCores;
+    bool lockMemory = false;
+
+    static RealtimeOptions parse(const juce::StringArray& args);
+    bool requestsAnything() const noexcept;
+
+    // Process-wide. Threads apply them as they start, so set them first.
+    static void setCurrent(const RealtimeOptions& options);
+    static const RealtimeOptions& getCurrent() noexcept;
+    static const char* getPolicyName(Policy policy) noexcept;
+};
+
+// What applying the options to one thread achieved. Filled without allocating,
+// so the audio thread can apply its own settings on its first callback.
+struct RealtimeThreadResult
+{
+    bool attempted = false;
+    RealtimeOptions::Policy policy = RealtimeOptions::Policy::normal;
+    int priority = 0;
+    int scheduleError = 0;      // errno from pthread_setschedparam, 0 on success
+    int affinityError = 0;      // errno from pthread_setaffinity_np, 0 on success
+    bool pinned = false;
+
+    juce::String describe(const juce::Array<int>& cores) const;
+};
+
+namespace Realtime
+{
+    RealtimeThreadResult configureAudioThread() noexcept;
+    RealtimeThreadResult configureWorkerThread() noexcept;
+
+    // Returns 0 or the errno from mlockall(); -1 where unsupported
+    int lockAllMemory() noexcept;
+    juce::String describeMemoryLock(int result);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+// Hands immutable objects (sample sets, tables...) built on a background thread
+// to the audio thread without locks, and without ever freeing on the audio thread.
+//
+// publish() may be called from any non-audio thread. The audio thread calls
+// acquire() once per block and uses the returned pointer until the next call.
+// Objects it lets go of are queued, and collectGarbage() frees them later on a
+// single non-audio thread.
+template <typename ObjectType>
+class RealtimeSwap
+{
+public:
+    RealtimeSwap() = default;
+
+    ~RealtimeSwap()
+    {
+        delete pending.exchange(nullptr);
+        delete active;
+        collectGarbage();
+    }
+
+    void publish(std::unique_ptr<ObjectType> next)
+    {
+        // A replaced pending object was never seen by the audio thread
+        delete pending.exchange(next.release(), std::memory_order_acq_rel);
+    }
+
+    ObjectType* acquire() noexcept
+    {
+        // With nowhere to retire the current object, keep it until the collector catches up
+        if (retiredFifo.getFreeSpace() == 0)
+            return active;
+
+        if (auto* next = pending.exchange(nullptr, std::memory_order_acq_rel))
+        {
+            if (active != nullptr)
+            {
+                int start1, size1, start2, size2;
+                retiredFifo.prepareToWrite(1, start1, size1, start2, size2);
+                retired[(size_t)(size1 > 0 ? start1 : start2)] = active;
+                retiredFifo.finishedWrite(1);
+            }
+
+            active = next;
+        }
+
+        return active;
+    }
+
+    void collectGarbage()
+    {
+        int start1, size1, start2, size2;
+        retiredFifo.prepareToRead(retiredFifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            delete std::exchange(retired[(size_t)(start1 + i)], nullptr);
+        for (int i = 0; i < size2; ++i)
+            delete std::exchange(retired[(size_t)(start2 + i)], nullptr);
+
+        retiredFifo.finishedRead(size1 + size2);
+    }
+
+private:
+    static constexpr int retiredCapacity = 32;
+
+    std::atomic<ObjectType*> pending { nullptr };
+    ObjectType* active = nullptr;
+    juce::AbstractFifo retiredFifo { retiredCapacity };
+    std::array<ObjectType*, retiredCapacity> retired {};
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeSwap)
+};
@@ -0,0 +1,293 @@
+#include "SampleOscillator.h"
+
+namespace
+{
+    constexpr int touchStrideFrames = 512;
+    constexpr int maxFrameChannels = 8;
+
+    double noteToFrequency(int midiNote)
+    {
+        return 440.0 * std::pow(2.0, (midiNote - 69) / 12.0);
+    }
+}
+
+//==============================================================================
+SampleOscillator::SampleOscillator()
+    : juce::Thread("Sample prefetch")
+{
+    startThread();
+}
+
+SampleOscillator::~SampleOscillator()
+{
+    loaderPool.removeAllJobs(true, 5000);
+    stopThread(2000);
+}
+
+void SampleOscillator::prepare(double sampleRate)
+{
+    engineSampleRate = sampleRate;
+    playing = false;
+    position = 0.0;
+}
+
+juce::String SampleOscillator::getSetName() const
+{
+    const juce::ScopedLock sl(nameLock);
+    return setName;
+}
+
+const SampleOscillator::Zone* SampleOscillator::SampleSet::findZone(int midiNote) const noexcept
+{
+    const Zone* best = nullptr;
+    int bestDistance = std::numeric_limits<int>::max();
+
+    for (const auto& zone : zones)
+    {
+        const int distance = std::abs(zone.rootNote - midiNote);
+        if (distance < bestDistance)
+        {
+            best = &zone;
+            bestDistance = distance;
+        }
+    }
+
+    return best;
+}
+
+//==============================================================================
+void SampleOscillator::loadSamples(const juce::File& folderOrFile)
+{
+    loaderPool.addJob([this, folderOrFile] { loadOnBackgroundThread(folderOrFile); });
+}
+
+void SampleOscillator::loadOnBackgroundThread(const juce::File& folderOrFile)
+{
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    juce::Array<juce::File> files;
+    if (folderOrFile.isDirectory())
+        files = folderOrFile.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff");
+    else
+        files.add(folderOrFile);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto set = std::make_unique<SampleSet>();
+    juce::int64 mappedBytes = 0;
+
+    for (const auto& file : files)
+    {
+        auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+        if (format == nullptr)
+            continue;
+
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(file));
+        if (reader == nullptr || reader->lengthInSamples < 4 || !reader->mapEntireFile())
+            continue;
+
+        Zone zone;
+        zone.rootNote = parseRootNote(*reader, file);
+        zone.rootFrequency = noteToFrequency(zone.rootNote);
+        zone.fileSampleRate = reader->sampleRate;
+        zone.length = reader->lengthInSamples;
+
+        const auto& metadata = reader->metadataValues;
+        if (metadata.getValue("NumSampleLoops", "0").getIntValue() > 0)
+        {
+            zone.loopStart = metadata.getValue("Loop0Start", "-1").getLargeIntValue();
+            zone.loopEnd = juce::jmin(zone.length - 2, metadata.getValue("Loop0End", "-1").getLargeIntValue());
+        }
+
+        mappedBytes += (juce::int64)reader->getNumBytesUsed();
+        zone.reader = std::move(reader);
+
+        // Fault the attack in now so note starts never wait on the disk
+        touchRange(zone, 0, (juce::int64)(attackPreloadSeconds * zone.fileSampleRate));
+
+        set->zones.push_back(std::move(zone));
+    }
+
+    if (set->zones.empty())
+        return;
+
+    std::sort(set->zones.begin(), set->zones.end(),
+        [](const Zone& a, const Zone& b) { return a.rootNote < b.rootNote; });
+
+    juce::Logger::writeToLog("Sample set " + folderOrFile.getFileName() + ": "
+        + juce::String((int)set->zones.size()) + " zones, "
+        + juce::File::descriptionOfSizeInBytes(mappedBytes) + " mapped, loaded in "
+        + juce::String(juce::Time::getMillisecondCounterHiRes() - startTime, 1) + " ms");
+
+    {
+        const juce::ScopedLock sl(nameLock);
+        setName = folderOrFile.getFileNameWithoutExtension();
+    }
+
+    sets.publish(std::move(set));
+}
+
+int SampleOscillator::parseRootNote(const juce::MemoryMappedAudioFormatReader& reader, const juce::File& file)
+{
+    const auto unityNote = reader.metadataValues.getValue("MidiUnityNote", {});
+    if (unityNote.isNotEmpty())
+        return juce::jlimit(0, 127, unityNote.getIntValue());
+
+    // Fall back to a trailing note name ("Piano_C#4") or number ("Piano_61")
+    auto tokens = juce::StringArray::fromTokens(file.getFileNameWithoutExtension(), " _-.", {});
+    for (int t = tokens.size(); --t >= 0;)
+    {
+        const auto token = tokens[t];
+
+        if (token.containsOnly("0123456789"))
+        {
+            const int number = token.getIntValue();
+            if (number <= 127)
+                return number;
+            continue;
+        }
+
+        static const juce::String noteNames = "C D EF G A B";
+        const int pitchClass = noteNames.indexOfChar(juce::CharacterFunctions::toUpperCase(token[0]));
+        if (pitchClass < 0 || noteNames[pitchClass] == ' ')
+            continue;
+
+        int index = 1;
+        int accidental = 0;
+        if (token[index] == '#')      { accidental = 1;  ++index; }
+        else if (token[index] == 'b') { accidental = -1; ++index; }
+
+        const auto octaveText = token.substring(index);
+        if (octaveText.isEmpty() || !octaveText.trimCharactersAtStart("-").containsOnly("0123456789"))
+            continue;
+
+        return juce::jlimit(0, 127, (octaveText.getIntValue() + 1) * 12 + pitchClass + accidental);
+    }
+
+    return 60;
+}
+
+void SampleOscillator::touchRange(const Zone& zone, juce::int64 start, juce::int64 end)
+{
+    end = juce::jmin(end, zone.length);
+    for (auto i = juce::jmax((juce::int64)0, start); i < end; i += touchStrideFrames)
+        zone.reader->touchSample(i);
+}
+
+//==============================================================================
+void SampleOscillator::run()
+{
+    threadResult = Realtime::configureWorkerThread();
+    threadConfigured.store(true, std::memory_order_release);
+
+    const Zone* lastZone = nullptr;
+    juce::int64 lastPlayhead = 0;
+    juce::int64 prefetchedUpTo = 0;
+
+    while (!threadShouldExit())
+    {
+        // The zone is only touched before this thread frees anything, so a set
+        // the audio thread has just retired is never read after deletion
+        const auto* zone = prefetchZone.load();
+        if (zone != nullptr)
+        {
+            const auto playhead = prefetchPlayhead.load(std::memory_order_relaxed);
+            if (zone != lastZone || playhead < lastPlayhead)
+                prefetchedUpTo = playhead;
+
+            lastZone = zone;
+            lastPlayhead = playhead;
+
+            const auto target = playhead + (juce::int64)(prefetchAheadSeconds * zone->fileSampleRate);
+            if (target > prefetchedUpTo)
+            {
+                touchRange(*zone, prefetchedUpTo, target);
+                prefetchedUpTo = target;
+            }
+        }
+        else
+        {
+            lastZone = nullptr;
+        }
+
+        sets.collectGarbage();
+        wait(zone != nullptr ? 5 : 50);
+    }
+}
+
+//==============================================================================
+void SampleOscillator::beginBlock() noexcept
+{
+    // Hide the zone from the prefetcher while a set might be retired
+    prefetchZone.store(nullptr);
+
+    auto* set = sets.acquire();
+    if (set != currentSet)
+    {
+        currentSet = set;
+        currentZone = nullptr;
+        playing = false;
+    }
+
+    if (playing)
+        prefetchZone.store(currentZone);
+}
+
+void SampleOscillator::trigger(int midiNote) noexcept
+{
+    if (currentSet == nullptr)
+        return;
+
+    currentZone = currentSet->findZone(midiNote);
+    position = 0.0;
+    playing = currentZone != nullptr;
+    prefetchPlayhead.store(0, std::memory_order_relaxed);
+    prefetchZone.store(playing ? currentZone : nullptr);
+}
+
+float SampleOscillator::readFrame(juce::int64 index) const noexcept
+{
+    float frame[maxFrameChannels];
+    currentZone->reader->getSample(juce::jlimit((juce::int64)0, currentZone->length - 1, index), frame);
+
+    const int channels = juce::jmin(2, (int)currentZone->reader->numChannels);
+    return channels > 1 ? 0.5f * (frame[0] + frame[1]) : frame[0];
+}
+
+float SampleOscillator::renderSample(float frequency, bool gate) noexcept
+{
+    if (!playing)
+        return 0.0f;
+
+    const auto& zone = *currentZone;
+    const auto i = (juce::int64)position;
+    const float t = (float)(position - (double)i);
+
+    // Catmull-Rom interpolation
+    const float y0 = readFrame(i - 1);
+    const float y1 = readFrame(i);
+    const float y2 = readFrame(i + 1);
+    const float y3 = readFrame(i + 2);
+    const float c1 = 0.5f * (y2 - y0);
+    const float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+    const float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+    const float out = ((c3 * t + c2) * t + c1) * t + y1;
+
+    position += ((double)frequency / zone.rootFrequency) * (zone.fileSampleRate / engineSampleRate);
+
+    if (gate && zone.loopEnd > zone.loopStart && zone.loopStart >= 0 && position >= (double)zone.loopEnd)
+        position -= (double)(zone.loopEnd - zone.loopStart);
+
+    if (position >= (double)(zone.length - 1))
+    {
+        playing = false;
+        prefetchZone.store(nullptr);
+    }
+    else
+    {
+        prefetchPlayhead.store((juce::int64)position, std::memory_order_relaxed);
+    }
+
+    return out;
+}
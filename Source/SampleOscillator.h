@@ -0,0 +1,93 @@
+#pragma once
+#include <JuceHeader.h>
+#include "RealtimeOptions.h"
+#include "RealtimeSwap.h"
+#include <vector>
+
+// Plays multisampled instruments straight from memory-mapped files, so sets far
+// larger than RAM can be layered with the morph oscillator.
+//
+// Files are mapped (not read) on a loader thread and the first part of every
+// zone is touched up front so attacks never fault. While a zone plays, a
+// prefetch thread touches the pages ahead of the playhead. The audio thread
+// reads frames from the mapping and pitch-shifts with cubic interpolation.
+class SampleOscillator : private juce::Thread
+{
+public:
+    SampleOscillator();
+    ~SampleOscillator() override;
+
+    void prepare(double sampleRate);
+    // Follows a rate change without stopping the sample that's playing
+    void setSampleRate(double sampleRate) noexcept    { engineSampleRate = sampleRate; }
+
+    // Message thread: maps every audio file in a folder (or a single file)
+    void loadSamples(const juce::File& folderOrFile);
+
+    // Audio thread
+    void beginBlock() noexcept;
+    void trigger(int midiNote) noexcept;
+    float renderSample(float frequency, bool gate) noexcept;
+
+    juce::String getSetName() const;
+
+    // Scheduling the prefetch thread got from the worker real-time options
+    bool getThreadResult(RealtimeThreadResult& result) const noexcept
+    {
+        if (!threadConfigured.load(std::memory_order_acquire))
+            return false;
+        result = threadResult;
+        return true;
+    }
+
+    static constexpr double attackPreloadSeconds = 0.5;
+    static constexpr double prefetchAheadSeconds = 1.0;
+
+private:
+    struct Zone
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+        int rootNote = 60;
+        double rootFrequency = 261.63;
+        double fileSampleRate = 44100.0;
+        juce::int64 length = 0;
+        juce::int64 loopStart = -1;
+        juce::int64 loopEnd = -1;
+    };
+
+    struct SampleSet
+    {
+        std::vector<Zone> zones;
+        const Zone* findZone(int midiNote) const noexcept;
+    };
+
+    void run() override;
+    void loadOnBackgroundThread(const juce::File& folderOrFile);
+    static int parseRootNote(const juce::MemoryMappedAudioFormatReader& reader, const juce::File& file);
+    static void touchRange(const Zone& zone, juce::int64 start, juce::int64 end);
+    float readFrame(juce::int64 index) const noexcept;
+
+    RealtimeSwap<SampleSet> sets;
+
+    // Audio thread
+    SampleSet* currentSet = nullptr;
+    const Zone* currentZone = nullptr;
+    double position = 0.0;
+    bool playing = false;
+    double engineSampleRate = 44100.0;
+
+    // Audio thread -> prefetcher
+    std::atomic<const Zone*> prefetchZone { nullptr };
+    std::atomic<juce::int64> prefetchPlayhead { 0 };
+
+    // Prefetcher
+    std::atomic<bool> threadConfigured { false };
+    RealtimeThreadResult threadResult;
+
+    juce::ThreadPool loaderPool { 1 };
+    juce::CriticalSection nameLock;
+    juce::String setName;
+
+    friend class SampleOscillatorTests;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleOscillator)
+};
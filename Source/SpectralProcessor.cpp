@@ -0,0 +1,405 @@
+#include "SpectralProcessor.h"
+
+namespace
+{
+    constexpr double mixRampSeconds = 0.05;
+    // Full blur holds magnitudes with this time constant
+    constexpr double maxBlurSeconds = 2.0;
+    // Time constants until an exponential tail is 60 dB down
+    constexpr double decayTo60dB = 6.9;
+    // Below this a bin counts as silent and keeps no phase
+    constexpr float binFloor = 1.0e-12f;
+}
+
+//==============================================================================
+SpectralProcessor::SpectralProcessor()
+{
+    for (int i = 0; i < numFftSizes; ++i)
+        ffts[(size_t)i] = std::make_unique<juce::dsp::FFT>(minFftOrder + i);
+}
+
+size_t SpectralProcessor::getArenaFootprint() noexcept
+{
+    size_t windowFloats = 0;
+    for (int order = minFftOrder; order <= maxFftOrder; ++order)
+        windowFloats += DspArena::getFootprint((size_t)1 << order);
+
+    const size_t perChannel = 2 * DspArena::getFootprint(ringSize)
+                            + DspArena::getFootprint(2 * maxFftSize)
+                            + 3 * DspArena::getFootprint(2 * maxBins)
+                            + 2 * DspArena::getFootprint(maxBins);
+    return windowFloats + 2 * perChannel;
+}
+
+void SpectralProcessor::prepare(double newSampleRate, DspArena& arena)
+{
+    sampleRate = newSampleRate;
+
+    // Periodic sqrt-Hann: analysis times synthesis is a Hann window, which
+    // overlap-adds to a constant at any of the hops
+    for (int i = 0; i < numFftSizes; ++i)
+    {
+        const int size = 1 << (minFftOrder + i);
+        auto* window = arena.allocate((size_t)size);
+        for (int n = 0; n < size; ++n)
+            window[n] = std::sin(juce::MathConstants<float>::pi * (float)n / (float)size);
+        windows[(size_t)i] = window;
+    }
+
+    for (auto& channel : channels)
+    {
+        channel.input = arena.allocate(ringSize);
+        channel.output = arena.allocate(ringSize);
+        channel.frame = arena.allocate(2 * maxFftSize);
+        channel.previous = arena.allocate(2 * maxBins);
+        channel.smoothed = arena.allocate(maxBins);
+        channel.frozen = arena.allocate(maxBins);
+        channel.phasor = arena.allocate(2 * maxBins);
+        channel.rotation = arena.allocate(2 * maxBins);
+    }
+
+    mixSmoothed.reset(sampleRate, mixRampSeconds);
+    engageSmoothed.reset(sampleRate, mixRampSeconds);
+    reset();
+}
+
+void SpectralProcessor::reset()
+{
+    mixSmoothed.setCurrentAndTargetValue(0.0f);
+    engageSmoothed.setCurrentAndTargetValue(0.0f);
+    engaged = false;
+    framingPending = false;
+    warmUpSamples = 0;
+    latencySamples.store(0, std::memory_order_relaxed);
+    applyFraming();
+
+    for (auto& channel : channels)
+        if (channel.input != nullptr)
+            juce::FloatVectorOperations::clear(channel.input, ringSize);
+    writePos = 0;
+    resetFrames();
+}
+
+void SpectralProcessor::resetFrames()
+{
+    // The input ring and its write position carry on, so the dry history stays whole
+    for (auto& channel : channels)
+    {
+        if (channel.output == nullptr)
+            continue;
+
+        juce::FloatVectorOperations::clear(channel.output, ringSize);
+        juce::FloatVectorOperations::clear(channel.previous, 2 * maxBins);
+        juce::FloatVectorOperations::clear(channel.smoothed, maxBins);
+        channel.holding = false;
+    }
+
+    hopPosition = 0;
+    frameEnd = writePos;
+    unitsDone = 0;
+    frameInFlight = false;
+}
+
+void SpectralProcessor::setParameters(int newFftOrder, int overlap, bool freeze, float blur, float newGateDb, float mix)
+{
+    newFftOrder = juce::jlimit(minFftOrder, maxFftOrder, newFftOrder);
+    overlap = overlap >= 8 ? 8 : (overlap >= 4 ? 4 : 2);
+    blur = juce::jlimit(0.0f, 1.0f, blur);
+    newGateDb = juce::jlimit(gateOffDb, 0.0f, newGateDb);
+
+    freezeRequested = freeze;
+    if (newFftOrder != requestedOrder || overlap != requestedOverlap)
+    {
+        requestedOrder = newFftOrder;
+        requestedOverlap = overlap;
+
+        // Running frames can't change shape; the stage fades out, reframes and fades back in
+        if (engaged)
+        {
+            framingPending = true;
+        }
+        else
+        {
+            applyFraming();
+            resetFrames();
+        }
+    }
+
+    if (blur != blurAmount || newGateDb != gateDb)
+    {
+        blurAmount = blur;
+        gateDb = newGateDb;
+        updateCoefficients();
+    }
+
+    mixSmoothed.setTargetValue(juce::jlimit(0.0f, 1.0f, mix));
+}
+
+void SpectralProcessor::applyFraming()
+{
+    fftOrder = requestedOrder;
+    fftSize = 1 << fftOrder;
+    hop = fftSize / requestedOverlap;
+    latency = fftSize + hop;
+    // sqrt-Hann squared sums to overlap / 2 across the frames covering a sample
+    overlapGain = 2.0f / (float)requestedOverlap;
+    updateCoefficients();
+}
+
+void SpectralProcessor::updateCoefficients()
+{
+    const double blurSeconds = (double)blurAmount * blurAmount * maxBlurSeconds;
+    blurCoefficient = blurSeconds > 0.0 ? (float)std::exp(-(double)hop / (blurSeconds * sampleRate)) : 0.0f;
+
+    // A full-scale sine peaks at half the window's sum, about size / pi
+    gateThreshold = gateDb > gateOffDb ? juce::Decibels::decibelsToGain(gateDb) * (float)fftSize / juce::MathConstants<float>::pi
+                                       : 0.0f;
+}
+
+int SpectralProcessor::getTailLengthSamples() const noexcept
+{
+    const double blurSeconds = (double)blurAmount * blurAmount * maxBlurSeconds;
+    return latency + fftSize + (int)std::ceil(blurSeconds * decayTo60dB * sampleRate);
+}
+
+//==============================================================================
+void SpectralProcessor::engage()
+{
+    engaged = true;
+    resetFrames();
+
+    // The dry side switches to the delayed input straight away; the wet side
+    // only ramps in once a full set of frames has been overlap-added
+    warmUpSamples = latency;
+    const float mixTarget = mixSmoothed.getTargetValue();
+    mixSmoothed.setCurrentAndTargetValue(0.0f);
+    mixSmoothed.setTargetValue(mixTarget);
+    engageSmoothed.setCurrentAndTargetValue(0.0f);
+    latencySamples.store(latency, std::memory_order_relaxed);
+}
+
+void SpectralProcessor::disengage()
+{
+    engaged = false;
+    latencySamples.store(0, std::memory_order_relaxed);
+    if (framingPending)
+    {
+        applyFraming();
+        framingPending = false;
+    }
+    resetFrames();
+}
+
+void SpectralProcessor::writeInput(float* const* io, int offset, int numSamples) noexcept
+{
+    const int first = juce::jmin(numSamples, ringSize - writePos);
+    for (int c = 0; c < numActiveChannels; ++c)
+    {
+        auto* input = channels[(size_t)c].input;
+        juce::FloatVectorOperations::copy(input + writePos, io[c] + offset, first);
+        if (first < numSamples)
+            juce::FloatVectorOperations::copy(input, io[c] + offset + first, numSamples - first);
+    }
+    writePos = (writePos + numSamples) & ringMask;
+}
+
+void SpectralProcessor::process(float* left, float* right, int numSamples)
+{
+    if (channels[0].input == nullptr)
+        return;
+
+    numActiveChannels = right != nullptr ? 2 : 1;
+    float* const io[2] = { left, right };
+
+    // Bypassed, the input still goes through the ring so the delayed dry is
+    // ready the moment the stage engages
+    const bool wanted = mixSmoothed.getTargetValue() > 0.0f && !framingPending;
+    if (!engaged)
+    {
+        if (!wanted)
+        {
+            writeInput(io, 0, numSamples);
+            return;
+        }
+        engage();
+    }
+    engageSmoothed.setTargetValue(wanted ? 1.0f : 0.0f);
+
+    // Walk the block a hop at a time; within a hop, samples only move through the rings
+    for (int done = 0; done < numSamples;)
+    {
+        const int count = juce::jmin(numSamples - done, hop - hopPosition);
+        for (int i = 0; i < count; ++i)
+        {
+            const int pos = (writePos + i) & ringMask;
+            const int dryPos = (pos - latency) & ringMask;
+            const float fade = engageSmoothed.getNextValue();
+            float mix = 0.0f;
+            if (warmUpSamples > 0)
+                --warmUpSamples;
+            else
+                mix = mixSmoothed.getNextValue();
+
+            // Crossfades between the live input and the delayed dry/wet path
+            for (int c = 0; c < numActiveChannels; ++c)
+            {
+                auto& channel = channels[(size_t)c];
+                float& sample = io[c][done + i];
+                const float live = sample;
+                channel.input[pos] = live;
+                const float wet = channel.output[pos];
+                channel.output[pos] = 0.0f;
+                const float delayed = channel.input[dryPos] + mix * (wet - channel.input[dryPos]);
+                sample = live + fade * (delayed - live);
+            }
+        }
+
+        writePos = (writePos + count) & ringMask;
+        hopPosition += count;
+        done += count;
+
+        // Faded all the way out: back to bypass for the rest of the block
+        if (!wanted && !engageSmoothed.isSmoothing())
+        {
+            disengage();
+            writeInput(io, done, numSamples - done);
+            return;
+        }
+
+        // The frame in flight is due in full by the end of this hop
+        if (frameInFlight)
+            runUnits(amortise ? (numUnits * hopPosition + hop - 1) / hop
+                              : (hopPosition == hop ? numUnits : 0));
+
+        if (hopPosition == hop)
+        {
+            hopPosition = 0;
+            frameEnd = writePos;
+            unitsDone = 0;
+            frameInFlight = true;
+        }
+    }
+}
+
+void SpectralProcessor::runUnits(int target)
+{
+    for (; unitsDone < target; ++unitsDone)
+    {
+        const int c = unitsDone % 2;
+        if (c >= numActiveChannels)
+            continue;
+
+        auto& channel = channels[(size_t)c];
+        switch (unitsDone / 2)
+        {
+            case analyse:       analyseFrame(channel); break;
+            case edit:          editSpectrum(channel); break;
+            case synthesise:    synthesiseFrame(channel); break;
+            default:            break;
+        }
+    }
+}
+
+void SpectralProcessor::analyseFrame(Channel& channel)
+{
+    const auto* window = windows[(size_t)(fftOrder - minFftOrder)];
+    const int start = (frameEnd - fftSize) & ringMask;
+    const int first = juce::jmin(fftSize, ringSize - start);
+
+    juce::FloatVectorOperations::multiply(channel.frame, channel.input + start, window, first);
+    if (first < fftSize)
+        juce::FloatVectorOperations::multiply(channel.frame + first, channel.input, window + first, fftSize - first);
+    juce::FloatVectorOperations::clear(channel.frame + fftSize, fftSize);
+
+    ffts[(size_t)(fftOrder - minFftOrder)]->performRealOnlyForwardTransform(channel.frame, true);
+}
+
+void SpectralProcessor::editSpectrum(Channel& channel)
+{
+    const int bins = fftSize / 2 + 1;
+    const bool capture = freezeRequested && !channel.holding;
+    const bool gate = gateThreshold > 0.0f;
+    const float thresholdSquared = gateThreshold * gateThreshold;
+    auto* s = channel.frame;
+
+    for (int k = 0; k < bins; ++k)
+    {
+        const float re = s[2 * k];
+        const float im = s[2 * k + 1];
+        const float magnitude = std::sqrt(re * re + im * im);
+
+        // Phase advance since the last frame, kept as a unit complex so a
+        // held spectrum can keep turning without any trig
+        if (capture)
+        {
+            const float pr = channel.previous[2 * k], pi = channel.previous[2 * k + 1];
+            const float rr = re * pr + im * pi;
+            const float ri = im * pr - re * pi;
+            const float length = std::sqrt(rr * rr + ri * ri);
+            channel.rotation[2 * k] = length > binFloor ? rr / length : 1.0f;
+            channel.rotation[2 * k + 1] = length > binFloor ? ri / length : 0.0f;
+        }
+        channel.previous[2 * k] = re;
+        channel.previous[2 * k + 1] = im;
+
+        // Gate with a soft knee (-6 dB at the threshold), then blur over time
+        float target = magnitude;
+        if (gate)
+        {
+            const float squared = magnitude * magnitude;
+            target *= squared / (squared + thresholdSquared);
+        }
+        channel.smoothed[k] = target + blurCoefficient * (channel.smoothed[k] - target);
+        target = channel.smoothed[k];
+
+        if (capture)
+        {
+            channel.frozen[k] = target;
+            channel.phasor[2 * k] = magnitude > binFloor ? re / magnitude : 1.0f;
+            channel.phasor[2 * k + 1] = magnitude > binFloor ? im / magnitude : 0.0f;
+        }
+        else if (channel.holding)
+        {
+            const float cr = channel.rotation[2 * k], ci = channel.rotation[2 * k + 1];
+            float pr = channel.phasor[2 * k], pi = channel.phasor[2 * k + 1];
+            const float nextR = pr * cr - pi * ci;
+            const float nextI = pr * ci + pi * cr;
+            // One Newton step back onto the unit circle stops rounding drift
+            const float correction = 1.5f - 0.5f * (nextR * nextR + nextI * nextI);
+            pr = nextR * correction;
+            pi = nextI * correction;
+            channel.phasor[2 * k] = pr;
+            channel.phasor[2 * k + 1] = pi;
+        }
+
+        if (freezeRequested)
+        {
+            s[2 * k] = channel.frozen[k] * channel.phasor[2 * k];
+            s[2 * k + 1] = channel.frozen[k] * channel.phasor[2 * k + 1];
+        }
+        else
+        {
+            const float gain = magnitude > binFloor ? target / magnitude : 0.0f;
+            s[2 * k] = re * gain;
+            s[2 * k + 1] = im * gain;
+        }
+    }
+
+    channel.holding = freezeRequested;
+}
+
+void SpectralProcessor::synthesiseFrame(Channel& channel)
+{
+    const int sizeIndex = fftOrder - minFftOrder;
+    ffts[(size_t)sizeIndex]->performRealOnlyInverseTransform(channel.frame);
+
+    auto* frame = channel.frame;
+    juce::FloatVectorOperations::multiply(frame, windows[(size_t)sizeIndex], fftSize);
+
+    // Lands one hop past the frame's end, after the hop this work was spread over
+    const int start = (frameEnd + hop) & ringMask;
+    const int first = juce::jmin(fftSize, ringSize - start);
+    juce::FloatVectorOperations::addWithMultiply(channel.output + start, frame, overlapGain, first);
+    if (first < fftSize)
+        juce::FloatVectorOperations::addWithMultiply(channel.output, frame + first, overlapGain, fftSize - first);
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include "DspArena.h"
+
+// Overlap-add STFT stage with spectral freeze, magnitude blur over time and a
+// spectral noise gate, on juce::dsp::FFT with sqrt-Hann analysis and
+// synthesis windows.
+//
+// A frame isn't transformed the moment its hop completes. Its work is cut
+// into units (forward FFT, spectral edit and inverse FFT, per channel) that
+// run spread over the following hop, so each block pays for its share of a
+// frame instead of one block paying for all of it. That costs one extra hop:
+// the latency is the FFT size plus one hop, and the dry signal is delayed to
+// match so the mix stays aligned.
+class SpectralProcessor
+{
+public:
+    static constexpr int minFftOrder = 9;       // 512 points
+    static constexpr int maxFftOrder = 12;      // 4096 points
+    static constexpr float gateOffDb = -100.0f; // at or below, the gate is bypassed
+
+    // Builds an FFT plan for every size, so it allocates
+    SpectralProcessor();
+
+    // Buffers are taken from arena, which needs getArenaFootprint() free
+    void prepare(double sampleRate, DspArena& arena);
+    // Clears everything, input history included, and drops back to bypass
+    void reset();
+    static size_t getArenaFootprint() noexcept;
+
+    // Audio thread, once per block. overlap is frames per FFT length (2, 4
+    // or 8). A new size or hop fades the stage out, restarts the frames and
+    // fades it back in.
+    void setParameters(int fftOrder, int overlap, bool freeze, float blur, float gateDb, float mix);
+
+    // Audio thread. right may be null for a mono output. The input is kept
+    // while bypassed; engaging and disengaging crossfade with the live signal.
+    void process(float* left, float* right, int numSamples);
+
+    // Any thread. Zero while the stage is bypassed.
+    int getLatencySamples() const noexcept      { return latencySamples.load(std::memory_order_relaxed); }
+    // How long the output keeps going after the input stops, blur included
+    int getTailLengthSamples() const noexcept;
+
+private:
+    static constexpr int numFftSizes = maxFftOrder - minFftOrder + 1;
+    static constexpr int maxFftSize = 1 << maxFftOrder;
+    static constexpr int maxBins = maxFftSize / 2 + 1;
+    static constexpr int ringSize = 2 * maxFftSize;     // room for a frame plus the hop being written
+    static constexpr int ringMask = ringSize - 1;
+
+    enum Stage { analyse, edit, synthesise, numStages };
+    static constexpr int numUnits = numStages * 2;
+
+    struct Channel
+    {
+        float* input = nullptr;         // ring of recent input, ringSize
+        float* output = nullptr;        // overlap-add ring, ringSize
+        float* frame = nullptr;         // FFT work, 2 * maxFftSize
+        float* previous = nullptr;      // last frame's analysis spectrum, 2 * maxBins
+        float* smoothed = nullptr;      // blurred magnitudes, maxBins
+        float* frozen = nullptr;        // held magnitudes, maxBins
+        float* phasor = nullptr;        // held phase as a unit complex, 2 * maxBins
+        float* rotation = nullptr;      // its advance per frame, 2 * maxBins
+        bool holding = false;
+    };
+
+    void applyFraming();
+    void updateCoefficients();
+    void resetFrames();
+    void engage();
+    void disengage();
+    void writeInput(float* const* io, int offset, int numSamples) noexcept;
+    void runUnits(int target);
+    void analyseFrame(Channel& channel);
+    void editSpectrum(Channel& channel);
+    void synthesiseFrame(Channel& channel);
+
+    std::array<std::unique_ptr<juce::dsp::FFT>, numFftSizes> ffts;
+    std::array<float*, numFftSizes> windows {};     // sqrt-Hann, in the arena
+    std::array<Channel, 2> channels;
+    double sampleRate = 44100.0;
+
+    // As last requested
+    int requestedOrder = 11;
+    int requestedOverlap = 4;
+    bool freezeRequested = false;
+    float blurAmount = 0.0f;
+    float gateDb = gateOffDb;
+    juce::SmoothedValue<float> mixSmoothed;
+    juce::SmoothedValue<float> engageSmoothed;  // live input to the delayed path
+    bool engaged = false;
+    bool framingPending = false;    // waiting for the fade out to reframe
+    int warmUpSamples = 0;          // until the first frames have overlap-added
+    bool amortise = true;       // off only for the benchmark's comparison
+
+    // Frame settings in use
+    int fftOrder = 11;
+    int fftSize = 2048;
+    int hop = 512;
+    int latency = 2560;
+    float overlapGain = 0.5f;
+    float blurCoefficient = 0.0f;
+    float gateThreshold = 0.0f;
+
+    // Frame clock, in ring positions
+    int writePos = 0;
+    int hopPosition = 0;
+    int frameEnd = 0;           // end of the frame being worked through
+    int unitsDone = 0;
+    bool frameInFlight = false;
+    int numActiveChannels = 2;
+
+    std::atomic<int> latencySamples { 0 };
+
+    friend class SpectralProcessorTests;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectralProcessor)
+};
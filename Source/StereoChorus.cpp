@@ -0,0 +1,102 @@
+#include "StereoChorus.h"
+
+namespace
+{
+    constexpr int renormaliseInterval = 4096;
+}
+
+//==============================================================================
+int StereoChorus::getLineLength(double rate) noexcept
+{
+    return (int)std::ceil((maxCentreDelayMs + maxModulationMs) * 0.001 * rate) + 4;
+}
+
+size_t StereoChorus::getArenaFootprint(double rate) noexcept
+{
+    return 2 * DspArena::getFootprint((size_t)getLineLength(rate));
+}
+
+void StereoChorus::prepare(double newSampleRate, DspArena& arena)
+{
+    sampleRate = newSampleRate;
+    lineLength = getLineLength(sampleRate);
+    for (auto*& line : lines)
+        line = arena.allocate((size_t)lineLength);
+    if (lines[0] == nullptr || lines[1] == nullptr)
+        lineLength = 0;
+
+    setRate(rateHz);
+    reset();
+}
+
+void StereoChorus::reset() noexcept
+{
+    if (lineLength > 0)
+        for (auto* line : lines)
+            juce::FloatVectorOperations::clear(line, lineLength);
+    lastOutput[0] = lastOutput[1] = 0.0f;
+    writeIndex = 0;
+    lfoCos = 1.0f;
+    lfoSin = 0.0f;
+    samplesSinceRenormalise = 0;
+}
+
+void StereoChorus::setRate(float hz) noexcept
+{
+    rateHz = juce::jlimit(0.0f, 20.0f, hz);
+    const float step = juce::MathConstants<float>::twoPi * rateHz / (float)sampleRate;
+    stepCos = std::cos(step);
+    stepSin = std::sin(step);
+}
+
+void StereoChorus::setSpread(float newSpread) noexcept
+{
+    const float offset = juce::MathConstants<float>::pi * juce::jlimit(0.0f, 1.0f, newSpread);
+    spreadCos = std::cos(offset);
+    spreadSin = std::sin(offset);
+}
+
+void StereoChorus::processSample(float& left, float& right) noexcept
+{
+    if (lineLength == 0)
+        return;
+
+    const float lfo[2] = { lfoSin, lfoSin * spreadCos - lfoCos * spreadSin };
+    float* io[2] = { &left, &right };
+    const float msToSamples = 0.001f * (float)sampleRate;
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const float delayMs = centreDelayMs + depth * maxModulationMs * 0.5f * lfo[ch];
+        const float delay = juce::jlimit(1.0f, (float)(lineLength - 2), delayMs * msToSamples);
+
+        float readPos = (float)writeIndex - delay;
+        if (readPos < 0.0f)
+            readPos += (float)lineLength;
+        const int i0 = (int)readPos;
+        const int i1 = i0 + 1 < lineLength ? i0 + 1 : 0;
+        const float frac = readPos - (float)i0;
+
+        auto* line = lines[ch];
+        const float wet = line[i0] + frac * (line[i1] - line[i0]);
+        line[writeIndex] = *io[ch] + feedback * lastOutput[ch];
+        lastOutput[ch] = wet;
+        *io[ch] = wet;
+    }
+
+    if (++writeIndex >= lineLength)
+        writeIndex = 0;
+
+    const float c = lfoCos * stepCos - lfoSin * stepSin;
+    lfoSin = lfoSin * stepCos + lfoCos * stepSin;
+    lfoCos = c;
+
+    // Keeps rounding from slowly growing or shrinking the phasor
+    if (++samplesSinceRenormalise >= renormaliseInterval)
+    {
+        const float scale = 1.0f / std::sqrt(lfoCos * lfoCos + lfoSin * lfoSin);
+        lfoCos *= scale;
+        lfoSin *= scale;
+        samplesSinceRenormalise = 0;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DspArena.h"
+
+// Two modulated delay lines with feedback, one per channel. The right
+// channel's LFO runs behind the left by up to half a cycle (spread). The
+// lines come out of the engine's DspArena, so a new sample rate lays them out
+// again instead of allocating. Output is fully wet; the caller mixes.
+class StereoChorus
+{
+public:
+    // The lines are taken from arena, which needs getArenaFootprint(sampleRate) free
+    void prepare(double sampleRate, DspArena& arena);
+    void reset() noexcept;
+    static size_t getArenaFootprint(double sampleRate) noexcept;
+
+    // Any time before processing
+    void setRate(float hz) noexcept;
+    void setDepth(float newDepth) noexcept            { depth = juce::jlimit(0.0f, 1.0f, newDepth); }
+    void setCentreDelay(float milliseconds) noexcept  { centreDelayMs = juce::jlimit(1.0f, maxCentreDelayMs, milliseconds); }
+    void setFeedback(float newFeedback) noexcept      { feedback = juce::jlimit(-0.95f, 0.95f, newFeedback); }
+    void setSpread(float newSpread) noexcept;
+
+    // Audio thread
+    void processSample(float& left, float& right) noexcept;
+
+    static constexpr float maxCentreDelayMs = 100.0f;
+    static constexpr float maxModulationMs = 10.0f;     // at depth 1
+
+private:
+    static int getLineLength(double sampleRate) noexcept;
+
+    double sampleRate = 44100.0;
+    float* lines[2] {};         // owned by the arena
+    int lineLength = 0;
+    int writeIndex = 0;
+
+    float rateHz = 0.35f, depth = 0.45f, centreDelayMs = 7.5f, feedback = 0.0f;
+    float lastOutput[2] {};
+
+    // The LFO is a rotating phasor; the right channel reads it rotated by spread
+    float lfoCos = 1.0f, lfoSin = 0.0f, stepCos = 1.0f, stepSin = 0.0f;
+    float spreadCos = 1.0f, spreadSin = 0.0f;
+    int samplesSinceRenormalise = 0;
+};
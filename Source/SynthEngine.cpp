@@ -0,0 +1,805 @@
+#include "SynthEngine.h"
+#include "TraceEvents.h"
+#include <cmath>
+
+namespace
+{
+    // Output level below which a sample counts as silent (about -100 dBFS)
+    constexpr float silenceThreshold = 1.0e-5f;
+    // Room for every note a block's worth of fast steps can produce
+    constexpr int arpeggiatorMidiReserveBytes = 8192;
+    // Length of the delay line, which the granular cloud also reads from
+    constexpr double maxDelaySeconds = 2.0;
+    // Extra run of silence required on top of the delay time, covering the chorus lines
+    constexpr double idleTailMarginSeconds = 0.05;
+
+    // Filter coefficient update interval per quality tier
+    constexpr int tierFilterUpdateSteps[QualityGovernor::numTiers] = { 16, 32, 64, 128 };
+    constexpr double tierRampSeconds = 0.05;
+
+    // Pitch limits, and the scale from vibrato / chaos depth to octaves. It
+    // matches the old 1 + depth ratio for shallow depths and, unlike the
+    // ratio, swings evenly up and down in pitch at full depth.
+    constexpr float minFrequencyHz = 20.0f;
+    constexpr float maxFrequencyHz = 20000.0f;
+    constexpr float ratioToOctaves = 1.44269504f;
+
+    // Trace stages of the per-sample loop, in the order they run
+    enum TraceStage { oscillatorStage, filterStage, crushStage, chorusStage, delayStage, glitchStage };
+}
+
+//==============================================================================
+SynthEngine::SynthEngine()
+{
+    updateAmplitudeEnvelope();
+
+    // Safe before the audio thread starts; render() takes over from here
+    activeTuning = &tuningBank.beginBlock();
+    targetPitch = std::log2(targetFrequency);
+    pitchSmoothed.setCurrentAndTargetValue(targetPitch);
+    gainSmoothed.setCurrentAndTargetValue(blockParams.outputGain);
+    cutoffSmoothed.setCurrentAndTargetValue(blockParams.cutoffHz);
+    resonanceSmoothed.setCurrentAndTargetValue(blockParams.resonanceQ);
+    stereoWidthSmoothed.setCurrentAndTargetValue(blockParams.stereoWidth);
+    lfoDepthSmoothed.setCurrentAndTargetValue(blockParams.lfoDepth);
+    driveSmoothed.setCurrentAndTargetValue(blockParams.driveAmount);
+    chorusMixSmoothed.setCurrentAndTargetValue(blockParams.chorusMix);
+
+    chorus.setRate(0.35f);
+    chorus.setDepth(0.45f);
+    chorus.setFeedback(0.12f);
+    chorus.setCentreDelay(7.5f);
+    chorus.setSpread(0.7f);
+
+    arpeggiatedMidi.ensureSize(arpeggiatorMidiReserveBytes);
+}
+
+//==============================================================================
+void SynthEngine::prepare(double sampleRate, int samplesPerBlockExpected)
+{
+    // Every stage splits longer blocks itself, so after the first call only the rate matters
+    if (prepared && sampleRate == currentSR)
+        return;
+
+    const bool firstPrepare = !prepared;
+    if (firstPrepare)
+        processingBlockSize = juce::jmax(1, samplesPerBlockExpected);
+
+    currentSR = sampleRate;
+    arena.reserve(getArenaFootprint(juce::jmax(sampleRate, DspArena::reservedSampleRate)));
+    layOutArena(sampleRate);
+
+    // The convolution keeps its buffers and worker; a new rate reloads the file
+    convolutionReverb.prepare(sampleRate, processingBlockSize);
+
+    // Rate-dependent coefficients; notes, phases and envelope stages carry on
+    chorusTierGain.reset(sampleRate, tierRampSeconds);
+    resetSmoothers(sampleRate);
+    updateFilterStatic();
+    amplitudeEnvelope.setSampleRate(sampleRate);
+    updateAmplitudeEnvelope();
+    fmOscillator.setSampleRate(sampleRate);
+    sampleOscillator.setSampleRate(sampleRate);
+    arpeggiator.prepare(sampleRate);
+    silentSampleRun = 0;
+
+    prepared = true;
+    if (firstPrepare)
+        reset();
+}
+
+void SynthEngine::reset()
+{
+    blockParams = params;
+    appliedPitchHz = blockParams.pitchHz;
+    noteStack.clear();
+    currentMidiNote = -1;
+    midiGate = false;
+    lastNoteOnCount = noteOnCount.load();
+    phase = 0.0f;
+    lfoPhase = 0.0f;
+    filterUpdateCount = 0;
+    subPhase = 0.0f;
+    detunePhase = 0.0f;
+    autoPanPhase = 0.0f;
+    crushCounter = 0;
+    crushHoldL = 0.0f;
+    crushHoldR = 0.0f;
+    chaosValue = 0.0f;
+    chaosSamplesRemaining = 0;
+    glitchSamplesRemaining = 0;
+    glitchHeldL = glitchHeldR = 0.0f;
+    engineIdle = false;
+    silentSampleRun = 0;
+    requestedQualityTier = QualityGovernor::Tier::full;
+    applyQualityTier(QualityGovernor::Tier::full);
+    chorusTierGain.setCurrentAndTargetValue(1.0f);
+    // Derived from the frequency alone, so a trace replay seeded with it matches
+    targetPitch = std::log2(targetFrequency);
+    resetSmoothers(currentSR);
+    updateFilterStatic();
+    updateAmplitudeEnvelope();
+    amplitudeEnvelope.reset();
+
+    // Laying the arena out again clears the delay and restarts the room and
+    // grain modulators, without allocating
+    if (prepared)
+        layOutArena(currentSR);
+
+    chorus.reset();
+    convolutionReverb.reset();
+    fmOscillator.reset();
+    unisonOscillator.reset();
+    fmGateOpen = false;
+    sampleOscillator.prepare(currentSR);
+    arpeggiator.reset();
+}
+
+size_t SynthEngine::getArenaFootprint(double sampleRate) const noexcept
+{
+    const auto delayLength = (size_t)juce::jmax(1, (int)std::ceil(sampleRate * maxDelaySeconds));
+    return 2 * DspArena::getFootprint(delayLength)
+         + StereoChorus::getArenaFootprint(sampleRate)
+         + FdnReverb::getArenaFootprint(sampleRate)
+         + GranularProcessor::getArenaFootprint(processingBlockSize)
+         + SpectralProcessor::getArenaFootprint();
+}
+
+void SynthEngine::layOutArena(double sampleRate)
+{
+    arena.rewind();
+
+    maxDelaySamples = juce::jmax(1, (int)std::ceil(sampleRate * maxDelaySeconds));
+    for (auto*& channel : delayChannels)
+        channel = arena.allocate((size_t)maxDelaySamples);
+    delayBuffer.setDataToReferTo(delayChannels, 2, maxDelaySamples);
+    delayWritePosition = 0;
+
+    chorus.prepare(sampleRate, arena);
+    fdnReverb.prepare(sampleRate, arena);
+    granular.prepare(sampleRate, processingBlockSize, arena);
+    spectral.prepare(sampleRate, arena);
+}
+
+void SynthEngine::updateFilterCoeffs(double cutoff, double Q)
+{
+    cutoff = juce::jlimit(20.0, 20000.0, cutoff);
+    Q = juce::jlimit(0.1, 12.0, Q);
+
+    const double w0 = juce::MathConstants<double>::twoPi * cutoff / currentSR;
+    const double cw = std::cos(w0);
+    const double sw = std::sin(w0);
+    const double alpha = sw / (2.0 * Q);
+
+    double b0 = (1.0 - cw) * 0.5;
+    double b1 = 1.0 - cw;
+    double b2 = (1.0 - cw) * 0.5;
+    double a0 = 1.0 + alpha;
+    double a1 = -2.0 * cw;
+    double a2 = 1.0 - alpha;
+
+    juce::IIRCoefficients c(b0 / a0, b1 / a0, b2 / a0,
+        1.0, a1 / a0, a2 / a0);
+
+    filterL.setCoefficients(c);
+    filterR.setCoefficients(c);
+}
+
+void SynthEngine::applyQualityTier(QualityGovernor::Tier tier)
+{
+    activeQualityTier = tier;
+    filterUpdateStep = tierFilterUpdateSteps[(int)tier];
+    fastOscillators = tier >= QualityGovernor::Tier::economy;
+
+    // The chorus is faded rather than cut so tier changes stay click-free
+    const bool chorusWanted = tier < QualityGovernor::Tier::survival;
+    if (chorusWanted && chorusTierGain.getTargetValue() < 1.0f)
+    {
+        if (chorusTierGain.getCurrentValue() <= 0.0f)
+            chorus.reset();
+        chorusTierGain.setTargetValue(1.0f);
+    }
+    else if (!chorusWanted)
+    {
+        chorusTierGain.setTargetValue(0.0f);
+    }
+}
+
+void SynthEngine::updateFilterStatic()
+{
+    appliedCutoffHz = blockParams.cutoffHz;
+    appliedResonanceQ = blockParams.resonanceQ;
+    updateFilterCoeffs(appliedCutoffHz, appliedResonanceQ);
+}
+
+void SynthEngine::resetSmoothers(double sampleRate)
+{
+    const double fastRampSeconds = 0.02;
+    const double filterRampSeconds = 0.06;
+    const double spatialRampSeconds = 0.1;
+
+    pitchSmoothed.reset(sampleRate, fastRampSeconds);
+    gainSmoothed.reset(sampleRate, fastRampSeconds);
+    cutoffSmoothed.reset(sampleRate, filterRampSeconds);
+    resonanceSmoothed.reset(sampleRate, filterRampSeconds);
+    stereoWidthSmoothed.reset(sampleRate, spatialRampSeconds);
+    lfoDepthSmoothed.reset(sampleRate, spatialRampSeconds);
+    driveSmoothed.reset(sampleRate, fastRampSeconds);
+    chorusMixSmoothed.reset(sampleRate, spatialRampSeconds);
+
+    pitchSmoothed.setCurrentAndTargetValue(targetPitch);
+    gainSmoothed.setCurrentAndTargetValue(blockParams.outputGain);
+    cutoffSmoothed.setCurrentAndTargetValue(blockParams.cutoffHz);
+    resonanceSmoothed.setCurrentAndTargetValue(blockParams.resonanceQ);
+    stereoWidthSmoothed.setCurrentAndTargetValue(blockParams.stereoWidth);
+    lfoDepthSmoothed.setCurrentAndTargetValue(blockParams.lfoDepth);
+    driveSmoothed.setCurrentAndTargetValue(blockParams.driveAmount);
+    chorusMixSmoothed.setCurrentAndTargetValue(blockParams.chorusMix);
+
+    filterL.reset();
+    filterR.reset();
+}
+
+void SynthEngine::updateSmootherTargets()
+{
+    // Knob changes land here once per block rather than from the UI thread
+    if (blockParams.pitchHz != appliedPitchHz)
+    {
+        appliedPitchHz = blockParams.pitchHz;
+        setTargetFrequency(appliedPitchHz);
+    }
+
+    gainSmoothed.setTargetValue(blockParams.outputGain);
+    stereoWidthSmoothed.setTargetValue(blockParams.stereoWidth);
+    lfoDepthSmoothed.setTargetValue(blockParams.lfoDepth);
+    driveSmoothed.setTargetValue(blockParams.driveAmount);
+    chorusMixSmoothed.setTargetValue(blockParams.chorusMix);
+
+    if (blockParams.cutoffHz != appliedCutoffHz || blockParams.resonanceQ != appliedResonanceQ)
+    {
+        appliedCutoffHz = blockParams.cutoffHz;
+        appliedResonanceQ = blockParams.resonanceQ;
+        cutoffSmoothed.setTargetValue(appliedCutoffHz);
+        resonanceSmoothed.setTargetValue(appliedResonanceQ);
+        filterUpdateCount = filterUpdateStep;
+    }
+
+    updateAmplitudeEnvelope();
+}
+
+void SynthEngine::setTargetFrequency(float newFrequency, bool force)
+{
+    targetFrequency = juce::jlimit(minFrequencyHz, maxFrequencyHz, newFrequency);
+    targetPitch = std::log2(targetFrequency);
+
+    if (force)
+        pitchSmoothed.setCurrentAndTargetValue(targetPitch);
+    else
+        pitchSmoothed.setTargetValue(targetPitch);
+}
+
+void SynthEngine::setTargetPitch(float log2Frequency, bool force)
+{
+    targetPitch = juce::jlimit(std::log2(minFrequencyHz), std::log2(maxFrequencyHz), log2Frequency);
+    targetFrequency = Tuning::fastExp2(targetPitch);
+
+    if (force)
+        pitchSmoothed.setCurrentAndTargetValue(targetPitch);
+    else
+        pitchSmoothed.setTargetValue(targetPitch);
+}
+
+inline float SynthEngine::renderMorphSample(float ph, float morph) const
+{
+    while (ph >= juce::MathConstants<float>::twoPi) ph -= juce::MathConstants<float>::twoPi;
+    if (ph < 0.0f) ph += juce::MathConstants<float>::twoPi;
+
+    const float m = juce::jlimit(0.0f, 1.0f, morph);
+    const float seg = 1.0f / 3.0f;
+
+    if (fastOscillators)
+    {
+        if (m < seg)
+            return juce::jmap(m / seg, fastSine(ph), fastTri(ph));
+        else if (m < 2.0f * seg)
+            return juce::jmap((m - seg) / seg, fastTri(ph), saw(ph));
+        else
+            return juce::dsp::FastMathApproximations::tanh(juce::jmap((m - 2.0f * seg) / seg, saw(ph), fastSqr(ph)));
+    }
+
+    if (m < seg)
+        return juce::jmap(m / seg, sine(ph), tri(ph));
+    else if (m < 2.0f * seg)
+        return juce::jmap((m - seg) / seg, tri(ph), saw(ph));
+    else
+        return std::tanh(juce::jmap((m - 2.0f * seg) / seg, saw(ph), sqr(ph)));
+}
+
+void SynthEngine::render(float* l, float* r, int numSamples)
+{
+    render(l, r, numSamples, {});
+}
+
+void SynthEngine::render(float* l, float* r, int numSamples, const juce::MidiBuffer& midi)
+{
+    // Knob values are latched once per block so a block depends only on what
+    // was set when it started
+    blockParams = params;
+    activeTuning = &tuningBank.beginBlock();
+
+    arpeggiator.process(midi, arpeggiatedMidi, numSamples, blockParams.arp);
+
+    // Split the block at each event so notes land on their exact sample
+    int position = 0;
+    for (const auto metadata : arpeggiatedMidi)
+    {
+        const int eventPosition = juce::jlimit(0, numSamples, metadata.samplePosition);
+        if (eventPosition > position)
+        {
+            renderSegment(l + position, r != nullptr ? r + position : nullptr, eventPosition - position);
+            position = eventPosition;
+        }
+        handleMidiMessage(metadata.getMessage());
+    }
+
+    if (position < numSamples)
+        renderSegment(l + position, r != nullptr ? r + position : nullptr, numSamples - position);
+}
+
+void SynthEngine::handleMidiMessage(const juce::MidiMessage& m)
+{
+    if (m.isNoteOn())
+        noteOn(m.getNoteNumber(), m.getVelocity() / 127.0f);
+    else if (m.isNoteOff())
+        noteOff(m.getNoteNumber());
+    else if (m.isAllNotesOff() || m.isAllSoundOff())
+        allNotesOff();
+}
+
+void SynthEngine::renderSegment(float* l, float* r, int numSamples)
+{
+    const auto requestedTier = requestedQualityTier.load(std::memory_order_relaxed);
+    if (requestedTier != activeQualityTier)
+        applyQualityTier(requestedTier);
+
+    updateSmootherTargets();
+
+    const float waveMorph = blockParams.waveMorph;
+    const float lfoCutModAmt = blockParams.lfoCutModAmt;
+    const float lfoInc = juce::MathConstants<float>::twoPi * blockParams.lfoRateHz / (float)currentSR;
+    const float autoPanInc = juce::MathConstants<float>::twoPi * autoPanRateHz / (float)currentSR;
+    const float crushAmt = juce::jlimit(0.0f, 1.0f, blockParams.crushAmount);
+    const float subMixAmt = juce::jlimit(0.0f, 1.0f, blockParams.subMixAmount);
+    const float sampleMixAmt = juce::jlimit(0.0f, 1.0f, blockParams.sampleMix);
+    const float envFilterAmt = juce::jlimit(-1.0f, 1.0f, blockParams.envFilterAmount);
+    const float chaosAmt = juce::jlimit(0.0f, 1.0f, blockParams.chaosAmount);
+    const float delayAmtLocal = juce::jlimit(0.0f, 1.0f, blockParams.delayAmount);
+    const float autoPanAmt = juce::jlimit(0.0f, 1.0f, blockParams.autoPanAmount);
+    const float glitchProbLocal = juce::jlimit(0.0f, 1.0f, blockParams.glitchProbability);
+    const float delayMix = juce::jmap(delayAmtLocal, 0.0f, 1.0f, 0.0f, 0.65f);
+    const float delayFeedback = juce::jmap(delayAmtLocal, 0.0f, 1.0f, 0.05f, 0.88f);
+    const int delaySamples = (maxDelaySamples > 1)
+        ? juce::jlimit(1, maxDelaySamples - 1,
+            (int)std::round(juce::jmap((double)delayAmtLocal, 0.0, 1.0,
+                currentSR * 0.03,
+                juce::jmin(currentSR * 1.25, (double)maxDelaySamples - 1.0))))
+        : 1;
+
+    sampleOscillator.beginBlock();
+    activeWavetable = wavetableBank.beginBlock();
+    const bool useFm = blockParams.fmEnabled;
+    unisonOscillator.setParameters(blockParams.unisonVoices, blockParams.unisonDetuneCents, blockParams.unisonStereoSpread, blockParams.unisonPhaseRandom);
+    const bool useUnison = unisonOscillator.getNumVoices() > 1 && activeWavetable == nullptr;
+    fmOscillator.setParameters(blockParams.fmAlgorithm, blockParams.fmFeedback, waveMorph * 2.0f, blockParams.fmOperators);
+
+    const int noteOns = noteOnCount.load();
+    if (noteOns != lastNoteOnCount)
+    {
+        lastNoteOnCount = noteOns;
+        sampleOscillator.trigger(currentMidiNote >= 0 ? currentMidiNote : 60);
+        fmOscillator.noteOn();
+        unisonOscillator.noteOn();
+        fmGateOpen = true;
+    }
+    if (fmGateOpen && !midiGate)
+    {
+        fmOscillator.noteOff();
+        fmGateOpen = false;
+    }
+
+    int idleTailSamples = delaySamples + (int)std::ceil(currentSR * idleTailMarginSeconds);
+    if (blockParams.reverbMix > 0.0f && convolutionReverb.hasImpulseResponse())
+        idleTailSamples += convolutionReverb.getTailLengthSamples();
+    if (blockParams.grainMix > 0.0f)
+        idleTailSamples = juce::jmax(idleTailSamples, maxDelaySamples);
+    if (blockParams.spectralMix > 0.0f)
+        idleTailSamples += spectral.getTailLengthSamples();
+    if (blockParams.roomMix > 0.0f)
+        idleTailSamples += fdnReverb.getTailLengthSamples();
+
+    // A frozen stage rings forever; set after the sum so it can't overflow
+    if ((blockParams.spectralMix > 0.0f && blockParams.spectralFreeze)
+        || (blockParams.roomMix > 0.0f && blockParams.roomFreeze))
+        idleTailSamples = std::numeric_limits<int>::max();
+    if (shouldEnterIdle(idleTailSamples))
+    {
+        if (!engineIdle)
+            enterIdleState();
+
+        advanceIdleState(numSamples);
+        return;
+    }
+    engineIdle = false;
+
+    fdnReverb.setParameters(blockParams.roomSize, blockParams.roomDecay, blockParams.roomDamping, blockParams.roomMix, blockParams.roomFreeze);
+
+    // The stages share one loop, so each is timed per sample and reported as a block total
+    TRACE_STAGES(stageTimer, "oscillators", "filter", "crush", "chorus", "delay + room", "glitch");
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (!audioEnabled && amplitudeEnvelope.isActive())
+            amplitudeEnvelope.noteOff();
+
+        const float basePitch = pitchSmoothed.getNextValue();
+        const float gain = gainSmoothed.getNextValue() * currentVelocity;
+        const float depth = lfoDepthSmoothed.getNextValue();
+        const float width = stereoWidthSmoothed.getNextValue();
+        const float baseCutoff = cutoffSmoothed.getNextValue();
+        const float baseResonance = resonanceSmoothed.getNextValue();
+        const float ampEnv = amplitudeEnvelope.getNextSample();
+        const float drive = driveSmoothed.getNextValue();
+
+        float lfoS = std::sin(lfoPhase);
+        const float vibrato = depth * lfoS * ratioToOctaves;
+        lfoPhase += lfoInc;
+        if (lfoPhase >= juce::MathConstants<float>::twoPi) lfoPhase -= juce::MathConstants<float>::twoPi;
+
+        float chaosOctaves = 0.0f;
+        if (chaosAmt > 0.0f)
+        {
+            if (chaosSamplesRemaining <= 0)
+            {
+                const int span = juce::jmax(1, (int)std::round(juce::jmap(chaosAmt, 0.0f, 1.0f,
+                    (float)currentSR * 0.18f,
+                    (float)currentSR * 0.01f)));
+                chaosSamplesRemaining = span;
+                chaosValue = random.nextFloat() * 2.0f - 1.0f;
+            }
+            chaosOctaves = chaosValue * chaosAmt * 0.12f * ratioToOctaves;
+            --chaosSamplesRemaining;
+        }
+        else
+        {
+            chaosValue = 0.0f;
+            chaosSamplesRemaining = 0;
+        }
+
+        // Glide, vibrato and chaos all add in octaves; one exp2 gets back to Hz
+        const float effectiveFrequency = Tuning::fastExp2(basePitch + vibrato + chaosOctaves);
+        const float phaseInc = juce::MathConstants<float>::twoPi * effectiveFrequency / (float)currentSR;
+        phase += phaseInc;
+
+        float subPhaseInc = phaseInc * 0.5f;
+        float detunePhaseInc = phaseInc * 1.01f;
+        subPhase += subPhaseInc;
+        detunePhase += detunePhaseInc;
+        if (subPhase >= juce::MathConstants<float>::twoPi) subPhase -= juce::MathConstants<float>::twoPi;
+        if (detunePhase >= juce::MathConstants<float>::twoPi) detunePhase -= juce::MathConstants<float>::twoPi;
+
+        float combined, combinedR;
+        if (useFm)
+        {
+            combined = fmOscillator.renderSample(phaseInc);
+            combinedR = combined;
+        }
+        else if (useUnison)
+        {
+            // The stack stands in for the primary and detuned copies
+            float stackL, stackR;
+            unisonOscillator.render(phaseInc, waveMorph, stackL, stackR);
+            const float subSample = subMixAmt > 0.0f ? renderMorphSample(subPhase, waveMorph) : 0.0f;
+            combined = stackL + 0.5f * subMixAmt * subSample;
+            combinedR = stackR + 0.5f * subMixAmt * subSample;
+        }
+        else
+        {
+            float primary, subSample, detuneSample;
+            if (activeWavetable != nullptr)
+            {
+                primary = activeWavetable->render(phase, waveMorph, phaseInc);
+                subSample = activeWavetable->render(subPhase, waveMorph, subPhaseInc);
+                detuneSample = activeWavetable->render(detunePhase, waveMorph, detunePhaseInc);
+            }
+            else
+            {
+                primary = renderMorphSample(phase, waveMorph);
+                subSample = renderMorphSample(subPhase, waveMorph);
+                detuneSample = renderMorphSample(detunePhase, waveMorph);
+            }
+            combined = juce::jmap(subMixAmt, primary, 0.5f * (primary + subSample + detuneSample));
+            combinedR = combined;
+        }
+        if (sampleMixAmt > 0.0f)
+        {
+            const float sampleValue = sampleOscillator.renderSample(effectiveFrequency, midiGate);
+            combined = juce::jmap(sampleMixAmt, combined, sampleValue);
+            combinedR = juce::jmap(sampleMixAmt, combinedR, sampleValue);
+        }
+        float s = combined * gain;
+        float sR = combinedR * gain;
+        TRACE_STAGE_LAP(stageTimer, oscillatorStage);
+
+        if (drive > 0.0f)
+        {
+            float shaped = std::tanh(s * (1.0f + drive * 10.0f));
+            s = juce::jmap(drive, 0.0f, 1.0f, s, shaped);
+            shaped = std::tanh(sR * (1.0f + drive * 10.0f));
+            sR = juce::jmap(drive, 0.0f, 1.0f, sR, shaped);
+        }
+
+        if (++filterUpdateCount >= filterUpdateStep)
+        {
+            filterUpdateCount = 0;
+            const double modFactor = std::pow(2.0, (double)lfoCutModAmt * (double)lfoS);
+            const double envFactor = juce::jlimit(0.1, 4.0, 1.0 + (double)envFilterAmt * (double)ampEnv);
+            const double effCut = juce::jlimit(80.0, 14000.0, (double)baseCutoff * modFactor * envFactor);
+            updateFilterCoeffs(effCut, (double)baseResonance);
+        }
+
+        float fL = filterL.processSingleSampleRaw(s);
+        float fR = (r ? filterR.processSingleSampleRaw(sR) : fL);
+        TRACE_STAGE_LAP(stageTimer, filterStage);
+
+        if (crushAmt > 0.0f)
+        {
+            if (crushCounter <= 0)
+            {
+                const int downsampleFactor = juce::jmax(1, (int)std::round(juce::jmap(crushAmt, 0.0f, 1.0f, 1.0f, 32.0f)));
+                crushCounter = downsampleFactor;
+                crushHoldL = fL;
+                crushHoldR = fR;
+            }
+
+            float levels = juce::jmap(crushAmt, 0.0f, 1.0f, 2048.0f, 6.0f);
+            float crushedL = std::round(crushHoldL * levels) / levels;
+            float crushedR = std::round(crushHoldR * levels) / levels;
+            fL = juce::jmap(crushAmt, 0.0f, 1.0f, fL, crushedL);
+            fR = juce::jmap(crushAmt, 0.0f, 1.0f, fR, crushedR);
+            --crushCounter;
+        }
+        else
+        {
+            crushCounter = 0;
+        }
+        TRACE_STAGE_LAP(stageTimer, crushStage);
+
+        fL *= ampEnv;
+        fR *= ampEnv;
+
+        float panMod = autoPanAmt * std::sin(autoPanPhase);
+        autoPanPhase += autoPanInc;
+        if (autoPanPhase >= juce::MathConstants<float>::twoPi) autoPanPhase -= juce::MathConstants<float>::twoPi;
+
+        float dynamicWidth = width * juce::jlimit(0.0f, 3.0f, 1.0f + panMod);
+        float mid = 0.5f * (fL + fR);
+        float side = 0.5f * (fL - fR) * dynamicWidth;
+
+        float dryL = mid + side;
+        float dryR = r ? (mid - side) : dryL;
+
+        const float chorusTier = chorusTierGain.getNextValue();
+        float chorusMixValue = chorusMixSmoothed.getNextValue() * chorusTier;
+        if (chorusTier > 0.0f)
+        {
+            float chorusWetL = dryL, chorusWetR = dryR;
+            chorus.processSample(chorusWetL, chorusWetR);
+            if (!r)
+                chorusWetR = chorusWetL;
+            if (chorusMixValue > 0.0001f)
+            {
+                dryL = juce::jmap(chorusMixValue, dryL, chorusWetL);
+                dryR = juce::jmap(chorusMixValue, dryR, chorusWetR);
+            }
+        }
+        TRACE_STAGE_LAP(stageTimer, chorusStage);
+
+        float wetL = 0.0f;
+        float wetR = 0.0f;
+        if (delayAmtLocal > 0.0f && maxDelaySamples > 1)
+        {
+            const int readPos = (delayWritePosition - delaySamples + maxDelaySamples) % maxDelaySamples;
+            wetL = delayBuffer.getSample(0, readPos);
+            wetR = delayBuffer.getNumChannels() > 1 ? delayBuffer.getSample(1, readPos) : wetL;
+
+            delayBuffer.setSample(0, delayWritePosition, dryL + wetL * delayFeedback);
+            delayBuffer.setSample(1, delayWritePosition, dryR + wetR * delayFeedback);
+            delayWritePosition = (delayWritePosition + 1) % maxDelaySamples;
+
+            dryL = dryL * (1.0f - delayMix) + wetL * delayMix;
+            dryR = dryR * (1.0f - delayMix) + wetR * delayMix;
+        }
+        else if (maxDelaySamples > 1)
+        {
+            delayBuffer.setSample(0, delayWritePosition, dryL);
+            delayBuffer.setSample(1, delayWritePosition, dryR);
+            delayWritePosition = (delayWritePosition + 1) % maxDelaySamples;
+        }
+
+        fdnReverb.processSample(dryL, dryR);
+        if (!r)
+            dryR = dryL;
+        TRACE_STAGE_LAP(stageTimer, delayStage);
+
+        if (glitchProbLocal > 0.0f)
+        {
+            if (glitchSamplesRemaining > 0)
+            {
+                --glitchSamplesRemaining;
+                dryL = glitchHeldL;
+                dryR = glitchHeldR;
+            }
+            else if (random.nextFloat() < glitchProbLocal * 0.004f)
+            {
+                glitchSamplesRemaining = juce::jmax(4, (int)std::round(juce::jmap(glitchProbLocal, 0.0f, 1.0f,
+                    12.0f,
+                    (float)currentSR * 0.08f)));
+                glitchHeldL = dryL;
+                glitchHeldR = dryR;
+            }
+        }
+        else
+        {
+            glitchSamplesRemaining = 0;
+        }
+
+        l[i] = dryL;
+        if (r) r[i] = dryR;
+        TRACE_STAGE_LAP(stageTimer, glitchStage);
+    }
+
+    // ===== Block-based FX =====
+    {
+        TRACE_ZONE("granular");
+        granular.setParameters(blockParams.grainSizeMs, blockParams.grainDensity, blockParams.grainPitch, blockParams.grainSpray, blockParams.grainReverse, blockParams.grainMix);
+        granular.process(delayBuffer, delayWritePosition, l, r, numSamples);
+    }
+    {
+        TRACE_ZONE("spectral");
+        spectral.setParameters(blockParams.spectralFftOrder, blockParams.spectralOverlap, blockParams.spectralFreeze,
+                               blockParams.spectralBlur, blockParams.spectralGateDb, blockParams.spectralMix);
+        spectral.process(l, r, numSamples);
+    }
+    {
+        TRACE_ZONE("convolution");
+        convolutionReverb.setMix(blockParams.reverbMix);
+        convolutionReverb.process(l, r, numSamples);
+    }
+
+    const bool envelopeActive = amplitudeEnvelope.isActive();
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const bool sampleSilent = std::abs(l[i]) < silenceThreshold && (r == nullptr || std::abs(r[i]) < silenceThreshold);
+        silentSampleRun = (sampleSilent && !envelopeActive) ? silentSampleRun + 1 : 0;
+    }
+}
+
+bool SynthEngine::shouldEnterIdle(int tailSamples) const
+{
+    if (amplitudeEnvelope.isActive())
+        return false;
+
+    return engineIdle || silentSampleRun >= tailSamples;
+}
+
+void SynthEngine::enterIdleState()
+{
+    // Everything downstream of the envelope has already decayed below the
+    // silence threshold, so zeroing it here is inaudible and lets the next
+    // note start from a clean state instead of stale tails.
+    engineIdle = true;
+    filterL.reset();
+    filterR.reset();
+    chorus.reset();
+    delayBuffer.clear();
+    fdnReverb.reset();
+    granular.reset();
+    spectral.reset();
+    fmOscillator.reset();
+    fmGateOpen = false;
+    crushCounter = 0;
+    crushHoldL = crushHoldR = 0.0f;
+    glitchSamplesRemaining = 0;
+    glitchHeldL = glitchHeldR = 0.0f;
+}
+
+void SynthEngine::advanceIdleState(int numSamples)
+{
+    // Keep parameter ramps and modulators moving so a resumed note picks up
+    // exactly where a continuously running engine would be.
+    pitchSmoothed.skip(numSamples);
+    gainSmoothed.skip(numSamples);
+    cutoffSmoothed.skip(numSamples);
+    resonanceSmoothed.skip(numSamples);
+    stereoWidthSmoothed.skip(numSamples);
+    lfoDepthSmoothed.skip(numSamples);
+    driveSmoothed.skip(numSamples);
+    chorusMixSmoothed.skip(numSamples);
+    chorusTierGain.skip(numSamples);
+
+    const float twoPi = juce::MathConstants<float>::twoPi;
+    lfoPhase = std::fmod(lfoPhase + twoPi * blockParams.lfoRateHz * (float)numSamples / (float)currentSR, twoPi);
+    autoPanPhase = std::fmod(autoPanPhase + twoPi * autoPanRateHz * (float)numSamples / (float)currentSR, twoPi);
+}
+
+void SynthEngine::updateAmplitudeEnvelope()
+{
+    juce::ADSR::Parameters next;
+    next.attack = juce::jlimit(0.0005f, 20.0f, blockParams.attackMs * 0.001f);
+    next.decay = juce::jlimit(0.0005f, 20.0f, blockParams.decayMs * 0.001f);
+    next.sustain = juce::jlimit(0.0f, 1.0f, blockParams.sustainLevel);
+    next.release = juce::jlimit(0.0005f, 20.0f, blockParams.releaseMs * 0.001f);
+
+    if (next.attack == ampEnvParams.attack && next.decay == ampEnvParams.decay
+        && next.sustain == ampEnvParams.sustain && next.release == ampEnvParams.release)
+        return;
+
+    ampEnvParams = next;
+    amplitudeEnvelope.setParameters(ampEnvParams);
+}
+
+//==============================================================================
+void SynthEngine::noteOn(int midiNote, float velocity)
+{
+    noteStack.addIfNotAlreadyThere(midiNote);
+    currentMidiNote = midiNote;
+    currentVelocity = juce::jlimit(0.0f, 1.0f, velocity);
+    setTargetPitch(activeTuning->getLog2Frequency(currentMidiNote));
+    midiGate = true;
+    amplitudeEnvelope.noteOn();
+    ++noteOnCount;
+}
+
+void SynthEngine::noteOff(int midiNote)
+{
+    noteStack.removeFirstMatchingValue(midiNote);
+    if (noteStack.isEmpty())
+    {
+        midiGate = false;
+        currentMidiNote = -1;
+        amplitudeEnvelope.noteOff();
+    }
+    else
+    {
+        currentMidiNote = noteStack.getLast();
+        setTargetPitch(activeTuning->getLog2Frequency(currentMidiNote));
+        midiGate = true;
+        amplitudeEnvelope.noteOn();
+    }
+}
+
+void SynthEngine::allNotesOff()
+{
+    noteStack.clear();
+    midiGate = false;
+    currentMidiNote = -1;
+    amplitudeEnvelope.noteOff();
+}
+
+void SynthEngine::setRandomSeed(juce::int64 seed)
+{
+    random.setSeed(seed);
+    granular.setRandomSeed(seed + 1);
+    unisonOscillator.setRandomSeed(seed + 2);
+    arpeggiator.setRandomSeed(seed + 3);
+}
+
+void SynthEngine::setAudioEnabled(bool enabled)
+{
+    audioEnabled = enabled;
+    if (!audioEnabled)
+    {
+        midiGate = false;
+        amplitudeEnvelope.noteOff();
+    }
+}
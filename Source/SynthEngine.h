@@ -0,0 +1,286 @@
+#pragma once
+#include <JuceHeader.h>
+#include "QualityGovernor.h"
+#include "ConvolutionReverb.h"
+#include "FdnReverb.h"
+#include "StereoChorus.h"
+#include "SampleOscillator.h"
+#include "Wavetable.h"
+#include "GranularProcessor.h"
+#include "FmOscillator.h"
+#include "UnisonOscillator.h"
+#include "DspArena.h"
+#include "Arpeggiator.h"
+#include "Tuning.h"
+#include "SpectralProcessor.h"
+
+// Every user-facing setting of the synth. The UI writes these as plain values
+// and the audio thread latches a copy at the start of each block. Kept
+// trivially copyable so traces can store it as raw words.
+struct SynthParameters
+{
+    float   waveMorph = 0.0f;
+    float   pitchHz = 220.0f;   // manual pitch; notes override it until the knob moves
+    float   outputGain = 0.5f;
+
+    // Envelope
+    float   attackMs = 8.0f;
+    float   decayMs = 90.0f;
+    float   sustainLevel = 0.75f;
+    float   releaseMs = 280.0f;
+
+    // Filter
+    float   cutoffHz = 1000.0f;
+    float   resonanceQ = 0.707f;
+    float   lfoCutModAmt = 0.0f;
+    float   envFilterAmount = 0.0f;
+
+    // LFO (vibrato)
+    float   lfoRateHz = 5.0f;
+    float   lfoDepth = 0.03f;
+
+    float   stereoWidth = 1.0f;
+    float   driveAmount = 0.0f;
+    float   crushAmount = 0.0f;
+    float   subMixAmount = 0.0f;
+    float   chaosAmount = 0.0f;
+    float   delayAmount = 0.0f;
+    float   autoPanAmount = 0.0f;
+    float   chorusMix = 0.35f;
+    float   glitchProbability = 0.0f;
+    float   reverbMix = 0.0f;
+    float   sampleMix = 0.0f;
+
+    // Algorithmic room (FDN) reverb
+    float   roomMix = 0.0f;
+    float   roomSize = 0.6f;
+    float   roomDecay = 0.55f;
+    float   roomDamping = 0.35f;
+    bool    roomFreeze = false;
+
+    // Granular cloud over the delay history
+    float   grainMix = 0.0f;
+    float   grainSizeMs = 80.0f;
+    float   grainDensity = 40.0f;
+    float   grainPitch = 0.0f;
+    float   grainSpray = 0.3f;
+    float   grainReverse = 0.2f;
+
+    // STFT stage: freeze, blur over time and a spectral gate
+    float   spectralMix = 0.0f;
+    int     spectralFftOrder = 11;      // 2^order points, 9..12
+    int     spectralOverlap = 4;        // frames per FFT length: 2, 4 or 8
+    bool    spectralFreeze = false;
+    float   spectralBlur = 0.0f;
+    float   spectralGateDb = SpectralProcessor::gateOffDb;
+
+    // FM engine as the oscillator source; waveMorph sets modulation depth
+    bool    fmEnabled = false;
+    int     fmAlgorithm = 0;
+    float   fmFeedback = 0.2f;
+    FmOscillator::Operators fmOperators {{
+        { 1.0f,  1.0f, 2.0f, 1200.0f, 0.6f, 400.0f },
+        { 1.0f,  0.7f, 1.0f, 900.0f,  0.3f, 300.0f },
+        { 2.0f,  0.5f, 1.0f, 600.0f,  0.2f, 300.0f },
+        { 1.0f,  1.0f, 2.0f, 1500.0f, 0.5f, 400.0f },
+        { 3.5f,  0.5f, 1.0f, 400.0f,  0.1f, 250.0f },
+        { 14.0f, 0.3f, 0.5f, 150.0f,  0.0f, 150.0f }
+    }};
+
+    // Unison stack; a single voice keeps the scalar primary + detune path
+    int     unisonVoices = 1;
+    float   unisonDetuneCents = 18.0f;
+    float   unisonStereoSpread = 0.8f;
+    float   unisonPhaseRandom = 1.0f;
+
+    // Arpeggiator / step sequencer over the held notes; off plays them directly
+    Arpeggiator::Settings arp;
+};
+
+static_assert(std::is_trivially_copyable_v<SynthParameters>, "SynthParameters is copied as raw words");
+
+//==============================================================================
+// The monophonic synth voice and its effect chain, independent of any audio
+// device or UI. MainComponent drives one from the device callback; headless
+// tools can run as many as they like side by side.
+class SynthEngine
+{
+public:
+    SynthEngine();
+
+    // Not the audio thread. The first call reserves every delay line and
+    // scratch buffer in one arena, sized for DspArena::reservedSampleRate, and
+    // starts from reset(). Later calls keep held notes, phases and envelopes:
+    // a new block size changes nothing, and a new rate only recomputes
+    // rate-dependent coefficients and clears the tails, which can't be
+    // carried across rates.
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    // Not the audio thread. Back to the state of a freshly prepared engine: no
+    // notes, silent tails, every phase and ramp at its start.
+    void reset();
+
+    // Audio thread. right may be null for a mono output. MIDI events, and the
+    // notes the arpeggiator makes of them, are applied at their sample positions.
+    void render(float* left, float* right, int numSamples);
+    void render(float* left, float* right, int numSamples, const juce::MidiBuffer& midi);
+
+    // Note input (last-note priority), applied immediately
+    void noteOn(int midiNote, float velocity);
+    void noteOff(int midiNote);
+    void allNotesOff();
+
+    void setTargetFrequency(float newFrequency, bool force = false);
+    float getTargetFrequency() const noexcept           { return targetFrequency; }
+    // In the active tuning; render() picks up a newly loaded one at the next block
+    float getNoteFrequency(int midiNote) const noexcept { return activeTuning->getFrequency(midiNote); }
+    void setAudioEnabled(bool enabled);
+    bool isAudioEnabled() const noexcept                { return audioEnabled; }
+
+    // Seeds every random source in the engine, for reproducible renders
+    void setRandomSeed(juce::int64 seed);
+    void setQualityTier(QualityGovernor::Tier tier)     { requestedQualityTier = tier; }
+
+    bool isIdle() const noexcept                        { return engineIdle; }
+    double getSampleRate() const noexcept               { return currentSR; }
+    // Any thread: processing delay in samples at getSampleRate(), from the spectral stage
+    int getLatencySamples() const noexcept              { return spectral.getLatencySamples(); }
+
+    ConvolutionReverb& getConvolutionReverb() noexcept  { return convolutionReverb; }
+    SampleOscillator& getSampleOscillator() noexcept    { return sampleOscillator; }
+    WavetableBank& getWavetableBank() noexcept          { return wavetableBank; }
+    TuningBank& getTuningBank() noexcept                { return tuningBank; }
+
+    SynthParameters params;
+
+    // The copy of params the current (or last) block was rendered with
+    const SynthParameters& getBlockParameters() const noexcept { return blockParams; }
+
+    static inline float midiNoteToFreq(int midiNote)
+    {
+        // 12-TET, A4 = 440 Hz, MIDI 69. Notes played follow the tuning bank instead.
+        return 440.0f * std::pow(2.0f, (midiNote - 69) / 12.0f);
+    }
+
+private:
+    SynthParameters blockParams;
+    float   appliedPitchHz = 220.0f;
+
+    // ===== Synth state =====
+    float   phase = 0.0f;
+    float   targetFrequency = 220.0f;
+    float   targetPitch = 0.0f;             // log2(targetFrequency)
+    float   lfoPhase = 0.0f;
+
+    // Smoothed parameters for a more polished response
+    juce::SmoothedValue<float> pitchSmoothed;      // log2 Hz, so glides are even in pitch
+    juce::SmoothedValue<float> gainSmoothed;
+    juce::SmoothedValue<float> cutoffSmoothed;
+    juce::SmoothedValue<float> resonanceSmoothed;
+    juce::SmoothedValue<float> stereoWidthSmoothed;
+    juce::SmoothedValue<float> lfoDepthSmoothed;
+    juce::SmoothedValue<float> driveSmoothed;
+    juce::SmoothedValue<float> chorusMixSmoothed;
+
+    juce::IIRFilter filterL, filterR;
+    float   appliedCutoffHz = 0.0f;
+    float   appliedResonanceQ = 0.0f;
+
+    float   chaosValue = 0.0f;
+    int     chaosSamplesRemaining = 0;
+    juce::Random random;
+
+    juce::ADSR amplitudeEnvelope;
+    juce::ADSR::Parameters ampEnvParams;
+
+    int filterUpdateStep = 16;
+    int filterUpdateCount = 0;
+    double currentSR = 44100.0;
+
+    float subPhase = 0.0f;
+    float detunePhase = 0.0f;
+    float autoPanPhase = 0.0f;
+    float autoPanRateHz = 0.35f;
+    int crushCounter = 0;
+    float crushHoldL = 0.0f;
+    float crushHoldR = 0.0f;
+    DspArena arena;
+    int processingBlockSize = 0;
+    bool prepared = false;
+    float* delayChannels[2] {};
+    juce::AudioBuffer<float> delayBuffer{ 2, 1 };   // in the arena once prepared
+    StereoChorus chorus;                            // in the arena once prepared
+    int delayWritePosition = 0;
+    int maxDelaySamples = 1;
+    int glitchSamplesRemaining = 0;
+    float glitchHeldL = 0.0f;
+    float glitchHeldR = 0.0f;
+
+    // Idle mode: once the envelope has closed and every tail has rung out,
+    // the per-sample loop is skipped until the next note
+    bool engineIdle = false;
+    int silentSampleRun = 0;
+
+    // CPU-adaptive quality tiers
+    std::atomic<QualityGovernor::Tier> requestedQualityTier { QualityGovernor::Tier::full };
+    QualityGovernor::Tier activeQualityTier = QualityGovernor::Tier::full;
+    bool fastOscillators = false;
+    juce::SmoothedValue<float> chorusTierGain;
+
+    ConvolutionReverb convolutionReverb;
+    FdnReverb fdnReverb;
+    GranularProcessor granular;
+    SpectralProcessor spectral;
+    FmOscillator fmOscillator;
+    UnisonOscillator unisonOscillator;
+    SampleOscillator sampleOscillator;
+    WavetableBank wavetableBank;
+    const WavetableSet* activeWavetable = nullptr;
+    TuningBank tuningBank;
+    const TuningTable* activeTuning = nullptr;
+    std::atomic<int> noteOnCount { 0 };
+    int lastNoteOnCount = 0;
+    bool fmGateOpen = false;
+
+    Arpeggiator arpeggiator;
+    juce::MidiBuffer arpeggiatedMidi;
+
+    // ===== MIDI state (monophonic, last-note priority) =====
+    juce::Array<int> noteStack;   // holds pressed MIDI notes
+    int currentMidiNote = -1;
+    float currentVelocity = 1.0f;
+    bool midiGate = false;        // gate controlled by MIDI
+    bool audioEnabled = true;
+
+    void renderSegment(float* left, float* right, int numSamples);
+    void handleMidiMessage(const juce::MidiMessage& message);
+    size_t getArenaFootprint(double sampleRate) const noexcept;
+    void layOutArena(double sampleRate);
+    void resetSmoothers(double sampleRate);
+    void updateSmootherTargets();
+    void setTargetPitch(float log2Frequency, bool force = false);
+    void updateAmplitudeEnvelope();
+    void updateFilterCoeffs(double cutoff, double Q);
+    void updateFilterStatic();
+    bool shouldEnterIdle(int tailSamples) const;
+    void enterIdleState();
+    void advanceIdleState(int numSamples);
+    void applyQualityTier(QualityGovernor::Tier tier);
+    inline float renderMorphSample(float ph, float morph) const;
+
+    inline float sine(float ph) const { return std::sin(ph); }
+    inline float tri(float ph)  const { return (2.0f / juce::MathConstants<float>::pi) * std::asin(std::sin(ph)); }
+    inline float saw(float ph)  const { return 2.0f * (ph / juce::MathConstants<float>::twoPi) - 1.0f; }
+    inline float sqr(float ph)  const { return std::tanh(3.0f * std::sin(ph)); }
+
+    // Cheaper shapes used by the lower quality tiers
+    inline float fastSine(float ph) const { return -juce::dsp::FastMathApproximations::sin(ph - juce::MathConstants<float>::pi); }
+    inline float fastTri(float ph)  const
+    {
+        const float t = ph / juce::MathConstants<float>::twoPi;
+        return t < 0.25f ? 4.0f * t : (t < 0.75f ? 2.0f - 4.0f * t : 4.0f * t - 4.0f);
+    }
+    inline float fastSqr(float ph)  const { return juce::dsp::FastMathApproximations::tanh(3.0f * fastSine(ph)); }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthEngine)
+};
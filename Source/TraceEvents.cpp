@@ -0,0 +1,208 @@
+#include "TraceEvents.h"
+
+#if SPECTRAL_TRACE_ZONES
+
+namespace
+{
+    constexpr int maxThreads = 16;
+    constexpr int ringSize = 1 << 13;
+    constexpr int flushIntervalMs = 100;
+    constexpr int overheadBenchmarkZones = 4096;
+    constexpr int overheadBenchmarkSamples = 4096;
+    constexpr int overheadBenchmarkStages = 6;     // as many as SynthEngine::render laps per sample
+
+    struct Event
+    {
+        const char* name;
+        juce::int64 start;
+        juce::int64 end;
+    };
+
+    struct ThreadRing
+    {
+        std::atomic<bool> claimed { false };
+        std::atomic<const char*> name { nullptr };
+        std::atomic<juce::uint32> writeIndex { 0 };
+        std::atomic<juce::uint32> readIndex { 0 };
+        std::atomic<juce::uint32> dropped { 0 };
+        Event events[ringSize];
+    };
+
+    ThreadRing rings[maxThreads];
+    std::atomic<bool> sessionRunning { false };
+    thread_local ThreadRing* currentRing = nullptr;
+    thread_local bool noRingLeft = false;
+
+    ThreadRing* getRing() noexcept
+    {
+        if (currentRing != nullptr || noRingLeft)
+            return currentRing;
+
+        for (auto& ring : rings)
+        {
+            bool expected = false;
+            if (ring.claimed.compare_exchange_strong(expected, true))
+                return currentRing = &ring;
+        }
+
+        noRingLeft = true;
+        return nullptr;
+    }
+
+    template <typename Callback>
+    void drainRing(ThreadRing& ring, Callback&& callback)
+    {
+        const auto write = ring.writeIndex.load(std::memory_order_acquire);
+        auto read = ring.readIndex.load(std::memory_order_relaxed);
+        for (; read != write; ++read)
+            callback(ring.events[read % ringSize]);
+        ring.readIndex.store(read, std::memory_order_release);
+    }
+}
+
+void TraceEvents::record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+{
+    if (!sessionRunning.load(std::memory_order_relaxed))
+        return;
+
+    auto* ring = getRing();
+    if (ring == nullptr)
+        return;
+
+    const auto write = ring->writeIndex.load(std::memory_order_relaxed);
+    if (write - ring->readIndex.load(std::memory_order_acquire) >= (juce::uint32)ringSize)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->events[write % ringSize] = { name, startTicks, endTicks };
+    ring->writeIndex.store(write + 1, std::memory_order_release);
+}
+
+void TraceEvents::nameCurrentThread(const char* name) noexcept
+{
+    if (auto* ring = getRing())
+        ring->name.store(name, std::memory_order_relaxed);
+}
+
+//==============================================================================
+TraceEvents::Session::Session(const juce::File& file)
+    : juce::Thread("Trace flusher")
+{
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+    stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen())
+    {
+        stream.reset();
+        return;
+    }
+
+    *stream << "{\"traceEvents\":[\n";
+    originTicks = now();
+
+    // What one zone costs on this machine, recorded into the trace itself
+    for (auto& ring : rings)
+        drainRing(ring, [](const Event&) {});
+
+    sessionRunning.store(true);
+    const auto benchmarkStart = now();
+    for (int i = 0; i < overheadBenchmarkZones; ++i)
+        const ScopedZone zone("overhead benchmark");
+    zoneOverheadNs = juce::Time::highResolutionTicksToSeconds(now() - benchmarkStart) * 1.0e9 / overheadBenchmarkZones;
+
+    // And what the engine's stage timer adds per sample: one lap per stage
+    const auto stagesStart = now();
+    {
+        TRACE_STAGES(stageTimer, "overhead 1", "overhead 2", "overhead 3", "overhead 4", "overhead 5", "overhead 6");
+        for (int i = 0; i < overheadBenchmarkSamples; ++i)
+            for (int stage = 0; stage < overheadBenchmarkStages; ++stage)
+                TRACE_STAGE_LAP(stageTimer, stage);
+    }
+    sampleOverheadNs = juce::Time::highResolutionTicksToSeconds(now() - stagesStart) * 1.0e9 / overheadBenchmarkSamples;
+
+    for (auto& ring : rings)
+        drainRing(ring, [](const Event&) {});
+
+    *stream << "{\"name\":\"zone_overhead\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"ns_per_zone\":"
+            << juce::String(zoneOverheadNs, 1) << ",\"ns_per_sample\":" << juce::String(sampleOverheadNs, 1) << "}}";
+    firstEvent = false;
+
+    juce::Logger::writeToLog("Trace zones: " + file.getFullPathName() + ", "
+                             + juce::String(zoneOverheadNs, 1) + " ns per zone, "
+                             + juce::String(sampleOverheadNs, 1) + " ns per sample with six stage laps");
+
+    startThread(juce::Thread::Priority::low);
+}
+
+TraceEvents::Session::~Session()
+{
+    if (stream == nullptr)
+        return;
+
+    stopThread(2000);
+    sessionRunning.store(false);
+    drain();
+
+    for (int t = 0; t < maxThreads; ++t)
+    {
+        if (!rings[t].claimed.load())
+            continue;
+
+        const auto* name = rings[t].name.load();
+        const auto dropped = rings[t].dropped.exchange(0);
+        *stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << (t + 1)
+                << ",\"args\":{\"name\":\"" << (name != nullptr ? name : "thread") << "\",\"dropped\":" << (int)dropped << "}}";
+    }
+
+    *stream << "\n]}\n";
+    stream->flush();
+}
+
+void TraceEvents::Session::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(flushIntervalMs);
+        drain();
+    }
+}
+
+void TraceEvents::Session::drain()
+{
+    const double ticksToMicros = 1.0e6 / (double)juce::Time::getHighResolutionTicksPerSecond();
+
+    for (int t = 0; t < maxThreads; ++t)
+    {
+        drainRing(rings[t], [&](const Event& e)
+        {
+            *stream << (firstEvent ? "" : ",\n")
+                    << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (t + 1)
+                    << ",\"ts\":" << juce::String((double)(e.start - originTicks) * ticksToMicros, 3)
+                    << ",\"dur\":" << juce::String((double)(e.end - e.start) * ticksToMicros, 3) << "}";
+            firstEvent = false;
+        });
+    }
+}
+
+//==============================================================================
+TraceEvents::StageTimer::StageTimer(std::initializer_list<const char*> stageNames) noexcept
+    : start(now()), last(start)
+{
+    for (auto* n : stageNames)
+        if (numStages < maxStages)
+            names[numStages++] = n;
+}
+
+TraceEvents::StageTimer::~StageTimer()
+{
+    auto t = start;
+    for (int s = 0; s < numStages; ++s)
+    {
+        record(names[s], t, t + totals[s]);
+        t += totals[s];
+    }
+}
+
+#endif
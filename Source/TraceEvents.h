@@ -0,0 +1,98 @@
+#pragma once
+#include <JuceHeader.h>
+#include <initializer_list>
+
+#ifndef SPECTRAL_TRACE_ZONES
+ #define SPECTRAL_TRACE_ZONES 0
+#endif
+
+// Scoped profiling zones exported as Chrome trace-event JSON, which Perfetto
+// and chrome://tracing open directly. Build with SPECTRAL_TRACE_ZONES=1 to
+// enable them; otherwise every macro at the bottom expands to nothing.
+//
+// Each thread writes finished zones into its own single-producer ring, claimed
+// from a fixed pool so a thread never allocates on its first zone. A Session
+// drains the rings to its file from a background thread.
+namespace TraceEvents
+{
+    inline juce::int64 now() noexcept   { return juce::Time::getHighResolutionTicks(); }
+
+    // Any thread; never blocks or allocates. Dropped when no session is running.
+    void record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+    void nameCurrentThread(const char* name) noexcept;
+
+    // Writes every zone recorded while it exists to a JSON file
+    class Session : private juce::Thread
+    {
+    public:
+        explicit Session(const juce::File& file);
+        ~Session() override;
+
+        // Measured on the creating thread when the session starts
+        double getZoneOverheadNanoseconds() const noexcept   { return zoneOverheadNs; }
+        double getSampleOverheadNanoseconds() const noexcept { return sampleOverheadNs; }   // six stage laps
+
+    private:
+        void run() override;
+        void drain();
+
+        std::unique_ptr<juce::FileOutputStream> stream;
+        juce::int64 originTicks = 0;
+        double zoneOverheadNs = 0.0;
+        double sampleOverheadNs = 0.0;
+        bool firstEvent = true;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Session)
+    };
+
+    struct ScopedZone
+    {
+        explicit ScopedZone(const char* zoneName) noexcept : name(zoneName), start(now()) {}
+        ~ScopedZone()                                      { record(name, start, now()); }
+
+        const char* name;
+        const juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedZone)
+    };
+
+    // Splits a fused per-sample loop into stages. lap() charges the time since
+    // the previous lap to a stage; on destruction the totals are written as
+    // back-to-back zones starting where the timer was created.
+    class StageTimer
+    {
+    public:
+        static constexpr int maxStages = 8;
+
+        StageTimer(std::initializer_list<const char*> stageNames) noexcept;
+        ~StageTimer();
+
+        void lap(int stage) noexcept
+        {
+            const auto t = now();
+            totals[stage] += t - last;
+            last = t;
+        }
+
+    private:
+        const char* names[maxStages] {};
+        juce::int64 totals[maxStages] {};
+        int numStages = 0;
+        const juce::int64 start;
+        juce::int64 last;
+
+        JUCE_DECLARE_NON_COPYABLE(StageTimer)
+    };
+}
+
+#if SPECTRAL_TRACE_ZONES
+ #define TRACE_ZONE(name)                const TraceEvents::ScopedZone JUCE_JOIN_MACRO(traceZone, __LINE__) (name)
+ #define TRACE_THREAD_NAME(name)         TraceEvents::nameCurrentThread(name)
+ #define TRACE_STAGES(timer, ...)        TraceEvents::StageTimer timer { __VA_ARGS__ }
+ #define TRACE_STAGE_LAP(timer, stage)   timer.lap(stage)
+#else
+ #define TRACE_ZONE(name)
+ #define TRACE_THREAD_NAME(name)
+ #define TRACE_STAGES(timer, ...)
+ #define TRACE_STAGE_LAP(timer, stage)
+#endif
@@ -0,0 +1,301 @@
+#include "Tuning.h"
+
+namespace
+{
+    constexpr int maxScaleSize = 1024;
+    constexpr double defaultReferenceHz = 440.0;
+    constexpr int defaultMiddleNote = 60;
+    constexpr int defaultReferenceNote = 69;
+
+    const char* const equalTemperamentScl =
+        "12-TET\n12\n100.0\n200.0\n300.0\n400.0\n500.0\n600.0\n700.0\n800.0\n900.0\n1000.0\n1100.0\n2/1\n";
+
+    // Non-comment lines; Scala comments start with '!'
+    juce::StringArray getDataLines(const juce::String& text, bool skipBlank)
+    {
+        juce::StringArray lines;
+        for (auto& line : juce::StringArray::fromLines(text))
+            if (!line.trimStart().startsWithChar('!') && !(skipBlank && line.trim().isEmpty()))
+                lines.add(line.trim());
+        return lines;
+    }
+
+    juce::String firstToken(const juce::String& line)
+    {
+        return line.upToFirstOccurrenceOf(" ", false, false).upToFirstOccurrenceOf("\t", false, false);
+    }
+
+    // A pitch line is cents if it has a '.', otherwise a ratio or a whole number
+    bool parsePitch(const juce::String& line, double& cents)
+    {
+        const auto token = firstToken(line);
+        if (token.containsChar('.'))
+        {
+            cents = token.getDoubleValue();
+            return token.containsAnyOf("0123456789");
+        }
+
+        const double numerator = token.upToFirstOccurrenceOf("/", false, false).getDoubleValue();
+        const double denominator = token.containsChar('/') ? token.fromFirstOccurrenceOf("/", false, false).getDoubleValue() : 1.0;
+        if (numerator <= 0.0 || denominator <= 0.0)
+            return false;
+
+        cents = 1200.0 * std::log2(numerator / denominator);
+        return true;
+    }
+
+    int floorDivide(int a, int b) noexcept
+    {
+        const int q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+}
+
+//==============================================================================
+std::unique_ptr<TuningTable> TuningTable::createEqualTemperament()
+{
+    auto table = std::make_unique<TuningTable>();
+    std::array<double, 128> hz {};
+    for (int note = 0; note < 128; ++note)
+        hz[(size_t)note] = defaultReferenceHz * std::exp2((note - defaultReferenceNote) / 12.0);
+    table->setFrequencies(hz);
+    table->name = "12-TET";
+    return table;
+}
+
+std::unique_ptr<TuningTable> TuningTable::createFromScala(const juce::String& scl, const juce::String& kbm,
+                                                          const juce::String& name, juce::String& error)
+{
+    // Scale: description, note count, then one pitch per degree ending with the period
+    const auto scaleLines = getDataLines(scl, false);
+    int numDegrees = scaleLines.size() > 1 ? firstToken(scaleLines[1]).getIntValue() : 0;
+    if (numDegrees < 1 || numDegrees > maxScaleSize)
+    {
+        error = "the scale has no valid note count";
+        return nullptr;
+    }
+
+    std::vector<double> degreeCents((size_t)numDegrees + 1, 0.0);
+    int parsed = 0;
+    for (int i = 2; i < scaleLines.size() && parsed < numDegrees; ++i)
+    {
+        if (scaleLines[i].isEmpty())
+            continue;
+        if (!parsePitch(scaleLines[i], degreeCents[(size_t)parsed + 1]))
+        {
+            error = "can't read pitch \"" + scaleLines[i] + "\"";
+            return nullptr;
+        }
+        ++parsed;
+    }
+    if (parsed < numDegrees)
+    {
+        error = "the scale lists " + juce::String(parsed) + " of " + juce::String(numDegrees) + " pitches";
+        return nullptr;
+    }
+    const double periodCents = degreeCents[(size_t)numDegrees];
+
+    // Mapping: size, first and last note, middle note, reference note and
+    // frequency, formal octave degree, then one degree (or 'x') per key
+    int mapSize = 0, firstNote = 0, lastNote = 127, middleNote = defaultMiddleNote, referenceNote = defaultReferenceNote;
+    double referenceHz = defaultReferenceHz;
+    int octaveDegree = numDegrees;
+    std::vector<int> keyDegrees;
+
+    if (kbm.isNotEmpty())
+    {
+        const auto mapLines = getDataLines(kbm, true);
+        if (mapLines.size() < 7)
+        {
+            error = "the keyboard mapping is missing its header values";
+            return nullptr;
+        }
+
+        mapSize = juce::jlimit(0, 128, firstToken(mapLines[0]).getIntValue());
+        firstNote = juce::jlimit(0, 127, firstToken(mapLines[1]).getIntValue());
+        lastNote = juce::jlimit(0, 127, firstToken(mapLines[2]).getIntValue());
+        middleNote = juce::jlimit(0, 127, firstToken(mapLines[3]).getIntValue());
+        referenceNote = juce::jlimit(0, 127, firstToken(mapLines[4]).getIntValue());
+        referenceHz = firstToken(mapLines[5]).getDoubleValue();
+        octaveDegree = firstToken(mapLines[6]).getIntValue();
+        if (octaveDegree <= 0)
+            octaveDegree = numDegrees;
+        if (referenceHz <= 0.0)
+        {
+            error = "the keyboard mapping has no reference frequency";
+            return nullptr;
+        }
+
+        // Keys past the listed entries are unmapped
+        for (int i = 0; i < mapSize; ++i)
+        {
+            const int line = 7 + i;
+            const auto token = line < mapLines.size() ? firstToken(mapLines[line]) : juce::String("x");
+            keyDegrees.push_back(token.equalsIgnoreCase("x") ? -1 : token.getIntValue());
+        }
+    }
+
+    const auto getDegree = [&](int note, int& degree)
+    {
+        if (note < firstNote || note > lastNote)
+            return false;
+        if (mapSize == 0)
+        {
+            degree = note - middleNote;
+            return true;
+        }
+
+        const int offset = note - middleNote;
+        const int octave = floorDivide(offset, mapSize);
+        const int key = keyDegrees[(size_t)(offset - octave * mapSize)];
+        if (key < 0)
+            return false;
+        degree = key + octave * octaveDegree;
+        return true;
+    };
+
+    const auto getCents = [&](int degree)
+    {
+        const int period = floorDivide(degree, numDegrees);
+        return period * periodCents + degreeCents[(size_t)(degree - period * numDegrees)];
+    };
+
+    int referenceDegree = 0;
+    if (!getDegree(referenceNote, referenceDegree))
+    {
+        error = "the reference note isn't mapped";
+        return nullptr;
+    }
+    const double referenceCents = getCents(referenceDegree);
+
+    // Unmapped keys repeat the nearest mapped key below them (above, at the bottom)
+    std::array<double, 128> hz {};
+    std::array<bool, 128> mapped {};
+    for (int note = 0; note < 128; ++note)
+    {
+        int degree = 0;
+        mapped[(size_t)note] = getDegree(note, degree);
+        if (mapped[(size_t)note])
+            hz[(size_t)note] = referenceHz * std::exp2((getCents(degree) - referenceCents) / 1200.0);
+    }
+    int firstMapped = 0;
+    while (!mapped[(size_t)firstMapped])
+        ++firstMapped;   // the reference note is mapped, so this stops
+    for (int note = 0; note < 128; ++note)
+        if (!mapped[(size_t)note])
+            hz[(size_t)note] = note < firstMapped ? hz[(size_t)firstMapped] : hz[(size_t)note - 1];
+
+    auto table = std::make_unique<TuningTable>();
+    table->setFrequencies(hz);
+    table->name = name;
+    return table;
+}
+
+std::unique_ptr<TuningTable> TuningTable::createFromScalaFiles(const juce::File& scl, const juce::File& kbm, juce::String& error)
+{
+    if (scl != juce::File() && !scl.existsAsFile())
+    {
+        error = scl.getFileName() + " not found";
+        return nullptr;
+    }
+    if (kbm != juce::File() && !kbm.existsAsFile())
+    {
+        error = kbm.getFileName() + " not found";
+        return nullptr;
+    }
+
+    auto name = scl != juce::File() ? scl.getFileNameWithoutExtension() : juce::String("12-TET");
+    if (kbm != juce::File())
+        name << " / " << kbm.getFileNameWithoutExtension();
+
+    return createFromScala(scl != juce::File() ? scl.loadFileAsString() : juce::String(equalTemperamentScl),
+                           kbm != juce::File() ? kbm.loadFileAsString() : juce::String(), name, error);
+}
+
+void TuningTable::setFrequencies(const std::array<double, 128>& hz)
+{
+    for (size_t note = 0; note < hz.size(); ++note)
+    {
+        frequencies[note] = (float)hz[note];
+        log2Frequencies[note] = (float)std::log2(hz[note]);
+    }
+}
+
+//==============================================================================
+TuningBank::TuningBank()
+    : equalTemperament(TuningTable::createEqualTemperament())
+{
+}
+
+TuningBank::~TuningBank()
+{
+    loaderPool.removeAllJobs(true, 5000);
+}
+
+void TuningBank::loadScale(const juce::File& scl)
+{
+    {
+        const juce::ScopedLock sl(fileLock);
+        scaleFile = scl;
+    }
+    rebuild();
+}
+
+void TuningBank::loadKeyboardMapping(const juce::File& kbm)
+{
+    {
+        const juce::ScopedLock sl(fileLock);
+        mappingFile = kbm;
+    }
+    rebuild();
+}
+
+void TuningBank::useEqualTemperament()
+{
+    {
+        const juce::ScopedLock sl(fileLock);
+        scaleFile = mappingFile = juce::File();
+        name = {};
+    }
+    tables.publish(TuningTable::createEqualTemperament());
+}
+
+juce::String TuningBank::getName() const
+{
+    const juce::ScopedLock sl(fileLock);
+    return name.isNotEmpty() ? name : juce::String("12-TET");
+}
+
+bool TuningBank::hasKeyboardMapping() const
+{
+    const juce::ScopedLock sl(fileLock);
+    return mappingFile != juce::File();
+}
+
+void TuningBank::rebuild()
+{
+    juce::File scl, kbm;
+    {
+        const juce::ScopedLock sl(fileLock);
+        scl = scaleFile;
+        kbm = mappingFile;
+    }
+
+    loaderPool.addJob([this, scl, kbm]
+    {
+        juce::String error;
+        if (auto table = TuningTable::createFromScalaFiles(scl, kbm, error))
+        {
+            juce::Logger::writeToLog("Tuning: " + table->getName() + ", A4 = " + juce::String(table->getFrequency(69), 3) + " Hz");
+            {
+                const juce::ScopedLock sl(fileLock);
+                name = table->getName();
+            }
+            tables.publish(std::move(table));
+        }
+        else
+        {
+            juce::Logger::writeToLog("Tuning: " + error);
+        }
+    });
+}
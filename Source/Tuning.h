@@ -0,0 +1,91 @@
+#pragma once
+#include <JuceHeader.h>
+#include "RealtimeSwap.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace Tuning
+{
+    // 2^x to within 0.01 cent over the audible range, without a libm call:
+    // 2^round(x) goes straight into the exponent bits and a degree-5
+    // polynomial covers the remaining half octave either side
+    inline float fastExp2(float x) noexcept
+    {
+        x = juce::jlimit(-126.0f, 126.0f, x);
+        // Offset so truncation rounds to nearest without a rounding-mode call
+        const int whole = (int)(x + 126.5f) - 126;
+        const float f = x - (float)whole;
+        const float p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f + f * (0.00961812911f + f * 0.00133335581f))));
+
+        const auto bits = (juce::uint32)(whole + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+}
+
+//==============================================================================
+// Frequencies for all 128 MIDI notes, immutable once built. Each note is
+// stored as log2(Hz) as well, since the engine glides and modulates pitch
+// in octaves rather than in Hz.
+class TuningTable
+{
+public:
+    // 12-TET, A4 (note 69) = 440 Hz
+    static std::unique_ptr<TuningTable> createEqualTemperament();
+
+    // Background thread. An empty kbm maps the scale linearly from note 60,
+    // with note 69 at 440 Hz. Returns null and sets error if either can't be used.
+    static std::unique_ptr<TuningTable> createFromScala(const juce::String& scl, const juce::String& kbm,
+                                                        const juce::String& name, juce::String& error);
+    static std::unique_ptr<TuningTable> createFromScalaFiles(const juce::File& scl, const juce::File& kbm, juce::String& error);
+
+    float getFrequency(int note) const noexcept         { return frequencies[(size_t)juce::jlimit(0, 127, note)]; }
+    float getLog2Frequency(int note) const noexcept     { return log2Frequencies[(size_t)juce::jlimit(0, 127, note)]; }
+    const juce::String& getName() const noexcept        { return name; }
+
+private:
+    void setFrequencies(const std::array<double, 128>& hz);
+
+    std::array<float, 128> frequencies {};
+    std::array<float, 128> log2Frequencies {};
+    juce::String name;
+};
+
+//==============================================================================
+// Owns the active tuning and parses replacements on a background thread.
+class TuningBank
+{
+public:
+    TuningBank();
+    ~TuningBank();
+
+    // Message thread. A keyboard mapping applies to the current scale; an
+    // empty file clears it.
+    void loadScale(const juce::File& scl);
+    void loadKeyboardMapping(const juce::File& kbm);
+    void useEqualTemperament();
+    void collectGarbage()                              { tables.collectGarbage(); }
+    juce::String getName() const;
+    bool hasKeyboardMapping() const;
+
+    // Audio thread: the table to use for this block
+    const TuningTable& beginBlock() noexcept
+    {
+        auto* table = tables.acquire();
+        return table != nullptr ? *table : *equalTemperament;
+    }
+
+private:
+    void rebuild();
+
+    RealtimeSwap<TuningTable> tables;
+    const std::unique_ptr<TuningTable> equalTemperament;
+    juce::ThreadPool loaderPool { 1 };
+    mutable juce::CriticalSection fileLock;
+    juce::File scaleFile, mappingFile;
+    juce::String name;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TuningBank)
+};
@@ -0,0 +1,89 @@
+#include "UnisonOscillator.h"
+
+void UnisonOscillator::setParameters(int newNumVoices, float detuneCents, float stereoSpread, float phaseRandomness)
+{
+    newNumVoices = juce::jlimit(1, maxVoices, newNumVoices);
+    detuneCents = juce::jlimit(0.0f, 100.0f, detuneCents);
+    stereoSpread = juce::jlimit(0.0f, 1.0f, stereoSpread);
+    randomness = juce::jlimit(0.0f, 1.0f, phaseRandomness);
+
+    if (newNumVoices == numVoices && detuneCents == detune && stereoSpread == spread)
+        return;
+
+    numVoices = newNumVoices;
+    numRegisters = (numVoices + (int)Lanes::SIZE - 1) / (int)Lanes::SIZE;
+    detune = detuneCents;
+    spread = stereoSpread;
+
+    // Copies sit evenly across +/-detune and alternate sides of the panorama,
+    // equal-power panned with the centre at unity. Unused lanes keep zero
+    // gain so whole registers can always be summed.
+    const float level = 1.0f / std::sqrt((float)numVoices);
+    for (int v = 0; v < maxVoices; ++v)
+    {
+        const float offset = numVoices > 1 ? 2.0f * (float)v / (float)(numVoices - 1) - 1.0f : 0.0f;
+        ratios[(size_t)v] = v < numVoices ? std::pow(2.0f, offset * detune / 1200.0f) : 1.0f;
+
+        const float pan = 0.5f + 0.5f * spread * ((v % 2 == 0) ? offset : -offset);
+        const float angle = pan * juce::MathConstants<float>::halfPi;
+        const float gain = v < numVoices ? level * juce::MathConstants<float>::sqrt2 : 0.0f;
+        gainsL[(size_t)v] = std::cos(angle) * gain;
+        gainsR[(size_t)v] = std::sin(angle) * gain;
+    }
+}
+
+void UnisonOscillator::reset() noexcept
+{
+    phases.fill(0.0f);
+}
+
+void UnisonOscillator::noteOn() noexcept
+{
+    for (auto& p : phases)
+        p = randomness * random.nextFloat();
+}
+
+void UnisonOscillator::render(float phaseInc, float morph, float& left, float& right) noexcept
+{
+    // Same four-way morph as the scalar oscillator: sine, triangle, saw, square
+    const float m = juce::jlimit(0.0f, 1.0f, morph) * 3.0f;
+    float wSine = 0.0f, wTri = 0.0f, wSaw = 0.0f, wSqr = 0.0f;
+    if (m < 1.0f)      { wSine = 1.0f - m;        wTri = m; }
+    else if (m < 2.0f) { wTri = 2.0f - m;         wSaw = m - 1.0f; }
+    else               { wSaw = 3.0f - m;         wSqr = m - 2.0f; }
+
+    const float inc = phaseInc / juce::MathConstants<float>::twoPi;
+    const Lanes zero(0.0f), one(1.0f), quarter(0.25f);
+    Lanes sumL(0.0f), sumR(0.0f);
+
+    for (int reg = 0; reg < numRegisters; ++reg)
+    {
+        const size_t k = (size_t)reg * Lanes::SIZE;
+
+        auto t = Lanes::fromRawArray(phases.data() + k) + Lanes::fromRawArray(ratios.data() + k) * inc;
+        t = t - (one & Lanes::greaterThanOrEqual(t, one));
+        t.copyToRawArray(phases.data() + k);
+
+        const auto saw = t + t - one;
+
+        // Refined parabola: sin(2 pi t) = -sin(pi u) for u = 2t - 1
+        auto para = saw * (one - Lanes::max(saw, zero - saw)) * 4.0f;
+        para = (para * Lanes::max(para, zero - para) - para) * 0.225f + para;
+        const auto sine = zero - para;
+
+        auto v = t + quarter;
+        v = v - (one & Lanes::greaterThanOrEqual(v, one));
+        const auto w = v + v - one;
+        const auto tri = one - Lanes::max(w, zero - w) * 2.0f;
+
+        const auto clipped = Lanes::max(zero - one, Lanes::min(one, sine * 2.0f));
+        const auto sqr = clipped * (Lanes(1.5f) - clipped * clipped * 0.5f);
+
+        const auto shape = sine * wSine + tri * wTri + saw * wSaw + sqr * wSqr;
+        sumL = sumL + shape * Lanes::fromRawArray(gainsL.data() + k);
+        sumR = sumR + shape * Lanes::fromRawArray(gainsR.data() + k);
+    }
+
+    left = sumL.sum();
+    right = sumR.sum();
+}
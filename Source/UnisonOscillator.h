@@ -0,0 +1,44 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+// Stack of up to 16 detuned copies of the morph shapes, spread across the
+// stereo field. Every copy advances and renders in SIMD lanes, using
+// polynomial shapes that need no per-lane transcendental calls. The cost grows
+// with the number of registers in use, not the number of copies.
+class UnisonOscillator
+{
+public:
+    static constexpr int maxVoices = 16;
+
+    // Audio thread, once per block
+    void setParameters(int numVoices, float detuneCents, float stereoSpread, float phaseRandomness);
+
+    void reset() noexcept;
+    void noteOn() noexcept;
+
+    int getNumVoices() const noexcept    { return numVoices; }
+    void setRandomSeed(juce::int64 seed) { random.setSeed(seed); }
+
+    // phaseInc is the centre voice's increment in radians per sample
+    void render(float phaseInc, float morph, float& left, float& right) noexcept;
+
+private:
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static_assert(maxVoices % Lanes::SIZE == 0, "voices must fill whole registers");
+
+    int numVoices = 1;
+    int numRegisters = 1;
+    float detune = -1.0f;
+    float spread = -1.0f;
+    float randomness = 1.0f;
+
+    alignas(32) std::array<float, maxVoices> phases {};
+    alignas(32) std::array<float, maxVoices> ratios {};
+    alignas(32) std::array<float, maxVoices> gainsL {};
+    alignas(32) std::array<float, maxVoices> gainsR {};
+
+    juce::Random random;
+
+    friend class UnisonOscillatorTests;
+};
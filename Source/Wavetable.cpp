@@ -0,0 +1,178 @@
+#include "Wavetable.h"
+#include <complex>
+
+namespace
+{
+    constexpr int maxSingleCycleLength = 4096;
+
+    std::atomic<int> liveSets { 0 };
+}
+
+//==============================================================================
+WavetableSet::WavetableSet()
+{
+    liveSets.fetch_add(1, std::memory_order_relaxed);
+}
+
+WavetableSet::~WavetableSet()
+{
+    liveSets.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int WavetableSet::getNumLiveSets() noexcept
+{
+    return liveSets.load(std::memory_order_relaxed);
+}
+
+std::unique_ptr<WavetableSet> WavetableSet::createFromFile(const juce::File& file)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples < 2)
+        return nullptr;
+
+    const int length = (int)juce::jmin(reader->lengthInSamples, (juce::int64)(tableSize * maxFrames));
+    juce::AudioBuffer<float> source(1, length);
+    reader->read(&source, 0, length, 0, true, false);
+
+    // Whole multiples of 2048 are frame sequences; anything short is one cycle
+    int frameLength = tableSize;
+    int frames = length / tableSize;
+    if (length % tableSize != 0 && length <= maxSingleCycleLength)
+    {
+        frameLength = length;
+        frames = 1;
+    }
+
+    if (frames <= 0)
+        return nullptr;
+
+    auto set = std::make_unique<WavetableSet>();
+    set->numFrames = frames;
+    set->tables.resize((size_t)(frames * numMipLevels * (tableSize + 1)));
+
+    juce::dsp::FFT fft(tableOrder);
+    std::vector<float> spectrum((size_t)tableSize * 2);
+    std::vector<float> work((size_t)tableSize * 2);
+    const auto* src = source.getReadPointer(0);
+    float peak = 0.0f;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        // Linear resample of the frame onto the table length
+        const float* frameStart = src + frame * frameLength;
+        std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+        for (int i = 0; i < tableSize; ++i)
+        {
+            const float pos = (float)i * (float)frameLength / (float)tableSize;
+            const int i0 = (int)pos;
+            const int i1 = (i0 + 1) % frameLength;
+            const float frac = pos - (float)i0;
+            spectrum[(size_t)i] = frameStart[i0] + frac * (frameStart[i1] - frameStart[i0]);
+        }
+
+        fft.performRealOnlyForwardTransform(spectrum.data(), true);
+        auto* bins = reinterpret_cast<std::complex<float>*>(spectrum.data());
+        bins[0] = {}; // no DC
+
+        for (int mip = 0; mip < numMipLevels; ++mip)
+        {
+            const int maxHarmonic = (tableSize / 2) >> mip;
+
+            std::copy(spectrum.begin(), spectrum.end(), work.begin());
+            auto* mipBins = reinterpret_cast<std::complex<float>*>(work.data());
+            std::fill(mipBins + maxHarmonic + 1, mipBins + tableSize, std::complex<float>());
+            if (mip == 0)
+                mipBins[tableSize / 2] = {};
+
+            fft.performRealOnlyInverseTransform(work.data());
+
+            auto* table = set->tables.data() + (size_t)((frame * numMipLevels + mip) * (tableSize + 1));
+            std::copy(work.begin(), work.begin() + tableSize, table);
+            table[tableSize] = table[0];
+
+            if (mip == 0)
+                for (int i = 0; i < tableSize; ++i)
+                    peak = juce::jmax(peak, std::abs(table[i]));
+        }
+    }
+
+    if (peak > 0.0f)
+        juce::FloatVectorOperations::multiply(set->tables.data(), 1.0f / peak, (int)set->tables.size());
+
+    return set;
+}
+
+float WavetableSet::render(float phase, float position, float phaseInc) const noexcept
+{
+    const float twoPi = juce::MathConstants<float>::twoPi;
+    phase -= twoPi * std::floor(phase / twoPi);
+
+    // Highest level whose harmonics all stay below Nyquist
+    const float allowedHarmonics = juce::MathConstants<float>::pi / juce::jmax(1.0e-6f, std::abs(phaseInc));
+    int mip = 0;
+    while (mip < numMipLevels - 1 && (float)((tableSize / 2) >> mip) > allowedHarmonics)
+        ++mip;
+
+    const float index = phase / twoPi * (float)tableSize;
+    const int i0 = juce::jlimit(0, tableSize - 1, (int)index);
+    const float frac = index - (float)i0;
+
+    const float framePos = juce::jlimit(0.0f, 1.0f, position) * (float)(numFrames - 1);
+    const int f0 = (int)framePos;
+    const int f1 = juce::jmin(f0 + 1, numFrames - 1);
+    const float frameFrac = framePos - (float)f0;
+
+    const float* a = getTable(f0, mip);
+    const float* b = getTable(f1, mip);
+    const float sampleA = a[i0] + frac * (a[i0 + 1] - a[i0]);
+    const float sampleB = b[i0] + frac * (b[i0 + 1] - b[i0]);
+    return sampleA + frameFrac * (sampleB - sampleA);
+}
+
+//==============================================================================
+WavetableBank::~WavetableBank()
+{
+    loaderPool.removeAllJobs(true, 5000);
+}
+
+void WavetableBank::loadFromFile(const juce::File& file)
+{
+    loaderPool.addJob([this, file]
+    {
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        if (auto set = WavetableSet::createFromFile(file))
+        {
+            juce::Logger::writeToLog("Wavetable " + file.getFileName() + ": "
+                + juce::String(set->getNumFrames()) + " frames built in "
+                + juce::String(juce::Time::getMillisecondCounterHiRes() - startTime, 1) + " ms");
+
+            {
+                const juce::ScopedLock sl(nameLock);
+                name = file.getFileNameWithoutExtension();
+            }
+
+            tables.publish(std::move(set));
+        }
+    });
+}
+
+void WavetableBank::useBuiltInShapes()
+{
+    {
+        const juce::ScopedLock sl(nameLock);
+        name = {};
+    }
+
+    // An empty set tells the audio thread to fall back to the morph shapes
+    tables.publish(std::make_unique<WavetableSet>());
+}
+
+juce::String WavetableBank::getName() const
+{
+    const juce::ScopedLock sl(nameLock);
+    return name;
+}
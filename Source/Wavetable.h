@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include "RealtimeSwap.h"
+#include <vector>
+
+// A set of single-cycle frames, each stored as a chain of band-limited mip
+// levels (level n keeps 1024 >> n harmonics). Immutable once built.
+class WavetableSet
+{
+public:
+    static constexpr int tableOrder = 11;
+    static constexpr int tableSize = 1 << tableOrder;
+    static constexpr int numMipLevels = tableOrder;
+    static constexpr int maxFrames = 256;
+
+    WavetableSet();
+    ~WavetableSet();
+
+    // Background thread: reads a single-cycle or multi-frame (2048 per frame) file
+    static std::unique_ptr<WavetableSet> createFromFile(const juce::File& file);
+
+    int getNumFrames() const noexcept   { return numFrames; }
+    size_t getNumBytes() const noexcept { return tables.size() * sizeof(float); }
+
+    // Sets alive in the process, built and not yet freed
+    static int getNumLiveSets() noexcept;
+
+    // Audio thread. position scans the frames 0..1, phaseInc picks the mip level.
+    float render(float phase, float position, float phaseInc) const noexcept;
+
+private:
+    const float* getTable(int frame, int mipLevel) const noexcept
+    {
+        return tables.data() + (size_t)((frame * numMipLevels + mipLevel) * (tableSize + 1));
+    }
+
+    int numFrames = 0;
+    std::vector<float> tables;  // [frame][mip][tableSize + 1 guard sample]
+};
+
+//==============================================================================
+// Owns the active wavetable and builds replacements on a background thread.
+class WavetableBank
+{
+public:
+    WavetableBank() = default;
+    ~WavetableBank();
+
+    // Message thread
+    void loadFromFile(const juce::File& file);
+    void useBuiltInShapes();
+    void collectGarbage()                  { tables.collectGarbage(); }
+    juce::String getName() const;
+
+    // Audio thread: the table to use for this block, or nullptr for the built-in shapes
+    const WavetableSet* beginBlock() noexcept
+    {
+        auto* set = tables.acquire();
+        return (set != nullptr && set->getNumFrames() > 0) ? set : nullptr;
+    }
+
+private:
+    RealtimeSwap<WavetableSet> tables;
+    juce::ThreadPool loaderPool { 1 };
+    juce::CriticalSection nameLock;
+    juce::String name;
+
+    friend class WavetableTests;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WavetableBank)
+};
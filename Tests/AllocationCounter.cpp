@@ -0,0 +1,78 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local bool counting = false;
+    thread_local int allocations = 0;
+
+    inline void count() noexcept
+    {
+        if (counting)
+            ++allocations;
+    }
+}
+
+//==============================================================================
+ScopedAllocationCount::ScopedAllocationCount() noexcept
+{
+    allocations = 0;
+    counting = true;
+}
+
+ScopedAllocationCount::~ScopedAllocationCount() noexcept
+{
+    counting = false;
+}
+
+int ScopedAllocationCount::get() const noexcept
+{
+    return allocations;
+}
+
+//==============================================================================
+#if defined (__GLIBC__)
+
+// glibc exports its allocator under these names too, so ours can count and
+// forward. libstdc++'s operator new ends up here as well.
+extern "C"
+{
+    void* __libc_malloc(size_t size) noexcept;
+    void* __libc_calloc(size_t numElements, size_t size) noexcept;
+    void* __libc_realloc(void* block, size_t size) noexcept;
+
+    void* malloc(size_t size) noexcept                          { count(); return __libc_malloc(size); }
+    void* calloc(size_t numElements, size_t size) noexcept      { count(); return __libc_calloc(numElements, size); }
+    void* realloc(void* block, size_t size) noexcept            { count(); return __libc_realloc(block, size); }
+}
+
+bool ScopedAllocationCount::countsMalloc() noexcept     { return true; }
+
+#else
+
+namespace
+{
+    void* allocate(std::size_t size)
+    {
+        count();
+        if (auto* block = std::malloc(size == 0 ? 1 : size))
+            return block;
+        throw std::bad_alloc();
+    }
+}
+
+bool ScopedAllocationCount::countsMalloc() noexcept     { return false; }
+
+void* operator new(std::size_t size)                                     { return allocate(size); }
+void* operator new[](std::size_t size)                                   { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept     { try { return allocate(size); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept   { try { return allocate(size); } catch (...) { return nullptr; } }
+void operator delete(void* block) noexcept                               { std::free(block); }
+void operator delete[](void* block) noexcept                             { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept                  { std::free(block); }
+void operator delete[](void* block, std::size_t) noexcept                { std::free(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept        { std::free(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept      { std::free(block); }
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Counts heap allocations on one thread, for checks that a code path doesn't
+// allocate. AllocationCounter.cpp interposes malloc, calloc and realloc where
+// the C library is glibc, which also catches operator new and JUCE's
+// HeapBlock. Elsewhere it can only replace the global operator new, and
+// countsMalloc() is false. While nothing is counting either costs a
+// thread-local read.
+struct ScopedAllocationCount
+{
+    ScopedAllocationCount() noexcept;
+    ~ScopedAllocationCount() noexcept;
+
+    // Allocations on this thread since construction
+    int get() const noexcept;
+
+    static bool countsMalloc() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllocationCount)
+};
@@ -0,0 +1,92 @@
+#include <JuceHeader.h>
+#include "../Source/Arpeggiator.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testSamples = 240000;
+    constexpr int testBlockSizes[] = { 7, 32, 64, 127, 256, 480, 512, 1024, 4096 };
+    constexpr int midiChannel = 1;
+}
+
+//==============================================================================
+// Every mode over a scripted performance at a range of block sizes: each note
+// has to land on the same sample as with one-sample blocks
+class ArpeggiatorTests : public juce::UnitTest
+{
+public:
+    ArpeggiatorTests() : juce::UnitTest("Arpeggiator timing", "Accuracy") {}
+
+    void runTest() override
+    {
+        for (int mode = Arpeggiator::up; mode < Arpeggiator::numModes; ++mode)
+        {
+            Arpeggiator::Settings settings;
+            settings.mode = mode;
+            settings.tempoBpm = 133.0f;
+            settings.division = 4;
+            settings.swing = 0.4f;
+            settings.octaves = 2;
+            Arpeggiator::applyPresetPattern(3, settings);
+
+            for (float gate : { 0.5f, 1.0f })
+            {
+                settings.gate = gate;
+                beginTest(Arpeggiator::getModeName(mode) + (gate >= 1.0f ? " tied" : " gated"));
+
+                const auto reference = run(1, settings);
+                logMessage(juce::String((int)reference.size()) + " events");
+                expect(!reference.empty());
+
+                for (int blockSize : testBlockSizes)
+                    expect(run(blockSize, settings) == reference, "notes moved at block size " + juce::String(blockSize));
+            }
+        }
+    }
+
+private:
+    struct Event
+    {
+        juce::int64 time;
+        bool noteOn;
+        int note;
+        bool operator==(const Event& other) const noexcept { return time == other.time && noteOn == other.noteOn && note == other.note; }
+    };
+
+    static std::vector<Event> run(int blockSize, const Arpeggiator::Settings& settings)
+    {
+        // Chords pressed and released off any block grid, including a gap with
+        // nothing held and a note that restarts the pattern
+        static constexpr Event performance[] = {
+            { 1001, true, 60 }, { 5003, true, 64 }, { 9100, true, 67 }, { 120007, false, 60 },
+            { 120009, false, 64 }, { 131313, false, 67 }, { 150001, true, 50 }, { 201234, false, 50 }
+        };
+
+        Arpeggiator arpeggiator;
+        arpeggiator.prepare(testSampleRate);
+        arpeggiator.setRandomSeed(1);
+
+        std::vector<Event> events;
+        juce::MidiBuffer input, output;
+        for (int start = 0; start < testSamples; start += blockSize)
+        {
+            const int numSamples = juce::jmin(blockSize, testSamples - start);
+            input.clear();
+            for (const auto& e : performance)
+                if (e.time >= start && e.time < start + numSamples)
+                    input.addEvent(e.noteOn ? juce::MidiMessage::noteOn(midiChannel, e.note, (juce::uint8)100)
+                                            : juce::MidiMessage::noteOff(midiChannel, e.note), (int)(e.time - start));
+
+            arpeggiator.process(input, output, numSamples, settings);
+            for (const auto metadata : output)
+            {
+                const auto message = metadata.getMessage();
+                if (message.isNoteOnOrOff())
+                    events.push_back({ start + metadata.samplePosition, message.isNoteOn(), message.getNoteNumber() });
+            }
+        }
+        return events;
+    }
+};
+
+static ArpeggiatorTests arpeggiatorTests;
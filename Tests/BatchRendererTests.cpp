@@ -0,0 +1,90 @@
+#include <JuceHeader.h>
+#include "../Source/BatchRenderer.h"
+
+namespace
+{
+    constexpr const char* testJob = R"({
+        "sampleRate": 48000, "bitsPerSample": 24,
+        "lowNote": 48, "highNote": 60, "noteStep": 6,
+        "velocities": [ 64, 127 ],
+        "holdSeconds": 0.3, "tailSeconds": 0.2,
+        "analysis": true,
+        "patches": [ { "name": "plain" }, { "name": "bright", "waveMorph": 0.7, "cutoffHz": 9000 } ]
+    })";
+    constexpr float silenceThreshold = 1.0e-4f;
+    constexpr float indexPeakToleranceDb = 0.1f;
+}
+
+//==============================================================================
+// A small job rendered once on one thread and once on every core, then every
+// WAV and index.csv read back. The two runs have to produce identical files.
+class BatchRendererTests : public juce::UnitTest
+{
+public:
+    BatchRendererTests() : juce::UnitTest("Batch renderer", "Accuracy") {}
+
+    void runTest() override
+    {
+        const auto folder = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("BatchSelfCheck", {});
+        folder.createDirectory();
+        const auto jobFile = folder.getChildFile("job.json");
+        jobFile.replaceWithText(testJob);
+
+        beginTest("Job parsing");
+        BatchRenderer::Job job;
+        expectEquals(BatchRenderer::parseJob(jobFile, job), juce::String());
+
+        // Renders mustn't depend on which worker picked them up
+        beginTest("One thread and every core");
+        auto singleThreaded = job;
+        singleThreaded.outputDirectory = folder.getChildFile("one thread");
+        job.outputDirectory = folder.getChildFile("all threads");
+        expect(BatchRenderer::run(singleThreaded, 1), "single-threaded run reported failures");
+        expect(BatchRenderer::run(job), "multi-threaded run reported failures");
+
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        const int expectedLength = juce::jmax(1, (int)std::round((job.holdSeconds + job.tailSeconds) * job.sampleRate));
+
+        // Every row of the index names a file that matches it
+        beginTest("Files against index.csv");
+        const auto rows = juce::StringArray::fromLines(job.outputDirectory.getChildFile("index.csv").loadFileAsString().trimEnd());
+        expect(rows.size() > 0 && rows[0] == "file,patch,note,velocity,peak_dbfs,rms_dbfs,centroid_hz", "index.csv header");
+        expectEquals(juce::jmax(0, rows.size() - 1), job.getNumRenders(), "index.csv rows");
+
+        int badFiles = 0, badRows = 0, mismatches = 0;
+        for (int r = 1; r < rows.size(); ++r)
+        {
+            const auto fields = juce::StringArray::fromTokens(rows[r], ",", {});
+            const auto file = job.outputDirectory.getChildFile(fields[0]);
+            std::unique_ptr<juce::AudioFormatReader> reader(fields.size() == 7 ? formatManager.createReaderFor(file) : nullptr);
+            if (reader == nullptr)
+            {
+                ++badRows;
+                continue;
+            }
+
+            juce::AudioBuffer<float> audio((int)reader->numChannels, (int)reader->lengthInSamples);
+            reader->read(&audio, 0, audio.getNumSamples(), 0, true, true);
+            const float peak = audio.getMagnitude(0, audio.getNumSamples());
+
+            const bool fileOk = reader->sampleRate == job.sampleRate && (int)reader->bitsPerSample == job.bitsPerSample
+                                && reader->numChannels == 2 && reader->lengthInSamples == expectedLength && peak > silenceThreshold;
+            const bool rowOk = fields[1] == fields[0].upToFirstOccurrenceOf("_", false, false)
+                               && std::abs(fields[4].getFloatValue() - juce::Decibels::gainToDecibels(peak)) <= indexPeakToleranceDb;
+            badFiles += fileOk ? 0 : 1;
+            badRows += rowOk ? 0 : 1;
+
+            const auto twin = singleThreaded.outputDirectory.getChildFile(fields[0]);
+            mismatches += twin.existsAsFile() && twin.hasIdenticalContentTo(file) ? 0 : 1;
+        }
+
+        expectEquals(badFiles, 0, "files with the wrong format, length or silent");
+        expectEquals(badRows, 0, "rows not matching their file");
+        expectEquals(mismatches, 0, "files differing between one thread and all");
+
+        folder.deleteRecursively();
+    }
+};
+
+static BatchRendererTests batchRendererTests;
@@ -0,0 +1,156 @@
+#include <JuceHeader.h>
+#include "../Source/ChannelVocoder.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr double testSeconds = 2.0;
+    constexpr float pathTolerance = 1.0e-4f;
+}
+
+//==============================================================================
+// For each band count, the SIMD path against a scalar reference, the cost of
+// both, and how long the output takes to follow a modulator onset
+class ChannelVocoderTests : public juce::UnitTest
+{
+public:
+    ChannelVocoderTests() : juce::UnitTest("Channel vocoder", "Benchmarks") {}
+
+    void runTest() override
+    {
+        const juce::ScopedNoDenormals noDenormals;
+        const int numSamples = (int)(testSeconds * testSampleRate);
+        std::vector<float> modulator((size_t)numSamples), carrier((size_t)numSamples);
+        juce::Random random(1);
+        double sawPhase = 0.0;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Noise bursts against a 110 Hz saw, which has energy in every band
+            const bool burst = (i / 4800) % 2 == 0;
+            modulator[(size_t)i] = burst ? (random.nextFloat() * 2.0f - 1.0f) * 0.1f : 0.0f;
+            carrier[(size_t)i] = (float)(2.0 * sawPhase - 1.0) * 0.25f;
+            sawPhase = std::fmod(sawPhase + 110.0 / testSampleRate, 1.0);
+        }
+
+        // One scalar biquad per sample, the unit the filterbank's cost is quoted
+        // in; best of a few runs so a stray interruption doesn't skew it
+        double biquadSeconds = std::numeric_limits<double>::max();
+        std::vector<float> scratch((size_t)numSamples);
+        for (int run = 0; run < 3; ++run)
+        {
+            std::copy(carrier.begin(), carrier.end(), scratch.begin());
+            float z1 = 0.0f, z2 = 0.0f;
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (auto& x : scratch)
+            {
+                const float forward = 0.05f * x;
+                const float y = forward + z1;
+                z1 = z2 + 1.8f * y;
+                z2 = -(forward + 0.9f * y);
+                x = y;
+            }
+            biquadSeconds = juce::jmin(biquadSeconds, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start));
+        }
+        const double biquadNanos = biquadSeconds * 1.0e9 / numSamples;
+        logMessage(juce::String((int)ChannelVocoder::Lanes::SIZE) + " lanes per register; one scalar biquad costs "
+                   + juce::String(biquadNanos, 2) + " ns per sample");
+
+        for (int bands : { 16, 24, 32 })
+        {
+            beginTest(juce::String(bands) + " bands, stereo carrier");
+
+            std::vector<float> output[2][2];
+            double nanosPerSample[2] {};
+            for (int simd = 0; simd < 2; ++simd)
+            {
+                auto vocoder = std::make_unique<ChannelVocoder>();
+                vocoder->prepare(testSampleRate);
+                vocoder->setParameters(bands, 1.0f, 12.0f);
+                vocoder->applyParameters();
+                vocoder->mixSmoothed.setCurrentAndTargetValue(1.0f);
+                vocoder->engaged = true;
+
+                auto& outL = output[simd][0];
+                auto& outR = output[simd][1];
+                outL = carrier;
+                outR = carrier;
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                for (int offset = 0; offset < numSamples; offset += ChannelVocoder::chunkSize)
+                {
+                    const int count = juce::jmin(ChannelVocoder::chunkSize, numSamples - offset);
+                    if (simd == 1)
+                        vocoder->processChunk(modulator.data() + offset, outL.data() + offset, outR.data() + offset, count);
+                    else
+                        processChunkScalar(*vocoder, modulator.data() + offset, outL.data() + offset, outR.data() + offset, count);
+                }
+                nanosPerSample[simd] = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e9 / numSamples;
+            }
+
+            float worstDifference = 0.0f;
+            for (int i = 0; i < numSamples; ++i)
+                worstDifference = juce::jmax(worstDifference, std::abs(output[0][0][(size_t)i] - output[1][0][(size_t)i]),
+                                             std::abs(output[0][1][(size_t)i] - output[1][1][(size_t)i]));
+            expectLessThan(worstDifference, pathTolerance, "SIMD against scalar");
+
+            // Response: from the second burst's onset until the output first
+            // reaches half its level over the rest of that burst
+            const int onset = 9600, settleEnd = 14400;
+            float settled = 0.0f;
+            for (int i = onset + 2400; i < settleEnd; ++i)
+                settled = juce::jmax(settled, std::abs(output[1][0][(size_t)i]));
+            int responseSamples = 0;
+            while (onset + responseSamples < settleEnd && std::abs(output[1][0][(size_t)(onset + responseSamples)]) < 0.5f * settled)
+                ++responseSamples;
+
+            logMessage("SIMD " + juce::String(nanosPerSample[1], 1) + " ns per sample (" + juce::String(nanosPerSample[1] / biquadNanos, 1)
+                       + " scalar biquads), scalar " + juce::String(nanosPerSample[0], 1) + " ns; envelope response "
+                       + juce::String(1000.0 * responseSamples / testSampleRate, 2) + " ms; paths differ by "
+                       + juce::String(worstDifference, 7));
+        }
+    }
+
+private:
+    // One band and one signal at a time: the reference for the SIMD path
+    static void processChunkScalar(ChannelVocoder& v, const float* modulator, float* left, float* right, int numSamples) noexcept
+    {
+        const auto bandPass = [&v](float x, ChannelVocoder::BandStates& states, int band)
+        {
+            for (int s = 0; s < ChannelVocoder::numStages; ++s)
+            {
+                auto& z1 = states.z1[s][(size_t)band];
+                auto& z2 = states.z2[s][(size_t)band];
+                const float forward = v.b0[(size_t)band] * x;
+                const float y = forward + z1;
+                z1 = z2 - v.a1[(size_t)band] * y;
+                z2 = -(forward + v.a2[(size_t)band] * y);
+                x = y;
+            }
+            return x;
+        };
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float voicedL = 0.0f, voicedR = 0.0f;
+            for (int band = 0; band < v.numBands; ++band)
+            {
+                const float analysed = bandPass(modulator[i] * v.inputGain, v.analysis, band);
+                auto& peak = v.peaks[(size_t)band];
+                auto& envelope = v.envelopes[(size_t)band];
+                peak = juce::jmax(std::abs(analysed), peak * v.releaseMultiplier);
+                envelope += (peak - envelope) * v.attackCoefficient;
+
+                voicedL += bandPass(left[i], v.carrierL, band) * envelope;
+                if (right != nullptr)
+                    voicedR += bandPass(right[i], v.carrierR, band) * envelope;
+            }
+
+            const float mix = v.mixSmoothed.getNextValue();
+            left[i] += mix * (voicedL * v.makeupGain - left[i]);
+            if (right != nullptr)
+                right[i] += mix * (voicedR * v.makeupGain - right[i]);
+        }
+    }
+};
+
+static ChannelVocoderTests channelVocoderTests;
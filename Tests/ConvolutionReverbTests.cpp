@@ -0,0 +1,128 @@
+#include <JuceHeader.h>
+#include "../Source/ConvolutionReverb.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr double timedSeconds = 4.0;
+    constexpr double impulseLengths[] = { 1.0, 5.0, 10.0 };
+    constexpr double loadTimeoutSeconds = 30.0;
+    constexpr float tailTolerance = 1.0e-4f;
+}
+
+//==============================================================================
+// For 1, 5 and 10 s impulse responses: an impulse through the tail path has
+// to come out as the impulse response; the load, the callback and the
+// worker's cost per partition are timed alongside
+class ConvolutionReverbTests : public juce::UnitTest
+{
+public:
+    ConvolutionReverbTests() : juce::UnitTest("Convolution reverb", "Benchmarks") {}
+
+    void runTest() override
+    {
+        constexpr int headLength = ConvolutionReverb::headLength;
+        constexpr int tailPartitionSize = ConvolutionReverb::tailPartitionSize;
+
+        for (const double impulseSeconds : impulseLengths)
+        {
+            beginTest(juce::String(juce::roundToInt(impulseSeconds)) + " s impulse response");
+
+            // Decaying noise, 60 dB down by the end
+            const int irLength = (int)(impulseSeconds * testSampleRate);
+            juce::AudioBuffer<float> ir(2, irLength);
+            juce::Random random(1);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < irLength; ++i)
+                    ir.setSample(ch, i, (random.nextFloat() - 0.5f) * std::pow(0.001f, (float)i / (float)irLength));
+
+            // The tail path driven directly, without the worker thread: an impulse
+            // in should come out as the impulse response from sample headLength on
+            auto direct = std::make_unique<ConvolutionReverb>();
+            direct->reset();
+            direct->pendingKernel.store(direct->buildTailKernel(ir).release());
+            direct->adoptPendingKernel();
+            const int numPartitions = direct->activeKernel->numPartitions;
+
+            std::vector<float> input((size_t)tailPartitionSize), outL((size_t)tailPartitionSize), outR((size_t)tailPartitionSize);
+            double workerSeconds = 0.0;
+            float worstError = 0.0f;
+            for (int start = 0; start < irLength + tailPartitionSize; start += tailPartitionSize)
+            {
+                std::fill(input.begin(), input.end(), 0.0f);
+                input[0] = start == 0 ? 1.0f : 0.0f;
+                direct->pushTailInput(input.data(), input.data(), tailPartitionSize);
+
+                const auto workerStart = juce::Time::getHighResolutionTicks();
+                direct->processTailPartition();
+                workerSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - workerStart);
+
+                std::fill(outL.begin(), outL.end(), 0.0f);
+                std::fill(outR.begin(), outR.end(), 0.0f);
+                direct->addTailOutput(outL.data(), outR.data(), tailPartitionSize);
+                for (int i = 0; i < tailPartitionSize; ++i)
+                {
+                    const int n = start + i;
+                    const bool inTail = n >= headLength && n < irLength;
+                    worstError = juce::jmax(worstError, std::abs(outL[(size_t)i] - (inTail ? ir.getSample(0, n) : 0.0f)),
+                                            std::abs(outR[(size_t)i] - (inTail ? ir.getSample(1, n) : 0.0f)));
+                }
+            }
+            const int partitionsRun = (irLength + 2 * tailPartitionSize - 1) / tailPartitionSize;
+            const double workerMicros = workerSeconds * 1.0e6 / partitionsRun;
+            expectLessThan(worstError, tailTolerance, "tail against the impulse response");
+
+            // Load and callback cost through the real path, file and worker included
+            const juce::TemporaryFile file(".wav");
+            {
+                juce::WavAudioFormat wav;
+                std::unique_ptr<juce::FileOutputStream> stream(file.getFile().createOutputStream());
+                std::unique_ptr<juce::AudioFormatWriter> writer;
+                if (stream != nullptr)
+                    writer.reset(wav.createWriterFor(stream.get(), testSampleRate, 2, 24, {}, 0));
+                if (writer != nullptr)
+                {
+                    stream.release(); // now owned by the writer
+                    writer->writeFromAudioSampleBuffer(ir, 0, irLength);
+                }
+            }
+
+            auto live = std::make_unique<ConvolutionReverb>();
+            live->prepare(testSampleRate, testBlockSize);
+            const auto loadStart = juce::Time::getHighResolutionTicks();
+            live->loadImpulseResponse(file.getFile());
+            while (!live->hasImpulseResponse()
+                   && juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - loadStart) < loadTimeoutSeconds)
+                juce::Thread::sleep(1);
+            const double loadMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - loadStart) * 1000.0;
+            expect(live->hasImpulseResponse(), "impulse response never loaded");
+
+            live->setMix(1.0f);
+            juce::AudioBuffer<float> block(2, testBlockSize);
+            const int numBlocks = (int)(timedSeconds * testSampleRate) / testBlockSize;
+            double worstMicros = 0.0, totalSeconds = 0.0;
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < testBlockSize; ++i)
+                        block.setSample(ch, i, random.nextFloat() * 0.5f - 0.25f);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                live->process(block.getWritePointer(0), block.getWritePointer(1), testBlockSize);
+                const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+                totalSeconds += seconds;
+                worstMicros = juce::jmax(worstMicros, seconds * 1.0e6);
+            }
+            live.reset();
+
+            logMessage(juce::String(numPartitions) + " tail partitions: loaded in " + juce::String(juce::roundToInt(loadMs)) + " ms; callback worst "
+                       + juce::String(worstMicros, 1) + " us, mean " + juce::String(totalSeconds * 1.0e6 / numBlocks, 1) + " us; worker "
+                       + juce::String(workerMicros, 1) + " us per partition ("
+                       + juce::String(100.0 * workerMicros * 1.0e-6 * testSampleRate / tailPartitionSize, 1)
+                       + "% of a core); tail error " + juce::String(worstError, 7));
+        }
+    }
+};
+
+static ConvolutionReverbTests convolutionReverbTests;
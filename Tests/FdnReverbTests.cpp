@@ -0,0 +1,123 @@
+#include <JuceHeader.h>
+#include "../Source/FdnReverb.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr double burstSeconds = 0.5;
+    constexpr int decayWindows = 30;        // one second each
+    constexpr int freezeWindows = 60;
+    constexpr double timingSeconds = 10.0;
+    constexpr float windowGrowthTolerance = 1.05f;  // headroom for the line modulation
+}
+
+//==============================================================================
+// Rings the network at maximum decay and holds it frozen; the level must
+// never grow or go non-finite. Then one instance is timed.
+class FdnReverbTests : public juce::UnitTest
+{
+public:
+    FdnReverbTests() : juce::UnitTest("FDN reverb stability", "Accuracy") {}
+
+    void runTest() override
+    {
+        float firstRms = 0.0f, lastRms = 0.0f, worstGrowth = 0.0f;
+
+        beginTest("Decay at size 1, decay 1, no damping");
+        expect(runTail(false, decayWindows, firstRms, lastRms, worstGrowth), "non-finite output");
+        logMessage("Over " + juce::String(decayWindows) + " s: " + juce::String(toDecibels(firstRms), 1) + " dB -> "
+                   + juce::String(toDecibels(lastRms), 1) + " dB, worst second-to-second growth x" + juce::String(worstGrowth, 3));
+        expectLessOrEqual(worstGrowth, windowGrowthTolerance);
+        expectLessThan(lastRms, firstRms);
+
+        beginTest("Frozen with input");
+        expect(runTail(true, freezeWindows, firstRms, lastRms, worstGrowth), "non-finite output");
+        logMessage("For " + juce::String(freezeWindows) + " s: " + juce::String(toDecibels(firstRms), 1) + " dB -> "
+                   + juce::String(toDecibels(lastRms), 1) + " dB, worst second-to-second growth x" + juce::String(worstGrowth, 3));
+        expectLessOrEqual(worstGrowth, windowGrowthTolerance);
+        expectLessOrEqual(lastRms, firstRms * windowGrowthTolerance);
+
+        // One instance at a typical setting
+        beginTest("Cost");
+        prepare();
+        fdn.setParameters(0.6f, 0.6f, 0.4f, 0.3f, false);
+        const int timingSamples = (int)(timingSeconds * testSampleRate);
+        float sink = 0.0f;
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < timingSamples; ++i)
+        {
+            float left = random.nextFloat() - 0.5f;
+            float right = random.nextFloat() - 0.5f;
+            fdn.processSample(left, right);
+            sink += left + right;
+        }
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        logMessage("One instance: " + juce::String(seconds * 1.0e9 / timingSamples, 1) + " ns/sample, "
+                   + juce::String(100.0 * seconds / timingSeconds, 2) + "% of a core");
+        expect(std::isfinite(sink), "non-finite output");
+    }
+
+private:
+    static float toDecibels(float rms)      { return juce::Decibels::gainToDecibels(rms, -200.0f); }
+
+    // Reserving again rewinds the arena, so the lines are laid out afresh
+    void prepare()
+    {
+        arena.reserve(FdnReverb::getArenaFootprint(testSampleRate));
+        fdn.prepare(testSampleRate, arena);
+    }
+
+    // RMS of one second of output with the given input level
+    float runWindow(float inputLevel)
+    {
+        const int windowLength = (int)testSampleRate;
+        double sumSquares = 0.0;
+        for (int i = 0; i < windowLength; ++i)
+        {
+            float left = (random.nextFloat() * 2.0f - 1.0f) * inputLevel;
+            float right = (random.nextFloat() * 2.0f - 1.0f) * inputLevel;
+            fdn.processSample(left, right);
+            sumSquares += (double)left * left + (double)right * right;
+        }
+        return (float)std::sqrt(sumSquares / (2.0 * windowLength));
+    }
+
+    // Fed once, then only allowed to die away. A burst shorter than the first
+    // window so every window after it is pure tail. False if it goes non-finite.
+    bool runTail(bool freeze, int numWindows, float& firstRms, float& lastRms, float& worstGrowth)
+    {
+        prepare();
+        fdn.setParameters(1.0f, 1.0f, 0.0f, 1.0f, false);
+        const int burst = (int)(burstSeconds * testSampleRate);
+        for (int i = 0; i < (int)testSampleRate; ++i)
+        {
+            float left = i < burst ? random.nextFloat() * 2.0f - 1.0f : 0.0f;
+            float right = i < burst ? random.nextFloat() * 2.0f - 1.0f : 0.0f;
+            fdn.processSample(left, right);
+        }
+        fdn.setParameters(1.0f, 1.0f, 0.0f, 1.0f, freeze);
+
+        // Frozen, the input is muted, so it is fed anyway to prove it
+        bool finite = true;
+        float previous = 0.0f;
+        worstGrowth = 0.0f;
+        for (int w = 0; w < numWindows; ++w)
+        {
+            const float rms = runWindow(freeze ? 1.0f : 0.0f);
+            finite = finite && std::isfinite(rms);
+            if (w == 0)
+                firstRms = rms;
+            else if (previous > 0.0f)
+                worstGrowth = juce::jmax(worstGrowth, rms / previous);
+            previous = rms;
+        }
+        lastRms = previous;
+        return finite;
+    }
+
+    DspArena arena;
+    FdnReverb fdn;
+    juce::Random random { 1 };
+};
+
+static FdnReverbTests fdnReverbTests;
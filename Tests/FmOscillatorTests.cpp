@@ -0,0 +1,144 @@
+#include <JuceHeader.h>
+#include "../Source/FmOscillator.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr double noteSeconds = 0.25;
+    constexpr float frequencies[] = { 110.0f, 880.0f, 3520.0f };
+    constexpr float ratios[] = { 1.0f, 2.0f, 3.5f, 7.0f, 11.0f, 16.0f };
+    constexpr float levels[] = { 1.0f, 0.8f, 0.7f, 0.6f, 0.5f, 0.4f };
+    constexpr float minimumSnrDb = 30.0f;
+    constexpr int voiceCounts[] = { 1, 8, 32 };
+    constexpr double timingSeconds = 1.0;
+
+    // Phase offset of a full-level modulator at depth 1, in cycles
+    constexpr double modulationCycles = 2.0;
+
+    // The reference routings: modulators[op] is a bitmask of the operators
+    // feeding op. Chained modulation and feedback amplify any rounding without
+    // bound, so accuracy is judged on algorithms with at most one modulator
+    // per carrier.
+    struct Route
+    {
+        int algorithm;
+        std::array<int, FmOscillator::numOperators> modulators;
+        int carriers;
+    };
+
+    constexpr Route checkedRoutes[] =
+    {
+        { 2, { 1 << 1, 0, 1 << 3, 0, 1 << 5, 0 }, (1 << 0) | (1 << 2) | (1 << 4) },     // Three pairs
+        { 7, { 0, 0, 0, 0, 0, 0 }, 0x3f }                                               // Organ
+    };
+}
+
+//==============================================================================
+// The table oscillator against a double-precision std::sin render of the
+// same patch, then the cost of every algorithm at several voice counts
+class FmOscillatorTests : public juce::UnitTest
+{
+public:
+    FmOscillatorTests() : juce::UnitTest("FM oscillator", "Benchmarks") {}
+
+    void runTest() override
+    {
+        constexpr int numOperators = FmOscillator::numOperators;
+
+        // Envelopes that open in one sample and hold, so each operator's gain is
+        // just its level and the reference needs no envelope of its own
+        FmOscillator::Operators operators;
+        for (int op = 0; op < numOperators; ++op)
+            operators[(size_t)op] = { ratios[op], levels[op], 0.0f, 1.0f, 1.0f, 1.0f };
+
+        const int numSamples = (int)(noteSeconds * testSampleRate);
+        for (const auto& route : checkedRoutes)
+        {
+            beginTest(FmOscillator::getAlgorithmName(route.algorithm) + " against std::sin");
+            for (const float frequency : frequencies)
+            {
+                FmOscillator fm;
+                fm.prepare(testSampleRate);
+                fm.setParameters(route.algorithm, 0.0f, 1.0f, operators);
+                fm.noteOn();
+
+                // The same float increments, so only the sine and the phase arithmetic differ
+                const float phaseInc = juce::MathConstants<float>::twoPi * frequency / (float)testSampleRate;
+                const float cycleInc = phaseInc / juce::MathConstants<float>::twoPi;
+                std::array<double, numOperators> phases {}, outputs {};
+                double errorSquares = 0.0, signalSquares = 0.0, worstError = 0.0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    double sum = 0.0;
+                    int numCarriers = 0;
+                    for (int op = numOperators - 1; op >= 0; --op)
+                    {
+                        auto& phase = phases[(size_t)op];
+                        phase += (double)(ratios[op] * cycleInc);
+                        phase -= std::floor(phase);
+
+                        double modulation = 0.0;
+                        for (int m = op + 1; m < numOperators; ++m)
+                            if ((route.modulators[(size_t)op] & (1 << m)) != 0)
+                                modulation += outputs[(size_t)m];
+
+                        outputs[(size_t)op] = std::sin(juce::MathConstants<double>::twoPi * (phase + modulation * modulationCycles)) * levels[op];
+                        if ((route.carriers & (1 << op)) != 0)
+                        {
+                            sum += outputs[(size_t)op];
+                            ++numCarriers;
+                        }
+                    }
+
+                    const double reference = numCarriers > 1 ? sum / numCarriers : sum;
+                    const double error = (double)fm.renderSample(phaseInc) - reference;
+                    errorSquares += error * error;
+                    signalSquares += reference * reference;
+                    worstError = juce::jmax(worstError, std::abs(error));
+                }
+
+                const float snrDb = (float)(10.0 * std::log10(signalSquares / juce::jmax(1.0e-30, errorSquares)));
+                logMessage(juce::String(frequency, 0) + " Hz: SNR " + juce::String(snrDb, 1) + " dB, worst error " + juce::String(worstError, 5));
+                expectGreaterOrEqual(snrDb, minimumSnrDb);
+            }
+        }
+
+        // All six operators always run, so cost varies with the routing and the voice count
+        beginTest("Cost per voice per sample");
+        juce::String header = "ns by voice count:";
+        for (const int voices : voiceCounts)
+            header << " " << voices;
+        logMessage(header);
+
+        const int timingSamples = (int)(timingSeconds * testSampleRate);
+        for (int index = 0; index < FmOscillator::numAlgorithms; ++index)
+        {
+            juce::String line = FmOscillator::getAlgorithmName(index) + ":";
+            for (const int voices : voiceCounts)
+            {
+                std::vector<std::unique_ptr<FmOscillator>> bank;
+                for (int v = 0; v < voices; ++v)
+                {
+                    bank.push_back(std::make_unique<FmOscillator>());
+                    bank.back()->prepare(testSampleRate);
+                    bank.back()->setParameters(index, 0.3f, 1.0f, operators);
+                    bank.back()->noteOn();
+                }
+
+                float sink = 0.0f;
+                const auto start = juce::Time::getHighResolutionTicks();
+                for (int i = 0; i < timingSamples; ++i)
+                    for (int v = 0; v < voices; ++v)
+                        sink += bank[(size_t)v]->renderSample(0.02f * (float)(v + 1));
+                const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+                line << " " << juce::String(seconds * 1.0e9 / ((double)timingSamples * voices), 1);
+                expect(std::isfinite(sink), "non-finite output");
+            }
+            logMessage(line);
+        }
+    }
+};
+
+static FmOscillatorTests fmOscillatorTests;
@@ -0,0 +1,83 @@
+#include <JuceHeader.h>
+#include "../Source/GranularProcessor.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr double historySeconds = 4.0;
+    constexpr float grainMs = 400.0f;
+    constexpr float overlaps[] = { 1.0f, 8.0f, 32.0f, 128.0f, 400.0f };
+    constexpr double warmUpSeconds = 1.0;
+    constexpr double timedSeconds = 5.0;
+}
+
+//==============================================================================
+// The cloud at overlaps from 1 to 400 grains, and the cost per grain. The
+// output has to stay finite throughout.
+class GranularProcessorTests : public juce::UnitTest
+{
+public:
+    GranularProcessorTests() : juce::UnitTest("Granular cloud", "Benchmarks") {}
+
+    void runTest() override
+    {
+        DspArena arena;
+        arena.reserve(GranularProcessor::getArenaFootprint(testBlockSize));
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> history(2, (int)(historySeconds * testSampleRate));
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < history.getNumSamples(); ++i)
+                history.setSample(ch, i, random.nextFloat() - 0.5f);
+
+        juce::AudioBuffer<float> block(2, testBlockSize);
+        for (const float overlap : overlaps)
+        {
+            beginTest("Overlap " + juce::String((int)overlap) + ", " + juce::String(grainMs, 0) + " ms grains");
+
+            GranularProcessor granular;
+            arena.rewind();
+            granular.prepare(testSampleRate, testBlockSize, arena);
+            granular.setRandomSeed(1);
+            granular.setParameters(grainMs, overlap * 1000.0f / grainMs, 0.0f, 0.5f, 0.2f, 1.0f);
+
+            int writePosition = 0;
+            const auto runBlock = [&]
+            {
+                block.clear();
+                writePosition = (writePosition + testBlockSize) % history.getNumSamples();
+                granular.process(history, writePosition, block.getWritePointer(0), block.getWritePointer(1), testBlockSize);
+            };
+
+            // Let the cloud fill before timing it
+            const int warmUpBlocks = (int)(warmUpSeconds * testSampleRate) / testBlockSize;
+            for (int b = 0; b < warmUpBlocks; ++b)
+                runBlock();
+
+            const int numBlocks = (int)(timedSeconds * testSampleRate) / testBlockSize;
+            double totalSeconds = 0.0, worstMicros = 0.0;
+            juce::int64 grainBlocks = 0;
+            bool finite = true;
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                runBlock();
+                const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+                totalSeconds += seconds;
+                worstMicros = juce::jmax(worstMicros, seconds * 1.0e6);
+                grainBlocks += granular.getActiveGrainCount();
+                finite = finite && std::isfinite(block.getMagnitude(0, testBlockSize));
+            }
+            expect(finite, "output went non-finite");
+
+            const double meanGrains = (double)grainBlocks / numBlocks;
+            const double nsPerGrainSample = grainBlocks > 0 ? totalSeconds * 1.0e9 / ((double)grainBlocks * testBlockSize) : 0.0;
+            logMessage(juce::String(meanGrains, 1) + " grains active, " + juce::String(totalSeconds * 1.0e6 / numBlocks, 1)
+                       + " us per block (worst " + juce::String(worstMicros, 1) + " us, " + juce::String(100.0 * totalSeconds / timedSeconds, 2)
+                       + "% of a core), " + juce::String(nsPerGrainSample, 2) + " ns per grain per sample");
+        }
+    }
+};
+
+static GranularProcessorTests granularProcessorTests;
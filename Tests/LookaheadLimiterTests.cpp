@@ -0,0 +1,112 @@
+#include <JuceHeader.h>
+#include "../Source/LookaheadLimiter.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr double testSeconds = 2.0;
+    constexpr float lookaheadsMs[] = { 1.0f, 2.0f, 5.0f, 10.0f };
+    constexpr float ceilingsDb[] = { -0.1f, -1.0f, -3.0f, -6.0f };
+    constexpr float releaseMs = 80.0f;
+    constexpr float transparentLevel = 0.25f;   // -12 dBFS, under every ceiling
+}
+
+//==============================================================================
+// Impulses, full-scale square bursts and random overs through every
+// look-ahead and ceiling: nothing may pass the ceiling, and material under it
+// has to come out untouched. Each look-ahead is timed.
+class LookaheadLimiterTests : public juce::UnitTest
+{
+public:
+    LookaheadLimiterTests() : juce::UnitTest("Look-ahead limiter", "Accuracy") {}
+
+    void runTest() override
+    {
+        const int numSamples = (int)(testSeconds * testSampleRate);
+        juce::Random random(1);
+
+        // +12 dB clicks in silence, 0 dBFS 100 Hz square in 50 ms bursts, and
+        // noise with random spikes up to +12 dB
+        enum { impulses, squareBursts, randomOvers, numSignals };
+        const char* signalNames[numSignals] = { "impulses", "square bursts", "random overs" };
+        juce::AudioBuffer<float> signals[numSignals];
+        for (auto& signal : signals)
+            signal.setSize(2, numSamples);
+
+        const int burstLength = (int)(0.05 * testSampleRate);
+        const int squarePeriod = (int)(testSampleRate / 100.0);
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                signals[impulses].setSample(ch, i, i % 1000 == 0 ? (ch == 0 ? 4.0f : -4.0f) : 0.0f);
+                signals[squareBursts].setSample(ch, i, (i / burstLength) % 2 == 0 ? ((i % squarePeriod) < squarePeriod / 2 ? 1.0f : -1.0f) : 0.0f);
+                const float noise = random.nextFloat() * 0.6f - 0.3f;
+                signals[randomOvers].setSample(ch, i, random.nextInt(200) == 0 ? (noise < 0.0f ? -1.0f : 1.0f) * (1.0f + 3.0f * random.nextFloat()) : noise);
+            }
+        }
+
+        juce::AudioBuffer<float> sine(2, numSamples);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                sine.setSample(ch, i, transparentLevel * (float)std::sin(juce::MathConstants<double>::twoPi * 997.0 * i / testSampleRate));
+
+        LookaheadLimiter limiter;
+        juce::AudioBuffer<float> work(2, numSamples);
+        const auto processAll = [&]
+        {
+            for (int pos = 0; pos < numSamples; pos += testBlockSize)
+                limiter.process(work.getWritePointer(0, pos), work.getWritePointer(1, pos), juce::jmin(testBlockSize, numSamples - pos));
+        };
+
+        for (const float lookaheadMs : lookaheadsMs)
+        {
+            beginTest(juce::String(lookaheadMs, 0) + " ms look-ahead");
+
+            float worstOverDb = -100.0f;
+            double limitingSeconds = 0.0;
+            int limitingRuns = 0;
+            for (const float ceilingDb : ceilingsDb)
+            {
+                limiter.setParameters(ceilingDb, lookaheadMs, releaseMs);
+                limiter.prepare(testSampleRate);
+                const float ceilingGain = juce::Decibels::decibelsToGain(ceilingDb);
+
+                for (int s = 0; s < numSignals; ++s)
+                {
+                    limiter.reset();
+                    work.makeCopyOf(signals[s], true);
+
+                    const auto start = juce::Time::getHighResolutionTicks();
+                    processAll();
+                    limitingSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+                    ++limitingRuns;
+
+                    const float peak = work.getMagnitude(0, numSamples);
+                    worstOverDb = juce::jmax(worstOverDb, juce::Decibels::gainToDecibels(peak, -100.0f) - ceilingDb);
+                    expectLessOrEqual(peak, ceilingGain, juce::String(signalNames[s]) + " at a " + juce::String(ceilingDb, 1) + " dB ceiling");
+                }
+            }
+
+            // Under the ceiling the output is the input, delayed by exactly the look-ahead
+            limiter.setParameters(-1.0f, lookaheadMs, releaseMs);
+            limiter.prepare(testSampleRate);
+            work.makeCopyOf(sine, true);
+            processAll();
+
+            const int latency = limiter.getLatencySamples();
+            float worstDifference = 0.0f;
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = latency; i < numSamples; ++i)
+                    worstDifference = juce::jmax(worstDifference, std::abs(work.getSample(ch, i) - sine.getSample(ch, i - latency)));
+            expectEquals(latency, juce::roundToInt(lookaheadMs * 0.001 * testSampleRate), "latency");
+            expectEquals(worstDifference, 0.0f, "-12 dBFS sine altered");
+
+            logMessage(juce::String(latency) + " samples: " + juce::String(limitingSeconds * 1.0e9 / ((double)limitingRuns * numSamples), 2)
+                       + " ns/sample while limiting; highest output " + juce::String(worstOverDb, 3) + " dB against the ceiling");
+        }
+    }
+};
+
+static LookaheadLimiterTests lookaheadLimiterTests;
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    Console runner for the accuracy checks and benchmarks. Every test is a
+    juce::UnitTest registered by a static instance in its own file.
+
+      NewProjectTests                      runs everything
+      NewProjectTests --test <name> ...    runs the named tests (repeatable)
+      NewProjectTests --category <name>    runs one category
+      NewProjectTests --list               lists the tests
+
+    The real-time options (see RealtimeOptions.h) are read from the
+    environment and the command line as the app does, so the worker threads
+    and the jitter test run with them. The exit code is 1 if anything failed.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../Source/RealtimeOptions.h"
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    auto realtimeArgs = juce::StringArray::fromTokens(juce::SystemStats::getEnvironmentVariable("SPECTRAL_LAB_REALTIME", {}), true);
+    realtimeArgs.addArray(args);
+    RealtimeOptions::setCurrent(RealtimeOptions::parse(realtimeArgs));
+
+    auto& allTests = juce::UnitTest::getAllTests();
+    if (args.contains("--list"))
+    {
+        for (auto* test : allTests)
+            std::cout << test->getCategory() << ": " << test->getName() << std::endl;
+        return 0;
+    }
+
+    juce::StringArray names, categories;
+    for (int i = 0; i < args.size() - 1; ++i)
+    {
+        if (args[i] == "--test")
+            names.add(args[++i].unquoted());
+        else if (args[i] == "--category")
+            categories.add(args[++i].unquoted());
+    }
+
+    juce::Array<juce::UnitTest*> tests;
+    for (auto* test : allTests)
+        if ((names.isEmpty() && categories.isEmpty())
+            || names.contains(test->getName(), true) || categories.contains(test->getCategory(), true))
+            tests.add(test);
+
+    if (tests.isEmpty())
+    {
+        std::cout << "No tests match; --list shows them" << std::endl;
+        return 1;
+    }
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTests(tests);
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+    return failures > 0 ? 1 : 0;
+}
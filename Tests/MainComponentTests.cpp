@@ -0,0 +1,85 @@
+#include <JuceHeader.h>
+#include "../Source/MainComponent.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr double timedSeconds = 5.0;
+    constexpr double idleTimeoutSeconds = 10.0;
+    // What an idle callback may cost against one playing a note
+    constexpr double maxIdleShare = 0.25;
+}
+
+//==============================================================================
+// The whole audio callback, engine to scope, with a note held and then once
+// everything has gone quiet. Idle callbacks have to stay silent, leave the
+// scope alone, and cost a small share of a playing one.
+class MainComponentTests : public juce::UnitTest
+{
+public:
+    MainComponentTests() : juce::UnitTest("Callback idle", "Benchmarks") {}
+
+    void runTest() override
+    {
+        component = std::make_unique<MainComponent>();
+        component->prepareToPlay(testBlockSize, testSampleRate);
+        buffer.setSize(2, testBlockSize);
+        const double blockMicros = testBlockSize * 1.0e6 / testSampleRate;
+
+        beginTest("Held note");
+        component->engine.noteOn(60, 0.8f);
+        const double heldMicros = timeCallbacks();
+        logMessage(juce::String(testBlockSize) + "-sample callbacks at " + juce::String(testSampleRate / 1000.0, 1) + " kHz: "
+                   + juce::String(heldMicros, 2) + " us (" + juce::String(100.0 * heldMicros / blockMicros, 2) + "% of real time)");
+
+        // Release the note and wait for the engine, the limiter and the scope to settle
+        beginTest("Idle after the tails");
+        component->engine.noteOff(60);
+        int samplesToQuiet = 0;
+        while (!isQuiet() && samplesToQuiet < (int)(idleTimeoutSeconds * testSampleRate))
+        {
+            runCallback();
+            samplesToQuiet += testBlockSize;
+        }
+        expect(isQuiet(), "never went quiet");
+
+        const auto scopeVersion = component->scopeVersion.load();
+        const double idleMicros = timeCallbacks();
+        expect(isQuiet(), "woke up while idle");
+        expectEquals(buffer.getMagnitude(0, testBlockSize), 0.0f, "output not silent while idle");
+        expect(component->scopeVersion.load() == scopeVersion, "scope redrawn while idle");
+        expectLessThan(idleMicros, heldMicros * maxIdleShare, "idle callback cost");
+        logMessage("Quiet " + juce::String(1000.0 * samplesToQuiet / testSampleRate, 0) + " ms after note-off; "
+                   + juce::String(idleMicros, 2) + " us per callback (" + juce::String(100.0 * idleMicros / blockMicros, 3) + "%)");
+
+        component->releaseResources();
+        component.reset();
+    }
+
+private:
+    void runCallback()
+    {
+        component->getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, 0, testBlockSize));
+    }
+
+    double timeCallbacks()
+    {
+        const int numBlocks = (int)(timedSeconds * testSampleRate) / testBlockSize;
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; ++block)
+            runCallback();
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6 / numBlocks;
+    }
+
+    bool isQuiet() const
+    {
+        return component->engine.isIdle() && component->limiter.isDrained()
+               && component->scopeSilentRun >= component->scopeBuffer.getNumSamples();
+    }
+
+    std::unique_ptr<MainComponent> component;
+    juce::AudioBuffer<float> buffer;
+};
+
+static MainComponentTests mainComponentTests;
@@ -0,0 +1,96 @@
+#include <JuceHeader.h>
+#include "../Source/OutputMeter.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr double toneSeconds = 3.0;
+    constexpr double loudnessSeconds = 20.0;
+    constexpr double pushSeconds = 2.0;
+    constexpr float levelToleranceDb = 0.1f;
+    constexpr float truePeakToleranceDb = 0.3f;     // 4x oversampling reads fs/4 about 0.2 dB low
+    constexpr float loudnessToleranceLu = 0.1f;     // EBU Tech 3341
+}
+
+//==============================================================================
+// Sine peak and RMS, an inter-sample true peak and the EBU Tech 3341 1 kHz
+// loudness tones, then pushBlock timed against the running meter thread and
+// the analysis on its own
+class OutputMeterTests : public juce::UnitTest
+{
+public:
+    OutputMeterTests() : juce::UnitTest("Output meter", "Accuracy") {}
+
+    void runTest() override
+    {
+        beginTest("997 Hz sine at -6.02 dBFS");
+        const auto sine = measureSine(997.0, 0.5f, 0.0, toneSeconds);
+        expectWithinAbsoluteError(sine.peakDb, -6.02f, levelToleranceDb, "sample peak");
+        expectWithinAbsoluteError(sine.rmsDb, -9.03f, levelToleranceDb, "RMS");
+
+        // Samples land at +/-45 degrees, so they sit 3 dB under the waveform's peak
+        beginTest("fs/4 sine at 45 degrees");
+        const auto interSample = measureSine(testSampleRate / 4.0, 1.0f, juce::MathConstants<double>::pi / 4.0, toneSeconds);
+        expectWithinAbsoluteError(interSample.peakDb, -3.01f, levelToleranceDb, "sample peak");
+        expectWithinAbsoluteError(interSample.maxTruePeakDb, 0.0f, truePeakToleranceDb, "true peak");
+        logMessage("True peak " + juce::String(interSample.maxTruePeakDb, 2) + " dBTP");
+
+        for (const float levelDb : { -23.0f, -33.0f })
+        {
+            beginTest("1 kHz stereo at " + juce::String(levelDb, 0) + " dBFS");
+            const auto tone = measureSine(1000.0, juce::Decibels::decibelsToGain(levelDb), 0.0, loudnessSeconds);
+            expectWithinAbsoluteError(tone.integratedLufs, levelDb, loudnessToleranceLu, "integrated");
+            expectWithinAbsoluteError(tone.shortTermLufs, levelDb, loudnessToleranceLu, "short-term");
+        }
+
+        // The analysis the meter thread does, per second of audio
+        beginTest("Meter thread cost");
+        meter.prepare(testSampleRate);
+        meter.stop();
+        juce::Random random(1);
+        std::vector<float> noise((size_t)testSampleRate);
+        for (auto& sample : noise)
+            sample = random.nextFloat() - 0.5f;
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        meter.measure(noise.data(), noise.data(), (int)noise.size());
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        logMessage(juce::String(seconds * 1.0e9 / testSampleRate, 1) + " ns/sample, " + juce::String(100.0 * seconds, 2) + "% of a core");
+
+        // The audio thread's share, paced like a device so the thread keeps up
+        beginTest("Audio thread cost");
+        meter.prepare(testSampleRate);
+        std::vector<float> block((size_t)testBlockSize, 0.25f);
+        const int numBlocks = (int)(pushSeconds * testSampleRate) / testBlockSize;
+        const int blockMs = juce::roundToInt(1000.0 * testBlockSize / testSampleRate);
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            meter.pushBlock(block.data(), block.data(), testBlockSize);
+            juce::Thread::sleep(blockMs);
+        }
+        logMessage("pushBlock " + juce::String(meter.getAveragePushMicros(), 2) + " us mean, " + juce::String(meter.getWorstPushMicros(), 2)
+                   + " us worst per " + juce::String(testBlockSize) + "-sample block; " + juce::String(meter.getDroppedBlocks()) + " blocks dropped");
+        meter.stop();
+    }
+
+private:
+    // Both channels carry the same sine for the given time
+    OutputMeter::Readings measureSine(double frequency, float amplitude, double phase, double seconds)
+    {
+        meter.prepare(testSampleRate);
+        meter.stop();
+
+        const int numSamples = (int)(seconds * testSampleRate);
+        std::vector<float> tone((size_t)numSamples);
+        for (int i = 0; i < numSamples; ++i)
+            tone[(size_t)i] = amplitude * (float)std::sin(juce::MathConstants<double>::twoPi * frequency * i / testSampleRate + phase);
+
+        meter.measure(tone.data(), tone.data(), numSamples);
+        return meter.getReadings();
+    }
+
+    OutputMeter meter;
+};
+
+static OutputMeterTests outputMeterTests;
@@ -0,0 +1,87 @@
+#include <JuceHeader.h>
+#include "AllocationCounter.h"
+#include "../Source/SynthEngine.h"
+#include "../Source/LookaheadLimiter.h"
+#include "../Source/OutputMeter.h"
+#include "../Source/ChannelVocoder.h"
+#include "../Source/OutputRecorder.h"
+
+namespace
+{
+    constexpr double firstRate = 48000.0;
+    // No two neighbours alike, so every call is a real rate change
+    constexpr double rates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0, 22050.0 };
+    constexpr int blockSizes[] = { 32, 64, 256, 512, 1024, 4096 };
+}
+
+//==============================================================================
+// The prepare calls prepareToPlay makes, repeated across rates as device
+// restarts would. Only the first call of each may allocate. The engine takes
+// the block size on its first call only, so each block size gets a fresh set
+// of components.
+class PrepareAllocationTests : public juce::UnitTest
+{
+public:
+    PrepareAllocationTests() : juce::UnitTest("Prepare allocations", "Accuracy") {}
+
+    void runTest() override
+    {
+        if (!ScopedAllocationCount::countsMalloc())
+            logMessage("Only operator new is counted on this platform, not malloc");
+
+        for (const int blockSize : blockSizes)
+        {
+            beginTest(juce::String(blockSize) + "-sample blocks");
+
+            auto engine = std::make_unique<SynthEngine>();
+            auto limiter = std::make_unique<LookaheadLimiter>();
+            auto meter = std::make_unique<OutputMeter>();
+            auto vocoder = std::make_unique<ChannelVocoder>();
+            auto recorder = std::make_unique<OutputRecorder>();
+
+            int first = 0;
+            {
+                const ScopedAllocationCount count;
+                engine->prepare(firstRate, blockSize);
+                limiter->prepare(firstRate);
+                meter->prepare(firstRate);
+                vocoder->prepare(firstRate);
+                recorder->prepare(firstRate);
+                first = count.get();
+            }
+
+            juce::StringArray counts;
+            for (const double rate : rates)
+            {
+                const int engineCount = countAllocations([&] { engine->prepare(rate, blockSize); });
+                const int limiterCount = countAllocations([&] { limiter->prepare(rate); });
+                const int meterCount = countAllocations([&] { meter->prepare(rate); });
+                const int vocoderCount = countAllocations([&] { vocoder->prepare(rate); });
+                const int recorderCount = countAllocations([&] { recorder->prepare(rate); });
+
+                const auto at = " at " + juce::String(rate / 1000.0, 2) + " kHz";
+                expectEquals(engine->getSampleRate(), rate, "engine kept its old rate" + at);
+                expectEquals(engineCount, 0, "SynthEngine" + at);
+                expectEquals(limiterCount, 0, "LookaheadLimiter" + at);
+                expectEquals(meterCount, 0, "OutputMeter" + at);
+                expectEquals(vocoderCount, 0, "ChannelVocoder" + at);
+                expectEquals(recorderCount, 0, "OutputRecorder" + at);
+                counts.add(juce::String(engineCount + limiterCount + meterCount + vocoderCount + recorderCount));
+            }
+
+            logMessage("First call " + juce::String(first) + " (allowed), then by rate: " + counts.joinIntoString(", "));
+            meter->stop();
+        }
+    }
+
+private:
+    template <typename Function>
+    static int countAllocations(Function&& function)
+    {
+        const ScopedAllocationCount count;
+        function();
+        return count.get();
+    }
+};
+
+static PrepareAllocationTests prepareAllocationTests;
@@ -0,0 +1,200 @@
+#include <JuceHeader.h>
+#include "../Source/QualityGovernor.h"
+#include "../Source/SynthEngine.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr double tierSeconds = 2.0;
+    constexpr double closedLoopSeconds = 4.0;
+    constexpr int closedLoopNotes[] = { 48, 55, 60, 64, 67, 72 };
+
+    // Busy-wait per block on top of the real render, as a share of the block's
+    // budget, standing in for a host that leaves less time at each tier: over
+    // the degrade threshold at full and reduced, comfortably under it below
+    constexpr double injectedLoad[] = { 0.95, 0.8, 0.45, 0.35 };
+}
+
+//==============================================================================
+// Synthetic callback loads (light, sustained overload, one spike, in between
+// the thresholds, then light again): each step has to come exactly when it
+// should. Then the engine is timed at every tier, and finally rendered with
+// extra load under the governor's own measurement: it has to step down until
+// blocks fit, then stay there without a block over budget.
+class QualityGovernorTests : public juce::UnitTest
+{
+public:
+    QualityGovernorTests() : juce::UnitTest("Quality governor", "Accuracy") {}
+
+    void runTest() override
+    {
+        using Tier = QualityGovernor::Tier;
+        constexpr int numTiers = QualityGovernor::numTiers;
+        constexpr int degradeAfterBlocks = QualityGovernor::degradeAfterBlocks;
+        const int blocksPerSecond = (int)(testSampleRate / testBlockSize);
+        const int recoverAfterBlocks = (int)(QualityGovernor::recoverAfterSeconds * testSampleRate / testBlockSize);
+        governor.prepare(testSampleRate);
+
+        beginTest("Light load");
+        auto steps = drive(0.2f, 2 * blocksPerSecond);
+        expect(steps.empty(), describe(steps));
+
+        // One step down per degradeAfterBlocks of overload, and no further than survival
+        beginTest("Sustained overload");
+        steps = drive(0.9f, 4 * numTiers * degradeAfterBlocks);
+        bool stepsDown = steps.size() == numTiers - 1;
+        for (size_t i = 0; stepsDown && i < steps.size(); ++i)
+            stepsDown = steps[i].block == (int)(i + 1) * degradeAfterBlocks && steps[i].tier == (Tier)(i + 1);
+        expect(stepsDown, describe(steps));
+
+        // Between the thresholds nothing moves, so the tier doesn't flap
+        beginTest("Between the thresholds");
+        steps = drive(0.5f, 5 * blocksPerSecond);
+        expect(steps.empty(), describe(steps));
+
+        // Back up one tier per recoverAfterSeconds once the smoothed load has fallen
+        beginTest("Recovery");
+        steps = drive(0.1f, (numTiers + 1) * (recoverAfterBlocks + blocksPerSecond));
+        bool recovers = steps.size() == numTiers - 1 && governor.getTier() == Tier::full;
+        for (size_t i = 1; recovers && i < steps.size(); ++i)
+            recovers = steps[i].block - steps[i - 1].block == recoverAfterBlocks;
+        expect(recovers, describe(steps));
+
+        // A single block over budget costs one tier, then comes back
+        beginTest("One block over budget");
+        steps = drive(1.5f, 1);
+        for (const auto& step : drive(0.2f, 2 * (recoverAfterBlocks + blocksPerSecond)))
+            steps.push_back({ step.block + 1, step.tier });
+        expect(steps.size() == 2 && steps[0].tier == Tier::reduced && steps[0].block == degradeAfterBlocks && steps[1].tier == Tier::full,
+               describe(steps));
+
+        // What each tier saves, on a held note with the chorus running
+        beginTest("Engine cost per tier");
+        auto engine = std::make_unique<SynthEngine>();
+        engine->prepare(testSampleRate, testBlockSize);
+        engine->setRandomSeed(1);
+        engine->noteOn(48, 0.8f);
+        juce::AudioBuffer<float> buffer(2, testBlockSize);
+        const int numBlocks = (int)(tierSeconds * testSampleRate) / testBlockSize;
+
+        juce::StringArray costs;
+        for (int t = 0; t < numTiers; ++t)
+        {
+            engine->setQualityTier((Tier)t);
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                buffer.clear();
+                engine->render(buffer.getWritePointer(0), buffer.getWritePointer(1), testBlockSize);
+            }
+            const double micros = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6 / numBlocks;
+            costs.add(juce::String(QualityGovernor::getTierName((Tier)t)) + " " + juce::String(micros, 1) + " us");
+        }
+        logMessage("Engine per block: " + costs.joinIntoString(", "));
+
+        // The loop the audio callback runs: measure, render at the governor's
+        // tier, and let the measurement report the block
+        beginTest("Closed loop under injected load");
+        engine = std::make_unique<SynthEngine>();
+        engine->prepare(testSampleRate, testBlockSize);
+        engine->setRandomSeed(1);
+        for (const int note : closedLoopNotes)
+            engine->noteOn(note, 0.8f);
+        governor.prepare(testSampleRate);
+
+        const double budget = testBlockSize / testSampleRate;
+        const int closedLoopBlocks = (int)(closedLoopSeconds * testSampleRate) / testBlockSize;
+        std::vector<Step> closedLoopSteps;
+        std::array<double, numTiers> tierSecondsTotal {}, tierWorst {};
+        std::array<int, numTiers> tierBlocks {};
+        int lastStepBlock = 0, overBudgetAfterSettling = 0;
+
+        for (int block = 0; block < closedLoopBlocks; ++block)
+        {
+            const auto tier = governor.getTier();
+            const auto start = juce::Time::getHighResolutionTicks();
+            {
+                const QualityGovernor::ScopedMeasurement measurement(governor, testBlockSize);
+                engine->setQualityTier(tier);
+                buffer.clear();
+                engine->render(buffer.getWritePointer(0), buffer.getWritePointer(1), testBlockSize);
+                spin(injectedLoad[(int)tier] * budget);
+            }
+            const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+            tierSecondsTotal[(size_t)tier] += seconds;
+            tierWorst[(size_t)tier] = juce::jmax(tierWorst[(size_t)tier], seconds);
+            ++tierBlocks[(size_t)tier];
+
+            if (governor.getTier() != tier)
+            {
+                closedLoopSteps.push_back({ block + 1, governor.getTier() });
+                lastStepBlock = block + 1;
+                overBudgetAfterSettling = 0;
+            }
+            else if (seconds > budget)
+            {
+                ++overBudgetAfterSettling;
+            }
+        }
+
+        juce::StringArray tierLoads;
+        for (int t = 0; t < numTiers; ++t)
+            if (tierBlocks[(size_t)t] > 0)
+                tierLoads.add(juce::String(QualityGovernor::getTierName((Tier)t)) + " "
+                              + juce::String(100.0 * tierSecondsTotal[(size_t)t] / (tierBlocks[(size_t)t] * budget), 0) + "% mean, "
+                              + juce::String(100.0 * tierWorst[(size_t)t] / budget, 0) + "% worst");
+        logMessage(describe(closedLoopSteps) + "; " + tierLoads.joinIntoString(", "));
+
+        const auto settled = (size_t)governor.getTier();
+        const double settledMean = tierSecondsTotal[settled] / juce::jmax(1, tierBlocks[settled]);
+        expect(settled != 0, "never stepped down: " + describe(closedLoopSteps));
+        expectLessThan(settledMean, budget, "settled tier still over budget on average");
+        expectLessThan(settledMean, tierSecondsTotal[0] / juce::jmax(1, tierBlocks[0]), "stepping down didn't shorten the blocks");
+        expectLessOrEqual(lastStepBlock, closedLoopBlocks / 2, "still stepping in the second half: " + describe(closedLoopSteps));
+        expectEquals(overBudgetAfterSettling, 0, "blocks over budget after the last step");
+    }
+
+private:
+    // The block count at each tier change
+    struct Step
+    {
+        int block;
+        QualityGovernor::Tier tier;
+    };
+
+    // Blocks at a fixed share of the budget
+    std::vector<Step> drive(float blockLoad, int numBlocks)
+    {
+        const double budget = testBlockSize / testSampleRate;
+        std::vector<Step> steps;
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const auto before = governor.getTier();
+            governor.recordCallback(blockLoad * budget, testBlockSize);
+            if (governor.getTier() != before)
+                steps.push_back({ block + 1, governor.getTier() });
+        }
+        return steps;
+    }
+
+    // Stands in for other work sharing the callback
+    static void spin(double seconds)
+    {
+        const auto end = juce::Time::getHighResolutionTicks() + juce::Time::secondsToHighResolutionTicks(seconds);
+        while (juce::Time::getHighResolutionTicks() < end) {}
+    }
+
+    static juce::String describe(const std::vector<Step>& steps)
+    {
+        juce::StringArray parts;
+        for (const auto& step : steps)
+            parts.add(juce::String(QualityGovernor::getTierName(step.tier)) + " at block " + juce::String(step.block));
+        return parts.isEmpty() ? juce::String("no change") : parts.joinIntoString(", ");
+    }
+
+    QualityGovernor governor;
+};
+
+static QualityGovernorTests qualityGovernorTests;
@@ -0,0 +1,183 @@
+#include <JuceHeader.h>
+#include "../Source/RateConverter.h"
+#include "../Source/SynthEngine.h"
+
+namespace
+{
+    // Render rate -> device rate
+    struct RatePair { double input, output; };
+    constexpr RatePair qualityPairs[] = { { 48000.0, 44100.0 }, { 44100.0, 48000.0 }, { 96000.0, 44100.0 },
+                                          { 48000.0, 192000.0 }, { 96000.0, 176400.0 } };
+    constexpr RatePair cpuPairs[] = { { 48000.0, 192000.0 }, { 96000.0, 176400.0 } };
+
+    constexpr int testBlockSize = 512;
+    constexpr int measuredSamples = 16384;
+    constexpr int numFrequencies = 24;
+    constexpr double maxRippleDb = 0.05;
+    constexpr double maxResidualDb = -80.0;     // the filter is designed for 90 dB
+    constexpr double cpuSeconds = 10.0;
+
+    // Least-squares fit of a sine at a known frequency: amplitude, and the RMS
+    // of whatever is left over
+    void fitSine(const std::vector<float>& x, double frequency, double sampleRate, double& amplitude, double& residualRms)
+    {
+        double cc = 0.0, ss = 0.0, cs = 0.0, xc = 0.0, xs = 0.0;
+        const double w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        for (size_t n = 0; n < x.size(); ++n)
+        {
+            const double c = std::cos(w * (double)n), s = std::sin(w * (double)n);
+            cc += c * c; ss += s * s; cs += c * s;
+            xc += x[n] * c; xs += x[n] * s;
+        }
+        const double det = cc * ss - cs * cs;
+        const double a = det != 0.0 ? (xc * ss - xs * cs) / det : 0.0;
+        const double b = det != 0.0 ? (xs * cc - xc * cs) / det : 0.0;
+        amplitude = std::sqrt(a * a + b * b);
+
+        double residual = 0.0;
+        for (size_t n = 0; n < x.size(); ++n)
+        {
+            const double e = x[n] - (a * std::cos(w * (double)n) + b * std::sin(w * (double)n));
+            residual += e * e;
+        }
+        residualRms = std::sqrt(residual / (double)juce::jmax<size_t>(1, x.size()));
+    }
+
+}
+
+//==============================================================================
+// Passband ripple, image and alias rejection for the render/device rate
+// pairs the app offers, then the engine's cost through the converter against
+// rendering natively at the device rate
+class RateConverterTests : public juce::UnitTest
+{
+public:
+    RateConverterTests() : juce::UnitTest("Resampler", "Accuracy") {}
+
+    void runTest() override
+    {
+        for (const auto& rates : qualityPairs)
+        {
+            beginTest(juce::String(rates.input) + " -> " + juce::String(rates.output) + " Hz");
+
+            RateConverter probe;
+            expect(probe.prepare(rates.input, rates.output, testBlockSize), "can't convert");
+            if (!probe.isActive())
+                continue;
+
+            const double passEdge = RateConverter::getPassbandEdge(rates.input, rates.output);
+            double minGainDb = 1000.0, maxGainDb = -1000.0, worstResidualDb = -1000.0;
+            for (int i = 0; i < numFrequencies; ++i)
+            {
+                const double frequency = 20.0 * std::pow(passEdge / 20.0, i / (double)(numFrequencies - 1));
+                double amplitude = 0.0, residual = 0.0;
+                measure(rates, frequency, amplitude, residual);
+                const double gainDb = juce::Decibels::gainToDecibels(amplitude, -200.0);
+                minGainDb = juce::jmin(minGainDb, gainDb);
+                maxGainDb = juce::jmax(maxGainDb, gainDb);
+                worstResidualDb = juce::jmax(worstResidualDb, juce::Decibels::gainToDecibels(residual, -200.0));
+            }
+
+            logMessage(juce::String(probe.upFactor) + "/" + juce::String(probe.downFactor) + ", " + juce::String(probe.tapsPerPhase)
+                       + " taps per phase, latency " + juce::String(probe.getLatencySamples()) + " samples; passband 20-"
+                       + juce::String(juce::roundToInt(passEdge)) + " Hz ripple " + juce::String(maxGainDb - minGainDb, 4)
+                       + " dB; worst image/alias residual " + juce::String(worstResidualDb, 1) + " dB");
+            expectLessOrEqual(maxGainDb - minGainDb, maxRippleDb, "passband ripple");
+            expectLessOrEqual(worstResidualDb, maxResidualDb, "image/alias residual");
+
+            // Tones that would fold back into the passband should vanish instead.
+            // Below the stopband edge they can only fold into the transition band.
+            const double stopEdge = rates.output - passEdge;
+            if (rates.input > rates.output && stopEdge < 0.49 * rates.input)
+            {
+                double worstLeakageDb = -1000.0;
+                for (int i = 0; i < numFrequencies; ++i)
+                {
+                    const double frequency = stopEdge + (0.49 * rates.input - stopEdge) * i / (double)(numFrequencies - 1);
+                    double amplitude = 0.0, residual = 0.0;
+                    measure(rates, frequency, amplitude, residual);
+                    const double leakage = std::sqrt(amplitude * amplitude + residual * residual);
+                    worstLeakageDb = juce::jmax(worstLeakageDb, juce::Decibels::gainToDecibels(leakage, -200.0));
+                }
+                logMessage("Stopband leakage " + juce::String(worstLeakageDb, 1) + " dB");
+                expectLessOrEqual(worstLeakageDb, maxResidualDb, "stopband leakage");
+            }
+        }
+
+        // The same held note rendered natively and through the converter
+        for (const auto& rates : cpuPairs)
+        {
+            beginTest("Engine at " + juce::String(rates.input) + " Hz for a " + juce::String(rates.output) + " Hz device");
+            const double native = renderSeconds(rates, false);
+            const double converted = renderSeconds(rates, true);
+            logMessage(juce::String(cpuSeconds, 0) + " s of audio: " + juce::String(native, 3) + " s native, "
+                       + juce::String(converted, 3) + " s at the render rate plus conversion ("
+                       + juce::String(100.0 * converted / juce::jmax(1.0e-9, native), 0) + "%)");
+        }
+    }
+
+private:
+    // Settled output of one sine through a fresh converter, both relative to
+    // the input so 1 is unity gain
+    static void measure(const RatePair& rates, double frequency, double& amplitude, double& residualRms)
+    {
+        RateConverter converter;
+        converter.prepare(rates.input, rates.output, testBlockSize);
+        const int settle = converter.getLatencySamples() * 2 + testBlockSize;
+        std::vector<float> output((size_t)(settle + measuredSamples));
+        double inputPhase = 0.0;
+        const double increment = juce::MathConstants<double>::twoPi * frequency / rates.input;
+
+        for (int pos = 0; pos < (int)output.size(); pos += testBlockSize)
+        {
+            const int n = juce::jmin(testBlockSize, (int)output.size() - pos);
+            const int needed = converter.getInputSamplesNeeded(n);
+            float* input = converter.getInputBuffer(0);
+            for (int i = 0; i < needed; ++i)
+            {
+                input[i] = (float)(0.5 * std::sin(inputPhase));
+                inputPhase += increment;
+            }
+            converter.process(output.data() + pos, nullptr, n);
+        }
+
+        output.erase(output.begin(), output.begin() + settle);
+        fitSine(output, frequency, rates.output, amplitude, residualRms);
+        amplitude /= 0.5;
+        residualRms /= 0.5 / juce::MathConstants<double>::sqrt2;
+    }
+
+    double renderSeconds(const RatePair& rates, bool resample)
+    {
+        SynthEngine engine;
+        RateConverter converter;
+        converter.prepare(rates.input, rates.output, testBlockSize);
+        engine.prepare(resample ? rates.input : rates.output, resample ? converter.getMaxInputBlock() : testBlockSize);
+        engine.setRandomSeed(1);
+        engine.noteOn(60, 0.8f);
+
+        juce::AudioBuffer<float> output(2, testBlockSize);
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int done = 0; done < (int)(cpuSeconds * rates.output); done += testBlockSize)
+        {
+            if (resample)
+            {
+                const int inputs = converter.getInputSamplesNeeded(testBlockSize);
+                juce::FloatVectorOperations::clear(converter.getInputBuffer(0), inputs);
+                juce::FloatVectorOperations::clear(converter.getInputBuffer(1), inputs);
+                engine.render(converter.getInputBuffer(0), converter.getInputBuffer(1), inputs);
+                converter.process(output.getWritePointer(0), output.getWritePointer(1), testBlockSize);
+            }
+            else
+            {
+                output.clear();
+                engine.render(output.getWritePointer(0), output.getWritePointer(1), testBlockSize);
+            }
+        }
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        expect(std::isfinite(output.getMagnitude(0, testBlockSize)), "output went non-finite");
+        return seconds;
+    }
+};
+
+static RateConverterTests rateConverterTests;
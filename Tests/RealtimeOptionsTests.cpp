@@ -0,0 +1,129 @@
+#include <JuceHeader.h>
+#include "../Source/RealtimeOptions.h"
+
+namespace
+{
+    constexpr double jitterPeriodMs = 256.0 / 48.0;    // 256 samples at 48 kHz
+    constexpr int jitterPeriods = 750;                 // about 4 s per run
+    constexpr double jitterWorkMs = 1.0;               // a callback at about 20% load
+
+    // Busy work at normal priority on every core, for the probe to compete with
+    class LoadThread : public juce::Thread
+    {
+    public:
+        LoadThread() : juce::Thread("Jitter load") {}
+
+        void run() override
+        {
+            float x = 1.0f;
+            while (!threadShouldExit())
+                for (int i = 0; i < 10000; ++i)
+                    x = std::sin(x) + 1.0f;
+            sink = x;
+        }
+
+        volatile float sink = 0.0f;
+    };
+
+    // Sleeps to each period boundary like a callback waiting on the driver,
+    // records how late it woke, then spins for the callback's work. Applies
+    // the current options the way the audio callback does.
+    class JitterProbe : public juce::Thread
+    {
+    public:
+        explicit JitterProbe(bool realtime)
+            : juce::Thread("Jitter probe"), configure(realtime)
+        {
+            latenessMs.ensureStorageAllocated(jitterPeriods);
+        }
+
+        void run() override
+        {
+            if (configure)
+                result = Realtime::configureAudioThread();
+
+            auto deadline = juce::Time::getMillisecondCounterHiRes();
+            for (int period = 0; period < jitterPeriods && !threadShouldExit(); ++period)
+            {
+                deadline += jitterPeriodMs;
+                const int sleepMs = (int)(deadline - juce::Time::getMillisecondCounterHiRes());
+                const double wakeAt = juce::Time::getMillisecondCounterHiRes() + juce::jmax(0, sleepMs);
+                if (sleepMs > 0)
+                    juce::Thread::sleep(sleepMs);
+                latenessMs.add(juce::jmax(0.0, juce::Time::getMillisecondCounterHiRes() - wakeAt));
+
+                const double workEnd = juce::Time::getMillisecondCounterHiRes() + jitterWorkMs;
+                while (juce::Time::getMillisecondCounterHiRes() < workEnd) {}
+            }
+        }
+
+        const bool configure;
+        RealtimeThreadResult result;
+        juce::Array<double> latenessMs;
+    };
+}
+
+//==============================================================================
+// How late a callback-sized thread wakes against a busy thread per core,
+// first with normal scheduling, then with the real-time options given to the
+// runner (SCHED_FIFO if none were). Options that were asked for have to take
+// effect; the SCHED_FIFO default is only reported when it's refused.
+class RealtimeOptionsTests : public juce::UnitTest
+{
+public:
+    RealtimeOptionsTests() : juce::UnitTest("Real-time jitter", "Benchmarks") {}
+
+    void runTest() override
+    {
+        const auto requested = RealtimeOptions::getCurrent();
+        auto realtime = requested;
+        if (realtime.policy == RealtimeOptions::Policy::normal)
+            realtime.policy = RealtimeOptions::Policy::fifo;
+
+        const int numLoadThreads = juce::SystemStats::getNumCpus();
+        logMessage("Wake-up lateness of a " + juce::String(jitterPeriodMs, 2) + " ms callback against "
+                   + juce::String(numLoadThreads) + " busy threads, " + juce::String(jitterPeriods) + " periods per run");
+
+        juce::OwnedArray<LoadThread> load;
+        for (int i = 0; i < numLoadThreads; ++i)
+            load.add(new LoadThread())->startThread();
+
+        for (const bool on : { false, true })
+        {
+            beginTest(on ? "Real-time options on" : "Normal scheduling");
+
+            RealtimeOptions::setCurrent(realtime);
+            JitterProbe probe(on);
+            probe.startThread();
+            while (probe.isThreadRunning())
+                juce::Thread::sleep(50);
+            RealtimeOptions::setCurrent(requested);
+
+            auto lateness = probe.latenessMs;
+            lateness.sort();
+            double mean = 0.0;
+            for (double ms : lateness)
+                mean += ms;
+            mean /= juce::jmax(1, lateness.size());
+            const auto percentile = [&lateness](double p) { return lateness.isEmpty() ? 0.0 : lateness[juce::jmin(lateness.size() - 1, (int)(p * lateness.size()))]; };
+
+            logMessage((on ? probe.result.describe(realtime.audioCores) : juce::String("RT off")) + ": "
+                       + juce::String(mean * 1000.0, 0) + " us mean, "
+                       + juce::String(percentile(0.99) * 1000.0, 0) + " us 99th percentile, "
+                       + juce::String(lateness.getLast() * 1000.0, 0) + " us worst");
+
+            if (on && requested.requestsAnything())
+            {
+                expectEquals(probe.result.scheduleError, 0, "scheduling refused");
+                expect(realtime.audioCores.isEmpty() || probe.result.pinned, "pinning refused");
+            }
+        }
+
+        for (auto* thread : load)
+            thread->signalThreadShouldExit();
+        for (auto* thread : load)
+            thread->stopThread(1000);
+    }
+};
+
+static RealtimeOptionsTests realtimeOptionsTests;
@@ -0,0 +1,117 @@
+#include <JuceHeader.h>
+#include "../Source/SampleOscillator.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr int firstNote = 36;
+    constexpr int noteSpacing = 6;
+    constexpr int numTestZones = 12;
+    constexpr double zoneSeconds = 10.0;
+    constexpr int bitsPerSample = 24;
+    constexpr double playSeconds = 20.0;
+}
+
+//==============================================================================
+// A temporary multisample set: its load time, mapped against preloaded
+// memory, and what one playhead costs, as voices per core. The set has to
+// load whole and play back audibly.
+class SampleOscillatorTests : public juce::UnitTest
+{
+public:
+    SampleOscillatorTests() : juce::UnitTest("Sampler streaming", "Benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Load");
+
+        // One sine per zone, named by its root note
+        const auto folder = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("SampleTest", {});
+        folder.createDirectory();
+
+        const int zoneLength = (int)(zoneSeconds * testSampleRate);
+        juce::AudioBuffer<float> zoneAudio(2, zoneLength);
+        juce::WavAudioFormat wav;
+        for (int z = 0; z < numTestZones; ++z)
+        {
+            const int note = firstNote + z * noteSpacing;
+            const double step = juce::MathConstants<double>::twoPi * juce::MidiMessage::getMidiNoteInHertz(note) / testSampleRate;
+            for (int i = 0; i < zoneLength; ++i)
+            {
+                const float value = 0.5f * (float)std::sin(step * i);
+                zoneAudio.setSample(0, i, value);
+                zoneAudio.setSample(1, i, value);
+            }
+
+            const auto file = folder.getChildFile("Zone_" + juce::String(note) + ".wav");
+            std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+            std::unique_ptr<juce::AudioFormatWriter> writer;
+            if (stream != nullptr)
+                writer.reset(wav.createWriterFor(stream.get(), testSampleRate, 2, bitsPerSample, {}, 0));
+            if (writer != nullptr)
+            {
+                stream.release(); // now owned by the writer
+                writer->writeFromAudioSampleBuffer(zoneAudio, 0, zoneLength);
+            }
+        }
+
+        auto sampler = std::make_unique<SampleOscillator>();
+        sampler->prepare(testSampleRate);
+        const auto loadStart = juce::Time::getHighResolutionTicks();
+        sampler->loadOnBackgroundThread(folder);
+        const double loadMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - loadStart) * 1000.0;
+        sampler->beginBlock();
+
+        // Only the touched attacks have to be resident; the rest pages in ahead of the playhead
+        juce::int64 mappedBytes = 0, preloadedBytes = 0;
+        const int numZones = sampler->currentSet != nullptr ? (int)sampler->currentSet->zones.size() : 0;
+        if (sampler->currentSet != nullptr)
+        {
+            for (const auto& zone : sampler->currentSet->zones)
+            {
+                const auto frameBytes = (juce::int64)zone.reader->numChannels * zone.reader->bitsPerSample / 8;
+                mappedBytes += (juce::int64)zone.reader->getNumBytesUsed();
+                preloadedBytes += juce::jmin(zone.length, (juce::int64)(SampleOscillator::attackPreloadSeconds * zone.fileSampleRate)) * frameBytes;
+            }
+        }
+
+        logMessage(juce::String(numZones) + " stereo " + juce::String(bitsPerSample) + "-bit zones of " + juce::String(zoneSeconds, 1)
+                   + " s loaded in " + juce::String(loadMs, 1) + " ms; " + juce::File::descriptionOfSizeInBytes(mappedBytes) + " mapped, "
+                   + juce::File::descriptionOfSizeInBytes(preloadedBytes) + " touched up front");
+        expectEquals(numZones, numTestZones);
+
+        // One playhead a semitone above each root, retriggered once per zone's
+        // share of the run, so every zone streams from its attack onwards
+        beginTest("One playhead");
+        const int numBlocks = (int)(playSeconds * testSampleRate) / testBlockSize;
+        const int blocksPerNote = juce::jmax(1, numBlocks / juce::jmax(1, numZones));
+        double totalSeconds = 0.0, worstBlockMicros = 0.0;
+        float peak = 0.0f;
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            const int note = firstNote + ((b / blocksPerNote) % numTestZones) * noteSpacing + 1;
+            const auto frequency = (float)juce::MidiMessage::getMidiNoteInHertz(note);
+            const auto start = juce::Time::getHighResolutionTicks();
+            sampler->beginBlock();
+            if (b % blocksPerNote == 0)
+                sampler->trigger(note);
+            for (int i = 0; i < testBlockSize; ++i)
+                peak = juce::jmax(peak, std::abs(sampler->renderSample(frequency, true)));
+            const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            totalSeconds += seconds;
+            worstBlockMicros = juce::jmax(worstBlockMicros, seconds * 1.0e6);
+        }
+
+        const double nsPerSample = totalSeconds * 1.0e9 / ((double)numBlocks * testBlockSize);
+        logMessage(juce::String(nsPerSample, 1) + " ns/sample, worst " + juce::String(testBlockSize) + "-sample block "
+                   + juce::String(worstBlockMicros, 1) + " us, about " + juce::String((int)(1.0e9 / (nsPerSample * testSampleRate)))
+                   + " voices per core; peak " + juce::String(peak, 3));
+        expect(std::isfinite(peak) && peak > 0.1f, "silent playback");
+
+        sampler.reset(); // unmaps the files
+        folder.deleteRecursively();
+    }
+};
+
+static SampleOscillatorTests sampleOscillatorTests;
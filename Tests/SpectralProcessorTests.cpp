@@ -0,0 +1,123 @@
+#include <JuceHeader.h>
+#include "../Source/SpectralProcessor.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 128;
+    constexpr double testSeconds = 4.0;
+    constexpr float reconstructionTolerance = 1.0e-4f;
+    constexpr double settleSeconds = 0.2;       // past the engage crossfade
+    constexpr float minGapRms = 0.5f;           // of the input's, in any block
+}
+
+//==============================================================================
+// For every FFT size, the unedited path has to reconstruct its input; then
+// each block is timed with every frame transformed at once and with the work
+// spread over the hop. Engaging and re-framing mustn't leave a gap.
+class SpectralProcessorTests : public juce::UnitTest
+{
+public:
+    SpectralProcessorTests() : juce::UnitTest("Spectral stage", "Benchmarks") {}
+
+    void runTest() override
+    {
+        auto processor = std::make_unique<SpectralProcessor>();
+        DspArena arena;
+        arena.reserve(SpectralProcessor::getArenaFootprint());
+        processor->prepare(testSampleRate, arena);
+
+        const int numBlocks = (int)(testSeconds * testSampleRate) / testBlockSize;
+        std::vector<float> input((size_t)(numBlocks * testBlockSize));
+        juce::Random random(1);
+        for (auto& sample : input)
+            sample = random.nextFloat() * 0.5f - 0.25f;
+
+        std::vector<float> left((size_t)testBlockSize), right((size_t)testBlockSize);
+        const auto processBlock = [&](int block)
+        {
+            const auto* source = input.data() + block * testBlockSize;
+            std::copy(source, source + testBlockSize, left.begin());
+            std::copy(source, source + testBlockSize, right.begin());
+            processor->process(left.data(), right.data(), testBlockSize);
+        };
+
+        for (int order = SpectralProcessor::minFftOrder; order <= SpectralProcessor::maxFftOrder; ++order)
+        {
+            beginTest("FFT " + juce::String(1 << order) + ", 4x overlap");
+
+            // Unedited, at full mix the output is the input delayed by the latency
+            processor->amortise = true;
+            processor->reset();
+            processor->setParameters(order, 4, false, 0.0f, SpectralProcessor::gateOffDb, 1.0f);
+            const int latency = processor->latency;
+            const int settled = latency + processor->fftSize + (int)(settleSeconds * testSampleRate);
+
+            float worstError = 0.0f;
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                processBlock(block);
+                for (int i = 0; i < testBlockSize; ++i)
+                {
+                    const int n = block * testBlockSize + i;
+                    if (n >= settled)
+                        worstError = juce::jmax(worstError, std::abs(left[(size_t)i] - input[(size_t)(n - latency)]),
+                                                std::abs(right[(size_t)i] - input[(size_t)(n - latency)]));
+                }
+            }
+            expectLessThan(worstError, reconstructionTolerance, "reconstruction");
+
+            // Per-block cost with the gate and blur running, every frame at once and then spread over its hop
+            double worstMicros[2] {}, meanMicros[2] {};
+            for (int spread = 0; spread < 2; ++spread)
+            {
+                processor->amortise = spread == 1;
+                processor->reset();
+                processor->setParameters(order, 4, false, 0.5f, -60.0f, 1.0f);
+
+                double totalSeconds = 0.0;
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    const auto start = juce::Time::getHighResolutionTicks();
+                    processBlock(block);
+                    const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+                    totalSeconds += seconds;
+                    worstMicros[spread] = juce::jmax(worstMicros[spread], seconds * 1.0e6);
+                }
+                meanMicros[spread] = totalSeconds * 1.0e6 / numBlocks;
+            }
+
+            logMessage("Hop " + juce::String(processor->hop) + ": latency " + juce::String(latency) + " samples ("
+                       + juce::String(1000.0 * latency / testSampleRate, 1) + " ms), reconstruction error " + juce::String(worstError, 7));
+            logMessage("Whole frames: worst " + juce::String(worstMicros[0], 1) + " us, mean " + juce::String(meanMicros[0], 1)
+                       + " us; spread over the hop: worst " + juce::String(worstMicros[1], 1) + " us, mean "
+                       + juce::String(meanMicros[1], 1) + " us");
+        }
+
+        // Bypassed for a second, engaged, re-framed twice, then bypassed again:
+        // the crossfades keep every block near the input's level
+        beginTest("Engage and re-frame without a gap");
+        processor->amortise = true;
+        processor->reset();
+        const int second = (int)testSampleRate / testBlockSize;
+        float quietestRms = 1.0f;
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const float mix = block < second || block >= 3 * second ? 0.0f : 1.0f;
+            const int order = block < 2 * second ? 11 : (block < 5 * second / 2 ? 9 : 12);
+            processor->setParameters(order, 4, false, 0.0f, SpectralProcessor::gateOffDb, mix);
+            processBlock(block);
+
+            float sum = 0.0f;
+            for (float sample : left)
+                sum += sample * sample;
+            quietestRms = juce::jmin(quietestRms, std::sqrt(sum / (float)testBlockSize));
+        }
+        const float inputRms = 0.25f / std::sqrt(3.0f);
+        logMessage("Quietest block " + juce::String(juce::Decibels::gainToDecibels(quietestRms / inputRms), 1) + " dB against the input");
+        expectGreaterThan(quietestRms, minGapRms * inputRms);
+    }
+};
+
+static SpectralProcessorTests spectralProcessorTests;
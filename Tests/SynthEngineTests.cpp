@@ -0,0 +1,106 @@
+#include <JuceHeader.h>
+#include "../Source/SynthEngine.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr double timedSeconds = 5.0;
+    constexpr double onsetSeconds = 0.02;
+    constexpr double idleTimeoutSeconds = 10.0;
+    // How much harder than a fresh engine's the resumed onset may step
+    constexpr float onsetStepTolerance = 1.25f;
+}
+
+//==============================================================================
+// A block of a held note against a block while idle; the engine has to go
+// idle, stay silent there, and start a note afterwards as cleanly as a
+// fresh engine does
+class SynthEngineIdleTests : public juce::UnitTest
+{
+public:
+    SynthEngineIdleTests() : juce::UnitTest("Engine idle", "Benchmarks") {}
+
+    void runTest() override
+    {
+        engine = std::make_unique<SynthEngine>();
+        engine->prepare(testSampleRate, testBlockSize);
+        engine->setRandomSeed(1);
+        buffer.setSize(2, testBlockSize);
+
+        beginTest("Held note");
+        float freshFirst = 0.0f;
+        const float freshStep = measureOnset(freshFirst);
+        const double heldMicros = timeBlocks();
+        const double blockMicros = testBlockSize * 1.0e6 / testSampleRate;
+        logMessage(juce::String(testBlockSize) + "-sample blocks at " + juce::String(testSampleRate / 1000.0, 1) + " kHz: "
+                   + juce::String(heldMicros, 2) + " us per block (" + juce::String(100.0 * heldMicros / blockMicros, 2) + "% of real time)");
+
+        // Release the note and wait for every tail to ring out
+        beginTest("Idle after the tails");
+        engine->noteOff(60);
+        int samplesToIdle = 0;
+        while (!engine->isIdle() && samplesToIdle < (int)(idleTimeoutSeconds * testSampleRate))
+        {
+            renderBlock();
+            samplesToIdle += testBlockSize;
+        }
+        expect(engine->isIdle(), "never went idle");
+        const double idleMicros = timeBlocks();
+        expect(engine->isIdle() && buffer.getMagnitude(0, testBlockSize) == 0.0f, "output not silent while idle");
+        logMessage("Idle " + juce::String(1000.0 * samplesToIdle / testSampleRate, 0) + " ms after note-off; "
+                   + juce::String(idleMicros, 2) + " us per block (" + juce::String(100.0 * idleMicros / blockMicros, 3) + "%)");
+
+        beginTest("Resumed onset");
+        float resumedFirst = 0.0f;
+        const float resumedStep = measureOnset(resumedFirst);
+        logMessage("First sample " + juce::String(resumedFirst, 6) + ", largest step in the first " + juce::String(1000.0 * onsetSeconds, 0)
+                   + " ms " + juce::String(resumedStep, 5) + "; fresh engine: " + juce::String(freshFirst, 6) + ", " + juce::String(freshStep, 5));
+        expectLessOrEqual(resumedStep, freshStep * onsetStepTolerance);
+
+        engine.reset();
+    }
+
+private:
+    void renderBlock()
+    {
+        buffer.clear();
+        engine->render(buffer.getWritePointer(0), buffer.getWritePointer(1), testBlockSize);
+    }
+
+    double timeBlocks()
+    {
+        const int numBlocks = (int)(timedSeconds * testSampleRate) / testBlockSize;
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; ++block)
+            renderBlock();
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6 / numBlocks;
+    }
+
+    // Largest sample-to-sample step over the start of a note, and its first sample
+    float measureOnset(float& firstSample)
+    {
+        engine->noteOn(60, 0.8f);
+        const int onsetSamples = (int)(onsetSeconds * testSampleRate);
+        float largestStep = 0.0f, previous = 0.0f;
+        firstSample = -1.0f;
+        for (int done = 0; done < onsetSamples; done += testBlockSize)
+        {
+            renderBlock();
+            const auto* data = buffer.getReadPointer(0);
+            for (int i = 0; i < testBlockSize; ++i)
+            {
+                if (firstSample < 0.0f)
+                    firstSample = std::abs(data[i]);
+                largestStep = juce::jmax(largestStep, std::abs(data[i] - previous));
+                previous = data[i];
+            }
+        }
+        return largestStep;
+    }
+
+    std::unique_ptr<SynthEngine> engine;
+    juce::AudioBuffer<float> buffer;
+};
+
+static SynthEngineIdleTests synthEngineIdleTests;
@@ -0,0 +1,108 @@
+#include <JuceHeader.h>
+#include "../Source/Tuning.h"
+
+namespace
+{
+    constexpr double toleranceCents = 0.01;
+    constexpr int benchmarkSamples = 10000000;
+}
+
+//==============================================================================
+// Table accuracy in cents against exact references for a few scales,
+// fastExp2 accuracy, and the cost of the per-sample pitch path
+class TuningTests : public juce::UnitTest
+{
+public:
+    TuningTests() : juce::UnitTest("Tuning accuracy", "Accuracy") {}
+
+    void runTest() override
+    {
+        juce::String error;
+
+        beginTest("12-TET from the built-in .scl");
+        checkTable(TuningTable::createFromScalaFiles({}, {}, error).get(),
+                   [](int note) { return 440.0 * std::exp2((note - 69) / 12.0); });
+
+        // A above middle C at 440 Hz
+        beginTest("5-limit JI from ratios");
+        const double ratios[] = { 1.0, 16.0 / 15.0, 9.0 / 8.0, 6.0 / 5.0, 5.0 / 4.0, 4.0 / 3.0, 45.0 / 32.0,
+                                  3.0 / 2.0, 8.0 / 5.0, 5.0 / 3.0, 9.0 / 5.0, 15.0 / 8.0 };
+        checkTable(TuningTable::createFromScala("! ji.scl\nJust\n 12\n16/15\n9/8\n6/5\n5/4\n4/3\n45/32\n3/2\n8/5\n5/3\n9/5\n15/8\n2/1\n",
+                                                {}, "Just", error).get(),
+                   [&ratios](int note)
+                   {
+                       const int degree = note - 60;
+                       const int octave = (int)std::floor(degree / 12.0);
+                       return 440.0 / (5.0 / 3.0) * ratios[degree - octave * 12] * std::exp2(octave);
+                   });
+
+        // A mapping that puts middle C at 261.6256 Hz
+        beginTest("19-EDO with .kbm");
+        juce::String steps;
+        for (int i = 1; i < 19; ++i)
+            steps << juce::String(i * 1200.0 / 19.0, 6) << "\n";
+        checkTable(TuningTable::createFromScala("19-EDO\n19\n" + steps + "2/1\n", "! 19.kbm\n0\n0\n127\n60\n60\n261.6256\n19\n", "19-EDO", error).get(),
+                   [](int note) { return 261.6256 * std::exp2((note - 60) / 19.0); });
+
+        beginTest("fastExp2 over 20 Hz - 20 kHz");
+        double worstExpCents = 0.0;
+        const double low = std::log2(20.0), high = std::log2(20000.0);
+        for (int i = 0; i <= 100000; ++i)
+        {
+            const float x = (float)(low + (high - low) * i / 100000.0);
+            worstExpCents = juce::jmax(worstExpCents, std::abs(1200.0 * std::log2(Tuning::fastExp2(x) / std::exp2((double)x))));
+        }
+        logMessage("Worst error " + juce::String(worstExpCents, 5) + " cents");
+        expectLessThan(worstExpCents, toleranceCents);
+
+        // The old linear-in-Hz glide with a vibrato ratio, against the
+        // log-domain glide through std::exp2 and fastExp2
+        beginTest("Per-sample pitch path");
+        timePitchPath("linear Hz glide", [](float value, float vibrato) { return value * 100.0f * (1.0f + vibrato); });
+        timePitchPath("log2 glide + std::exp2", [](float value, float vibrato) { return std::exp2(value + vibrato); });
+        timePitchPath("log2 glide + fastExp2", [](float value, float vibrato) { return Tuning::fastExp2(value + vibrato); });
+    }
+
+private:
+    void checkTable(const TuningTable* table, const std::function<double(int)>& expectedHz)
+    {
+        expect(table != nullptr, "failed to build");
+        if (table == nullptr)
+            return;
+
+        double worstCents = 0.0, worstLog2Cents = 0.0;
+        for (int note = 0; note < 128; ++note)
+        {
+            const double expected = expectedHz(note);
+            worstCents = juce::jmax(worstCents, std::abs(1200.0 * std::log2(table->getFrequency(note) / expected)));
+            worstLog2Cents = juce::jmax(worstLog2Cents, std::abs(1200.0 * (table->getLog2Frequency(note) - std::log2(expected))));
+        }
+        logMessage("Worst error " + juce::String(worstCents, 5) + " cents in Hz, " + juce::String(worstLog2Cents, 5) + " cents in log2");
+        expectLessThan(worstCents, toleranceCents);
+        expectLessThan(worstLog2Cents, toleranceCents);
+    }
+
+    template <typename PerSample>
+    void timePitchPath(const char* label, PerSample&& perSample)
+    {
+        juce::SmoothedValue<float> glide;
+        glide.reset(benchmarkSamples / 16);
+        glide.setCurrentAndTargetValue(6.0f);
+        float sink = 0.0f, lfo = 0.0f;
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < benchmarkSamples; ++i)
+        {
+            if ((i & 65535) == 0)
+                glide.setTargetValue(glide.getTargetValue() > 8.0f ? 6.0f : 11.0f);
+            lfo += 0.001f;
+            if (lfo > 1.0f)
+                lfo -= 2.0f;
+            sink += perSample(glide.getNextValue(), lfo * 0.03f);
+        }
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        logMessage(juce::String(label) + ": " + juce::String(seconds * 1.0e9 / benchmarkSamples, 2) + " ns per sample"
+                   + (sink == 0.12345f ? " " : ""));
+    }
+};
+
+static TuningTests tuningTests;
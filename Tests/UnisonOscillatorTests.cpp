@@ -0,0 +1,113 @@
+#include <JuceHeader.h>
+#include "../Source/UnisonOscillator.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr double timedSeconds = 2.0;
+    constexpr int voiceCounts[] = { 1, 2, 4, 8, 12, 16 };
+    constexpr float testMorph = 0.8f;       // sine, triangle and saw all in play
+    constexpr float matchTolerance = 1.0e-4f;
+    constexpr float phaseInc = juce::MathConstants<float>::twoPi * 220.0f / (float)testSampleRate;
+}
+
+//==============================================================================
+// The stack at every copy count against the same shapes rendered one copy at
+// a time: the two have to agree, and both are timed
+class UnisonOscillatorTests : public juce::UnitTest
+{
+public:
+    UnisonOscillatorTests() : juce::UnitTest("Unison oscillator", "Benchmarks") {}
+
+    void runTest() override
+    {
+        const int numSamples = (int)(timedSeconds * testSampleRate);
+        logMessage(juce::String((int)UnisonOscillator::Lanes::SIZE) + " copies per register");
+
+        for (const int voices : voiceCounts)
+        {
+            beginTest(juce::String(voices) + (voices == 1 ? " copy" : " copies"));
+
+            UnisonOscillator unison;
+            unison.setRandomSeed(1);
+            unison.setParameters(voices, 18.0f, 0.8f, 1.0f);
+            unison.noteOn();
+            auto scalarPhases = unison.phases;
+
+            // Agreement first, over a short run
+            float worstDifference = 0.0f;
+            for (int i = 0; i < (int)testSampleRate / 10; ++i)
+            {
+                float left, right, scalarLeft, scalarRight;
+                unison.render(phaseInc, testMorph, left, right);
+                renderScalar(unison, scalarPhases, scalarLeft, scalarRight);
+                worstDifference = juce::jmax(worstDifference, std::abs(left - scalarLeft), std::abs(right - scalarRight));
+            }
+            expectLessOrEqual(worstDifference, matchTolerance, "lanes against one at a time");
+
+            float sink = 0.0f;
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float left, right;
+                unison.render(phaseInc, testMorph, left, right);
+                sink += left + right;
+            }
+            const double laneSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+            start = juce::Time::getHighResolutionTicks();
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float left, right;
+                renderScalar(unison, scalarPhases, left, right);
+                sink += left + right;
+            }
+            const double scalarSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            expect(std::isfinite(sink), "non-finite output");
+
+            logMessage("Lanes " + juce::String(laneSeconds * 1.0e9 / numSamples, 1) + " ns per sample, one at a time "
+                       + juce::String(scalarSeconds * 1.0e9 / numSamples, 1) + " ns ("
+                       + juce::String(scalarSeconds / juce::jmax(1.0e-12, laneSeconds), 2) + "x), difference " + juce::String(worstDifference, 7));
+        }
+    }
+
+private:
+    // The shapes and weights from render(), one copy at a time
+    static void renderScalar(const UnisonOscillator& source, std::array<float, UnisonOscillator::maxVoices>& phases, float& left, float& right)
+    {
+        const float m = testMorph * 3.0f;
+        const float wSine = m < 1.0f ? 1.0f - m : 0.0f;
+        const float wTri = m < 1.0f ? m : (m < 2.0f ? 2.0f - m : 0.0f);
+        const float wSaw = m < 1.0f ? 0.0f : (m < 2.0f ? m - 1.0f : 3.0f - m);
+        const float wSqr = m < 2.0f ? 0.0f : m - 2.0f;
+
+        const float inc = phaseInc / juce::MathConstants<float>::twoPi;
+        left = right = 0.0f;
+        for (int v = 0; v < source.numVoices; ++v)
+        {
+            auto& t = phases[(size_t)v];
+            t += source.ratios[(size_t)v] * inc;
+            if (t >= 1.0f)
+                t -= 1.0f;
+
+            const float saw = t + t - 1.0f;
+            float para = saw * (1.0f - std::abs(saw)) * 4.0f;
+            para = (para * std::abs(para) - para) * 0.225f + para;
+            const float sine = -para;
+
+            float u = t + 0.25f;
+            if (u >= 1.0f)
+                u -= 1.0f;
+            const float tri = 1.0f - std::abs(u + u - 1.0f) * 2.0f;
+
+            const float clipped = juce::jlimit(-1.0f, 1.0f, sine * 2.0f);
+            const float sqr = clipped * (1.5f - clipped * clipped * 0.5f);
+
+            const float shape = sine * wSine + tri * wTri + saw * wSaw + sqr * wSqr;
+            left += shape * source.gainsL[(size_t)v];
+            right += shape * source.gainsR[(size_t)v];
+        }
+    }
+};
+
+static UnisonOscillatorTests unisonOscillatorTests;
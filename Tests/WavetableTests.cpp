@@ -0,0 +1,109 @@
+#include <JuceHeader.h>
+#include "../Source/Wavetable.h"
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int frameCounts[] = { 1, 16, 64, 256 };
+    constexpr int buildRuns = 3;
+    constexpr int numSwaps = 100;
+    constexpr int collectInterval = 10;     // swaps per collector pass
+}
+
+//==============================================================================
+// Build time for 1 to 256-frame tables, then tables swapped through a bank
+// far more often than the retire queue holds: every retired one must be freed
+class WavetableTests : public juce::UnitTest
+{
+public:
+    WavetableTests() : juce::UnitTest("Wavetable generation", "Benchmarks") {}
+
+    void runTest() override
+    {
+        const juce::TemporaryFile file(".wav");
+
+        for (const int numFrames : frameCounts)
+        {
+            beginTest(juce::String(numFrames) + " frames");
+            writeTable(file.getFile(), numFrames);
+
+            double bestMs = std::numeric_limits<double>::max();
+            size_t bytes = 0;
+            for (int run = 0; run < buildRuns; ++run)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                auto set = WavetableSet::createFromFile(file.getFile());
+                bestMs = juce::jmin(bestMs, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0);
+                expect(set != nullptr && set->getNumFrames() == numFrames, "table failed to build");
+                bytes = set != nullptr ? set->getNumBytes() : 0;
+            }
+
+            logMessage(juce::String(WavetableSet::numMipLevels) + " mip levels of " + juce::String(WavetableSet::tableSize) + " samples: best of "
+                       + juce::String(buildRuns) + " " + juce::String(bestMs, 1) + " ms (" + juce::String(bestMs * 1000.0 / numFrames, 0)
+                       + " us per frame), " + juce::File::descriptionOfSizeInBytes((juce::int64)bytes));
+        }
+
+        // Retirement, with the audio thread's acquire and the collector interleaved
+        // as they are in the engine. Only the active table should survive.
+        beginTest("Retired tables are freed");
+        writeTable(file.getFile(), 1);
+        const int liveBefore = WavetableSet::getNumLiveSets();
+        int mostAlive = 0;
+        {
+            WavetableBank bank;
+            bool newestActive = true;
+            for (int swap = 0; swap < numSwaps; ++swap)
+            {
+                auto set = WavetableSet::createFromFile(file.getFile());
+                const auto* published = set.get();
+                bank.tables.publish(std::move(set));
+                newestActive = newestActive && bank.beginBlock() == published;
+
+                if ((swap + 1) % collectInterval == 0)
+                {
+                    mostAlive = juce::jmax(mostAlive, WavetableSet::getNumLiveSets() - liveBefore);
+                    bank.collectGarbage();
+                }
+            }
+            bank.collectGarbage();
+
+            const int alive = WavetableSet::getNumLiveSets() - liveBefore;
+            logMessage(juce::String(numSwaps) + " swaps, collected every " + juce::String(collectInterval) + ": at most "
+                       + juce::String(mostAlive) + " tables alive before a pass, " + juce::String(alive) + " after the last");
+            expect(newestActive, "the newest table wasn't the active one");
+            expectEquals(alive, 1, "only the active table should be alive");
+        }
+        expectEquals(WavetableSet::getNumLiveSets() - liveBefore, 0, "tables outlived the bank");
+    }
+
+private:
+    // Saw to square across the frames, written as a multi-frame file
+    static void writeTable(const juce::File& file, int numFrames)
+    {
+        juce::AudioBuffer<float> frames(1, numFrames * WavetableSet::tableSize);
+        for (int f = 0; f < numFrames; ++f)
+        {
+            const float morph = numFrames > 1 ? (float)f / (float)(numFrames - 1) : 0.0f;
+            for (int i = 0; i < WavetableSet::tableSize; ++i)
+            {
+                const float saw = 2.0f * (float)i / (float)WavetableSet::tableSize - 1.0f;
+                const float square = i < WavetableSet::tableSize / 2 ? 1.0f : -1.0f;
+                frames.setSample(0, f * WavetableSet::tableSize + i, saw + morph * (square - saw));
+            }
+        }
+
+        file.deleteFile();
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        if (stream != nullptr)
+            writer.reset(wav.createWriterFor(stream.get(), testSampleRate, 1, 24, {}, 0));
+        if (writer != nullptr)
+        {
+            stream.release(); // now owned by the writer
+            writer->writeFromAudioSampleBuffer(frames, 0, frames.getNumSamples());
+        }
+    }
+};
+
+static WavetableTests wavetableTests;